@@ -18,7 +18,11 @@
 
 // CodeLite includes
 #include <CxxVariableScanner.h>
+#include <clFileFingerprint.h>
+#include <cl_indexer_tags.h>
+#include <clFuzzyMatcher.h>
 #include <ctags_manager.h>
+#include <fileutils.h>
 #include <wx/crt.h>
 
 #ifdef __WXGTK__
@@ -486,6 +490,230 @@ TEST_FUNC(testUnorderedMapIterator)
     return true;
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// clFuzzyMatcher test cases
+/////////////////////////////////////////////////////////////////////////////
+
+static std::vector<wxString> GetFuzzyMatcherItems()
+{
+    std::vector<wxString> items;
+    items.push_back("GetFileName");   // 0
+    items.push_back("getfilename");   // 1
+    items.push_back("GetFile");       // 2
+    items.push_back("FileGetter");    // 3
+    items.push_back("get_file_name"); // 4
+    items.push_back("SetName");       // 5
+    return items;
+}
+
+static wxString FuzzyMatchesToString(const clFuzzyMatcher::Vec_t& matches)
+{
+    wxString str;
+    for(size_t i = 0; i < matches.size(); ++i) {
+        str << matches[i].m_index << " ";
+    }
+    return str.Trim();
+}
+
+TEST_FUNC(testFuzzyMatcherRanking)
+{
+    clFuzzyMatcher matcher;
+    matcher.SetItems(GetFuzzyMatcherItems());
+
+    // exact, starts with, starts with (ignoring case) and the fuzzy match last
+    clFuzzyMatcher::Vec_t matches;
+    matcher.Filter("GetFile", matches);
+    CHECK_SIZE(matches.size(), 4);
+    CHECK_STRING(FuzzyMatchesToString(matches).mb_str(wxConvUTF8).data(), "2 0 1 4");
+    CHECK_CONDITION(clFuzzyMatcher::GetKind(matches[0].m_score) == clFuzzyMatcher::kExact, "expected an exact match");
+    CHECK_CONDITION(clFuzzyMatcher::GetKind(matches[3].m_score) == clFuzzyMatcher::kFuzzy, "expected a fuzzy match");
+
+    // The words starts are preferred
+    matcher.Filter("gfn", matches);
+    CHECK_SIZE(matches.size(), 3);
+    CHECK_STRING(FuzzyMatchesToString(matches).mb_str(wxConvUTF8).data(), "0 4 1");
+
+    // A single character matches only the items containing it
+    matcher.Filter("w", matches);
+    CHECK_SIZE(matches.size(), 0);
+
+    // An empty filter matches all the items in their order
+    matcher.Filter("", matches);
+    CHECK_SIZE(matches.size(), 6);
+    CHECK_STRING(FuzzyMatchesToString(matches).mb_str(wxConvUTF8).data(), "0 1 2 3 4 5");
+    return true;
+}
+
+TEST_FUNC(testFuzzyMatcherIncrementalFiltering)
+{
+    // 'typed' filters as the user types, and deletes, characters. Every result must be the one of a matcher that
+    // filters once
+    const char* typed[] = { "g", "ge", "get", "getx", "get", "getn", "g", "s", "se", "" };
+    clFuzzyMatcher incremental;
+    incremental.SetItems(GetFuzzyMatcherItems());
+    for(size_t i = 0; i < sizeof(typed) / sizeof(typed[0]); ++i) {
+        clFuzzyMatcher once;
+        once.SetItems(GetFuzzyMatcherItems());
+        clFuzzyMatcher::Vec_t expected, matches;
+        once.Filter(typed[i], expected);
+        incremental.Filter(typed[i], matches);
+        CHECK_STRING(FuzzyMatchesToString(matches).mb_str(wxConvUTF8).data(),
+                     FuzzyMatchesToString(expected).mb_str(wxConvUTF8).data());
+    }
+
+    // New items reset the incremental state
+    clFuzzyMatcher::Vec_t matches;
+    incremental.Filter("Set", matches);
+    CHECK_SIZE(matches.size(), 1);
+    std::vector<wxString> items;
+    items.push_back("SetFileName");
+    items.push_back("Settings");
+    incremental.SetItems(items);
+    incremental.Filter("SetF", matches);
+    CHECK_SIZE(matches.size(), 1);
+    CHECK_STRING(incremental.GetItem(matches[0].m_index).mb_str(wxConvUTF8).data(), "SetFileName");
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// clFileFingerprint test cases
+/////////////////////////////////////////////////////////////////////////////
+
+TEST_FUNC(testFileFingerprint)
+{
+    wxFileName file(wxFileName::GetTempDir(), "cctest_fingerprint.cpp");
+    FileUtils::Deleter deleter(file);
+    const wxString& path = file.GetFullPath();
+    CHECK_CONDITION(FileUtils::WriteFileContent(file, "int main() {}"), "failed to write the test file");
+
+    clFileFingerprint fingerprint;
+    CHECK_CONDITION(fingerprint.Read(path), "failed to read the fingerprint");
+    CHECK_SIZE(fingerprint.m_size, 13);
+
+    // ReadHash() alone hashes the content the same way
+    clFileFingerprint hashOnly;
+    CHECK_CONDITION(hashOnly.ReadHash(path), "failed to hash the file");
+    CHECK_CONDITION(hashOnly.m_hash == fingerprint.m_hash, "expected the same hash");
+
+    // The size and the modification time did not change: the previous hash is used, the content is not hashed
+    clFileFingerprint previous = fingerprint;
+    previous.m_hash = 42;
+    clFileFingerprint reused;
+    CHECK_CONDITION(reused.Read(path, previous), "failed to read the fingerprint");
+    CHECK_CONDITION(reused.m_hash == 42, "expected the previous hash to be used");
+
+    // A missing file has no fingerprint
+    clFileFingerprint missing;
+    CHECK_CONDITION(!missing.Read(path + ".missing") && !missing.IsOk(), "expected no fingerprint");
+    return true;
+}
+
+TEST_FUNC(testFileFingerprintFindModified)
+{
+    wxFileName file(wxFileName::GetTempDir(), "cctest_fingerprint_modified.cpp");
+    FileUtils::Deleter deleter(file);
+    const wxString& path = file.GetFullPath();
+    CHECK_CONDITION(FileUtils::WriteFileContent(file, "int main() {}"), "failed to write the test file");
+
+    clFileFingerprint parsed;
+    CHECK_CONDITION(parsed.Read(path), "failed to read the fingerprint");
+
+    wxArrayString files;
+    files.Add(path);
+    std::unordered_map<wxString, int> retagged;
+    retagged[path] = (int)time(NULL);
+    clFileFingerprint::Map_t stored;
+
+    // Unchanged since it was parsed
+    stored[path] = parsed;
+    wxArrayString modified;
+    clFileFingerprint::Map_t updated;
+    clFileFingerprint::FindModified(files, retagged, stored, modified, updated);
+    CHECK_SIZE(modified.GetCount(), 0);
+    CHECK_SIZE(updated.size(), 0);
+
+    // Touched: same content with another modification time, the new fingerprint should be stored
+    stored[path].m_mtime -= 1;
+    clFileFingerprint::FindModified(files, retagged, stored, modified, updated);
+    CHECK_SIZE(modified.GetCount(), 0);
+    CHECK_SIZE(updated.size(), 1);
+    CHECK_CONDITION(updated[path].m_mtime == parsed.m_mtime, "expected the current modification time");
+
+    // Same size and another modification time, but another content
+    stored[path].m_hash = parsed.m_hash + 1;
+    updated.clear();
+    clFileFingerprint::FindModified(files, retagged, stored, modified, updated);
+    CHECK_SIZE(modified.GetCount(), 1);
+    CHECK_SIZE(updated.size(), 0);
+
+    // A new size is always a modification
+    modified.Clear();
+    CHECK_CONDITION(FileUtils::WriteFileContent(file, "int main() { return 0; }"), "failed to write the test file");
+    stored[path] = parsed;
+    clFileFingerprint::FindModified(files, retagged, stored, modified, updated);
+    CHECK_SIZE(modified.GetCount(), 1);
+
+    // Never parsed
+    modified.Clear();
+    retagged.clear();
+    clFileFingerprint::FindModified(files, retagged, stored, modified, updated);
+    CHECK_SIZE(modified.GetCount(), 1);
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Indexer binary tags test cases
+/////////////////////////////////////////////////////////////////////////////
+
+TEST_FUNC(testBinaryTagsRoundTrip)
+{
+    // The ctags output is UTF-8
+    std::string ctags;
+    ctags += "main\t/tmp/src/main.cpp\t/^int main(int argc, char** argv)$/;\"\tfunction\tline:3\t"
+             "signature:(int argc, char** argv)\n";
+    ctags += "m_count\t/tmp/src/main.cpp\t/^    int m_count;  $/  ;\"\tmember  \tline:8\tclass:Foo\taccess:private\n";
+    ctags += "Bar\t/tmp/src/main.cpp\t  /^struct Bar {$/;\"\tstruct\tnamespace:\n";
+    ctags += "Anon\t/tmp/src/main.cpp\t/^    int Anon;$/;\"\tmember\tline:12\tclass:\taccess:public\n";
+    ctags += "\xc3\xa9t\xc3\xa9\t/tmp/src/caf\xc3\xa9.cpp\t/^void \xc3\xa9t\xc3\xa9();$/;\"\tprototype\tline:14\t"
+             "class:Caf\xc3\xa9\taccess:public\tsignature:()\n";
+    ctags += "MAX_SIZE\t/tmp/src/main.cpp\t 16 ;\"\tmacro\n";
+
+    clIndexerTagsWriter writer;
+    writer.addTags(ctags.c_str());
+    CHECK_SIZE(writer.getCount(), 6);
+    std::string binaryTags;
+    writer.flush(binaryTags);
+
+    TagsManagerST::Get()->SetEncoding(wxFONTENCODING_DEFAULT);
+    std::vector<TagEntryPtr> entries;
+    TagsManagerST::Get()->TagsFromBinaryTags(binaryTags, entries);
+    CHECK_SIZE(entries.size(), 6);
+
+    // The binary tags must be the same as the tags built from the ctags text
+    wxArrayString lines = wxStringTokenize(wxString::FromUTF8(ctags.c_str()), "\n", wxTOKEN_STRTOK);
+    CHECK_SIZE(lines.GetCount(), entries.size());
+    for(size_t i = 0; i < lines.GetCount(); ++i) {
+        wxString line = lines.Item(i);
+        line.Trim().Trim(false);
+        TagEntry expected;
+        expected.FromLine(line);
+        CHECK_CONDITION(expected == *entries.at(i), line.mb_str(wxConvUTF8).data());
+        CHECK_SIZE(entries.at(i)->GetLine(), expected.GetLine());
+    }
+
+    // The pattern keeps its leading whitespace
+    CHECK_STRING(entries.at(1)->GetPattern().mb_str(wxConvUTF8).data(), "/^    int m_count;  $/");
+    CHECK_STRING(entries.at(1)->GetKind().mb_str(wxConvUTF8).data(), "member");
+    CHECK_STRING(entries.at(2)->GetPattern().mb_str(wxConvUTF8).data(), "/^struct Bar {$/");
+    CHECK_STRING(entries.at(2)->GetScope().mb_str(wxConvUTF8).data(), "<global>");
+    CHECK_STRING(entries.at(3)->GetScope().mb_str(wxConvUTF8).data(), "<global>");
+    CHECK_STRING(entries.at(4)->GetName().mb_str(wxConvUTF8).data(), "\xc3\xa9t\xc3\xa9");
+    CHECK_STRING(entries.at(4)->GetFile().mb_str(wxConvUTF8).data(), "/tmp/src/caf\xc3\xa9.cpp");
+    CHECK_STRING(entries.at(4)->GetScope().mb_str(wxConvUTF8).data(), "Caf\xc3\xa9");
+    CHECK_SIZE(entries.at(5)->GetLine(), 16);
+    return true;
+}
+
 ///////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////
@@ -187,7 +187,7 @@ bool sortOnName(const string* a, const string* b)
 void ASResource::buildAssignmentOperators(vector<const string*>* assignmentOperators)
 {
 	const size_t elements = 15;
-	static bool reserved = false;
+	static thread_local bool reserved = false;
 	if (!reserved)
 	{
 		assignmentOperators->reserve(elements);
@@ -225,7 +225,7 @@ void ASResource::buildAssignmentOperators(vector<const string*>* assignmentOpera
 void ASResource::buildCastOperators(vector<const string*>* castOperators)
 {
 	const size_t elements = 5;
-	static bool reserved = false;
+	static thread_local bool reserved = false;
 	if (!reserved)
 	{
 		castOperators->reserve(elements);
@@ -250,7 +250,7 @@ void ASResource::buildCastOperators(vector<const string*>* castOperators)
 void ASResource::buildHeaders(vector<const string*>* headers, int fileType, bool beautifier)
 {
 	const size_t elements = 25;
-	static bool reserved = false;
+	static thread_local bool reserved = false;
 	if (!reserved)
 	{
 		headers->reserve(elements);
@@ -335,7 +335,7 @@ void ASResource::buildIndentableHeaders(vector<const string*>* indentableHeaders
 void ASResource::buildIndentableMacros(vector<const pair<const string, const string>* >* indentableMacros)
 {
 	const size_t elements = 10;
-	static bool reserved = false;
+	static thread_local bool reserved = false;
 	if (!reserved)
 	{
 		indentableMacros->reserve(elements);
@@ -372,7 +372,7 @@ void ASResource::buildIndentableMacros(vector<const pair<const string, const str
 void ASResource::buildNonAssignmentOperators(vector<const string*>* nonAssignmentOperators)
 {
 	const size_t elements = 15;
-	static bool reserved = false;
+	static thread_local bool reserved = false;
 	if (!reserved)
 	{
 		nonAssignmentOperators->reserve(elements);
@@ -408,7 +408,7 @@ void ASResource::buildNonAssignmentOperators(vector<const string*>* nonAssignmen
 void ASResource::buildNonParenHeaders(vector<const string*>* nonParenHeaders, int fileType, bool beautifier)
 {
 	const size_t elements = 20;
-	static bool reserved = false;
+	static thread_local bool reserved = false;
 	if (!reserved)
 	{
 		nonParenHeaders->reserve(elements);
@@ -468,7 +468,7 @@ void ASResource::buildNonParenHeaders(vector<const string*>* nonParenHeaders, in
 void ASResource::buildOperators(vector<const string*>* operators, int fileType)
 {
 	const size_t elements = 50;
-	static bool reserved = false;
+	static thread_local bool reserved = false;
 	if (!reserved)
 	{
 		operators->reserve(elements);
@@ -539,7 +539,7 @@ void ASResource::buildOperators(vector<const string*>* operators, int fileType)
 void ASResource::buildPreBlockStatements(vector<const string*>* preBlockStatements, int fileType)
 {
 	const size_t elements = 10;
-	static bool reserved = false;
+	static thread_local bool reserved = false;
 	if (!reserved)
 	{
 		preBlockStatements->reserve(elements);
@@ -584,7 +584,7 @@ void ASResource::buildPreBlockStatements(vector<const string*>* preBlockStatemen
 void ASResource::buildPreCommandHeaders(vector<const string*>* preCommandHeaders, int fileType)
 {
 	const size_t elements = 10;
-	static bool reserved = false;
+	static thread_local bool reserved = false;
 	if (!reserved)
 	{
 		preCommandHeaders->reserve(elements);
@@ -628,7 +628,7 @@ void ASResource::buildPreCommandHeaders(vector<const string*>* preCommandHeaders
 void ASResource::buildPreDefinitionHeaders(vector<const string*>* preDefinitionHeaders, int fileType)
 {
 	const size_t elements = 10;
-	static bool reserved = false;
+	static thread_local bool reserved = false;
 	if (!reserved)
 	{
 		preDefinitionHeaders->reserve(elements);
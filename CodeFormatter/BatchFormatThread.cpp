@@ -0,0 +1,378 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2014 Eran Ifrah
+// file name            : BatchFormatThread.cpp
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#include "BatchFormatThread.h"
+#include "asyncprocess.h"
+#include "clWorkerPool.h"
+#include "file_logger.h"
+#include "fileutils.h"
+#include "globals.h"
+#include "macros.h"
+#include <algorithm>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+#include <wx/stopwatch.h>
+#include <wx/xml/xml.h>
+
+#ifndef __WXMSW__
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define BATCH_FORMAT_MAX_WORKERS 16
+// The number of external formatters that may run at the same time
+#define BATCH_FORMAT_MAX_PROCESSES 4
+// Don't report the progress more often than this (milliseconds)
+#define BATCH_FORMAT_PROGRESS_INTERVAL 100
+
+extern "C" char* STDCALL AStyleMain(const char* pSourceIn, const char* pOptions,
+                                    void(STDCALL* fpError)(int, const char*), char*(STDCALL* fpAlloc)(unsigned long));
+// Implemented in codeformatter.cpp
+extern void STDCALL ASErrorHandler(int errorNumber, const char* errorMessage);
+extern char* STDCALL ASMemoryAlloc(unsigned long memoryNeeded);
+
+/**
+ * @brief state shared between the format workers
+ */
+class BatchFormatContext
+{
+    const std::vector<BatchFormatJob>& m_jobs;
+    const BatchFormatSettings& m_settings;
+    const BatchFormatCache_t& m_cache;
+    BatchFormatResult& m_result;
+    const std::function<bool(size_t, const wxString&)>& m_progress;
+    wxString m_signature;
+    size_t m_done;
+    wxCriticalSection m_cs;
+    wxSemaphore m_processes;
+
+protected:
+    bool IsUnchanged(const BatchFormatJob& job, const wxString& signature, clFileFingerprint& fingerprint);
+    bool FormatContent(const BatchFormatJob& job, const wxString& original, wxString& content);
+    void RunJob(const BatchFormatJob& job);
+    wxString RunCommand(const wxString& command);
+
+public:
+    BatchFormatContext(const std::vector<BatchFormatJob>& jobs, const BatchFormatSettings& settings,
+                       const BatchFormatCache_t& cache, BatchFormatResult& result,
+                       const std::function<bool(size_t, const wxString&)>& progress)
+        : m_jobs(jobs)
+        , m_settings(settings)
+        , m_cache(cache)
+        , m_result(result)
+        , m_progress(progress)
+        , m_signature(settings.GetSignature())
+        , m_done(0)
+        , m_processes(BATCH_FORMAT_MAX_PROCESSES, BATCH_FORMAT_MAX_PROCESSES)
+    {
+    }
+
+    /**
+     * @brief format the file of jobs[index], unless the batch was cancelled
+     */
+    void Run(size_t index);
+};
+
+/**
+ * @brief the .clang-format file used for 'filename' (the closest one in its parent folders)
+ */
+static wxFileName FindClangFormatConfig(const wxFileName& filename)
+{
+    wxFileName configFile(filename.GetPath(), ".clang-format");
+    while(configFile.GetDirCount()) {
+        if(configFile.FileExists()) { return configFile; }
+        configFile.RemoveLastDir();
+    }
+    return wxFileName();
+}
+
+/**
+ * @brief write 'content' to a temporary file next to 'filename' and rename it over 'filename'.
+ * A symlink is resolved first so the link target is replaced and not the link itself. When the file can not be
+ * replaced without losing something (it is still a link, it has other hardlinks or its owner can not be kept)
+ * the file is written in place
+ */
+static bool WriteFileAtomically(const wxFileName& filename, const wxString& content)
+{
+    wxFileName target(FileUtils::RealPath(filename.GetFullPath()));
+
+#ifndef __WXMSW__
+    struct stat buff;
+    if(::lstat(target.GetFullPath().mb_str(wxConvUTF8).data(), &buff) != 0 || S_ISLNK(buff.st_mode) ||
+       buff.st_nlink > 1) {
+        return FileUtils::WriteFileContent(filename, content);
+    }
+#endif
+
+    wxFileName tempFile(target.GetFullPath() + "-code-formatter-tmp");
+    FileUtils::Deleter deleter(tempFile);
+    if(!FileUtils::WriteFileContent(tempFile, content)) { return false; }
+
+#ifndef __WXMSW__
+    // Keep the owner, the group and the permissions of the original file
+    const wxCharBuffer tempPath = tempFile.GetFullPath().mb_str(wxConvUTF8);
+    if(::chown(tempPath.data(), buff.st_uid, buff.st_gid) != 0) {
+        return FileUtils::WriteFileContent(filename, content);
+    }
+    ::chmod(tempPath.data(), buff.st_mode & 07777);
+#endif
+    return ::wxRenameFile(tempFile.GetFullPath(), target.GetFullPath(), true);
+}
+
+wxString BatchFormatSettings::GetSignature() const
+{
+    wxString signature;
+    signature << m_astyleOptions << "|" << m_eol << "|" << m_phpOptions.flags << "|" << m_phpOptions.indentSize
+              << "|" << m_phpOptions.eol << "|" << m_xmlIndent;
+    return signature;
+}
+
+wxString BatchFormatContext::RunCommand(const wxString& command)
+{
+    clDEBUG() << "CodeFormatter running: " << command << clEndl;
+
+    wxString output;
+    m_processes.Wait();
+    IProcess::Ptr_t process(::CreateSyncProcess(command, IProcessCreateDefault | IProcessCreateWithHiddenConsole));
+    if(process) { process->WaitForTerminate(output); }
+    m_processes.Post();
+    return output;
+}
+
+bool BatchFormatContext::IsUnchanged(const BatchFormatJob& job, const wxString& signature,
+                                     clFileFingerprint& fingerprint)
+{
+    BatchFormatCache_t::const_iterator iter = m_cache.find(job.m_file);
+    if(iter == m_cache.end() || iter->second.m_signature != signature) { return false; }
+    if(!fingerprint.ReadAttributes(job.m_file)) { return false; }
+
+    const clFileFingerprint& formatted = iter->second.m_fingerprint;
+    if(formatted.m_size != fingerprint.m_size) { return false; }
+    if(formatted.m_mtime == fingerprint.m_mtime) {
+        fingerprint = formatted;
+        return true;
+    }
+
+    // Same size but a different modification time, compare the content
+    return fingerprint.ReadHash(job.m_file) && (fingerprint.m_hash == formatted.m_hash);
+}
+
+bool BatchFormatContext::FormatContent(const BatchFormatJob& job, const wxString& original, wxString& content)
+{
+    content.clear();
+    switch(job.m_engine) {
+    case kFormatEngineAStyle: {
+        char* textOut = AStyleMain(_C(original), _C(m_settings.m_astyleOptions), ASErrorHandler, ASMemoryAlloc);
+        if(textOut) {
+            content = _U(textOut);
+            content.Trim();
+            delete[] textOut;
+        }
+        if(!content.IsEmpty()) { content << m_settings.m_eol; }
+        break;
+    }
+    case kFormatEngineBuildInPhp: {
+        PHPFormatterBuffer buffer(original, m_settings.m_phpOptions);
+        buffer.format();
+        content = buffer.GetBuffer();
+        break;
+    }
+    case kFormatEngineClangFormat: {
+        if(m_settings.m_options.GetClangFormatExe().IsEmpty()) {
+            clWARNING() << "CodeFormatter: Missing clang_format exec" << clEndl;
+            return false;
+        }
+        // Format a copy in place: what clang-format prints may contain warnings and errors, it is never used as
+        // the content. The copy is in the same folder and has the same extension, so the same .clang-format file
+        // and language are used
+        FileUtils::Deleter deleter(job.m_tempFile);
+        if(!FileUtils::WriteFileContent(job.m_tempFile, original)) { return false; }
+        wxString output = RunCommand(m_settings.m_options.ClangFormatCommand(job.m_tempFile, ""));
+        if(!output.IsEmpty()) { clDEBUG() << "CodeFormatter: clang-format:" << output << clEndl; }
+        if(!FileUtils::ReadFileContent(job.m_tempFile, content)) { return false; }
+        break;
+    }
+    case kFormatEnginePhpCsFixer:
+    case kFormatEnginePhpcbf: {
+        if(job.m_command.IsEmpty()) { return false; }
+
+        // These tools format the file in place, let them format a copy
+        FileUtils::Deleter deleter(job.m_tempFile);
+        if(!FileUtils::WriteFileContent(job.m_tempFile, original)) { return false; }
+        RunCommand(job.m_command);
+        if(!FileUtils::ReadFileContent(job.m_tempFile, content)) { return false; }
+        break;
+    }
+    case kFormatEngineWxXmlDocument: {
+        FileUtils::Deleter deleter(job.m_tempFile);
+        wxXmlDocument doc;
+        if(!doc.Load(job.m_file) || !doc.Save(job.m_tempFile, m_settings.m_xmlIndent)) { return false; }
+        if(!FileUtils::ReadFileContent(job.m_tempFile, content)) { return false; }
+        break;
+    }
+    default:
+        return false;
+    }
+    return !content.IsEmpty();
+}
+
+void BatchFormatContext::RunJob(const BatchFormatJob& job)
+{
+    wxString signature = m_signature;
+    if(job.m_engine == kFormatEngineClangFormat) {
+        // The output depends on the .clang-format file, if one is used
+        wxString style = m_settings.m_options.GetClangFormatStyleAsString(job.m_file);
+        signature << "|" << m_settings.m_options.GetClangFormatExe() << "|" << style;
+        if(style == "file") {
+            clFileFingerprint config;
+            if(config.ReadAttributes(FindClangFormatConfig(job.m_file).GetFullPath())) {
+                signature << "|" << config.m_size << "|" << config.m_mtime;
+            }
+        }
+    } else if(!job.m_command.IsEmpty()) {
+        signature << "|" << job.m_command;
+    }
+
+    enum eState { kFailed, kFormatted, kUnchanged };
+    eState state = kFailed;
+    BatchFormatCacheEntry entry;
+    entry.m_signature = signature;
+
+    wxString original, content;
+    if(IsUnchanged(job, signature, entry.m_fingerprint)) {
+        state = kUnchanged;
+
+    } else if(!FileUtils::ReadFileContent(job.m_file, original)) {
+        clWARNING() << "CodeFormatter: Failed to load file: " << job.m_file << clEndl;
+
+    } else if(!FormatContent(job, original, content)) {
+        clWARNING() << "CodeFormatter: Failed to format file: " << job.m_file << clEndl;
+
+    } else if(content == original) {
+        // Already formatted
+        state = entry.m_fingerprint.Read(job.m_file) ? kUnchanged : kFailed;
+
+    } else if(!WriteFileAtomically(job.m_file, content)) {
+        clWARNING() << "CodeFormatter: Failed to save file: " << job.m_file << clEndl;
+
+    } else {
+        state = entry.m_fingerprint.Read(job.m_file) ? kFormatted : kFailed;
+    }
+
+    wxCriticalSectionLocker locker(m_cs);
+    switch(state) {
+    case kFormatted:
+        ++m_result.m_formatted;
+        break;
+    case kUnchanged:
+        ++m_result.m_unchanged;
+        break;
+    default:
+        ++m_result.m_failed;
+        break;
+    }
+    if(state != kFailed) { m_result.m_cache[job.m_file] = entry; }
+}
+
+void BatchFormatContext::Run(size_t index)
+{
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        if(m_result.m_cancelled) { return; }
+    }
+
+    const BatchFormatJob& job = m_jobs[index];
+    clDEBUG() << "CodeFormatter formatting file: " << job.m_file << clEndl;
+    RunJob(job);
+
+    size_t done;
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        done = ++m_done;
+    }
+    if(m_progress && !m_progress(done, job.m_file)) {
+        wxCriticalSectionLocker locker(m_cs);
+        m_result.m_cancelled = true;
+    }
+}
+
+BatchFormatThread::BatchFormatThread(CodeFormatter* formatter, const std::vector<BatchFormatJob>& jobs,
+                                     const BatchFormatSettings& settings, const BatchFormatCache_t& cache)
+    : wxThread(wxTHREAD_JOINABLE)
+    , m_formatter(formatter)
+    , m_jobs(jobs)
+    , m_settings(settings)
+    , m_cache(cache)
+    , m_cancelled(false)
+{
+}
+
+BatchFormatThread::~BatchFormatThread() {}
+
+void BatchFormatThread::Cancel()
+{
+    wxCriticalSectionLocker locker(m_cs);
+    m_cancelled = true;
+}
+
+bool BatchFormatThread::IsCancelled()
+{
+    wxCriticalSectionLocker locker(m_cs);
+    return m_cancelled;
+}
+
+void BatchFormatThread::Format(const std::vector<BatchFormatJob>& jobs, const BatchFormatSettings& settings,
+                               const BatchFormatCache_t& cache, BatchFormatResult& result,
+                               const std::function<bool(size_t, const wxString&)>& progress)
+{
+    if(jobs.empty()) { return; }
+
+    BatchFormatContext context(jobs, settings, cache, result, progress);
+    clWorkerPool pool(std::min(clWorkerPool::GetCPUCount(), (size_t)BATCH_FORMAT_MAX_WORKERS));
+    pool.ForEach(jobs.size(), [&](size_t index) { context.Run(index); });
+}
+
+void* BatchFormatThread::Entry()
+{
+    wxStopWatch sw;
+    wxCriticalSection progressCS;
+    long lastReport = -BATCH_FORMAT_PROGRESS_INTERVAL;
+
+    Format(m_jobs, m_settings, m_cache, m_result, [&](size_t done, const wxString& file) {
+        {
+            wxCriticalSectionLocker locker(progressCS);
+            if(done < m_jobs.size() && (sw.Time() - lastReport) < BATCH_FORMAT_PROGRESS_INTERVAL) {
+                return !IsCancelled();
+            }
+            lastReport = sw.Time();
+        }
+        m_formatter->CallAfter(&CodeFormatter::OnBatchFormatProgress, done, file);
+        return !IsCancelled();
+    });
+
+    m_result.m_cancelled = m_result.m_cancelled || IsCancelled();
+    m_formatter->CallAfter(&CodeFormatter::OnBatchFormatCompleted);
+    return NULL;
+}
@@ -0,0 +1,142 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2014 Eran Ifrah
+// file name            : BatchFormatThread.h
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BATCHFORMATTHREAD_H
+#define BATCHFORMATTHREAD_H
+
+#include "PHPFormatterBuffer.h"
+#include "codeformatter.h"
+#include "formatoptions.h"
+#include <functional>
+#include <vector>
+#include <wx/string.h>
+#include <wx/thread.h>
+
+/**
+ * @brief a file to format
+ */
+struct BatchFormatJob {
+    wxString m_file;
+    FormatterEngine m_engine;
+    wxString m_command; // php-cs-fixer / phpcbf: the command that formats m_tempFile in place
+    wxString m_tempFile;
+
+    BatchFormatJob()
+        : m_engine(kFormatEngineNone)
+    {
+    }
+};
+
+/**
+ * @brief a snapshot of the formatting settings, taken in the main thread so the workers don't access the
+ * configuration
+ */
+struct BatchFormatSettings {
+    FormatOptions m_options;
+    wxString m_astyleOptions;
+    wxString m_eol;
+    PHPFormatterOptions m_phpOptions;
+    int m_xmlIndent;
+
+    BatchFormatSettings()
+        : m_xmlIndent(4)
+    {
+    }
+
+    /**
+     * @brief a string that changes when the formatted output of a file may change
+     */
+    wxString GetSignature() const;
+};
+
+struct BatchFormatResult {
+    size_t m_formatted;
+    size_t m_unchanged; // already formatted, or skipped because it was not modified since it was formatted
+    size_t m_failed;
+    bool m_cancelled;
+    BatchFormatCache_t m_cache; // the new entries of the formatted files
+
+    BatchFormatResult()
+        : m_formatted(0)
+        , m_unchanged(0)
+        , m_failed(0)
+        , m_cancelled(false)
+    {
+    }
+};
+
+/**
+ * @class BatchFormatThread
+ * @brief format a list of files in the background. The files are formatted by a pool of threads: the in process
+ * engines (astyle, the PHP formatter, XML) use all of them, while the number of external formatters
+ * (clang-format, php-cs-fixer, phpcbf) that run at the same time is bounded.
+ * A file whose content did not change since it was last formatted with the same settings is skipped, and a
+ * formatted file is written to a temporary file which is then renamed over the original file, so a file is never
+ * left half written.
+ * The progress is reported with CodeFormatter::OnBatchFormatProgress() and the completion with
+ * CodeFormatter::OnBatchFormatCompleted()
+ */
+class BatchFormatThread : public wxThread
+{
+    CodeFormatter* m_formatter;
+    std::vector<BatchFormatJob> m_jobs;
+    BatchFormatSettings m_settings;
+    BatchFormatCache_t m_cache;
+    BatchFormatResult m_result;
+    wxCriticalSection m_cs;
+    bool m_cancelled;
+
+public:
+    BatchFormatThread(CodeFormatter* formatter, const std::vector<BatchFormatJob>& jobs,
+                      const BatchFormatSettings& settings, const BatchFormatCache_t& cache);
+    virtual ~BatchFormatThread();
+
+    /**
+     * @brief stop formatting. The files that are being formatted are completed
+     */
+    void Cancel();
+    bool IsCancelled();
+
+    /**
+     * @brief the result, available once the thread completed
+     */
+    const BatchFormatResult& GetResult() const { return m_result; }
+
+    /**
+     * @brief format 'jobs' using a pool of threads. The calling thread takes part in the work
+     * @param cache the state of the files when they were last formatted
+     * @param result [output]
+     * @param progress called (from any thread) after each file, with the number of files done. Returns false to
+     * cancel
+     */
+    static void Format(const std::vector<BatchFormatJob>& jobs, const BatchFormatSettings& settings,
+                       const BatchFormatCache_t& cache, BatchFormatResult& result,
+                       const std::function<bool(size_t, const wxString&)>& progress);
+
+protected:
+    virtual void* Entry();
+};
+
+#endif // BATCHFORMATTHREAD_H
@@ -22,6 +22,7 @@
 //
 //////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////
+#include "BatchFormatThread.h"
 #include "asyncprocess.h"
 #include "clEditorConfig.h"
 #include "clEditorStateLocker.h"
@@ -98,6 +99,8 @@ CL_PLUGIN_API int GetPluginInterfaceVersion() { return PLUGIN_INTERFACE_VERSION;
 
 CodeFormatter::CodeFormatter(IManager* manager)
     : IPlugin(manager)
+    , m_batchThread(nullptr)
+    , m_batchDlg(nullptr)
 {
     m_longName = _("Source Code Formatter");
     m_shortName = _("Source Code Formatter");
@@ -378,14 +381,19 @@ wxString CodeFormatter::RunCommand(const wxString& command)
     return output;
 }
 
+void CodeFormatter::DoGetPhpFormatterOptions(PHPFormatterOptions& options) const
+{
+    options.flags = m_options.GetPHPFormatterOptions();
+    if(m_mgr->GetEditorSettings()->GetIndentUsesTabs()) { options.flags |= kPFF_UseTabs; }
+    options.indentSize = m_mgr->GetEditorSettings()->GetTabWidth();
+    options.eol = m_mgr->GetEditorSettings()->GetEOLAsString();
+}
+
 void CodeFormatter::DoFormatWithBuildInPhp(wxString& content)
 {
     // Construct the formatting options
     PHPFormatterOptions phpOptions;
-    phpOptions.flags = m_options.GetPHPFormatterOptions();
-    if(m_mgr->GetEditorSettings()->GetIndentUsesTabs()) { phpOptions.flags |= kPFF_UseTabs; }
-    phpOptions.indentSize = m_mgr->GetEditorSettings()->GetTabWidth();
-    phpOptions.eol = m_mgr->GetEditorSettings()->GetEOLAsString();
+    DoGetPhpFormatterOptions(phpOptions);
 
     // Create the formatter buffer
     PHPFormatterBuffer buffer(content, phpOptions);
@@ -441,7 +449,7 @@ void CodeFormatter::DoFormatWithClang(wxString& content, const wxFileName& fileN
     if(selStart != wxNOT_FOUND) { content = content.Mid(selStart, content.length() - tailLength - selStart); }
 }
 
-void CodeFormatter::DoFormatWithAstyle(wxString& content, const bool& appendEOL)
+wxString CodeFormatter::DoGetAstyleOptions() const
 {
     wxString options = m_options.AstyleOptionsAsString();
 
@@ -450,7 +458,12 @@ void CodeFormatter::DoFormatWithAstyle(wxString& content, const bool& appendEOL)
     int tabWidth = m_mgr->GetEditorSettings()->GetTabWidth();
     int indentWidth = m_mgr->GetEditorSettings()->GetIndentWidth();
     options << (useTabs && tabWidth == indentWidth ? wxT(" -t") : wxT(" -s")) << indentWidth;
+    return options;
+}
 
+void CodeFormatter::DoFormatWithAstyle(wxString& content, const bool& appendEOL)
+{
+    wxString options = DoGetAstyleOptions();
     char* textOut = AStyleMain(_C(content), _C(options), ASErrorHandler, ASMemoryAlloc);
     content.clear();
     if(textOut) {
@@ -582,6 +595,17 @@ void CodeFormatter::UnPlug()
                                  this);
     EventNotifier::Get()->Unbind(wxEVT_PHP_SETTINGS_CHANGED, &CodeFormatter::OnPhpSettingsChanged, this);
     EventNotifier::Get()->Unbind(wxEVT_CONTEXT_MENU_FOLDER, &CodeFormatter::OnContextMenu, this);
+
+    // Stop the batch format (the files that are being formatted are completed)
+    if(m_batchThread) {
+        m_batchThread->Cancel();
+        m_batchThread->Wait(wxTHREAD_WAIT_BLOCK);
+        wxDELETE(m_batchThread);
+    }
+    if(m_batchDlg) {
+        m_batchDlg->Destroy();
+        m_batchDlg = nullptr;
+    }
 }
 
 IManager* CodeFormatter::GetManager() { return m_mgr; }
@@ -688,6 +712,35 @@ void CodeFormatter::OnFormatProject(wxCommandEvent& event)
     BatchFormat(filesToFormat, false);
 }
 
+void CodeFormatter::DoCreateBatchJobs(const std::vector<wxFileName>& files, std::vector<BatchFormatJob>& jobs)
+{
+    jobs.reserve(files.size());
+    std::for_each(files.begin(), files.end(), [&](const wxFileName& fn) {
+        BatchFormatJob job;
+        job.m_file = fn.GetFullPath();
+        job.m_engine = FindFormatter(fn);
+        if(job.m_engine == kFormatEngineNone) { return; }
+
+        // The external formatters and the XML formatter format a temporary copy of the file
+        job.m_tempFile = job.m_file + "-code-formatter-tmp." + fn.GetExt();
+        if(job.m_engine == kFormatEnginePhpCsFixer) {
+            m_options.GetPhpFixerCommand(job.m_tempFile, job.m_command);
+        } else if(job.m_engine == kFormatEnginePhpcbf) {
+            m_options.GetPhpcbfCommand(job.m_tempFile, job.m_command);
+        }
+        jobs.push_back(job);
+    });
+}
+
+void CodeFormatter::DoGetBatchSettings(BatchFormatSettings& settings) const
+{
+    settings.m_options = m_options;
+    settings.m_astyleOptions = DoGetAstyleOptions();
+    settings.m_eol = DoGetGlobalEOLString();
+    DoGetPhpFormatterOptions(settings.m_phpOptions);
+    settings.m_xmlIndent = m_mgr->GetEditorSettings()->GetIndentWidth();
+}
+
 void CodeFormatter::BatchFormat(const std::vector<wxFileName>& files, bool silent)
 {
     if(files.empty()) {
@@ -695,26 +748,77 @@ void CodeFormatter::BatchFormat(const std::vector<wxFileName>& files, bool silen
         return;
     }
 
-    wxProgressDialog* dlg = nullptr;
+    if(!silent && m_batchThread) {
+        ::wxMessageBox(_("Files are already being formatted"), _("Source Code Formatter"), wxOK | wxICON_WARNING);
+        return;
+    }
+
     if(!silent) {
         wxString msg;
         msg << _("You are about to beautify ") << files.size() << _(" files\nContinue?");
         if(wxYES != ::wxMessageBox(msg, _("Source Code Formatter"), wxYES_NO | wxCANCEL | wxCENTER)) { return; }
+    }
 
-        dlg = new wxProgressDialog(_("Source Code Formatter"), _("Formatting files..."), (int)files.size(),
-                                   m_mgr->GetTheApp()->GetTopWindow());
+    std::vector<BatchFormatJob> jobs;
+    DoCreateBatchJobs(files, jobs);
+    BatchFormatSettings settings;
+    DoGetBatchSettings(settings);
+
+    if(!silent) {
+        BatchFormatThread* thread = new BatchFormatThread(this, jobs, settings, m_batchCache);
+        if((thread->Create() == wxTHREAD_NO_ERROR) && (thread->Run() == wxTHREAD_NO_ERROR)) {
+            m_batchThread = thread;
+            m_batchDlg = new wxProgressDialog(_("Source Code Formatter"), _("Formatting files..."), (int)jobs.size(),
+                                              m_mgr->GetTheApp()->GetTopWindow(),
+                                              wxPD_AUTO_HIDE | wxPD_CAN_ABORT | wxPD_ELAPSED_TIME);
+            return;
+        }
+        clWARNING() << "CodeFormatter: failed to start the batch format thread" << clEndl;
+        delete thread;
     }
-    for(size_t i = 0; i < files.size(); ++i) {
-        wxString msg;
-        msg << "[ " << i << " / " << files.size() << " ] " << files.at(i).GetFullName();
-        if(dlg) { dlg->Update(i, msg); }
 
-        FormatterEngine engine = FindFormatter(files.at(i).GetFullPath());
-        DoFormatFile(files.at(i).GetFullPath(), engine);
+    // Format the files before returning
+    BatchFormatResult result;
+    BatchFormatThread::Format(jobs, settings, m_batchCache, result, nullptr);
+    DoBatchFormatCompleted(result);
+}
+
+void CodeFormatter::OnBatchFormatProgress(size_t done, const wxString& file)
+{
+    if(!m_batchDlg || !m_batchThread) { return; }
+
+    wxString msg;
+    msg << "[ " << done << " / " << m_batchDlg->GetRange() << " ] " << wxFileName(file).GetFullName();
+    if(!m_batchDlg->Update(done, msg)) {
+        // Cancelled by the user
+        m_batchThread->Cancel();
+    }
+}
+
+void CodeFormatter::OnBatchFormatCompleted()
+{
+    CHECK_PTR_RET(m_batchThread);
+
+    m_batchThread->Wait(wxTHREAD_WAIT_BLOCK);
+    DoBatchFormatCompleted(m_batchThread->GetResult());
+    wxDELETE(m_batchThread);
+
+    if(m_batchDlg) {
+        m_batchDlg->Destroy();
+        m_batchDlg = nullptr;
     }
+}
+
+void CodeFormatter::DoBatchFormatCompleted(const BatchFormatResult& result)
+{
+    // Remember the formatted files, so they are skipped until they are modified
+    std::for_each(result.m_cache.begin(), result.m_cache.end(),
+                  [&](const BatchFormatCache_t::value_type& vt) { m_batchCache[vt.first] = vt.second; });
 
-    if(dlg) { dlg->Destroy(); }
-    EventNotifier::Get()->PostReloadExternallyModifiedEvent(false);
+    clDEBUG() << "CodeFormatter: batch format completed." << result.m_formatted << "files formatted,"
+              << result.m_unchanged << "unchanged," << result.m_failed << "failed"
+              << (result.m_cancelled ? "(cancelled)" : "") << clEndl;
+    if(result.m_formatted) { EventNotifier::Get()->PostReloadExternallyModifiedEvent(false); }
 }
 
 void CodeFormatter::OnBeforeFileSave(clCommandEvent& e)
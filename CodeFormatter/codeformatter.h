@@ -25,10 +25,14 @@
 #ifndef CODEFORMATTER_H
 #define CODEFORMATTER_H
 
+#include "clFileFingerprint.h"
 #include "cl_command_event.h"
 #include "fileextmanager.h"
 #include "formatoptions.h"
 #include "plugin.h"
+#include "wxStringHash.h"
+#include <unordered_map>
+#include <vector>
 
 enum FormatterEngine {
     kFormatEngineNone,
@@ -40,10 +44,29 @@ enum FormatterEngine {
     kFormatEngineWxXmlDocument,
 };
 
+/**
+ * @brief the state of a file the last time it was formatted by a batch
+ */
+struct BatchFormatCacheEntry {
+    clFileFingerprint m_fingerprint; // the file after it was formatted
+    wxString m_signature;            // the settings used to format it
+};
+typedef std::unordered_map<wxString, BatchFormatCacheEntry> BatchFormatCache_t;
+
+class BatchFormatThread;
+struct BatchFormatJob;
+struct BatchFormatResult;
+struct BatchFormatSettings;
+struct PHPFormatterOptions;
+class wxProgressDialog;
+
 class CodeFormatter : public IPlugin
 {
     FormatOptions m_options;
     PhpOptions m_optionsPhp;
+    BatchFormatThread* m_batchThread;
+    wxProgressDialog* m_batchDlg;
+    BatchFormatCache_t m_batchCache;
 
 protected:
     wxString m_selectedFolder;
@@ -84,6 +107,12 @@ private:
         const int& selEnd = wxNOT_FOUND);
     void DoFormatWithAstyle(wxString& content, const bool& appendEOL = true);
     void DoFormatWithWxXmlDocument(const wxFileName& fileName);
+    wxString DoGetAstyleOptions() const;
+    void DoGetPhpFormatterOptions(PHPFormatterOptions& options) const;
+
+    void DoCreateBatchJobs(const std::vector<wxFileName>& files, std::vector<BatchFormatJob>& jobs);
+    void DoGetBatchSettings(BatchFormatSettings& settings) const;
+    void DoBatchFormatCompleted(const BatchFormatResult& result);
 
     void OnPhpSettingsChanged(clCommandEvent& event);
 
@@ -91,9 +120,11 @@ public:
     wxString RunCommand(const wxString& command);
 
     /**
-     * @brief format list of files
+     * @brief format list of files. Unless 'silent' is set, the files are formatted in the background
      */
     void BatchFormat(const std::vector<wxFileName>& files, bool silent = true);
+    void OnBatchFormatProgress(size_t done, const wxString& file);
+    void OnBatchFormatCompleted();
     void OnContextMenu(clContextMenuEvent& event);
 
     CodeFormatter(IManager* manager);
@@ -1,14 +1,16 @@
 #include "CxxScannerBase.h"
 #include "CxxPreProcessor.h"
-#include "fileutils.h"
+#include "clFileContentCache.h"
 
 CxxScannerBase::CxxScannerBase(CxxPreProcessor* preProcessor, const wxFileName& filename)
     : m_scanner(NULL)
     , m_filename(filename)
     , m_preProcessor(preProcessor)
 {
+    // The same headers are scanned for every file that includes them
     wxString content;
-    FileUtils::ReadFileContent(filename, content, wxConvISO8859_1);
+    clFileContent::Ptr_t file = clFileContentCache::Get().Load(filename.GetFullPath());
+    if(file) { content = file->GetText(wxFONTENCODING_ISO8859_1); }
     m_scanner = ::LexerNew(content, m_preProcessor->GetOptions());
 }
 
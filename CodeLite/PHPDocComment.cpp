@@ -11,7 +11,8 @@ PHPDocComment::PHPDocComment(PHPSourceFile& sourceFile, const wxString& comment)
     : m_sourceFile(sourceFile)
     , m_comment(comment)
 {
-    static std::unordered_set<wxString> nativeTypes;
+    // Per thread: doc comments are parsed by multiple threads when the workspace is indexed
+    static thread_local std::unordered_set<wxString> nativeTypes;
     if(nativeTypes.empty()) {
         nativeTypes.insert("int");
         nativeTypes.insert("integer");
@@ -28,7 +29,7 @@ PHPDocComment::PHPDocComment(PHPSourceFile& sourceFile, const wxString& comment)
         nativeTypes.insert("null");
     }
 
-    static wxRegEx reReturnStatement(wxT("@(return)[ \t]+([\\a-zA-Z_]{1}[\\|\\a-zA-Z0-9_]*)"));
+    static thread_local wxRegEx reReturnStatement(wxT("@(return)[ \t]+([\\a-zA-Z_]{1}[\\|\\a-zA-Z0-9_]*)"));
     if(reReturnStatement.IsValid() && reReturnStatement.Matches(m_comment)) {
         wxString returnValue = reReturnStatement.GetMatch(m_comment, 2);
         wxArrayString types = ::wxStringTokenize(returnValue, "|", wxTOKEN_STRTOK);
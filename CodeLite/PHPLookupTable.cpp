@@ -4,6 +4,7 @@
 #include "PHPEntityNamespace.h"
 #include "PHPEntityVariable.h"
 #include "PHPLookupTable.h"
+#include "clWorkerPool.h"
 #include "event_notifier.h"
 #include "file_logger.h"
 #include "fileextmanager.h"
@@ -11,10 +12,22 @@
 #include <algorithm>
 #include <wx/filename.h>
 #include <wx/log.h>
+#include <wx/msgqueue.h>
+#include <wx/sharedptr.h>
 #include <wx/stopwatch.h>
 #include <wx/tokenzr.h>
 #include "clFilesCollector.h"
 
+// The parsed files are committed to the database in batches of this size
+#define PHP_INDEX_FILES_PER_TRANSACTION 1000
+// The number of parsed files waiting to be stored. This bounds the memory used when the database is slower than
+// the parsers
+#define PHP_INDEX_QUEUE_SIZE 256
+#define PHP_INDEX_MAX_WORKERS 8
+// Files are stored with the time they were parsed but may be committed a little later: the class hierarchy cache
+// checks for files parsed since its last check, minus this number of seconds
+#define PHP_CLASS_CACHE_TIMESTAMP_SLACK 2
+
 wxDEFINE_EVENT(wxPHP_PARSE_STARTED, clParseEvent);
 wxDEFINE_EVENT(wxPHP_PARSE_ENDED, clParseEvent);
 wxDEFINE_EVENT(wxPHP_PARSE_PROGRESS, clParseEvent);
@@ -158,10 +171,47 @@ const static wxString CREATE_FILES_TABLE_SQL =
     ")";
 const static wxString CREATE_FILES_TABLE_SQL_IDX1 =
     "CREATE UNIQUE INDEX IF NOT EXISTS FILES_TABLE_IDX_1 ON FILES_TABLE(FILE_NAME)";
+const static wxString CREATE_FILES_TABLE_SQL_IDX2 =
+    "CREATE INDEX IF NOT EXISTS FILES_TABLE_IDX_2 ON FILES_TABLE(LAST_UPDATED)";
 
 PHPLookupTable::PHPLookupTable()
     : m_sizeLimit(50)
+    , m_classCacheTime(0)
+{
+}
+
+/**
+ * @brief return 'var' with its type taken from the PHPDoc 'docs'. Cached entities are shared, so the variable is
+ * copied when its type changes
+ */
+static PHPEntityBase::Ptr_t ApplyVarDocComment(PHPEntityBase::Ptr_t var, const PHPDocVar::Map_t& docs)
+{
+    if(!var->Is(kEntityTypeVariable)) { return var; }
+    PHPDocVar::Map_t::const_iterator iter = docs.find(var->GetShortName());
+    if(iter == docs.end()) { return var; }
+
+    const wxString& type = iter->second->GetType();
+    if(type.IsEmpty() || type == var->Cast<PHPEntityVariable>()->GetTypeHint()) { return var; }
+    PHPEntityBase::Ptr_t copy(new PHPEntityVariable(*var->Cast<PHPEntityVariable>()));
+    copy->Cast<PHPEntityVariable>()->SetTypeHint(type);
+    return copy;
+}
+
+/**
+ * @brief the in memory version of DoAddNameFilter(). 'name' is the trimmed name hint and 'lcName' its lower case
+ * version (LIKE is case insensitive)
+ */
+static bool MatchesNameHint(const wxString& entityName, const wxString& name, const wxString& lcName, size_t flags)
 {
+    if(name.IsEmpty()) { return true; }
+    if(flags & PHPLookupTable::kLookupFlags_ExactMatch) {
+        return entityName == name;
+    } else if(flags & PHPLookupTable::kLookupFlags_Contains) {
+        return entityName.Lower().Contains(lcName);
+    } else if(flags & PHPLookupTable::kLookupFlags_StartsWith) {
+        return entityName.Lower().StartsWith(lcName);
+    }
+    return true;
 }
 
 PHPLookupTable::~PHPLookupTable() { Close(); }
@@ -171,20 +221,18 @@ PHPEntityBase::Ptr_t PHPLookupTable::FindMemberOf(wxLongLong parentDbId, const w
     // find the entity
     PHPEntityBase::Ptr_t scope = DoFindScope(parentDbId);
     if(scope && scope->Cast<PHPEntityClass>()) {
-        std::vector<wxLongLong> parents;
-        std::set<wxLongLong> parentsVisited;
-
-        DoGetInheritanceParentIDs(scope, parents, parentsVisited, flags & kLookupFlags_Parent);
-        // std::reverse(parents.begin(), parents.end());
-
-        // Parents should now contain an ordered list of all the inheritance
-        for(size_t i = 0; i < parents.size(); ++i) {
-            PHPEntityBase::Ptr_t match = DoFindMemberOf(parents.at(i), exactName);
+        DoValidateClassHierarchyCache();
+        ClassCacheEntry* entry = DoGetClassCacheEntry(parentDbId, scope);
+        if(!entry) { return PHPEntityBase::Ptr_t(NULL); }
+        DoLoadClassHierarchy(*entry);
+
+        // Parents contains an ordered list of all the inheritance
+        const std::vector<wxLongLong>& parents = entry->m_parents;
+        for(size_t i = (flags & kLookupFlags_Parent) ? 1 : 0; i < parents.size(); ++i) {
+            PHPEntityBase::Ptr_t match = DoFindCachedMemberOf(parents.at(i), exactName);
             if(match) {
-                PHPEntityBase::List_t matches;
-                matches.push_back(match);
-                DoFixVarsDocComment(matches, parentDbId);
-                return match;
+                // Let the class PHPDoc override the type of the member
+                return ApplyVarDocComment(match, entry->m_docs);
             }
         }
     } else {
@@ -311,6 +359,7 @@ void PHPLookupTable::CreateSchema()
         // Files
         m_db.ExecuteUpdate(CREATE_FILES_TABLE_SQL);
         m_db.ExecuteUpdate(CREATE_FILES_TABLE_SQL_IDX1);
+        m_db.ExecuteUpdate(CREATE_FILES_TABLE_SQL_IDX2);
 
         // Update the schema version
         wxSQLite3Statement st =
@@ -499,20 +548,302 @@ PHPEntityBase::Ptr_t PHPLookupTable::DoFindMemberOf(wxLongLong parentDbId, const
 }
 
 void PHPLookupTable::DoGetInheritanceParentIDs(PHPEntityBase::Ptr_t cls, std::vector<wxLongLong>& parents,
-                                               std::set<wxLongLong>& parentsVisited, bool excludeSelf)
+                                               std::set<wxLongLong>& parentsVisited, bool excludeSelf,
+                                               wxStringSet_t& files, bool& complete)
 {
     if(!excludeSelf) { parents.push_back(cls->GetDbId()); }
 
     parentsVisited.insert(cls->GetDbId());
+    files.insert(cls->GetFilename().GetFullPath());
     wxArrayString parentsArr = cls->Cast<PHPEntityClass>()->GetInheritanceArray();
     for(size_t i = 0; i < parentsArr.GetCount(); ++i) {
         PHPEntityBase::Ptr_t parent = FindClass(parentsArr.Item(i));
-        if(parent && !parentsVisited.count(parent->GetDbId())) {
-            DoGetInheritanceParentIDs(parent, parents, parentsVisited, false);
+        if(!parent) {
+            complete = false;
+        } else if(!parentsVisited.count(parent->GetDbId())) {
+            DoGetInheritanceParentIDs(parent, parents, parentsVisited, false, files, complete);
+        }
+    }
+}
+
+PHPLookupTable::ClassCacheEntry* PHPLookupTable::DoGetClassCacheEntry(wxLongLong id, PHPEntityBase::Ptr_t cls)
+{
+    ClassCache_t::iterator iter = m_classCache.find(id.GetValue());
+    if(iter != m_classCache.end()) { return &iter->second; }
+
+    if(!cls) { cls = FindClass(id); }
+    if(!cls || !cls->Is(kEntityTypeClass)) { return NULL; }
+
+    // The map is node based: the entries addresses remain valid when new classes are added
+    ClassCacheEntry& entry = m_classCache[id.GetValue()];
+    entry.m_class = cls;
+    DoLoadClassMembers(entry);
+    return &entry;
+}
+
+void PHPLookupTable::DoLoadClassMembers(ClassCacheEntry& entry)
+{
+    wxLongLong classId = entry.m_class->GetDbId();
+    entry.m_files.insert(entry.m_class->GetFilename().GetFullPath());
+    try {
+        // Load all the members at once, the lookups filter them in memory
+        {
+            wxString sql;
+            sql << "SELECT * from SCOPE_TABLE WHERE SCOPE_ID=" << classId << " AND SCOPE_TYPE = 1";
+            wxSQLite3Statement st = m_db.PrepareStatement(sql);
+            wxSQLite3ResultSet res = st.ExecuteQuery();
+            while(res.NextRow()) {
+                PHPEntityBase::Ptr_t match(new PHPEntityClass());
+                match->FromResultSet(res);
+                entry.m_members.push_back(match);
+            }
+        }
+
+        {
+            wxString sql;
+            sql << "SELECT * from FUNCTION_TABLE WHERE SCOPE_ID=" << classId;
+            wxSQLite3Statement st = m_db.PrepareStatement(sql);
+            wxSQLite3ResultSet res = st.ExecuteQuery();
+            while(res.NextRow()) {
+                PHPEntityBase::Ptr_t match(new PHPEntityFunction());
+                match->FromResultSet(res);
+                entry.m_members.push_back(match);
+            }
+        }
+
+        {
+            wxString sql;
+            sql << "SELECT * from FUNCTION_ALIAS_TABLE WHERE SCOPE_ID=" << classId;
+            wxSQLite3Statement st = m_db.PrepareStatement(sql);
+            wxSQLite3ResultSet res = st.ExecuteQuery();
+            while(res.NextRow()) {
+                PHPEntityBase::Ptr_t match(new PHPEntityFunctionAlias());
+                match->FromResultSet(res);
+                PHPEntityBase::Ptr_t pFunc = FindFunction(match->Cast<PHPEntityFunctionAlias>()->GetRealname());
+                if(pFunc) {
+                    match->Cast<PHPEntityFunctionAlias>()->SetFunc(pFunc);
+                    entry.m_members.push_back(match);
+                    entry.m_files.insert(pFunc->GetFilename().GetFullPath());
+                }
+            }
+        }
+
+        {
+            wxString sql;
+            sql << "SELECT * from VARIABLES_TABLE WHERE SCOPE_ID=" << classId;
+            wxSQLite3Statement st = m_db.PrepareStatement(sql);
+            wxSQLite3ResultSet res = st.ExecuteQuery();
+            while(res.NextRow()) {
+                PHPEntityBase::Ptr_t match(new PHPEntityVariable());
+                match->FromResultSet(res);
+                entry.m_members.push_back(match);
+            }
+        }
+
+        {
+            wxString sql;
+            sql << "SELECT * from PHPDOC_VAR_TABLE WHERE SCOPE_ID=" << classId;
+            wxSQLite3Statement st = m_db.PrepareStatement(sql);
+            wxSQLite3ResultSet res = st.ExecuteQuery();
+            while(res.NextRow()) {
+                PHPDocVar::Ptr_t var(new PHPDocVar());
+                var->FromResultSet(res);
+                entry.m_docs.insert(std::make_pair(var->GetName(), var));
+            }
+        }
+
+    } catch(wxSQLite3Exception& e) {
+        // Don't keep a partial entry for long
+        entry.m_complete = false;
+        CL_WARNING("PHPLookupTable::DoLoadClassMembers: %s", e.GetMessage());
+    }
+
+    // The members are not shared yet: apply the class PHPDoc to its variables in place
+    for(size_t i = 0; i < entry.m_members.size(); ++i) {
+        PHPEntityBase::Ptr_t member = entry.m_members[i];
+        entry.m_files.insert(member->GetFilename().GetFullPath());
+        if(!member->Is(kEntityTypeVariable)) { continue; }
+        PHPDocVar::Map_t::const_iterator iter = entry.m_docs.find(member->GetShortName());
+        if(iter != entry.m_docs.end() && !iter->second->GetType().IsEmpty()) {
+            member->Cast<PHPEntityVariable>()->SetTypeHint(iter->second->GetType());
+        }
+    }
+}
+
+void PHPLookupTable::DoLoadClassHierarchy(ClassCacheEntry& entry)
+{
+    if(entry.m_hierarchyLoaded) { return; }
+    std::set<wxLongLong> parentsVisited;
+    DoGetInheritanceParentIDs(entry.m_class, entry.m_parents, parentsVisited, false, entry.m_files,
+                              entry.m_complete);
+    entry.m_hierarchyLoaded = true;
+}
+
+const std::vector<PHPLookupTable::ClassCacheMember>& PHPLookupTable::DoGetFlatMembers(ClassCacheEntry& entry,
+                                                                                     bool excludeSelf)
+{
+    int which = excludeSelf ? 1 : 0;
+    std::vector<ClassCacheMember>& flat = entry.m_flat[which];
+    if(entry.m_flatLoaded[which]) { return flat; }
+
+    DoLoadClassHierarchy(entry);
+    // Base classes first. Like DoFindChildren(), the PHPDoc of every class overrides the type of the variables it
+    // inherits
+    size_t first = excludeSelf ? 1 : 0;
+    for(size_t i = entry.m_parents.size(); i > first; --i) {
+        ClassCacheEntry* parent = DoGetClassCacheEntry(entry.m_parents.at(i - 1));
+        if(!parent) {
+            entry.m_complete = false;
+            continue;
+        }
+        for(size_t j = 0; j < flat.size(); ++j) {
+            flat[j].m_entity = ApplyVarDocComment(flat[j].m_entity, parent->m_docs);
+        }
+        for(size_t j = 0; j < parent->m_members.size(); ++j) {
+            flat.push_back(ClassCacheMember(parent->m_members[j], i - 1));
+        }
+        if(parent != &entry) { entry.m_files.insert(parent->m_files.begin(), parent->m_files.end()); }
+    }
+    entry.m_flatLoaded[which] = true;
+    return flat;
+}
+
+void PHPLookupTable::DoFilterMembers(const std::vector<ClassCacheMember>& members, PHPEntityBase::List_t& matches,
+                                     size_t flags, const wxString& nameHint)
+{
+    wxString name = nameHint;
+    name.Trim().Trim(false);
+    wxString lcName = name.Lower();
+
+    // Like DoFindChildren(), take up to m_sizeLimit classes, functions, aliases and variables from each class
+    enum { kClass, kFunction, kAlias, kVariable, kKindsCount };
+    size_t counts[kKindsCount] = { 0 };
+    size_t owner = wxString::npos;
+    for(size_t i = 0; i < members.size(); ++i) {
+        const ClassCacheMember& member = members[i];
+        if(member.m_owner != owner) {
+            owner = member.m_owner;
+            std::fill(counts, counts + kKindsCount, 0);
+        }
+
+        PHPEntityBase::Ptr_t match = member.m_entity;
+        int kind = kVariable;
+        if(match->Is(kEntityTypeClass)) {
+            if(flags & kLookupFlags_FunctionsAndConstsOnly) { continue; }
+            kind = kClass;
+        } else if(match->Is(kEntityTypeFunction)) {
+            kind = kFunction;
+        } else if(match->Is(kEntityTypeFunctionAlias)) {
+            kind = kAlias;
+        }
+
+        if(!MatchesNameHint(match->GetShortName(), name, lcName, flags)) { continue; }
+        if(counts[kind]++ >= m_sizeLimit) { continue; }
+
+        if(kind == kFunction) {
+            // always return static functions
+            if(match->HasFlag(kFunc_Static) || !(flags & kLookupFlags_Static)) { matches.push_back(match); }
+
+        } else if(kind == kVariable) {
+            PHPEntityVariable* var = match->Cast<PHPEntityVariable>();
+            if((flags & kLookupFlags_FunctionsAndConstsOnly) && !var->IsConst() && !var->IsDefine()) { continue; }
+            bool isConst = var->IsConst();
+            bool isStatic = var->IsStatic();
+            bool bAddIt = ((isStatic || isConst) && CollectingStatics(flags)) ||
+                          (!isStatic && !isConst && !CollectingStatics(flags));
+            if(bAddIt) { matches.push_back(match); }
+
+        } else {
+            matches.push_back(match);
+        }
+    }
+}
+
+PHPEntityBase::Ptr_t PHPLookupTable::DoFindCachedMemberOf(wxLongLong classId, const wxString& exactName)
+{
+    ClassCacheEntry* entry = DoGetClassCacheEntry(classId);
+    if(!entry) { return PHPEntityBase::Ptr_t(NULL); }
+
+    wxString nameWDollar, namwWODollar;
+    nameWDollar = exactName;
+    if(exactName.StartsWith("$")) {
+        namwWODollar = exactName.Mid(1);
+    } else {
+        namwWODollar = exactName;
+        nameWDollar.Prepend("$");
+    }
+
+    // Same as DoFindMemberOf(): search the functions, then the function aliases and then the variables. More than
+    // one match means no match
+    PHPEntityBase::List_t functions, aliases, variables;
+    for(size_t i = 0; i < entry->m_members.size(); ++i) {
+        PHPEntityBase::Ptr_t member = entry->m_members[i];
+        const wxString& name = member->GetShortName();
+        if(member->Is(kEntityTypeFunction) && name == exactName) {
+            functions.push_back(member);
+        } else if(member->Is(kEntityTypeFunctionAlias) && name == exactName) {
+            aliases.push_back(member);
+        } else if(member->Is(kEntityTypeVariable) && (name == nameWDollar || name == namwWODollar)) {
+            variables.push_back(member);
+        }
+    }
+
+    const PHPEntityBase::List_t& matches = !functions.empty() ? functions : (!aliases.empty() ? aliases : variables);
+    if(matches.size() != 1) { return PHPEntityBase::Ptr_t(NULL); }
+    return matches.at(0);
+}
+
+void PHPLookupTable::DoValidateClassHierarchyCache()
+{
+    time_t now = time(NULL);
+    if(m_classCache.empty()) {
+        m_classCacheTime = now;
+        return;
+    }
+
+    // The files parsed since the last check, by this instance or by another process / thread
+    wxStringSet_t files;
+    try {
+        wxSQLite3Statement st =
+            m_db.PrepareStatement("SELECT FILE_NAME FROM FILES_TABLE WHERE LAST_UPDATED >= :LAST_UPDATED");
+        st.Bind(st.GetParamIndex(":LAST_UPDATED"), (wxLongLong)(m_classCacheTime - PHP_CLASS_CACHE_TIMESTAMP_SLACK));
+        wxSQLite3ResultSet res = st.ExecuteQuery();
+        while(res.NextRow()) {
+            files.insert(res.GetString("FILE_NAME"));
+        }
+
+    } catch(wxSQLite3Exception& e) {
+        CL_WARNING("PHPLookupTable::DoValidateClassHierarchyCache: %s", e.GetMessage());
+        DoClearClassHierarchyCache();
+        return;
+    }
+
+    m_classCacheTime = now;
+    if(!files.empty()) { DoInvalidateClassHierarchyCache(files); }
+}
+
+void PHPLookupTable::DoInvalidateClassHierarchyCache(const wxStringSet_t& files)
+{
+    ClassCache_t::iterator iter = m_classCache.begin();
+    while(iter != m_classCache.end()) {
+        const ClassCacheEntry& entry = iter->second;
+        // A class with a missing parent may be completed by any file
+        bool remove = !entry.m_complete;
+        wxStringSet_t::const_iterator fileIter = files.begin();
+        for(; !remove && fileIter != files.end(); ++fileIter) {
+            remove = entry.m_files.count(*fileIter) != 0;
+        }
+
+        if(remove) {
+            iter = m_classCache.erase(iter);
+        } else {
+            ++iter;
         }
     }
 }
 
+void PHPLookupTable::DoClearClassHierarchyCache() { m_classCache.clear(); }
+
 PHPEntityBase::Ptr_t PHPLookupTable::DoFindScope(const wxString& fullname, ePhpScopeType scopeType)
 {
     // locate the scope
@@ -599,16 +930,12 @@ PHPEntityBase::List_t PHPLookupTable::FindChildren(wxLongLong parentId, size_t f
     PHPEntityBase::List_t matches, matchesNoAbstracts;
     PHPEntityBase::Ptr_t scope = DoFindScope(parentId);
     if(scope && scope->Is(kEntityTypeClass)) {
-        std::vector<wxLongLong> parents;
-        std::set<wxLongLong> parentsVisited;
+        DoValidateClassHierarchyCache();
+        ClassCacheEntry* entry = DoGetClassCacheEntry(parentId, scope);
+        if(!entry) { return matches; }
 
-        DoGetInheritanceParentIDs(scope, parents, parentsVisited, flags & kLookupFlags_Parent);
-        // Reverse the order of the parents
-        std::reverse(parents.begin(), parents.end());
-
-        for(size_t i = 0; i < parents.size(); ++i) {
-            DoFindChildren(matches, parents.at(i), flags, nameHint);
-        }
+        // The members of the class and its parents, base classes first
+        DoFilterMembers(DoGetFlatMembers(*entry, flags & kLookupFlags_Parent), matches, flags, nameHint);
 
         // Filter out abstract functions
         if(!(flags & kLookupFlags_IncludeAbstractMethods)) {
@@ -805,6 +1132,11 @@ void PHPLookupTable::DeleteFileEntries(const wxFileName& filename, bool autoComm
         }
 
         if(autoCommit) m_db.Commit();
+
+        wxStringSet_t files;
+        files.insert(filename.GetFullPath());
+        DoInvalidateClassHierarchyCache(files);
+
     } catch(wxSQLite3Exception& e) {
         if(autoCommit) m_db.Rollback();
         CL_WARNING("PHPLookupTable::DeleteFileEntries: %s", e.GetMessage());
@@ -816,7 +1148,8 @@ void PHPLookupTable::Close()
     try {
         if(m_db.IsOpen()) { m_db.Close(); }
         m_filename.Clear();
-        m_allClasses.clear();
+        DoClearClassCache();
+        DoClearClassHierarchyCache();
 
     } catch(wxSQLite3Exception& e) {
         CL_WARNING("PHPLookupTable::Close: %s", e.GetMessage());
@@ -944,6 +1277,18 @@ wxLongLong PHPLookupTable::GetFileLastParsedTimestamp(const wxFileName& filename
     return 0;
 }
 
+void PHPLookupTable::LoadFilesLastParsedTimestamp(std::unordered_map<wxString, wxLongLong>& timestamps)
+{
+    try {
+        wxSQLite3ResultSet res = m_db.ExecuteQuery("SELECT FILE_NAME, LAST_UPDATED FROM FILES_TABLE");
+        while(res.NextRow()) {
+            timestamps[res.GetString("FILE_NAME")] = res.GetInt64("LAST_UPDATED");
+        }
+    } catch(wxSQLite3Exception& e) {
+        CL_WARNING("PHPLookupTable::LoadFilesLastParsedTimestamp: %s", e.GetMessage());
+    }
+}
+
 void PHPLookupTable::UpdateFileLastParsedTimestamp(const wxFileName& filename)
 {
     try {
@@ -998,6 +1343,8 @@ void PHPLookupTable::ClearAll(bool autoCommit)
         }
 
         if(autoCommit) m_db.Commit();
+        DoClearClassHierarchyCache();
+
     } catch(wxSQLite3Exception& e) {
         if(autoCommit) m_db.Rollback();
         CL_WARNING("PHPLookupTable::ClearAll: %s", e.GetMessage());
@@ -1296,16 +1643,28 @@ void PHPLookupTable::DoFixVarsDocComment(PHPEntityBase::List_t& matches, wxLongL
 
 void PHPLookupTable::UpdateClassCache(const wxString& classname)
 {
+    wxCriticalSectionLocker locker(m_allClassesLock);
     if(m_allClasses.count(classname) == 0) { m_allClasses.insert(classname); }
 }
 
-bool PHPLookupTable::ClassExists(const wxString& classname) const { return m_allClasses.count(classname) != 0; }
+bool PHPLookupTable::ClassExists(const wxString& classname) const
+{
+    wxCriticalSectionLocker locker(m_allClassesLock);
+    return m_allClasses.count(classname) != 0;
+}
+
+void PHPLookupTable::DoClearClassCache()
+{
+    wxCriticalSectionLocker locker(m_allClassesLock);
+    m_allClasses.clear();
+}
 
 void PHPLookupTable::RebuildClassCache()
 {
     // locate the scope
     clDEBUG() << "Rebuilding PHP class cache..." << clEndl;
-    m_allClasses.clear();
+    DoClearClassCache();
+    DoClearClassHierarchyCache();
     size_t count = 0;
     try {
         wxString sql;
@@ -1424,3 +1783,232 @@ void PHPLookupTable::ParseFolder(const wxString& folder, const wxString& filemas
         }
     });
 }
+
+typedef wxSharedPtr<PHPSourceFile> PHPSourceFilePtr_t;
+
+/**
+ * @class PHPIndexerContext
+ * @brief the files to parse and the queue of parsed files, shared by the parsing threads and the thread that stores
+ * the files into the database
+ */
+class PHPIndexerContext
+{
+    const std::vector<wxString>& m_files;
+    PHPLookupTable* m_lookup;
+    bool m_parseFuncBodies;
+    size_t m_next;
+    bool m_stop;
+    wxCriticalSection m_cs;
+    wxMessageQueue<PHPSourceFilePtr_t> m_parsed; // NULL for files that could not be read
+    wxSemaphore m_slots;                         // free places in m_parsed
+
+public:
+    PHPIndexerContext(const std::vector<wxString>& files, PHPLookupTable* lookup, bool parseFuncBodies)
+        : m_files(files)
+        , m_lookup(lookup)
+        , m_parseFuncBodies(parseFuncBodies)
+        , m_next(0)
+        , m_stop(false)
+        , m_slots(PHP_INDEX_QUEUE_SIZE, 0)
+    {
+    }
+
+    /**
+     * @brief parse the next file and queue it. Return false when there are no more files or when the indexing
+     * was stopped
+     */
+    bool ParseNext()
+    {
+        size_t index;
+        {
+            wxCriticalSectionLocker locker(m_cs);
+            if(m_stop || m_next >= m_files.size()) { return false; }
+            index = m_next++;
+        }
+
+        PHPSourceFilePtr_t source(NULL);
+        wxFileName fnSourceFile(m_files[index]);
+        wxString content;
+        // Read the file directly: the files of a bulk parse would only evict the files the user works on from
+        // clFileContentCache
+        if(FileUtils::ReadFileContent(fnSourceFile, content, wxConvISO8859_1)) {
+            source.reset(new PHPSourceFile(content, m_lookup));
+            source->SetFilename(fnSourceFile);
+            source->SetParseFunctionBody(m_parseFuncBodies);
+            // The classes are stored by another thread while we parse: checking them here would make the result
+            // depend on the order the files are parsed in
+            source->SetDeferClassLookup(true);
+            source->Parse();
+        } else {
+            clWARNING() << "PHP: Failed to read file:" << fnSourceFile << "for parsing" << clEndl;
+        }
+
+        m_slots.Wait();
+        m_parsed.Post(source);
+        return true;
+    }
+
+    /**
+     * @brief wait up to 'timeout' milliseconds for a parsed file
+     */
+    bool Receive(PHPSourceFilePtr_t& source, long timeout)
+    {
+        if(m_parsed.ReceiveTimeout(timeout, source) != wxMSGQUEUE_NO_ERROR) { return false; }
+        m_slots.Post();
+        return true;
+    }
+
+    /**
+     * @brief stop the parsing threads. A thread waiting for a free place in the queue gets one and stops after it
+     * queued its file
+     */
+    void Stop(size_t workersCount)
+    {
+        {
+            wxCriticalSectionLocker locker(m_cs);
+            m_stop = true;
+        }
+        for(size_t i = 0; i < workersCount; ++i) {
+            m_slots.Post();
+        }
+    }
+};
+
+void PHPLookupTable::DoRecreateSymbolsDatabaseParallel(const wxArrayString& files, eUpdateMode updateMode,
+                                                       const std::function<bool()>& pFuncGoingDown,
+                                                       bool parseFuncBodies)
+{
+    {
+        clParseEvent event(wxPHP_PARSE_STARTED);
+        event.SetTotalFiles(files.GetCount());
+        event.SetCurfileIndex(0);
+        EventNotifier::Get()->AddPendingEvent(event);
+    }
+
+    wxStopWatch sw;
+    sw.Start();
+
+    // Select the files to parse. In fast mode, the parse timestamps are loaded at once instead of querying the
+    // database for every file
+    std::unordered_map<wxString, wxLongLong> lastParsed;
+    if(updateMode == kUpdateMode_Fast) { LoadFilesLastParsedTimestamp(lastParsed); }
+
+    std::vector<wxString> filesToParse;
+    filesToParse.reserve(files.GetCount());
+    for(size_t i = 0; i < files.GetCount(); ++i) {
+        wxFileName fnFile(files.Item(i));
+        // Parse only valid PHP files
+        if(FileExtManager::GetType(fnFile.GetFullName()) != FileExtManager::TypePhp) { continue; }
+        // Ensure that the file exists
+        if(!fnFile.Exists()) { continue; }
+        if(updateMode == kUpdateMode_Fast) {
+            std::unordered_map<wxString, wxLongLong>::const_iterator iter = lastParsed.find(fnFile.GetFullPath());
+            if(iter != lastParsed.end() && fnFile.GetModificationTime().GetTicks() <= iter->second.ToLong()) {
+                continue;
+            }
+        }
+        filesToParse.push_back(fnFile.GetFullPath());
+    }
+    size_t skipped = files.GetCount() - filesToParse.size();
+
+    DoClearClassCache();
+    PHPIndexerContext context(filesToParse, this, parseFuncBodies);
+    size_t workersCount = std::max(clWorkerPool::GetCPUCount() - 1, (size_t)1);
+    workersCount = std::min(workersCount, (size_t)PHP_INDEX_MAX_WORKERS);
+    workersCount = std::min(workersCount, filesToParse.size());
+    clWorkerPool workers(workersCount);
+    size_t started = workers.Run(workersCount, [&]() {
+        while(context.ParseNext()) {
+        }
+    });
+
+    // This thread is the only one using the database: store the files in the order they are parsed
+    size_t received = 0;
+    std::vector<std::pair<wxString, std::set<wxString> > > deferred; // file -> types to check
+    try {
+        m_db.Begin();
+        while(received < filesToParse.size()) {
+            if(pFuncGoingDown()) { break; }
+            // No thread could be started, parse the files here
+            if(started == 0) { context.ParseNext(); }
+
+            PHPSourceFilePtr_t source(NULL);
+            if(!context.Receive(source, 100)) { continue; }
+            ++received;
+            {
+                clParseEvent event(wxPHP_PARSE_PROGRESS);
+                event.SetTotalFiles(files.GetCount());
+                event.SetCurfileIndex(skipped + received);
+                event.SetFileName(source ? source->GetFilename().GetFullPath() : wxString());
+                EventNotifier::Get()->AddPendingEvent(event);
+            }
+
+            if(!source) { continue; }
+            UpdateSourceFile(*source, false);
+            if(!source->GetDeferredTypes().empty()) {
+                deferred.push_back(std::make_pair(source->GetFilename().GetFullPath(), source->GetDeferredTypes()));
+            }
+            if((received % PHP_INDEX_FILES_PER_TRANSACTION) == 0) {
+                m_db.Commit();
+                m_db.Begin();
+            }
+        }
+        m_db.Commit();
+
+    } catch(wxSQLite3Exception& e) {
+        try {
+            m_db.Rollback();
+
+        } catch(...) {
+        }
+        clWARNING() << "PHPLookupTable::RecreateSymbolsDatabaseParallel:" << e.GetMessage() << clEndl;
+    }
+
+    // Stop the threads (the files still queued are dropped)
+    context.Stop(started);
+    workers.Wait();
+
+    // Second pass: now that all the classes are known, parse again the files with a type hint that was resolved to
+    // its namespace but is not a class of that namespace (the global class is used instead)
+    size_t reparsed = 0;
+    try {
+        m_db.Begin();
+        for(size_t i = 0; i < deferred.size(); ++i) {
+            if(pFuncGoingDown()) { break; }
+            const std::set<wxString>& types = deferred[i].second;
+            if(std::all_of(types.begin(), types.end(), [&](const wxString& type) { return ClassExists(type); })) {
+                continue;
+            }
+
+            wxFileName fnSourceFile(deferred[i].first);
+            wxString content;
+            if(!FileUtils::ReadFileContent(fnSourceFile, content, wxConvISO8859_1)) { continue; }
+            PHPSourceFile source(content, this);
+            source.SetFilename(fnSourceFile);
+            source.SetParseFunctionBody(parseFuncBodies);
+            source.Parse();
+            UpdateSourceFile(source, false);
+            ++reparsed;
+        }
+        m_db.Commit();
+
+    } catch(wxSQLite3Exception& e) {
+        try {
+            m_db.Rollback();
+
+        } catch(...) {
+        }
+        clWARNING() << "PHPLookupTable::RecreateSymbolsDatabaseParallel:" << e.GetMessage() << clEndl;
+    }
+
+    clDEBUG() << "PHP: parsed" << received << "files (out of" << files.GetCount() << ") using" << started
+              << "threads in" << sw.Time() << "milliseconds," << reparsed << "files parsed again" << clEndl;
+
+    {
+        // always make sure that the end event is sent
+        clParseEvent event(wxPHP_PARSE_ENDED);
+        event.SetTotalFiles(files.GetCount());
+        event.SetCurfileIndex(files.GetCount());
+        EventNotifier::Get()->AddPendingEvent(event);
+    }
+}
@@ -26,6 +26,7 @@
 #ifndef PHPLOOKUPTABLE_H
 #define PHPLOOKUPTABLE_H
 
+#include "PHPDocVar.h"
 #include "PHPEntityBase.h"
 #include "PHPSourceFile.h"
 #include "cl_command_event.h"
@@ -34,14 +35,18 @@
 #include "file_logger.h"
 #include "fileextmanager.h"
 #include "fileutils.h"
+#include "macros.h"
 #include "smart_ptr.h"
 #include "wx/wxsqlite3.h"
+#include <functional>
 #include <set>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 #include <wx/longlong.h>
 #include <wx/stopwatch.h>
 #include <wx/string.h>
+#include <wx/thread.h>
 #include <wxStringHash.h>
 
 wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_CL, wxPHP_PARSE_STARTED, clParseEvent);
@@ -65,6 +70,48 @@ class WXDLLIMPEXP_CL PHPLookupTable
     wxFileName m_filename;
     size_t m_sizeLimit;
     std::unordered_set<wxString> m_allClasses;
+    mutable wxCriticalSection m_allClassesLock; // the class cache is read by the parsing threads
+
+    /**
+     * @brief a member in the flattened members list of a class
+     */
+    struct ClassCacheMember {
+        PHPEntityBase::Ptr_t m_entity;
+        size_t m_owner; // the index of the declaring class in the class parents list
+        ClassCacheMember(PHPEntityBase::Ptr_t entity, size_t owner)
+            : m_entity(entity)
+            , m_owner(owner)
+        {
+        }
+    };
+
+    /**
+     * @brief a class in the class hierarchy cache. The parents and the members are loaded when they are first
+     * needed and are kept until one of the files the entry was built from is parsed again.
+     * Cached entities are shared: variables whose type is changed by a PHPDoc are copied
+     */
+    struct ClassCacheEntry {
+        PHPEntityBase::Ptr_t m_class;
+        bool m_hierarchyLoaded;
+        std::vector<wxLongLong> m_parents; // the class followed by its parents (DoGetInheritanceParentIDs order)
+        PHPEntityBase::List_t m_members;   // the class own members: classes, functions, aliases and variables
+        PHPDocVar::Map_t m_docs;           // the class PHPDoc variables
+        bool m_flatLoaded[2];
+        std::vector<ClassCacheMember> m_flat[2]; // all the members, base classes first (with/without the class)
+        wxStringSet_t m_files;                   // the files this entry was built from
+        bool m_complete; // false when a parent class could not be found: it may be defined by a file not parsed yet
+
+        ClassCacheEntry()
+            : m_hierarchyLoaded(false)
+            , m_complete(true)
+        {
+            m_flatLoaded[0] = m_flatLoaded[1] = false;
+        }
+    };
+    typedef std::unordered_map<wxLongLong_t, ClassCacheEntry> ClassCache_t;
+
+    ClassCache_t m_classCache;
+    time_t m_classCacheTime; // the last time the cache was checked for modified files
 
 public:
     enum eLookupFlags {
@@ -101,7 +148,30 @@ private:
 
     void DoFixVarsDocComment(PHPEntityBase::List_t& matches, wxLongLong parentId);
     void DoGetInheritanceParentIDs(PHPEntityBase::Ptr_t cls, std::vector<wxLongLong>& parents,
-                                   std::set<wxLongLong>& parentsVisited, bool excludeSelf);
+                                   std::set<wxLongLong>& parentsVisited, bool excludeSelf, wxStringSet_t& files,
+                                   bool& complete);
+
+    /**
+     * @brief return the hierarchy cache entry of class 'id' (its members are loaded). Return NULL if there is no
+     * such class. 'cls' is the class entity, if the caller already loaded it
+     */
+    ClassCacheEntry* DoGetClassCacheEntry(wxLongLong id, PHPEntityBase::Ptr_t cls = PHPEntityBase::Ptr_t(NULL));
+    void DoLoadClassMembers(ClassCacheEntry& entry);
+    void DoLoadClassHierarchy(ClassCacheEntry& entry);
+    const std::vector<ClassCacheMember>& DoGetFlatMembers(ClassCacheEntry& entry, bool excludeSelf);
+    void DoFilterMembers(const std::vector<ClassCacheMember>& members, PHPEntityBase::List_t& matches, size_t flags,
+                         const wxString& nameHint);
+    /**
+     * @brief the cached version of DoFindMemberOf() for classes
+     */
+    PHPEntityBase::Ptr_t DoFindCachedMemberOf(wxLongLong classId, const wxString& exactName);
+
+    /**
+     * @brief drop the hierarchy cache entries built from files that were parsed since the last check
+     */
+    void DoValidateClassHierarchyCache();
+    void DoInvalidateClassHierarchyCache(const wxStringSet_t& files);
+    void DoClearClassHierarchyCache();
 
     /**
      * @brief find namespace by fullname. If it does not exist, add it and return a pointer to it
@@ -146,6 +216,15 @@ private:
      */
     wxLongLong GetFileLastParsedTimestamp(const wxFileName& filename);
 
+    /**
+     * @brief load the timestamp of the last parse of all the files (full path -> timestamp)
+     */
+    void LoadFilesLastParsedTimestamp(std::unordered_map<wxString, wxLongLong>& timestamps);
+
+    void DoClearClassCache();
+    void DoRecreateSymbolsDatabaseParallel(const wxArrayString& files, eUpdateMode updateMode,
+                                           const std::function<bool()>& pFuncGoingDown, bool parseFuncBodies);
+
     /**
      * @brief update the file's last updated timestamp
      */
@@ -161,7 +240,7 @@ public:
     virtual ~PHPLookupTable();
 
     /**
-     * @brief rebuild the class cache
+     * @brief rebuild the class cache. This also clears the class hierarchy cache
      */
     void RebuildClassCache();
     /**
@@ -287,7 +366,20 @@ public:
     template <typename GoindDownFunc>
     void RecreateSymbolsDatabase(const wxArrayString& files, eUpdateMode updateMode, GoindDownFunc pFuncGoingDown,
                                  bool parseFuncBodies = true);
-    
+
+    /**
+     * @brief update list of source files, parsing them with a pool of threads. The calling thread is the only one
+     * using the database: it stores the parsed files as they arrive and commits them in batches. The files whose
+     * type hints depend on classes that do not exist are parsed again once all the files are stored.
+     * pFuncGoingDown is only called by the calling thread
+     */
+    template <typename GoindDownFunc>
+    void RecreateSymbolsDatabaseParallel(const wxArrayString& files, eUpdateMode updateMode,
+                                         GoindDownFunc pFuncGoingDown, bool parseFuncBodies = true)
+    {
+        DoRecreateSymbolsDatabaseParallel(files, updateMode, std::function<bool()>(pFuncGoingDown), parseFuncBodies);
+    }
+
     /**
      * @brief parse folder
      */
@@ -328,7 +420,7 @@ void PHPLookupTable::RecreateSymbolsDatabase(const wxArrayString& files, eUpdate
         wxStopWatch sw;
         sw.Start();
 
-        m_allClasses.clear(); // clear the cache
+        DoClearClassCache(); // clear the cache
         m_db.Begin();
         for(size_t i = 0; i < files.GetCount(); ++i) {
             if(pFuncGoingDown()) { break; }
@@ -11,7 +11,7 @@
 #include "PHPEntityFunctionAlias.h"
 #include <unordered_set>
 #include "PHPLookupTable.h"
-#include "fileutils.h"
+#include "clFileContentCache.h"
 
 #define NEXT_TOKEN_BREAK_IF_NOT(t, action) \
     {                                      \
@@ -29,6 +29,7 @@ PHPSourceFile::PHPSourceFile(const wxString& content, PHPLookupTable* lookup)
     , m_reachedEOF(false)
     , m_converter(NULL)
     , m_lookup(lookup)
+    , m_deferClassLookup(false)
 {
     m_scanner = ::phpLexerNew(content, kPhpLexerOpt_ReturnComments);
 }
@@ -40,12 +41,13 @@ PHPSourceFile::PHPSourceFile(const wxFileName& filename, PHPLookupTable* lookup)
     , m_reachedEOF(false)
     , m_converter(NULL)
     , m_lookup(lookup)
+    , m_deferClassLookup(false)
 {
     // Filename is kept in absolute path
     m_filename.MakeAbsolute();
     
-    wxString content;
-    if(FileUtils::ReadFileContent(filename, content, wxConvISO8859_1)) { m_text.swap(content); }
+    clFileContent::Ptr_t file = clFileContentCache::Get().Load(m_filename.GetFullPath());
+    if(file) { m_text = file->GetText(wxFONTENCODING_ISO8859_1); }
     m_scanner = ::phpLexerNew(m_text, kPhpLexerOpt_ReturnComments);
 }
 
@@ -1304,7 +1306,8 @@ void PHPSourceFile::OnConstant(const phpLexerToken& tok)
 
 phpLexerToken& PHPSourceFile::GetPreviousToken()
 {
-    static phpLexerToken NullToken;
+    // Per thread: files are parsed by multiple threads when the workspace is indexed
+    static thread_local phpLexerToken NullToken;
     if(m_lookBackTokens.size() >= 2) {
         // The last token in the list is the current one. We want the previous one
         return m_lookBackTokens.at(m_lookBackTokens.size() - 2);
@@ -1357,7 +1360,7 @@ wxString PHPSourceFile::DoMakeIdentifierAbsolute(const wxString& type, bool exac
 {
     if(m_converter) { return m_converter->MakeIdentifierAbsolute(type); }
 
-    static std::unordered_set<std::string> phpKeywords;
+    static thread_local std::unordered_set<std::string> phpKeywords;
     if(phpKeywords.empty()) {
         phpKeywords.insert("string");
         phpKeywords.insert("array");
@@ -1406,7 +1409,11 @@ wxString PHPSourceFile::DoMakeIdentifierAbsolute(const wxString& type, bool exac
     wxString ns = Namespace()->GetFullName();
     if(!ns.EndsWith("\\")) { ns << "\\"; }
 
-    if(exactMatch && m_lookup && !typeWithNS.Contains("\\") && !m_lookup->ClassExists(ns + typeWithNS)) {
+    if(exactMatch && m_deferClassLookup && !typeWithNS.Contains("\\")) {
+        typeWithNS.Prepend(ns);
+        m_deferredTypes.insert(typeWithNS);
+
+    } else if(exactMatch && m_lookup && !typeWithNS.Contains("\\") && !m_lookup->ClassExists(ns + typeWithNS)) {
         // Only when "exactMatch" apply this logic, otherwise, we might be getting a partialy typed string
         // which we will not find by calling FindChild()
         typeWithNS.Prepend("\\"); // Use the global NS
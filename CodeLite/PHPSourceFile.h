@@ -50,6 +50,9 @@ class WXDLLIMPEXP_CL PHPSourceFile
     std::map<wxString, wxString> m_aliases;
     PHPSourceFile* m_converter;
     PHPLookupTable* m_lookup;
+    bool m_deferClassLookup;
+    // the types resolved to the current namespace without checking that the class exists
+    std::set<wxString> m_deferredTypes;
 
 public:
     typedef wxSharedPtr<PHPSourceFile> Ptr_t;
@@ -241,6 +244,14 @@ public:
      */
     void SetTypeAbsoluteConverter(PHPSourceFile* converter) { m_converter = converter; }
 
+    /**
+     * @brief do not look up the classes while parsing (e.g. when the lookup table is being filled by other threads).
+     * Unqualified type hints are resolved to the current namespace and are returned by GetDeferredTypes(), the
+     * caller parses the file again if one of them is not a known class
+     */
+    void SetDeferClassLookup(bool deferClassLookup) { m_deferClassLookup = deferClassLookup; }
+    const std::set<wxString>& GetDeferredTypes() const { return m_deferredTypes; }
+
     /**
      * @brief check if we are inside a PHP block at the end of the given buffer
      */
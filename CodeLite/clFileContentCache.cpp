@@ -0,0 +1,183 @@
+#include "clFileContentCache.h"
+#include "clMemoryMappedFile.h"
+#include "file_logger.h"
+#include <algorithm>
+#include <string.h>
+#include <wx/ffile.h>
+#include <wx/strconv.h>
+
+// The cache budget: every entry is charged for its raw bytes and for a decoded copy of them
+#define FILE_CONTENT_CACHE_MAX_COST (256 * 1024 * 1024)
+#define FILE_CONTENT_CACHE_MAX_FILES 8192
+// Larger files are not cached (e.g. generated sources or data files)
+#define FILE_CONTENT_CACHE_MAX_FILE_SIZE (8 * 1024 * 1024)
+// The number of bytes examined to tell if a file is binary
+#define FILE_CONTENT_BINARY_CHECK_SIZE 4096
+
+clFileContent::clFileContent(const wxString& filename, const clFileFingerprint& fingerprint)
+    : m_filename(filename.c_str()) // deep copy, entries are shared between threads
+    , m_fingerprint(fingerprint)
+{
+}
+
+clFileContent::~clFileContent() {}
+
+bool clFileContent::Read()
+{
+    // Map the file and keep a copy of its content: a mapping kept alive while the file is rewritten (e.g. saved
+    // by the editor) faults when the file is truncated, and on Windows it prevents the file from being truncated
+    clMemoryMappedFile file;
+    if(!file.Open(m_filename)) { return false; }
+    if(file.GetSize()) { m_data.assign(file.GetData(), file.GetSize()); }
+    if((wxInt64)m_data.length() != m_fingerprint.m_size) {
+        // The file was modified after its attributes were read: do not record attributes that do not match
+        // the content
+        m_fingerprint.m_size = m_data.length();
+        m_fingerprint.m_mtime = 0;
+    }
+    return true;
+}
+
+wxString clFileContent::GetText(wxFontEncoding encoding)
+{
+    wxCriticalSectionLocker locker(m_cs);
+    std::map<wxFontEncoding, wxString>::iterator iter = m_texts.find(encoding);
+    if(iter == m_texts.end()) {
+        // Callers using different encodings (e.g. find in files and the parser) do not decode the file
+        // over and over again
+        iter = m_texts.insert(std::make_pair(encoding, wxString())).first;
+        wxString& text = iter->second;
+        if(!m_data.empty()) {
+            wxCSConv conv(encoding);
+            text = wxString(m_data.c_str(), conv, m_data.length());
+            if(text.IsEmpty()) {
+                // Conversion failed
+                text = wxString::From8BitData(m_data.c_str(), m_data.length());
+            }
+        }
+    }
+    // Return a deep copy, the caller may use it from another thread
+    return wxString(iter->second.c_str(), iter->second.length());
+}
+
+bool clFileContent::IsBinary() const
+{
+    return memchr(m_data.c_str(), 0, std::min(m_data.length(), (size_t)FILE_CONTENT_BINARY_CHECK_SIZE)) != NULL;
+}
+
+clFileContentCache::clFileContentCache()
+    : m_cost(0)
+{
+}
+
+clFileContentCache::~clFileContentCache() {}
+
+clFileContentCache& clFileContentCache::Get()
+{
+    static clFileContentCache cache;
+    return cache;
+}
+
+clFileContent::Ptr_t clFileContentCache::Load(const wxString& filename)
+{
+    clFileFingerprint fingerprint;
+    if(!fingerprint.ReadAttributes(filename)) {
+        Invalidate(filename);
+        return clFileContent::Ptr_t(NULL);
+    }
+
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        std::unordered_map<wxString, List_t::iterator>::iterator iter = m_index.find(filename);
+        if(iter != m_index.end()) {
+            const clFileFingerprint& cached = iter->second->m_content->GetFingerprint();
+            if(cached.m_size == fingerprint.m_size && cached.m_mtime == fingerprint.m_mtime) {
+                // Move the entry to the front of the list
+                m_entries.splice(m_entries.begin(), m_entries, iter->second);
+                return m_entries.front().m_content;
+            }
+        }
+    }
+
+    // Read the file without holding the lock
+    clFileContent::Ptr_t content(new clFileContent(filename, fingerprint));
+    if(!content->Read()) {
+        Invalidate(filename);
+        return clFileContent::Ptr_t(NULL);
+    }
+
+    wxCriticalSectionLocker locker(m_cs);
+    DoRemove(filename);
+    if(content->GetSize() <= FILE_CONTENT_CACHE_MAX_FILE_SIZE) {
+        Entry entry;
+        entry.m_filename = content->GetFilename();
+        entry.m_content = content;
+        entry.m_cost = content->GetSize() * (1 + sizeof(wxChar));
+        m_entries.push_front(entry);
+        m_index[entry.m_filename] = m_entries.begin();
+        m_cost += entry.m_cost;
+        DoEvict();
+    }
+    return content;
+}
+
+bool clFileContentCache::IsBinary(const wxString& filename)
+{
+    clFileFingerprint fingerprint;
+    if(!fingerprint.ReadAttributes(filename)) { return true; }
+
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        std::unordered_map<wxString, List_t::iterator>::iterator iter = m_index.find(filename);
+        if(iter != m_index.end()) {
+            const clFileContent::Ptr_t& content = iter->second->m_content;
+            const clFileFingerprint& cached = content->GetFingerprint();
+            if(cached.m_size == fingerprint.m_size && cached.m_mtime == fingerprint.m_mtime) {
+                return content->IsBinary();
+            }
+        }
+    }
+
+    // Not cached: read only the first bytes, the file may be skipped and never loaded
+    wxFFile fp(filename, "rb");
+    if(!fp.IsOpened()) { return true; }
+    char buffer[FILE_CONTENT_BINARY_CHECK_SIZE];
+    size_t count = fp.Read(buffer, sizeof(buffer));
+    if(fp.Error()) { return true; }
+    return memchr(buffer, 0, count) != NULL;
+}
+
+void clFileContentCache::Invalidate(const wxString& filename)
+{
+    wxCriticalSectionLocker locker(m_cs);
+    DoRemove(filename);
+}
+
+void clFileContentCache::Clear()
+{
+    wxCriticalSectionLocker locker(m_cs);
+    m_entries.clear();
+    m_index.clear();
+    m_cost = 0;
+}
+
+void clFileContentCache::DoRemove(const wxString& filename)
+{
+    std::unordered_map<wxString, List_t::iterator>::iterator iter = m_index.find(filename);
+    if(iter == m_index.end()) { return; }
+    m_cost -= iter->second->m_cost;
+    m_entries.erase(iter->second);
+    m_index.erase(iter);
+}
+
+void clFileContentCache::DoEvict()
+{
+    // The entries still used by a caller are released when the caller is done with them
+    while(!m_entries.empty() &&
+          (m_cost > FILE_CONTENT_CACHE_MAX_COST || m_index.size() > FILE_CONTENT_CACHE_MAX_FILES)) {
+        const Entry& entry = m_entries.back();
+        m_cost -= entry.m_cost;
+        m_index.erase(entry.m_filename);
+        m_entries.pop_back();
+    }
+}
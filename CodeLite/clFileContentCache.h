@@ -0,0 +1,121 @@
+#ifndef CLFILECONTENTCACHE_H
+#define CLFILECONTENTCACHE_H
+
+#include "clFileFingerprint.h"
+#include "codelite_exports.h"
+#include "wxStringHash.h"
+#include <list>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <wx/fontenc.h>
+#include <wx/sharedptr.h>
+#include <wx/string.h>
+#include <wx/thread.h>
+
+/**
+ * @class clFileContent
+ * @brief the content of a file as it was when it was read: the raw bytes and, decoded on demand, the text.
+ * A clFileContent is never modified once it is read, apart from the decoded text which is computed once (per
+ * encoding) and may be requested from multiple threads
+ */
+class WXDLLIMPEXP_CL clFileContent
+{
+public:
+    typedef wxSharedPtr<clFileContent> Ptr_t;
+
+protected:
+    wxString m_filename;
+    clFileFingerprint m_fingerprint; // the size and modification time of the file when it was read
+    std::string m_data;
+    wxCriticalSection m_cs;
+    std::map<wxFontEncoding, wxString> m_texts; // the decoded text, by encoding
+
+public:
+    clFileContent(const wxString& filename, const clFileFingerprint& fingerprint);
+    virtual ~clFileContent();
+
+    /**
+     * @brief read the file content
+     */
+    bool Read();
+
+    const wxString& GetFilename() const { return m_filename; }
+    const clFileFingerprint& GetFingerprint() const { return m_fingerprint; }
+
+    /**
+     * @brief the raw bytes of the file (not NUL terminated)
+     */
+    const char* GetData() const { return m_data.c_str(); }
+    size_t GetSize() const { return m_data.length(); }
+
+    /**
+     * @brief return the content decoded with 'encoding'. If the content can not be decoded, every byte is
+     * converted to the character with the same value
+     */
+    wxString GetText(wxFontEncoding encoding);
+
+    /**
+     * @brief does the content look like a binary file (a NUL in its first bytes)
+     */
+    bool IsBinary() const;
+};
+
+/**
+ * @class clFileContentCache
+ * @brief a process wide cache of the files content, shared by the components that read the workspace files (find
+ * in files, the tags manager, the pre-processor and PHP scanners and the refactoring storage).
+ * An entry is returned only if the size and the modification time of the file are those it had when it was read,
+ * so a modified file is always read again. Files reported as modified by clFileSystemWatcher are removed from the
+ * cache. The least recently used entries are evicted when the cache grows over its budget.
+ * This class is thread safe
+ */
+class WXDLLIMPEXP_CL clFileContentCache
+{
+    struct Entry {
+        wxString m_filename;
+        clFileContent::Ptr_t m_content;
+        size_t m_cost;
+    };
+    typedef std::list<Entry> List_t;
+
+    wxCriticalSection m_cs;
+    List_t m_entries; // most recently used first
+    std::unordered_map<wxString, List_t::iterator> m_index;
+    size_t m_cost; // the sum of the entries cost
+
+protected:
+    clFileContentCache();
+    virtual ~clFileContentCache();
+
+    void DoRemove(const wxString& filename);
+    void DoEvict();
+
+public:
+    static clFileContentCache& Get();
+
+    /**
+     * @brief return the current content of 'filename', reading it only if it is not cached or if it was modified
+     * since it was read. Files too large to be cached are read and returned without being cached
+     * @return NULL if the file can not be read
+     */
+    clFileContent::Ptr_t Load(const wxString& filename);
+
+    /**
+     * @brief is 'filename' a binary file. The cached content is used if the file is cached and was not modified,
+     * otherwise only the first bytes of the file are read and the file is not added to the cache
+     */
+    bool IsBinary(const wxString& filename);
+
+    /**
+     * @brief remove 'filename' from the cache
+     */
+    void Invalidate(const wxString& filename);
+
+    /**
+     * @brief remove all the files from the cache
+     */
+    void Clear();
+};
+
+#endif // CLFILECONTENTCACHE_H
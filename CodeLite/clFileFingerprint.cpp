@@ -0,0 +1,139 @@
+#include "clFileFingerprint.h"
+#include "clMemoryMappedFile.h"
+#include "clWorkerPool.h"
+#include <algorithm>
+#include <functional>
+
+#ifdef __WXMSW__
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// stat() mostly waits for the file system (e.g. on a cold NFS cache), so use more workers than CPUs
+#define FINGERPRINT_WORKERS_PER_CPU 2
+#define FINGERPRINT_MAX_WORKERS 16
+
+// 64 bit FNV-1a
+#define FINGERPRINT_HASH_OFFSET 14695981039346656037ULL
+#define FINGERPRINT_HASH_PRIME 1099511628211ULL
+
+/**
+ * @brief call 'func' for every index in [0, count) using a pool of threads
+ */
+static void ParallelForEach(size_t count, const std::function<void(size_t)>& func)
+{
+    clWorkerPool pool(std::min(clWorkerPool::GetCPUCount() * FINGERPRINT_WORKERS_PER_CPU,
+                               (size_t)FINGERPRINT_MAX_WORKERS));
+    pool.ForEach(count, func);
+}
+
+bool clFileFingerprint::ReadAttributes(const wxString& filename)
+{
+    m_size = -1;
+#ifdef __WXMSW__
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if(!::GetFileAttributesExW(filename.wc_str(), GetFileExInfoStandard, &data)) { return false; }
+    m_size = ((wxInt64)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+
+    // FILETIME counts 100 nanoseconds intervals since 1601-01-01
+    wxInt64 filetime = ((wxInt64)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+    m_mtime = (filetime - 116444736000000000LL) * 100;
+#else
+    struct stat buff;
+    if(::stat(filename.mb_str(wxConvUTF8).data(), &buff) != 0) { return false; }
+    m_size = buff.st_size;
+#ifdef __WXOSX__
+    m_mtime = ((wxInt64)buff.st_mtimespec.tv_sec * 1000000000) + buff.st_mtimespec.tv_nsec;
+#else
+    m_mtime = ((wxInt64)buff.st_mtim.tv_sec * 1000000000) + buff.st_mtim.tv_nsec;
+#endif
+#endif
+    return true;
+}
+
+bool clFileFingerprint::Read(const wxString& filename, const clFileFingerprint& previous)
+{
+    if(!ReadAttributes(filename)) { return false; }
+    if(previous.IsOk() && (previous.m_size == m_size) && (previous.m_mtime == m_mtime)) {
+        m_hash = previous.m_hash;
+        return true;
+    }
+    return ReadHash(filename);
+}
+
+bool clFileFingerprint::ReadHash(const wxString& filename)
+{
+    clMemoryMappedFile file;
+    if(!file.Open(filename)) { return false; }
+
+    wxUint64 hash = FINGERPRINT_HASH_OFFSET;
+    const unsigned char* p = (const unsigned char*)file.GetData();
+    for(size_t i = 0; i < file.GetSize(); ++i) {
+        hash ^= p[i];
+        hash *= FINGERPRINT_HASH_PRIME;
+    }
+    m_hash = hash;
+    return true;
+}
+
+void clFileFingerprint::Compute(const wxArrayString& files, Vec_t& fingerprints)
+{
+    fingerprints.clear();
+    fingerprints.resize(files.GetCount());
+    ParallelForEach(files.GetCount(), [&](size_t index) {
+        wxString filename = files.Item(index);
+        fingerprints[index].Read(filename);
+    });
+}
+
+void clFileFingerprint::FindModified(const wxArrayString& files, const std::unordered_map<wxString, int>& retagged,
+                                     const Map_t& stored, wxArrayString& modified, Map_t& updated)
+{
+    enum eState { kUnchanged, kModified, kUpdated };
+    std::vector<int> states(files.GetCount(), kModified);
+    Vec_t fingerprints(files.GetCount());
+
+    ParallelForEach(files.GetCount(), [&](size_t index) {
+        wxString filename = files.Item(index);
+        std::unordered_map<wxString, int>::const_iterator retagIter = retagged.find(filename);
+        if(retagIter == retagged.end()) {
+            // never parsed
+            return;
+        }
+
+        clFileFingerprint& current = fingerprints[index];
+        if(!current.ReadAttributes(filename)) {
+            // the file can not be accessed, keep its tags
+            states[index] = kUnchanged;
+            return;
+        }
+
+        Map_t::const_iterator iter = stored.find(filename);
+        if(iter == stored.end()) {
+            // parsed before the fingerprints were recorded, compare the retag timestamp
+            if(retagIter->second >= current.GetModificationTime() && current.ReadHash(filename)) {
+                states[index] = kUpdated;
+            }
+            return;
+        }
+
+        const clFileFingerprint& previous = iter->second;
+        if(previous.m_size != current.m_size) { return; }
+        if(previous.m_mtime == current.m_mtime) {
+            states[index] = kUnchanged;
+            return;
+        }
+
+        // Same size but a different modification time, compare the content
+        if(current.ReadHash(filename) && current.m_hash == previous.m_hash) { states[index] = kUpdated; }
+    });
+
+    for(size_t i = 0; i < files.GetCount(); ++i) {
+        if(states[i] == kModified) {
+            modified.Add(files.Item(i));
+        } else if(states[i] == kUpdated) {
+            updated[files.Item(i)] = fingerprints[i];
+        }
+    }
+}
@@ -0,0 +1,86 @@
+#ifndef CLFILEFINGERPRINT_H
+#define CLFILEFINGERPRINT_H
+
+#include "codelite_exports.h"
+#include "wxStringHash.h"
+#include <time.h>
+#include <unordered_map>
+#include <vector>
+#include <wx/arrstr.h>
+#include <wx/defs.h>
+#include <wx/string.h>
+
+/**
+ * @class clFileFingerprint
+ * @brief the size, the modification time (in nanoseconds) and a hash of the content of a file.
+ * It is used to tell whether a file content changed since it was last parsed: a file whose attributes changed
+ * but whose content hash is the same (e.g. after a 'git checkout' or a 'touch') does not need to be parsed again
+ */
+class WXDLLIMPEXP_CL clFileFingerprint
+{
+public:
+    typedef std::vector<clFileFingerprint> Vec_t;
+    typedef std::unordered_map<wxString, clFileFingerprint> Map_t;
+
+    wxInt64 m_size; // -1 if the file could not be read
+    wxInt64 m_mtime;
+    wxUint64 m_hash;
+
+public:
+    clFileFingerprint()
+        : m_size(-1)
+        , m_mtime(0)
+        , m_hash(0)
+    {
+    }
+
+    bool IsOk() const { return m_size >= 0; }
+
+    /**
+     * @brief return the modification time in seconds since the epoch
+     */
+    time_t GetModificationTime() const { return (time_t)(m_mtime / 1000000000); }
+
+    /**
+     * @brief read the size and the modification time of 'filename'
+     */
+    bool ReadAttributes(const wxString& filename);
+
+    /**
+     * @brief compute the hash of 'filename' content
+     */
+    bool ReadHash(const wxString& filename);
+
+    /**
+     * @brief read the attributes and the content hash of 'filename'
+     */
+    bool Read(const wxString& filename) { return ReadAttributes(filename) && ReadHash(filename); }
+
+    /**
+     * @brief same as Read(), but when the size and the modification time of 'filename' are the ones of 'previous'
+     * the content is not hashed and the hash of 'previous' is used
+     */
+    bool Read(const wxString& filename, const clFileFingerprint& previous);
+
+    /**
+     * @brief compute the fingerprints of 'files' using a pool of threads. The fingerprint of a file that
+     * could not be read is not Ok
+     */
+    static void Compute(const wxArrayString& files, Vec_t& fingerprints);
+
+    /**
+     * @brief find the files whose content changed since they were last parsed, using a pool of threads.
+     * A file content is hashed only when its size is unchanged but its modification time changed
+     * @param files the files to check
+     * @param retagged the last retag timestamp of the parsed files. A file that is not in this map was never parsed
+     * @param stored the fingerprints recorded when the files were parsed. A file parsed before the fingerprints
+     * were recorded is compared by its retag timestamp
+     * @param modified [output] the files that need to be parsed
+     * @param updated [output] the new fingerprints of the unchanged files whose attributes changed (or that had
+     * no fingerprint), these should be stored so their content is not hashed again
+     */
+    static void FindModified(const wxArrayString& files, const std::unordered_map<wxString, int>& retagged,
+                             const Map_t& stored, wxArrayString& modified, Map_t& updated);
+};
+
+#endif // CLFILEFINGERPRINT_H
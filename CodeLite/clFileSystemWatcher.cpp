@@ -1,4 +1,5 @@
 #include "clFileSystemWatcher.h"
+#include "clFileContentCache.h"
 #include <algorithm>
 #include <set>
 #include "fileutils.h"
@@ -54,6 +55,22 @@ void clFileSystemWatcher::SetFile(const wxFileName& filename)
 #endif
 }
 
+void clFileSystemWatcher::AddFile(const wxFileName& filename)
+{
+#if CL_FSW_USE_TIMER
+    if(filename.Exists()) {
+        File f;
+        f.filename = filename;
+        f.lastModified = FileUtils::GetFileModificationTime(filename);
+        f.file_size = FileUtils::GetFileSize(filename);
+        m_files[filename.GetFullPath()] = f;
+    }
+#else
+    // the native watcher supports a single file
+    SetFile(filename);
+#endif
+}
+
 void clFileSystemWatcher::Start()
 {
 #if CL_FSW_USE_TIMER
@@ -95,6 +112,7 @@ void clFileSystemWatcher::OnTimer(wxTimerEvent& event)
         const File& f = p.second;
         const wxFileName& fn = f.filename;
         if(!fn.Exists()) {
+            clFileContentCache::Get().Invalidate(fn.GetFullPath());
 
             // fire file not found event
             if(GetOwner()) {
@@ -116,6 +134,9 @@ void clFileSystemWatcher::OnTimer(wxTimerEvent& event)
 #endif
 
             if(prev_value != curr_value) {
+                // Drop the cached content now rather than on its next use
+                clFileContentCache::Get().Invalidate(fn.GetFullPath());
+
                 // Fire a modified event
                 if(GetOwner()) {
                     clFileSystemEvent evt(wxEVT_FILE_MODIFIED);
@@ -150,6 +171,7 @@ void clFileSystemWatcher::OnFileModified(wxFileSystemWatcherEvent& event)
     if(event.GetChangeType() == wxFSW_EVENT_MODIFY) {
         const wxFileName& modpath = event.GetPath();
         if(modpath == m_watchedFile) {
+            clFileContentCache::Get().Invalidate(modpath.GetFullPath());
             if(GetOwner()) {
                 clFileSystemEvent evt(wxEVT_FILE_MODIFIED);
                 evt.SetPath(modpath.GetFullPath());
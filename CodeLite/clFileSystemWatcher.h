@@ -58,6 +58,11 @@ public:
      */
     void SetFile(const wxFileName& filename);
 
+    /**
+     * @brief add a file to the watch list, without removing the files already watched
+     */
+    void AddFile(const wxFileName& filename);
+
     /**
      * @brief remove file from the watch list
      */
@@ -0,0 +1,100 @@
+#include "clMemoryMappedFile.h"
+#include "file_logger.h"
+
+#ifdef __WXMSW__
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+clMemoryMappedFile::clMemoryMappedFile()
+    : m_data(NULL)
+    , m_size(0)
+#ifdef __WXMSW__
+    , m_file(INVALID_HANDLE_VALUE)
+    , m_mapping(NULL)
+#endif
+{
+}
+
+clMemoryMappedFile::~clMemoryMappedFile() { Close(); }
+
+bool clMemoryMappedFile::Open(const wxString& filename)
+{
+    Close();
+#ifdef __WXMSW__
+    m_file = ::CreateFileW(filename.wc_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                           NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if(m_file == INVALID_HANDLE_VALUE) { return false; }
+
+    LARGE_INTEGER size;
+    if(!::GetFileSizeEx(m_file, &size)) {
+        Close();
+        return false;
+    }
+
+    m_size = (size_t)size.QuadPart;
+    if(m_size == 0) {
+        // empty files can not be mapped
+        return true;
+    }
+
+    m_mapping = ::CreateFileMappingW(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(!m_mapping) {
+        Close();
+        return false;
+    }
+
+    m_data = (const char*)::MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+    if(!m_data) {
+        Close();
+        return false;
+    }
+#else
+    int fd = ::open(filename.mb_str(wxConvUTF8).data(), O_RDONLY);
+    if(fd < 0) { return false; }
+
+    struct stat st;
+    if(::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+
+    m_size = (size_t)st.st_size;
+    if(m_size == 0) {
+        // empty files can not be mapped
+        ::close(fd);
+        return true;
+    }
+
+    void* data = ::mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping remains valid after the file descriptor is closed
+    ::close(fd);
+    if(data == MAP_FAILED) {
+        clDEBUG1() << "Failed to map file:" << filename << clEndl;
+        m_size = 0;
+        return false;
+    }
+    ::madvise(data, m_size, MADV_SEQUENTIAL);
+    m_data = (const char*)data;
+#endif
+    return true;
+}
+
+void clMemoryMappedFile::Close()
+{
+#ifdef __WXMSW__
+    if(m_data) { ::UnmapViewOfFile(m_data); }
+    if(m_mapping) { ::CloseHandle(m_mapping); }
+    if(m_file != INVALID_HANDLE_VALUE) { ::CloseHandle(m_file); }
+    m_mapping = NULL;
+    m_file = INVALID_HANDLE_VALUE;
+#else
+    if(m_data) { ::munmap((void*)m_data, m_size); }
+#endif
+    m_data = NULL;
+    m_size = 0;
+}
@@ -0,0 +1,41 @@
+#ifndef CLMEMORYMAPPEDFILE_H
+#define CLMEMORYMAPPEDFILE_H
+
+#include "codelite_exports.h"
+#include <wx/string.h>
+
+/**
+ * @class clMemoryMappedFile
+ * @brief a read-only view of a file content mapped into memory
+ */
+class WXDLLIMPEXP_CL clMemoryMappedFile
+{
+    const char* m_data;
+    size_t m_size;
+#ifdef __WXMSW__
+    void* m_file;
+    void* m_mapping;
+#endif
+
+public:
+    clMemoryMappedFile();
+    virtual ~clMemoryMappedFile();
+
+    /**
+     * @brief map 'filename' into memory. Empty files can not be mapped: Open() succeeds, GetSize() returns 0
+     * and GetData() returns NULL
+     * @return true on success
+     */
+    bool Open(const wxString& filename);
+
+    /**
+     * @brief unmap the file
+     */
+    void Close();
+
+    bool IsOpened() const { return m_data != NULL; }
+    const char* GetData() const { return m_data; }
+    size_t GetSize() const { return m_size; }
+};
+
+#endif // CLMEMORYMAPPEDFILE_H
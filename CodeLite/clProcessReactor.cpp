@@ -0,0 +1,368 @@
+#include "clProcessReactor.h"
+
+#if defined(__WXMAC__) || defined(__WXGTK__)
+#include "asyncprocess.h"
+#include "file_logger.h"
+#include "processreaderthread.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#define REACTOR_USE_EPOLL 1
+#endif
+
+#define REACTOR_READ_SIZE (64 * 1024)
+// The maximum number of bytes delivered to a process in a single notification
+#define REACTOR_MAX_CHUNK (1024 * 1024)
+#define REACTOR_MAX_EVENTS 64
+
+clProcessReactor* clProcessReactor::ms_instance = NULL;
+
+// Protects clProcessReactor::ms_instance
+static wxCriticalSection s_instanceCS;
+
+static bool HasMoreData(int fd)
+{
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    return (poll(&pfd, 1, 0) > 0) && (pfd.revents & POLLIN);
+}
+
+static void SetCloseOnExec(int fd)
+{
+    int flags = fcntl(fd, F_GETFD);
+    if(flags != -1) { fcntl(fd, F_SETFD, flags | FD_CLOEXEC); }
+}
+
+clProcessReactor::clProcessReactor()
+    : wxThread(wxTHREAD_JOINABLE)
+    , m_buffer(REACTOR_READ_SIZE)
+    , m_pollHandle(-1)
+    , m_shutdown(false)
+{
+    m_wakeupPipe[0] = -1;
+    m_wakeupPipe[1] = -1;
+}
+
+clProcessReactor::~clProcessReactor()
+{
+    if(m_pollHandle != -1) { close(m_pollHandle); }
+    if(m_wakeupPipe[0] != -1) { close(m_wakeupPipe[0]); }
+    if(m_wakeupPipe[1] != -1) { close(m_wakeupPipe[1]); }
+}
+
+bool clProcessReactor::Init()
+{
+    if(pipe(m_wakeupPipe) != 0) {
+        m_wakeupPipe[0] = m_wakeupPipe[1] = -1;
+        clWARNING() << "Process reactor: failed to create the wakeup pipe:" << strerror(errno) << clEndl;
+        return false;
+    }
+
+    // The child processes should not inherit our handles
+    for(size_t i = 0; i < 2; ++i) {
+        SetCloseOnExec(m_wakeupPipe[i]);
+        fcntl(m_wakeupPipe[i], F_SETFL, fcntl(m_wakeupPipe[i], F_GETFL) | O_NONBLOCK);
+    }
+
+#ifdef REACTOR_USE_EPOLL
+    m_pollHandle = epoll_create(REACTOR_MAX_EVENTS);
+    if(m_pollHandle == -1) {
+        clWARNING() << "Process reactor: epoll_create error:" << strerror(errno) << clEndl;
+        return false;
+    }
+    SetCloseOnExec(m_pollHandle);
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = m_wakeupPipe[0];
+    if(epoll_ctl(m_pollHandle, EPOLL_CTL_ADD, m_wakeupPipe[0], &ev) != 0) {
+        clWARNING() << "Process reactor: epoll_ctl error:" << strerror(errno) << clEndl;
+        return false;
+    }
+#endif
+
+    if((Create() != wxTHREAD_NO_ERROR) || (Run() != wxTHREAD_NO_ERROR)) {
+        clWARNING() << "Process reactor: failed to start the reactor thread" << clEndl;
+        return false;
+    }
+    return true;
+}
+
+void clProcessReactor::Wakeup()
+{
+    char ch = 'x';
+    // A full pipe already has a pending wakeup
+    while(write(m_wakeupPipe[1], &ch, 1) < 0 && errno == EINTR) {
+    }
+}
+
+bool clProcessReactor::IsShutdown()
+{
+    wxCriticalSectionLocker locker(m_cs);
+    return m_shutdown;
+}
+
+void clProcessReactor::DoWait(std::vector<int>& readyHandles)
+{
+    readyHandles.clear();
+#ifdef REACTOR_USE_EPOLL
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+    int count = epoll_wait(m_pollHandle, events, REACTOR_MAX_EVENTS, -1);
+    for(int i = 0; i < count; ++i) {
+        readyHandles.push_back(events[i].data.fd);
+    }
+#else
+    std::vector<struct pollfd> handles;
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        handles.reserve(m_channels.size() + 1);
+        struct pollfd pfd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        pfd.fd = m_wakeupPipe[0];
+        handles.push_back(pfd);
+        for(ChannelsMap_t::const_iterator iter = m_channels.begin(); iter != m_channels.end(); ++iter) {
+            pfd.fd = iter->first;
+            handles.push_back(pfd);
+        }
+    }
+
+    if(poll(&handles[0], handles.size(), -1) <= 0) { return; }
+    for(size_t i = 0; i < handles.size(); ++i) {
+        if(handles[i].revents & (POLLIN | POLLHUP | POLLERR)) { readyHandles.push_back(handles[i].fd); }
+    }
+#endif
+}
+
+void* clProcessReactor::Entry()
+{
+    std::vector<int> readyHandles;
+    while(!IsShutdown()) {
+        DoWait(readyHandles);
+        for(size_t i = 0; i < readyHandles.size(); ++i) {
+            if(readyHandles[i] == m_wakeupPipe[0]) {
+                // Drain the wakeup pipe
+                char buffer[64];
+                while(read(m_wakeupPipe[0], buffer, sizeof(buffer)) > 0) {
+                }
+            } else {
+                DoRead(readyHandles[i]);
+            }
+        }
+    }
+    return NULL;
+}
+
+bool clProcessReactor::DoAdd(IProcess* process, int fd, wxEvtHandler* notifiedWindow)
+{
+    wxCriticalSectionLocker locker(m_cs);
+    Channel& channel = m_channels[fd];
+    channel.m_process = process;
+    channel.m_notifiedWindow = notifiedWindow;
+    channel.m_pending.clear();
+    channel.m_inEscape = false;
+
+#ifdef REACTOR_USE_EPOLL
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if(epoll_ctl(m_pollHandle, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        clWARNING() << "Process reactor: failed to watch handle" << fd << ":" << strerror(errno) << clEndl;
+        m_channels.erase(fd);
+        return false;
+    }
+#else
+    // Let the reactor thread pick the new handle
+    Wakeup();
+#endif
+    return true;
+}
+
+void clProcessReactor::DoRemove(int fd)
+{
+    // Called while holding m_cs
+    if(m_channels.erase(fd) == 0) { return; }
+#ifdef REACTOR_USE_EPOLL
+    epoll_ctl(m_pollHandle, EPOLL_CTL_DEL, fd, NULL);
+#else
+    Wakeup();
+#endif
+}
+
+void clProcessReactor::DoRead(int fd)
+{
+    wxCriticalSectionLocker locker(m_cs);
+    ChannelsMap_t::iterator iter = m_channels.find(fd);
+    if(iter == m_channels.end()) {
+        // Unwatched while we were waiting
+        return;
+    }
+
+    // Read all the output that is available, up to REACTOR_MAX_CHUNK
+    Channel& channel = iter->second;
+    bool terminated = false;
+    size_t total = 0;
+    while(true) {
+        ssize_t bytesRead = read(fd, &m_buffer[0], m_buffer.size());
+        if(bytesRead < 0 && (errno == EINTR || errno == EAGAIN)) { break; }
+        if(bytesRead <= 0) {
+            // Process terminated
+            // the exit code will be set in the sigchld event handler
+            terminated = true;
+            break;
+        }
+
+        size_t length = RemoveTerminalColoring(&m_buffer[0], bytesRead, channel.m_inEscape);
+        channel.m_pending.append(&m_buffer[0], length);
+        total += bytesRead;
+        if(total >= REACTOR_MAX_CHUNK || !HasMoreData(fd)) { break; }
+    }
+
+    DoNotify(channel, terminated);
+    if(terminated) { DoRemove(fd); }
+}
+
+void clProcessReactor::DoNotify(Channel& channel, bool terminated)
+{
+    wxString output = ConvertOutput(channel.m_pending, terminated);
+    if(!output.IsEmpty()) {
+        // If we got a callback object, use it
+        if(channel.m_process->GetCallback()) {
+            channel.m_process->GetCallback()->CallAfter(&IProcessCallback::OnProcessOutput, output);
+
+        } else if(channel.m_notifiedWindow) {
+            // fallback to the event system
+            clProcessEvent e(wxEVT_ASYNC_PROCESS_OUTPUT);
+            e.SetOutput(output);
+            e.SetProcess(channel.m_process);
+            channel.m_notifiedWindow->AddPendingEvent(e);
+        }
+    }
+
+    if(terminated) {
+        if(channel.m_process->GetCallback()) {
+            channel.m_process->GetCallback()->CallAfter(&IProcessCallback::OnProcessTerminated);
+
+        } else if(channel.m_notifiedWindow) {
+            clProcessEvent e(wxEVT_ASYNC_PROCESS_TERMINATED);
+            e.SetProcess(channel.m_process);
+            channel.m_notifiedWindow->AddPendingEvent(e);
+        }
+    }
+}
+
+bool clProcessReactor::Watch(IProcess* process, int fd, wxEvtHandler* notifiedWindow)
+{
+    wxCriticalSectionLocker locker(s_instanceCS);
+    if(!ms_instance) {
+        clProcessReactor* reactor = new clProcessReactor();
+        if(!reactor->Init()) {
+            // The thread was not started
+            delete reactor;
+            return false;
+        }
+        ms_instance = reactor;
+    }
+    return ms_instance->DoAdd(process, fd, notifiedWindow);
+}
+
+void clProcessReactor::Unwatch(int fd)
+{
+    wxCriticalSectionLocker locker(s_instanceCS);
+    if(!ms_instance) { return; }
+
+    wxCriticalSectionLocker channelsLocker(ms_instance->m_cs);
+    ms_instance->DoRemove(fd);
+}
+
+void clProcessReactor::Release()
+{
+    clProcessReactor* reactor = NULL;
+    {
+        wxCriticalSectionLocker locker(s_instanceCS);
+        reactor = ms_instance;
+        ms_instance = NULL;
+    }
+    if(!reactor) { return; }
+
+    {
+        wxCriticalSectionLocker locker(reactor->m_cs);
+        reactor->m_shutdown = true;
+        reactor->m_channels.clear();
+    }
+    reactor->Wakeup();
+    reactor->Wait();
+    delete reactor;
+}
+
+size_t clProcessReactor::RemoveTerminalColoring(char* buffer, size_t length, bool& inEscape)
+{
+    size_t count = 0;
+    for(size_t i = 0; i < length; ++i) {
+        char ch = buffer[i];
+        if(inEscape) {
+            switch(ch) {
+            case 'm':
+            case 'K':
+            case 'G':
+            case 'J':
+            case 'H':
+            case 'X':
+            case 'B':
+            case 'C':
+            case 'D':
+            case 'd':
+                inEscape = false;
+                break;
+            default:
+                break;
+            }
+        } else if(ch == 0x1B) { // found ESC char
+            inEscape = true;
+        } else if(ch != 0) {
+            buffer[count++] = ch;
+        }
+    }
+    return count;
+}
+
+wxString clProcessReactor::ConvertOutput(std::string& bytes, bool flush)
+{
+    size_t length = bytes.length();
+    if(!flush) {
+        // Keep a trailing incomplete UTF-8 sequence for the next read
+        for(size_t i = 1; i <= 3 && i <= length; ++i) {
+            unsigned char ch = bytes[length - i];
+            if((ch & 0xC0) == 0x80) {
+                // continuation byte
+                continue;
+            }
+
+            size_t sequenceLen = 1;
+            if((ch & 0xE0) == 0xC0) {
+                sequenceLen = 2;
+            } else if((ch & 0xF0) == 0xE0) {
+                sequenceLen = 3;
+            } else if((ch & 0xF8) == 0xF0) {
+                sequenceLen = 4;
+            }
+            if(sequenceLen > i) { length -= i; }
+            break;
+        }
+    }
+
+    if(length == 0) { return wxString(); }
+    wxString output = wxString::FromUTF8(bytes.data(), length);
+    if(output.IsEmpty()) { output = wxString::From8BitData(bytes.data(), length); }
+    bytes.erase(0, length);
+    return output;
+}
+
+#endif // defined(__WXMAC__) || defined(__WXGTK__)
@@ -0,0 +1,90 @@
+#ifndef CLPROCESSREACTOR_H
+#define CLPROCESSREACTOR_H
+
+#if defined(__WXMAC__) || defined(__WXGTK__)
+#include "codelite_exports.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <wx/event.h>
+#include <wx/string.h>
+#include <wx/thread.h>
+
+class IProcess;
+
+/**
+ * @class clProcessReactor
+ * @brief a single thread that reads the output of all the asynchronous child processes, instead of a reader
+ * thread per process. The read handles are watched with epoll (poll() on platforms without epoll).
+ * All the output that is available for a process when it is woken up is delivered as a single chunk. The
+ * chunk is converted to wxString once, a UTF-8 sequence that is split between two reads is kept until the rest
+ * of it arrives.
+ * The notifications are the same as the ones sent by ProcessReaderThread
+ */
+class WXDLLIMPEXP_CL clProcessReactor : public wxThread
+{
+    struct Channel {
+        IProcess* m_process;
+        wxEvtHandler* m_notifiedWindow;
+        std::string m_pending; // output that was read but not delivered yet
+        bool m_inEscape;       // inside a terminal colouring sequence
+    };
+    typedef std::unordered_map<int, Channel> ChannelsMap_t;
+
+    ChannelsMap_t m_channels;
+    wxCriticalSection m_cs;
+    std::vector<char> m_buffer;
+    int m_pollHandle; // the epoll handle (-1 when poll() is used)
+    int m_wakeupPipe[2];
+    bool m_shutdown;
+
+    static clProcessReactor* ms_instance;
+
+protected:
+    clProcessReactor();
+    virtual ~clProcessReactor();
+
+    bool Init();
+    void Wakeup();
+    bool IsShutdown();
+    void DoWait(std::vector<int>& readyHandles);
+    bool DoAdd(IProcess* process, int fd, wxEvtHandler* notifiedWindow);
+    void DoRemove(int fd);
+    void DoRead(int fd);
+    void DoNotify(Channel& channel, bool terminated);
+    virtual void* Entry();
+
+public:
+    /**
+     * @brief start reading the output of 'process' from 'fd'. The reactor thread is started on the first call
+     * @return false if the handle can not be watched, the caller should read it by itself
+     */
+    static bool Watch(IProcess* process, int fd, wxEvtHandler* notifiedWindow);
+
+    /**
+     * @brief stop reading from 'fd'. Once this function returns, no more notifications are sent for it.
+     * Must be called before the handle is closed
+     */
+    static void Unwatch(int fd);
+
+    /**
+     * @brief stop the reactor thread
+     */
+    static void Release();
+
+    /**
+     * @brief remove the terminal colouring sequences and the null characters from 'buffer' (in place)
+     * @param inEscape [input/output] the state carried between two consecutive reads
+     * @return the new length of the buffer
+     */
+    static size_t RemoveTerminalColoring(char* buffer, size_t length, bool& inEscape);
+
+    /**
+     * @brief convert the complete UTF-8 sequences at the start of 'bytes' and remove them from it.
+     * @param flush convert everything, including a trailing incomplete sequence
+     */
+    static wxString ConvertOutput(std::string& bytes, bool flush);
+};
+
+#endif // defined(__WXMAC__) || defined(__WXGTK__)
+#endif // CLPROCESSREACTOR_H
@@ -0,0 +1,509 @@
+#include "clTagsSymbolIndex.h"
+#include "file_logger.h"
+#include <algorithm>
+#include <iterator>
+#include <wx/stopwatch.h>
+#include <wx/wxsqlite3.h>
+
+// Compact the arena once this many symbols were removed from it
+#define SYMBOL_INDEX_COMPACT_THRESHOLD 4096
+
+#define SYMBOL_INDEX_COLUMNS "ID, name, file, kind, path, scope"
+
+static std::string ToKey(const wxString& str) { return std::string(str.mb_str(wxConvUTF8).data()); }
+
+static inline char AsciiToLower(char c) { return (c >= 'A' && c <= 'Z') ? (c + ('a' - 'A')) : c; }
+
+static inline unsigned int MakeTrigram(const std::string& str, size_t pos)
+{
+    return ((unsigned char)AsciiToLower(str[pos]) << 16) | ((unsigned char)AsciiToLower(str[pos + 1]) << 8) |
+           (unsigned char)AsciiToLower(str[pos + 2]);
+}
+
+static std::string ToLowerKey(const wxString& str)
+{
+    std::string key = ToKey(str);
+    std::transform(key.begin(), key.end(), key.begin(), AsciiToLower);
+    return key;
+}
+
+// 'lowerPart' is expected to be lower-cased already
+static bool ContainsNoCase(const std::string& str, const std::string& lowerPart)
+{
+    if(str.length() < lowerPart.length()) return false;
+    for(size_t i = 0; i + lowerPart.length() <= str.length(); ++i) {
+        size_t j = 0;
+        while(j < lowerPart.length() && AsciiToLower(str[i + j]) == lowerPart[j]) {
+            ++j;
+        }
+        if(j == lowerPart.length()) return true;
+    }
+    return false;
+}
+
+// Same as SQLite 'LIKE' - only ASCII letters are compared case insensitive
+static bool IsPrefixOf(const std::string& prefix, const std::string& str, bool ignoreCase)
+{
+    if(str.length() < prefix.length()) return false;
+    if(!ignoreCase) return str.compare(0, prefix.length(), prefix) == 0;
+    for(size_t i = 0; i < prefix.length(); ++i) {
+        char a = prefix[i];
+        char b = str[i];
+        if(a >= 'A' && a <= 'Z') a += ('a' - 'A');
+        if(b >= 'A' && b <= 'Z') b += ('a' - 'A');
+        if(a != b) return false;
+    }
+    return true;
+}
+
+clTagsSymbolIndex::clTagsSymbolIndex()
+    : m_maxId(0)
+    , m_deletedCount(0)
+    , m_loaded(false)
+    , m_needSync(false)
+    , m_needVerify(false)
+    , m_substringsReady(false)
+{
+}
+
+clTagsSymbolIndex::~clTagsSymbolIndex() {}
+
+void clTagsSymbolIndex::Clear()
+{
+    m_symbols.clear();
+    m_byName.clear();
+    m_byPath.clear();
+    m_byScope.clear();
+    m_byFile.clear();
+    m_files.clear();
+    m_strings.clear();
+    m_nameSubstrings.Clear();
+    m_scopeSubstrings.Clear();
+    m_dirtyFiles.clear();
+    m_maxId = 0;
+    m_deletedCount = 0;
+    m_loaded = false;
+    m_needSync = false;
+    m_needVerify = false;
+    m_substringsReady = false;
+}
+
+const std::string* clTagsSymbolIndex::Intern(const wxString& str) { return &(*m_strings.insert(ToKey(str)).first); }
+
+const std::string* clTagsSymbolIndex::FindInterned(const wxString& str) const
+{
+    std::unordered_set<std::string>::const_iterator iter = m_strings.find(ToKey(str));
+    if(iter == m_strings.end()) return NULL;
+    return &(*iter);
+}
+
+void clTagsSymbolIndex::DoAdd(long id, const wxString& name, const wxString& file, const wxString& kind,
+                              const wxString& path, const wxString& scope)
+{
+    Symbol symbol;
+    symbol.m_id = id;
+    symbol.m_name = ToKey(name);
+    symbol.m_path = ToKey(path);
+    symbol.m_scope = Intern(scope);
+    symbol.m_kind = Intern(kind);
+    symbol.m_file = Intern(file);
+    m_symbols.push_back(symbol);
+    DoIndex(m_symbols.size() - 1);
+
+    FileStats& stats = m_files[symbol.m_file];
+    ++stats.m_count;
+    stats.m_maxId = std::max(stats.m_maxId, id);
+}
+
+void clTagsSymbolIndex::DoIndex(unsigned int index)
+{
+    const Symbol& symbol = m_symbols[index];
+    m_byName[symbol.m_name].push_back(index);
+    m_byPath[symbol.m_path].push_back(index);
+    m_byScope[symbol.m_scope].push_back(index);
+    m_byFile[symbol.m_file].push_back(index);
+    if(m_substringsReady) {
+        m_nameSubstrings.Add(symbol.m_name);
+        m_scopeSubstrings.Add(*symbol.m_scope);
+    }
+}
+
+void clTagsSymbolIndex::DoRemoveFile(const std::string* file)
+{
+    // The symbols are only marked as removed, the other buckets are cleaned by DoCompact()
+    std::unordered_map<const std::string*, Bucket_t>::iterator iter = m_byFile.find(file);
+    if(iter != m_byFile.end()) {
+        for(size_t i = 0; i < iter->second.size(); ++i) {
+            Symbol& symbol = m_symbols[iter->second[i]];
+            if(symbol.m_id == wxNOT_FOUND) continue;
+            symbol.m_id = wxNOT_FOUND;
+            std::string().swap(symbol.m_name);
+            std::string().swap(symbol.m_path);
+            ++m_deletedCount;
+        }
+        m_byFile.erase(iter);
+    }
+    m_files.erase(file);
+}
+
+void clTagsSymbolIndex::DoLoadFile(wxSQLite3Database* db, const wxString& file)
+{
+    wxSQLite3Statement statement = db->PrepareStatement("select " SYMBOL_INDEX_COLUMNS " from tags where file=?");
+    statement.Bind(1, file);
+    wxSQLite3ResultSet rs = statement.ExecuteQuery();
+    while(rs.NextRow()) {
+        DoAdd(rs.GetInt(0), rs.GetString(1), rs.GetString(2), rs.GetString(3), rs.GetString(4), rs.GetString(5));
+    }
+    rs.Finalize();
+}
+
+void clTagsSymbolIndex::DoCompact()
+{
+    std::vector<Symbol> symbols;
+    symbols.reserve(m_symbols.size() - m_deletedCount);
+    for(size_t i = 0; i < m_symbols.size(); ++i) {
+        if(m_symbols[i].m_id != wxNOT_FOUND) { symbols.push_back(m_symbols[i]); }
+    }
+    m_symbols.swap(symbols);
+    m_deletedCount = 0;
+
+    m_byName.clear();
+    m_byPath.clear();
+    m_byScope.clear();
+    m_byFile.clear();
+    for(size_t i = 0; i < m_symbols.size(); ++i) {
+        DoIndex(i);
+    }
+}
+
+bool clTagsSymbolIndex::DoLoad(wxSQLite3Database* db)
+{
+    wxStopWatch sw;
+    Clear();
+    wxSQLite3ResultSet rs = db->ExecuteQuery("select " SYMBOL_INDEX_COLUMNS " from tags");
+    while(rs.NextRow()) {
+        long id = rs.GetInt(0);
+        DoAdd(id, rs.GetString(1), rs.GetString(2), rs.GetString(3), rs.GetString(4), rs.GetString(5));
+        m_maxId = std::max(m_maxId, id);
+    }
+    rs.Finalize();
+    m_loaded = true;
+    clDEBUG() << "Symbol index: loaded" << m_symbols.size() << "symbols from" << m_files.size() << "files in"
+              << sw.Time() << "ms" << clEndl;
+    return true;
+}
+
+bool clTagsSymbolIndex::DoSync(wxSQLite3Database* db)
+{
+    // Files are retagged with INSERT OR REPLACE and the IDs are AUTOINCREMENT, so the files that were modified since
+    // the last sync are the ones that have tags above the highest ID we have seen. Take the highest ID first: tags
+    // that are added while we reload are found again by the next sync
+    long maxId = db->ExecuteScalar(wxT("select max(ID) from tags"));
+    std::set<wxString> modified;
+    modified.swap(m_dirtyFiles);
+    if(maxId > m_maxId) {
+        wxSQLite3Statement statement = db->PrepareStatement("select distinct file from tags where ID > ? and ID <= ?");
+        statement.Bind(1, (int)m_maxId);
+        statement.Bind(2, (int)maxId);
+        wxSQLite3ResultSet rs = statement.ExecuteQuery();
+        while(rs.NextRow()) {
+            modified.insert(rs.GetString(0));
+        }
+        rs.Finalize();
+        m_maxId = maxId;
+    }
+
+    // When most of the files were modified, it is faster to load everything again
+    if(modified.size() > (m_files.size() / 2)) { return DoLoad(db); }
+    return DoReloadFiles(db, modified);
+}
+
+bool clTagsSymbolIndex::DoReloadFiles(wxSQLite3Database* db, const std::set<wxString>& files)
+{
+    std::set<wxString>::const_iterator iter = files.begin();
+    for(; iter != files.end(); ++iter) {
+        const std::string* key = FindInterned(*iter);
+        if(key) { DoRemoveFile(key); }
+        DoLoadFile(db, *iter);
+    }
+
+    if(m_deletedCount > SYMBOL_INDEX_COMPACT_THRESHOLD && m_deletedCount > (m_symbols.size() / 4)) { DoCompact(); }
+
+    if(!files.empty()) { clDEBUG1() << "Symbol index: reloaded" << files.size() << "files" << clEndl; }
+    return true;
+}
+
+bool clTagsSymbolIndex::DoVerify(wxSQLite3Database* db)
+{
+    // Compare the tags of every file with what we have in memory
+    long maxId = db->ExecuteScalar(wxT("select max(ID) from tags"));
+    std::unordered_set<const std::string*> found;
+    std::set<wxString> modified;
+    modified.swap(m_dirtyFiles);
+    wxSQLite3ResultSet rs = db->ExecuteQuery(wxT("select file, count(*), max(ID) from tags group by file"));
+    while(rs.NextRow()) {
+        wxString file = rs.GetString(0);
+        const std::string* key = FindInterned(file);
+        if(key) {
+            found.insert(key);
+            std::unordered_map<const std::string*, FileStats>::iterator iter = m_files.find(key);
+            if(iter != m_files.end() && iter->second.m_count == (size_t)rs.GetInt(1) &&
+               iter->second.m_maxId == rs.GetInt(2)) {
+                continue;
+            }
+        }
+        modified.insert(file);
+    }
+    rs.Finalize();
+    m_maxId = std::max(m_maxId, maxId);
+
+    // When most of the files were modified, it is faster to load everything again
+    if(modified.size() > (m_files.size() / 2)) { return DoLoad(db); }
+
+    std::vector<const std::string*> removed;
+    std::unordered_map<const std::string*, FileStats>::iterator iter = m_files.begin();
+    for(; iter != m_files.end(); ++iter) {
+        if(found.count(iter->first) == 0) { removed.push_back(iter->first); }
+    }
+    for(size_t i = 0; i < removed.size(); ++i) {
+        DoRemoveFile(removed[i]);
+    }
+    if(!removed.empty()) { clDEBUG1() << "Symbol index: removed" << removed.size() << "files" << clEndl; }
+    return DoReloadFiles(db, modified);
+}
+
+bool clTagsSymbolIndex::Sync(wxSQLite3Database* db)
+{
+    if(m_loaded && !m_needSync) return true;
+    try {
+        if(!m_loaded) { return DoLoad(db); }
+        bool verify = m_needVerify;
+        m_needSync = false;
+        m_needVerify = false;
+        return verify ? DoVerify(db) : DoSync(db);
+
+    } catch(wxSQLite3Exception& e) {
+        clWARNING() << "Symbol index: failed to read the tags:" << e.GetMessage() << clEndl;
+        Clear();
+    }
+    return false;
+}
+
+void clTagsSymbolIndex::FindByScopeAndName(const wxString& scope, const wxString& name, bool partial, bool ignoreCase,
+                                           size_t limit, SymbolPtrVec_t& symbols) const
+{
+    const std::string* scopeKey = FindInterned(scope);
+    if(!scopeKey) return;
+
+    std::unordered_map<const std::string*, Bucket_t>::const_iterator scopeIter = m_byScope.find(scopeKey);
+    if(scopeIter == m_byScope.end()) return;
+
+    // For an exact name, scan the smaller of the two buckets
+    const Bucket_t* bucket = &scopeIter->second;
+    std::string nameKey = ToKey(name);
+    if(!nameKey.empty() && !partial) {
+        std::unordered_map<std::string, Bucket_t>::const_iterator nameIter = m_byName.find(nameKey);
+        if(nameIter == m_byName.end()) return;
+        if(nameIter->second.size() < bucket->size()) { bucket = &nameIter->second; }
+    }
+
+    size_t count = 0;
+    for(size_t i = 0; i < bucket->size(); ++i) {
+        const Symbol& symbol = m_symbols[bucket->at(i)];
+        if(symbol.m_id == wxNOT_FOUND || symbol.m_scope != scopeKey) continue;
+        if(!nameKey.empty()) {
+            if(partial ? !IsPrefixOf(nameKey, symbol.m_name, ignoreCase) : (symbol.m_name != nameKey)) continue;
+        }
+        symbols.push_back(&symbol);
+        if(limit && (++count >= limit)) break;
+    }
+}
+
+void clTagsSymbolIndex::FindByName(const wxString& name, size_t limit, SymbolPtrVec_t& symbols) const
+{
+    std::unordered_map<std::string, Bucket_t>::const_iterator iter = m_byName.find(ToKey(name));
+    if(iter == m_byName.end()) return;
+
+    size_t count = 0;
+    for(size_t i = 0; i < iter->second.size(); ++i) {
+        const Symbol& symbol = m_symbols[iter->second[i]];
+        if(symbol.m_id == wxNOT_FOUND) continue;
+        symbols.push_back(&symbol);
+        if(limit && (++count >= limit)) break;
+    }
+}
+
+void clTagsSymbolIndex::FindByPath(const wxString& path, size_t limit, SymbolPtrVec_t& symbols) const
+{
+    std::unordered_map<std::string, Bucket_t>::const_iterator iter = m_byPath.find(ToKey(path));
+    if(iter == m_byPath.end()) return;
+
+    size_t count = 0;
+    for(size_t i = 0; i < iter->second.size(); ++i) {
+        const Symbol& symbol = m_symbols[iter->second[i]];
+        if(symbol.m_id == wxNOT_FOUND) continue;
+        symbols.push_back(&symbol);
+        if(limit && (++count >= limit)) break;
+    }
+}
+
+void clTagsSymbolIndex::DoBuildSubstrings()
+{
+    wxStopWatch sw;
+    for(size_t i = 0; i < m_symbols.size(); ++i) {
+        const Symbol& symbol = m_symbols[i];
+        if(symbol.m_id == wxNOT_FOUND) continue;
+        m_nameSubstrings.Add(symbol.m_name);
+        m_scopeSubstrings.Add(*symbol.m_scope);
+    }
+    m_substringsReady = true;
+    clDEBUG() << "Symbol index: built the substring index in" << sw.Time() << "ms" << clEndl;
+}
+
+bool clTagsSymbolIndex::DoAddBucket(const Bucket_t& bucket, const std::vector<std::string>& pathParts, size_t maxSize,
+                                    std::unordered_set<unsigned int>& visited, SymbolPtrVec_t& symbols) const
+{
+    for(size_t i = 0; i < bucket.size(); ++i) {
+        const Symbol& symbol = m_symbols[bucket[i]];
+        if(symbol.m_id == wxNOT_FOUND || !visited.insert(bucket[i]).second) continue;
+
+        bool match = true;
+        for(size_t n = 0; match && n < pathParts.size(); ++n) {
+            match = ContainsNoCase(symbol.m_path, pathParts[n]);
+        }
+        if(!match) continue;
+
+        symbols.push_back(&symbol);
+        if(maxSize && symbols.size() >= maxSize) return false;
+    }
+    return true;
+}
+
+void clTagsSymbolIndex::FindByNameSubstring(const wxString& part, size_t limit, SymbolPtrVec_t& symbols)
+{
+    if(!m_substringsReady) { DoBuildSubstrings(); }
+
+    std::vector<const std::string*> names;
+    m_nameSubstrings.Find(ToLowerKey(part), names);
+
+    size_t maxSize = limit ? (symbols.size() + limit) : 0;
+    std::unordered_set<unsigned int> visited;
+    std::vector<std::string> pathParts;
+    for(size_t i = 0; i < names.size(); ++i) {
+        std::unordered_map<std::string, Bucket_t>::const_iterator iter = m_byName.find(*names[i]);
+        if(iter == m_byName.end()) continue;
+        if(!DoAddBucket(iter->second, pathParts, maxSize, visited, symbols)) break;
+    }
+}
+
+bool clTagsSymbolIndex::FindByPathSubstrings(const wxArrayString& parts, size_t limit, SymbolPtrVec_t& symbols)
+{
+    // The candidates are collected using the longest part, the other parts are checked against the path
+    std::vector<std::string> pathParts;
+    std::string longest;
+    for(size_t i = 0; i < parts.GetCount(); ++i) {
+        std::string part = ToLowerKey(parts.Item(i));
+        if(part.empty()) continue;
+        if(part.find(':') != std::string::npos) return false;
+        if(part.length() > longest.length()) { longest = part; }
+        pathParts.push_back(part);
+    }
+    if(longest.empty()) return false;
+    if(!m_substringsReady) { DoBuildSubstrings(); }
+
+    size_t maxSize = limit ? (symbols.size() + limit) : 0;
+    std::unordered_set<unsigned int> visited;
+
+    // A path is "scope::name", or just the name for a global symbol
+    std::vector<const std::string*> matches;
+    m_nameSubstrings.Find(longest, matches);
+    for(size_t i = 0; i < matches.size(); ++i) {
+        std::unordered_map<std::string, Bucket_t>::const_iterator iter = m_byName.find(*matches[i]);
+        if(iter == m_byName.end()) continue;
+        if(!DoAddBucket(iter->second, pathParts, maxSize, visited, symbols)) return true;
+    }
+
+    matches.clear();
+    m_scopeSubstrings.Find(longest, matches);
+    for(size_t i = 0; i < matches.size(); ++i) {
+        // "<global>" is not part of the path
+        if(*matches[i] == "<global>") continue;
+        std::unordered_set<std::string>::const_iterator interned = m_strings.find(*matches[i]);
+        if(interned == m_strings.end()) continue;
+        std::unordered_map<const std::string*, Bucket_t>::const_iterator iter = m_byScope.find(&(*interned));
+        if(iter == m_byScope.end()) continue;
+        if(!DoAddBucket(iter->second, pathParts, maxSize, visited, symbols)) return true;
+    }
+    return true;
+}
+
+void clTagsSymbolIndex::FilterByKind(const wxArrayString& kinds, SymbolPtrVec_t& symbols)
+{
+    std::unordered_set<std::string> kindsSet;
+    for(size_t i = 0; i < kinds.GetCount(); ++i) {
+        kindsSet.insert(ToKey(kinds.Item(i)));
+    }
+    symbols.erase(std::remove_if(symbols.begin(), symbols.end(),
+                                 [&](const Symbol* symbol) { return kindsSet.count(*symbol->m_kind) == 0; }),
+                  symbols.end());
+}
+
+void clTagsSymbolIndex::SubstringIndex::Clear()
+{
+    m_ids.clear();
+    m_byId.clear();
+    m_postings.clear();
+}
+
+void clTagsSymbolIndex::SubstringIndex::Add(const std::string& str)
+{
+    std::pair<std::unordered_map<std::string, unsigned int>::iterator, bool> res =
+        m_ids.insert(std::make_pair(str, (unsigned int)m_byId.size()));
+    if(!res.second) return;
+
+    unsigned int id = res.first->second;
+    m_byId.push_back(&res.first->first);
+    for(size_t i = 0; i + 2 < str.length(); ++i) {
+        // IDs are added in increasing order, so the postings remain sorted
+        std::vector<unsigned int>& posting = m_postings[MakeTrigram(str, i)];
+        if(posting.empty() || posting.back() != id) { posting.push_back(id); }
+    }
+}
+
+void clTagsSymbolIndex::SubstringIndex::Find(const std::string& part, std::vector<const std::string*>& matches) const
+{
+    if(part.length() < 3) {
+        // Too short to have a trigram, check all the strings
+        for(size_t i = 0; i < m_byId.size(); ++i) {
+            if(ContainsNoCase(*m_byId[i], part)) { matches.push_back(m_byId[i]); }
+        }
+        return;
+    }
+
+    std::vector<const std::vector<unsigned int>*> postings;
+    for(size_t i = 0; i + 2 < part.length(); ++i) {
+        std::unordered_map<unsigned int, std::vector<unsigned int> >::const_iterator iter =
+            m_postings.find(MakeTrigram(part, i));
+        if(iter == m_postings.end()) return;
+        postings.push_back(&iter->second);
+    }
+
+    // Intersect the postings, starting with the shortest one
+    std::sort(postings.begin(), postings.end(),
+              [](const std::vector<unsigned int>* a, const std::vector<unsigned int>* b) {
+                  return a->size() < b->size();
+              });
+    std::vector<unsigned int> candidates(*postings[0]);
+    for(size_t i = 1; i < postings.size() && !candidates.empty(); ++i) {
+        std::vector<unsigned int> intersection;
+        std::set_intersection(candidates.begin(), candidates.end(), postings[i]->begin(), postings[i]->end(),
+                              std::back_inserter(intersection));
+        candidates.swap(intersection);
+    }
+
+    // The trigrams may appear in a different order in the string
+    for(size_t i = 0; i < candidates.size(); ++i) {
+        const std::string* str = m_byId[candidates[i]];
+        if(ContainsNoCase(*str, part)) { matches.push_back(str); }
+    }
+}
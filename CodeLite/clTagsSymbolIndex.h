@@ -0,0 +1,180 @@
+#ifndef CLTAGSSYMBOLINDEX_H
+#define CLTAGSSYMBOLINDEX_H
+
+#include "codelite_exports.h"
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <wx/arrstr.h>
+#include <wx/string.h>
+
+class wxSQLite3Database;
+
+/**
+ * @class clTagsSymbolIndex
+ * @brief an in-memory index of the TAGS table used to answer the code completion lookups without running SQL.
+ * Only the columns needed for the lookups (id, name, scope, path, kind and file) are kept in a contiguous arena.
+ * The full tags are fetched from the database by their ID.
+ * The index is loaded once from the database and then kept up to date per file. Tags are never updated in place and
+ * their IDs only grow, so a sync reloads the files that have tags with an ID above the highest ID seen so far, and
+ * the files that were marked dirty. A complete comparison of every file with the database (which also finds the
+ * files whose tags were deleted) is only done after MarkOutOfDate().
+ * Substring lookups use a trigram index of the distinct names and scopes. It is built on the first
+ * substring lookup and then updated with the symbols that are added to the index.
+ * The symbols returned by the Find methods are valid until the next call to Sync() or Clear().
+ * This class is not thread safe
+ */
+class WXDLLIMPEXP_CL clTagsSymbolIndex
+{
+public:
+    struct Symbol {
+        long m_id; // wxNOT_FOUND for a removed symbol
+        std::string m_name;
+        std::string m_path;
+        const std::string* m_scope;
+        const std::string* m_kind;
+        const std::string* m_file;
+    };
+    typedef std::vector<const Symbol*> SymbolPtrVec_t;
+
+protected:
+    typedef std::vector<unsigned int> Bucket_t; // indexes into m_symbols
+    struct FileStats {
+        size_t m_count;
+        long m_maxId;
+    };
+
+    /**
+     * @class SubstringIndex
+     * @brief maps the (ASCII lower-cased) trigrams of a set of distinct strings to the strings containing them.
+     * Strings are never removed, a string without symbols is skipped by the caller
+     */
+    class SubstringIndex
+    {
+        std::unordered_map<std::string, unsigned int> m_ids;
+        std::vector<const std::string*> m_byId;
+        std::unordered_map<unsigned int, std::vector<unsigned int> > m_postings; // trigram -> sorted string IDs
+
+    public:
+        void Add(const std::string& str);
+        void Clear();
+        /**
+         * @brief find the strings that contain 'part', ASCII case insensitive
+         */
+        void Find(const std::string& part, std::vector<const std::string*>& matches) const;
+    };
+
+    std::vector<Symbol> m_symbols;
+    std::unordered_set<std::string> m_strings; // interned scopes, kinds and files
+    std::unordered_map<std::string, Bucket_t> m_byName;
+    std::unordered_map<std::string, Bucket_t> m_byPath;
+    std::unordered_map<const std::string*, Bucket_t> m_byScope;
+    std::unordered_map<const std::string*, Bucket_t> m_byFile;
+    std::unordered_map<const std::string*, FileStats> m_files;
+    SubstringIndex m_nameSubstrings;
+    SubstringIndex m_scopeSubstrings;
+    std::set<wxString> m_dirtyFiles;
+    long m_maxId; // the highest tag ID that was seen by the last sync
+    size_t m_deletedCount;
+    bool m_loaded;
+    bool m_needSync;
+    bool m_needVerify;
+    bool m_substringsReady;
+
+protected:
+    const std::string* Intern(const wxString& str);
+    const std::string* FindInterned(const wxString& str) const;
+    void DoAdd(long id, const wxString& name, const wxString& file, const wxString& kind, const wxString& path,
+               const wxString& scope);
+    void DoIndex(unsigned int index);
+    void DoRemoveFile(const std::string* file);
+    void DoLoadFile(wxSQLite3Database* db, const wxString& file);
+    void DoCompact();
+    bool DoLoad(wxSQLite3Database* db);
+    bool DoSync(wxSQLite3Database* db);
+    bool DoVerify(wxSQLite3Database* db);
+    bool DoReloadFiles(wxSQLite3Database* db, const std::set<wxString>& files);
+    void DoBuildSubstrings();
+    bool DoAddBucket(const Bucket_t& bucket, const std::vector<std::string>& pathParts, size_t maxSize,
+                     std::unordered_set<unsigned int>& visited, SymbolPtrVec_t& symbols) const;
+
+public:
+    clTagsSymbolIndex();
+    virtual ~clTagsSymbolIndex();
+
+    /**
+     * @brief remove all symbols. The index will be loaded again by the next call to Sync()
+     */
+    void Clear();
+
+    /**
+     * @brief the database was modified, look for new tags on the next call to Sync()
+     */
+    void MarkDirty() { m_needSync = true; }
+
+    /**
+     * @brief the tags of 'file' were modified, reload them on the next call to Sync()
+     */
+    void MarkFileDirty(const wxString& file)
+    {
+        m_dirtyFiles.insert(file);
+        m_needSync = true;
+    }
+
+    /**
+     * @brief some of the symbols no longer exist in the database, compare every file with the database on the next
+     * call to Sync()
+     */
+    void MarkOutOfDate()
+    {
+        m_needVerify = true;
+        m_needSync = true;
+    }
+
+    /**
+     * @brief load the index on the first call, and reload the modified files after one of the Mark methods was called
+     * @return true if the index can be used
+     */
+    bool Sync(wxSQLite3Database* db);
+
+    /**
+     * @brief find the symbols of a given scope. An empty 'name' returns all the symbols of the scope
+     * @param partial when true, 'name' is a prefix of the symbol name
+     * @param ignoreCase when true, a partial name is matched ASCII case insensitive (like SQLite 'LIKE' does)
+     * @param limit the maximum number of symbols to add to 'symbols'. 0 means no limit
+     */
+    void FindByScopeAndName(const wxString& scope, const wxString& name, bool partial, bool ignoreCase, size_t limit,
+                            SymbolPtrVec_t& symbols) const;
+
+    /**
+     * @brief find the symbols with the given name (exact match)
+     */
+    void FindByName(const wxString& name, size_t limit, SymbolPtrVec_t& symbols) const;
+
+    /**
+     * @brief find the symbols with the given path (exact match)
+     */
+    void FindByPath(const wxString& path, size_t limit, SymbolPtrVec_t& symbols) const;
+
+    /**
+     * @brief find the symbols that their name contains 'part' (ASCII case insensitive, like SQLite 'LIKE' does)
+     */
+    void FindByNameSubstring(const wxString& part, size_t limit, SymbolPtrVec_t& symbols);
+
+    /**
+     * @brief find the symbols that their path contains all of 'parts' (ASCII case insensitive).
+     * The candidates are collected from the names and the scopes, so a part that spans both (i.e. contains ':')
+     * can not be answered by the index
+     * @return false if the index can not be used for these parts
+     */
+    bool FindByPathSubstrings(const wxArrayString& parts, size_t limit, SymbolPtrVec_t& symbols);
+
+    /**
+     * @brief keep only the symbols that their kind is one of 'kinds'
+     */
+    static void FilterByKind(const wxArrayString& kinds, SymbolPtrVec_t& symbols);
+};
+
+#endif // CLTAGSSYMBOLINDEX_H
@@ -0,0 +1,525 @@
+#include "clFileFingerprint.h"
+#include "clMemoryMappedFile.h"
+#include "clTrigramIndex.h"
+#include "file_logger.h"
+#include <algorithm>
+#include <iterator>
+#include <string.h>
+#include <wx/ffile.h>
+#include <wx/filefn.h>
+
+// Files larger than this are not indexed, so they are always searched
+#define TRIGRAM_INDEX_MAX_FILE_SIZE (8 * 1024 * 1024)
+
+// Compact the index once that many files were removed or re-indexed
+#define TRIGRAM_INDEX_COMPACT_THRESHOLD 1024
+
+#define TRIGRAM_INDEX_MAGIC "CLTRIGRAMS"
+#define TRIGRAM_INDEX_VERSION 2
+
+static inline unsigned char AsciiToLower(unsigned char c) { return (c >= 'A' && c <= 'Z') ? (c + ('a' - 'A')) : c; }
+
+static inline bool IsLineBreak(unsigned char c) { return c == '\n' || c == '\r' || c == 0; }
+
+/**
+ * @brief collect the unique trigrams of 'data' into 'trigrams' (sorted). Trigrams that span multiple lines are
+ * ignored: the search never matches across lines
+ */
+static void GetTrigrams(const char* data, size_t len, std::vector<unsigned int>& trigrams)
+{
+    trigrams.clear();
+    if(len < 3) { return; }
+
+    trigrams.reserve(len - 2);
+    const unsigned char* p = (const unsigned char*)data;
+    unsigned char a = AsciiToLower(p[0]);
+    unsigned char b = AsciiToLower(p[1]);
+    for(size_t i = 2; i < len; ++i) {
+        unsigned char c = AsciiToLower(p[i]);
+        if(!IsLineBreak(a) && !IsLineBreak(b) && !IsLineBreak(c)) {
+            trigrams.push_back((a << 16) | (b << 8) | c);
+        }
+        a = b;
+        b = c;
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+}
+
+/**
+ * @class TrigramIndexReader
+ * @brief bounds checked reader over the content of an index file
+ */
+class TrigramIndexReader
+{
+    const char* m_data;
+    size_t m_size;
+    size_t m_offset;
+
+public:
+    TrigramIndexReader(const char* data, size_t size)
+        : m_data(data)
+        , m_size(size)
+        , m_offset(0)
+    {
+    }
+
+    bool Read(void* buffer, size_t len)
+    {
+        if(len > (m_size - m_offset)) { return false; }
+        memcpy(buffer, m_data + m_offset, len);
+        m_offset += len;
+        return true;
+    }
+
+    template <typename T> bool Read(T& value) { return Read(&value, sizeof(value)); }
+
+    bool ReadString(wxString& str)
+    {
+        unsigned int len(0);
+        if(!Read(len) || (len > (m_size - m_offset))) { return false; }
+        str = wxString(m_data + m_offset, wxConvUTF8, len);
+        m_offset += len;
+        return true;
+    }
+};
+
+clTrigramIndex::clTrigramIndex(const wxFileName& filename)
+    : m_filename(filename)
+    , m_deletedCount(0)
+    , m_modified(false)
+{
+}
+
+clTrigramIndex::~clTrigramIndex() {}
+
+void clTrigramIndex::DoClear()
+{
+    m_files.clear();
+    m_fileIds.clear();
+    m_postings.clear();
+    m_deletedCount = 0;
+}
+
+void clTrigramIndex::Clear()
+{
+    wxCriticalSectionLocker locker(m_cs);
+    DoClear();
+    m_modified = true;
+}
+
+bool clTrigramIndex::Load()
+{
+    wxCriticalSectionLocker locker(m_cs);
+    DoClear();
+    m_modified = false;
+
+    clMemoryMappedFile file;
+    if(!file.Open(m_filename.GetFullPath()) || (file.GetSize() == 0)) { return false; }
+
+    TrigramIndexReader reader(file.GetData(), file.GetSize());
+    char magic[sizeof(TRIGRAM_INDEX_MAGIC) - 1];
+    unsigned int version(0);
+    if(!reader.Read(magic, sizeof(magic)) || (memcmp(magic, TRIGRAM_INDEX_MAGIC, sizeof(magic)) != 0) ||
+       !reader.Read(version) || (version != TRIGRAM_INDEX_VERSION)) {
+        clWARNING() << "Ignoring invalid trigram index file:" << m_filename << clEndl;
+        return false;
+    }
+
+    bool ok = true;
+    unsigned int filesCount(0);
+    ok = reader.Read(filesCount);
+    for(unsigned int i = 0; ok && (i < filesCount); ++i) {
+        FileEntry entry;
+        wxInt64 lastModified(0);
+        wxUint64 size(0);
+        ok = reader.ReadString(entry.m_filename) && reader.Read(lastModified) && reader.Read(size);
+        entry.m_lastModified = lastModified;
+        entry.m_size = (size_t)size;
+        entry.m_deleted = false;
+        if(ok) {
+            m_fileIds[entry.m_filename] = (FileId_t)m_files.size();
+            m_files.push_back(entry);
+        }
+    }
+
+    unsigned int postingsCount(0);
+    ok = ok && reader.Read(postingsCount);
+    for(unsigned int i = 0; ok && (i < postingsCount); ++i) {
+        unsigned int trigram(0);
+        unsigned int count(0);
+        ok = reader.Read(trigram) && reader.Read(count) && (count <= m_files.size());
+        if(!ok) { break; }
+
+        std::vector<FileId_t>& ids = m_postings[trigram];
+        ids.resize(count);
+        ok = (count == 0) || reader.Read(&ids[0], count * sizeof(FileId_t));
+        ok = ok && std::all_of(ids.begin(), ids.end(), [&](FileId_t id) { return id < m_files.size(); });
+    }
+
+    if(!ok) {
+        clWARNING() << "Trigram index file:" << m_filename << "is corrupted" << clEndl;
+        DoClear();
+        return false;
+    }
+    clDEBUG() << "Trigram index loaded:" << m_files.size() << "files," << m_postings.size() << "trigrams" << clEndl;
+    return true;
+}
+
+bool clTrigramIndex::Save()
+{
+    wxCriticalSectionLocker locker(m_cs);
+    if(!m_modified) { return true; }
+    if(m_deletedCount) { DoCompact(); }
+
+    // Write to a temporary file first so a crash never leaves a truncated index behind
+    wxString tmpfile = m_filename.GetFullPath() + ".tmp";
+    {
+        wxFFile fp(tmpfile, "wb");
+        if(!fp.IsOpened()) { return false; }
+
+        bool ok = fp.Write(TRIGRAM_INDEX_MAGIC, sizeof(TRIGRAM_INDEX_MAGIC) - 1) == (sizeof(TRIGRAM_INDEX_MAGIC) - 1);
+        unsigned int version = TRIGRAM_INDEX_VERSION;
+        ok = ok && (fp.Write(&version, sizeof(version)) == sizeof(version));
+
+        unsigned int filesCount = m_files.size();
+        ok = ok && (fp.Write(&filesCount, sizeof(filesCount)) == sizeof(filesCount));
+        for(size_t i = 0; ok && (i < m_files.size()); ++i) {
+            const FileEntry& entry = m_files[i];
+            wxCharBuffer name = entry.m_filename.mb_str(wxConvUTF8);
+            unsigned int len = name.length();
+            wxInt64 lastModified = entry.m_lastModified;
+            wxUint64 size = entry.m_size;
+            ok = (fp.Write(&len, sizeof(len)) == sizeof(len)) && (fp.Write(name.data(), len) == len) &&
+                 (fp.Write(&lastModified, sizeof(lastModified)) == sizeof(lastModified)) &&
+                 (fp.Write(&size, sizeof(size)) == sizeof(size));
+        }
+
+        unsigned int postingsCount = m_postings.size();
+        ok = ok && (fp.Write(&postingsCount, sizeof(postingsCount)) == sizeof(postingsCount));
+        std::unordered_map<unsigned int, std::vector<FileId_t> >::const_iterator iter = m_postings.begin();
+        for(; ok && (iter != m_postings.end()); ++iter) {
+            unsigned int trigram = iter->first;
+            unsigned int count = iter->second.size();
+            size_t bytes = count * sizeof(FileId_t);
+            ok = (fp.Write(&trigram, sizeof(trigram)) == sizeof(trigram)) &&
+                 (fp.Write(&count, sizeof(count)) == sizeof(count)) &&
+                 ((count == 0) || (fp.Write(&iter->second[0], bytes) == bytes));
+        }
+
+        if(!ok || !fp.Close()) {
+            clWARNING() << "Failed to write trigram index file:" << tmpfile << clEndl;
+            ::wxRemoveFile(tmpfile);
+            return false;
+        }
+    }
+
+    if(!::wxRenameFile(tmpfile, m_filename.GetFullPath(), true)) { return false; }
+    m_modified = false;
+    return true;
+}
+
+void clTrigramIndex::DoRemove(const wxString& filename)
+{
+    std::unordered_map<wxString, FileId_t>::iterator iter = m_fileIds.find(filename);
+    if(iter == m_fileIds.end()) { return; }
+
+    // The file id remains in the posting lists until the next compaction
+    m_files[iter->second].m_deleted = true;
+    m_fileIds.erase(iter);
+    ++m_deletedCount;
+    m_modified = true;
+}
+
+void clTrigramIndex::DoCompact()
+{
+    const FileId_t deletedId = (FileId_t)-1;
+    std::vector<FileId_t> newIds(m_files.size(), deletedId);
+    std::vector<FileEntry> files;
+    files.reserve(m_files.size() - m_deletedCount);
+    for(size_t i = 0; i < m_files.size(); ++i) {
+        if(m_files[i].m_deleted) { continue; }
+        newIds[i] = (FileId_t)files.size();
+        m_fileIds[m_files[i].m_filename] = newIds[i];
+        files.push_back(m_files[i]);
+    }
+    m_files.swap(files);
+
+    // Ids are renumbered in the same order, so the posting lists remain sorted
+    std::unordered_map<unsigned int, std::vector<FileId_t> >::iterator iter = m_postings.begin();
+    while(iter != m_postings.end()) {
+        std::vector<FileId_t>& ids = iter->second;
+        size_t count = 0;
+        for(size_t i = 0; i < ids.size(); ++i) {
+            if(newIds[ids[i]] != deletedId) { ids[count++] = newIds[ids[i]]; }
+        }
+        if(count == 0) {
+            iter = m_postings.erase(iter);
+        } else {
+            ids.resize(count);
+            ++iter;
+        }
+    }
+    m_deletedCount = 0;
+}
+
+void clTrigramIndex::Update(const wxString& filename, const char* data, size_t len, wxInt64 lastModified, size_t size)
+{
+    if(len > TRIGRAM_INDEX_MAX_FILE_SIZE) {
+        Remove(filename);
+        return;
+    }
+
+    // Collect the trigrams before taking the lock
+    std::vector<unsigned int> trigrams;
+    GetTrigrams(data, len, trigrams);
+
+    wxCriticalSectionLocker locker(m_cs);
+    DoRemove(filename);
+
+    FileEntry entry;
+    entry.m_filename = filename.c_str(); // deep copy, this method is called from multiple threads
+    entry.m_lastModified = lastModified;
+    entry.m_size = size;
+    entry.m_deleted = false;
+
+    // New ids are always the largest, appending them keeps the posting lists sorted
+    FileId_t id = (FileId_t)m_files.size();
+    m_files.push_back(entry);
+    m_fileIds[entry.m_filename] = id;
+    for(size_t i = 0; i < trigrams.size(); ++i) {
+        m_postings[trigrams[i]].push_back(id);
+    }
+    m_modified = true;
+
+    if(m_deletedCount > TRIGRAM_INDEX_COMPACT_THRESHOLD && m_deletedCount > (m_files.size() / 2)) { DoCompact(); }
+}
+
+bool clTrigramIndex::Update(const wxString& filename)
+{
+    wxInt64 lastModified(0);
+    size_t size(0);
+    if(!GetFileAttributes(filename, lastModified, size)) {
+        Remove(filename);
+        return false;
+    }
+
+    if(size > TRIGRAM_INDEX_MAX_FILE_SIZE) {
+        Remove(filename);
+        return true;
+    }
+
+    clMemoryMappedFile file;
+    if(!file.Open(filename)) {
+        Remove(filename);
+        return false;
+    }
+    Update(filename, file.GetData(), file.GetSize(), lastModified, size);
+    return true;
+}
+
+void clTrigramIndex::Remove(const wxString& filename)
+{
+    wxCriticalSectionLocker locker(m_cs);
+    DoRemove(filename);
+}
+
+bool clTrigramIndex::IsUpToDate(const wxString& filename)
+{
+    wxInt64 lastModified(0);
+    size_t size(0);
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        std::unordered_map<wxString, FileId_t>::const_iterator iter = m_fileIds.find(filename);
+        if(iter == m_fileIds.end()) { return false; }
+        lastModified = m_files[iter->second].m_lastModified;
+        size = m_files[iter->second].m_size;
+    }
+
+    wxInt64 curLastModified(0);
+    size_t curSize(0);
+    return GetFileAttributes(filename, curLastModified, curSize) && (curLastModified == lastModified) &&
+           (curSize == size);
+}
+
+size_t clTrigramIndex::GetFilesCount()
+{
+    wxCriticalSectionLocker locker(m_cs);
+    return m_fileIds.size();
+}
+
+bool clTrigramIndex::Filter(const std::string& literal, wxArrayString& files, std::vector<bool>& stale)
+{
+    if(literal.length() < 3) { return false; }
+    for(size_t i = 0; i < literal.length(); ++i) {
+        if((unsigned char)literal[i] > 127) { return false; }
+    }
+
+    std::vector<unsigned int> trigrams;
+    GetTrigrams(literal.c_str(), literal.length(), trigrams);
+    if(trigrams.empty()) { return false; }
+
+    // The state of each file, as recorded in the index
+    enum eState { kNotIndexed, kMatch, kNoMatch };
+    struct IndexedFile {
+        eState m_state;
+        wxInt64 m_lastModified;
+        size_t m_size;
+    };
+    std::vector<IndexedFile> indexedFiles(files.GetCount());
+    {
+        wxCriticalSectionLocker locker(m_cs);
+
+        // Intersect the posting lists, starting with the shortest one
+        std::vector<const std::vector<FileId_t>*> lists;
+        for(size_t i = 0; i < trigrams.size(); ++i) {
+            std::unordered_map<unsigned int, std::vector<FileId_t> >::const_iterator iter = m_postings.find(trigrams[i]);
+            if(iter == m_postings.end()) {
+                lists.clear();
+                break;
+            }
+            lists.push_back(&iter->second);
+        }
+        std::sort(lists.begin(), lists.end(),
+                  [](const std::vector<FileId_t>* a, const std::vector<FileId_t>* b) { return a->size() < b->size(); });
+
+        std::vector<FileId_t> matches;
+        if(!lists.empty()) {
+            matches = *lists[0];
+            for(size_t i = 1; i < lists.size() && !matches.empty(); ++i) {
+                std::vector<FileId_t> intersection;
+                std::set_intersection(matches.begin(), matches.end(), lists[i]->begin(), lists[i]->end(),
+                                      std::back_inserter(intersection));
+                matches.swap(intersection);
+            }
+        }
+
+        for(size_t i = 0; i < files.GetCount(); ++i) {
+            IndexedFile& indexedFile = indexedFiles[i];
+            std::unordered_map<wxString, FileId_t>::const_iterator iter = m_fileIds.find(files.Item(i));
+            if(iter == m_fileIds.end()) {
+                indexedFile.m_state = kNotIndexed;
+                continue;
+            }
+            const FileEntry& entry = m_files[iter->second];
+            indexedFile.m_state =
+                std::binary_search(matches.begin(), matches.end(), iter->second) ? kMatch : kNoMatch;
+            indexedFile.m_lastModified = entry.m_lastModified;
+            indexedFile.m_size = entry.m_size;
+        }
+    }
+
+    // Check for modified files outside of the lock
+    wxArrayString candidates;
+    stale.clear();
+    for(size_t i = 0; i < files.GetCount(); ++i) {
+        const IndexedFile& indexedFile = indexedFiles[i];
+        bool isStale = (indexedFile.m_state == kNotIndexed);
+        if(!isStale) {
+            wxInt64 lastModified(0);
+            size_t size(0);
+            isStale = !GetFileAttributes(files.Item(i), lastModified, size) ||
+                      (lastModified != indexedFile.m_lastModified) || (size != indexedFile.m_size);
+        }
+
+        if(isStale || (indexedFile.m_state == kMatch)) {
+            candidates.Add(files.Item(i));
+            stale.push_back(isStale);
+        }
+    }
+    files.swap(candidates);
+    return true;
+}
+
+bool clTrigramIndex::GetFileAttributes(const wxString& filename, wxInt64& lastModified, size_t& size)
+{
+    // A file can be modified more than once in the same second, use the nanoseconds modification time
+    clFileFingerprint fingerprint;
+    if(!fingerprint.ReadAttributes(filename)) { return false; }
+    lastModified = fingerprint.m_mtime;
+    size = (size_t)fingerprint.m_size;
+    return true;
+}
+
+wxString clTrigramIndex::GetRegexLiteral(const wxString& regex)
+{
+    // Alternations, embedded options and ARE directors make the analysis unreliable
+    if(regex.Contains("|") || regex.Contains("(?") || regex.StartsWith("***")) { return ""; }
+
+    wxString best;
+    wxString current;
+    auto endRun = [&]() {
+        if(current.length() > best.length()) { best = current; }
+        current.clear();
+    };
+
+    int depth = 0;
+    for(size_t i = 0; i < regex.length(); ++i) {
+        wxChar ch = regex[i];
+        wxChar next = 0;
+        switch(ch) {
+        case '\\':
+            next = ((i + 1) < regex.length()) ? (wxChar)regex[i + 1] : 0;
+            if(next && !wxIsalnum(next)) {
+                // an escaped literal, e.g. "\."
+                if(depth == 0) {
+                    current << next;
+                } else {
+                    endRun();
+                }
+                ++i;
+            } else {
+                // a class or a constraint escape, e.g. "\d" or "\m"
+                endRun();
+                ++i;
+            }
+            break;
+        case '*':
+        case '?':
+        case '{':
+            // the previous atom is optional
+            if(!current.IsEmpty()) { current.RemoveLast(); }
+            endRun();
+            if(ch == '{') {
+                while((i < regex.length()) && (regex[i] != '}')) {
+                    ++i;
+                }
+            }
+            break;
+        case '[': {
+            endRun();
+            // skip the bracket expression, a ']' right after the '[' or '[^' is a literal
+            ++i;
+            if((i < regex.length()) && (regex[i] == '^')) { ++i; }
+            if((i < regex.length()) && (regex[i] == ']')) { ++i; }
+            while((i < regex.length()) && (regex[i] != ']')) {
+                ++i;
+            }
+            break;
+        }
+        case '(':
+            ++depth;
+            endRun();
+            break;
+        case ')':
+            if(depth > 0) { --depth; }
+            endRun();
+            break;
+        case '+':
+        case '.':
+        case '^':
+        case '$':
+            endRun();
+            break;
+        default:
+            if(depth == 0) {
+                current << ch;
+            } else {
+                endRun();
+            }
+            break;
+        }
+    }
+    endRun();
+    return best;
+}
@@ -0,0 +1,123 @@
+#ifndef CLTRIGRAMINDEX_H
+#define CLTRIGRAMINDEX_H
+
+#include "codelite_exports.h"
+#include "wxStringHash.h"
+#include <string>
+#include <vector>
+#include <wx/arrstr.h>
+#include <wx/filename.h>
+#include <wx/sharedptr.h>
+#include <wx/string.h>
+#include <wx/thread.h>
+
+/**
+ * @class clTrigramIndex
+ * @brief a persistent index of the (ASCII lower-cased) 3 bytes sequences found in a set of files.
+ * It is used to narrow down the list of files that may contain a string before searching them.
+ * The index only stores whether a file contains a trigram, so it can only tell which files do NOT contain
+ * a string. Files that were modified since they were indexed are always reported as candidates.
+ * All the public methods are thread safe
+ */
+class WXDLLIMPEXP_CL clTrigramIndex
+{
+public:
+    typedef wxSharedPtr<clTrigramIndex> Ptr_t;
+    typedef unsigned int FileId_t;
+
+protected:
+    struct FileEntry {
+        wxString m_filename;
+        wxInt64 m_lastModified; // nanoseconds
+        size_t m_size;
+        bool m_deleted;
+    };
+
+    wxFileName m_filename;
+    std::vector<FileEntry> m_files; // indexed by FileId_t
+    std::unordered_map<wxString, FileId_t> m_fileIds;
+    std::unordered_map<unsigned int, std::vector<FileId_t> > m_postings; // trigram -> sorted file ids
+    size_t m_deletedCount;
+    bool m_modified;
+    wxCriticalSection m_cs;
+
+protected:
+    void DoClear();
+    void DoRemove(const wxString& filename);
+    void DoCompact();
+
+public:
+    /**
+     * @param filename the file used to persist the index
+     */
+    clTrigramIndex(const wxFileName& filename);
+    virtual ~clTrigramIndex();
+
+    const wxFileName& GetFileName() const { return m_filename; }
+
+    /**
+     * @brief load the index from the disk. A missing or corrupted index file leaves the index empty
+     */
+    bool Load();
+
+    /**
+     * @brief write the index to the disk, if it was modified since it was loaded or saved
+     */
+    bool Save();
+
+    /**
+     * @brief remove all files from the index
+     */
+    void Clear();
+
+    /**
+     * @brief index the content of a file. 'lastModified' and 'size' are the file attributes
+     * at the time 'data' was read (see GetFileAttributes())
+     */
+    void Update(const wxString& filename, const char* data, size_t len, wxInt64 lastModified, size_t size);
+
+    /**
+     * @brief read 'filename' and index it
+     * @return false if the file could not be read
+     */
+    bool Update(const wxString& filename);
+
+    /**
+     * @brief remove a file from the index
+     */
+    void Remove(const wxString& filename);
+
+    /**
+     * @brief return true if 'filename' is indexed and was not modified since
+     */
+    bool IsUpToDate(const wxString& filename);
+
+    /**
+     * @brief return the number of indexed files
+     */
+    size_t GetFilesCount();
+
+    /**
+     * @brief keep only the files from 'files' that may contain 'literal'. The order of 'files' is preserved.
+     * @param literal the string to look for. The search is ASCII case insensitive
+     * @param files [input/output] the files to filter
+     * @param stale [output] for every file kept in 'files', true if the file was not indexed or was modified since
+     * it was indexed
+     * @return false if the index can not be used for 'literal' (e.g. it is shorter than 3 chars or non ASCII). In
+     * this case 'files' is not modified
+     */
+    bool Filter(const std::string& literal, wxArrayString& files, std::vector<bool>& stale);
+
+    /**
+     * @brief return the file attributes used to detect modified files. 'lastModified' is in nanoseconds
+     */
+    static bool GetFileAttributes(const wxString& filename, wxInt64& lastModified, size_t& size);
+
+    /**
+     * @brief extract from a regular expression a string that every match must contain
+     * @return an empty string if no such string could be found
+     */
+    static wxString GetRegexLiteral(const wxString& regex);
+};
+
+#endif // CLTRIGRAMINDEX_H
@@ -0,0 +1,146 @@
+#include "clWorkerPool.h"
+#include <algorithm>
+
+class clWorkerPoolThread : public wxThread
+{
+    clWorkerPool* m_pool;
+
+public:
+    clWorkerPoolThread(clWorkerPool* pool)
+        : wxThread(wxTHREAD_JOINABLE)
+        , m_pool(pool)
+    {
+    }
+    virtual ~clWorkerPoolThread() {}
+
+protected:
+    virtual void* Entry()
+    {
+        m_pool->WorkerMain();
+        return NULL;
+    }
+};
+
+clWorkerPool::clWorkerPool(size_t maxWorkers)
+    : m_maxWorkers(maxWorkers)
+    , m_shutdown(false)
+    , m_taskQueued(m_mutex)
+    , m_taskDone(m_mutex)
+{
+}
+
+clWorkerPool::~clWorkerPool()
+{
+    {
+        wxMutexLocker locker(m_mutex);
+        m_shutdown = true;
+        m_taskQueued.Broadcast();
+    }
+
+    std::for_each(m_workers.begin(), m_workers.end(), [&](clWorkerPoolThread* worker) {
+        worker->Wait(wxTHREAD_WAIT_BLOCK);
+        delete worker;
+    });
+    m_workers.clear();
+}
+
+size_t clWorkerPool::GetCPUCount() { return (wxThread::GetCPUCount() > 0) ? (size_t)wxThread::GetCPUCount() : 1; }
+
+size_t clWorkerPool::DoQueue(size_t count, const Task_t& task, Group& group)
+{
+    wxMutexLocker locker(m_mutex);
+    if(m_shutdown) { return 0; }
+
+    // Start the missing workers. A new worker blocks on m_mutex until we are done here
+    count = std::min(count, m_maxWorkers);
+    while(m_workers.size() < count) {
+        clWorkerPoolThread* worker = new clWorkerPoolThread(this);
+        if((worker->Create() != wxTHREAD_NO_ERROR) || (worker->Run() != wxTHREAD_NO_ERROR)) {
+            delete worker;
+            break;
+        }
+        m_workers.push_back(worker);
+    }
+
+    count = std::min(count, m_workers.size());
+    for(size_t i = 0; i < count; ++i) {
+        Task t;
+        t.m_task = task;
+        t.m_group = &group;
+        m_tasks.push_back(t);
+    }
+    group.m_pending += count;
+    if(count) { m_taskQueued.Broadcast(); }
+    return count;
+}
+
+void clWorkerPool::DoWait(Group& group, bool dropQueued)
+{
+    wxMutexLocker locker(m_mutex);
+    if(dropQueued) {
+        // The tasks that did not start yet have nothing left to do
+        std::deque<Task>::iterator iter = m_tasks.begin();
+        while(iter != m_tasks.end()) {
+            if(iter->m_group == &group) {
+                --group.m_pending;
+                iter = m_tasks.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+    }
+
+    while(group.m_pending) {
+        m_taskDone.Wait();
+    }
+}
+
+void clWorkerPool::WorkerMain()
+{
+    while(true) {
+        Task task;
+        {
+            wxMutexLocker locker(m_mutex);
+            while(!m_shutdown && m_tasks.empty()) {
+                m_taskQueued.Wait();
+            }
+            if(m_tasks.empty()) { return; }
+            task = m_tasks.front();
+            m_tasks.pop_front();
+        }
+
+        task.m_task();
+
+        wxMutexLocker locker(m_mutex);
+        --task.m_group->m_pending;
+        m_taskDone.Broadcast();
+    }
+}
+
+void clWorkerPool::ForEach(size_t count, const std::function<void(size_t)>& func)
+{
+    if(count == 0) { return; }
+
+    size_t next = 0;
+    wxCriticalSection cs;
+    Task_t runAll = [&]() {
+        while(true) {
+            size_t index;
+            {
+                wxCriticalSectionLocker locker(cs);
+                if(next >= count) { return; }
+                index = next++;
+            }
+            func(index);
+        }
+    };
+
+    Group group;
+    DoQueue(count - 1, runAll, group);
+    runAll();
+    DoWait(group, true);
+}
+
+size_t clWorkerPool::Run(size_t count, const Task_t& task) { return DoQueue(count, task, m_runGroup); }
+
+void clWorkerPool::Wait() { DoWait(m_runGroup, false); }
@@ -0,0 +1,90 @@
+#ifndef CLWORKERPOOL_H
+#define CLWORKERPOOL_H
+
+#include "codelite_exports.h"
+#include <deque>
+#include <functional>
+#include <vector>
+#include <wx/thread.h>
+
+class clWorkerPoolThread;
+
+/**
+ * @class clWorkerPool
+ * @brief a pool of threads that run tasks. The threads are started when they are first needed and are kept
+ * until the pool is deleted, so a pool that lives as long as its owner does not pay for starting threads on every
+ * call
+ */
+class WXDLLIMPEXP_CL clWorkerPool
+{
+    friend class clWorkerPoolThread;
+
+public:
+    typedef std::function<void()> Task_t;
+
+protected:
+    // The tasks that were submitted together
+    struct Group {
+        size_t m_pending; // queued or running
+
+        Group()
+            : m_pending(0)
+        {
+        }
+    };
+
+    struct Task {
+        Task_t m_task;
+        Group* m_group;
+
+        Task()
+            : m_group(NULL)
+        {
+        }
+    };
+
+    size_t m_maxWorkers;
+    std::vector<clWorkerPoolThread*> m_workers;
+    std::deque<Task> m_tasks;
+    Group m_runGroup;
+    bool m_shutdown;
+    wxMutex m_mutex;
+    wxCondition m_taskQueued;
+    wxCondition m_taskDone;
+
+protected:
+    size_t DoQueue(size_t count, const Task_t& task, Group& group);
+    void DoWait(Group& group, bool dropQueued);
+    void WorkerMain();
+
+public:
+    clWorkerPool(size_t maxWorkers);
+    virtual ~clWorkerPool();
+
+    size_t GetMaxWorkers() const { return m_maxWorkers; }
+
+    /**
+     * @brief call 'func' for every index in [0, count) and return when they were all processed. The calling thread
+     * takes part in the work, so all the indexes are processed even if no worker could be started
+     */
+    void ForEach(size_t count, const std::function<void(size_t)>& func);
+
+    /**
+     * @brief run 'task' on 'count' workers and return without waiting for them. Use Wait() to wait for the tasks
+     * @return the number of workers that run the task. It is less than 'count' when not enough threads could be
+     * started, 0 means that the caller has to do the work itself
+     */
+    size_t Run(size_t count, const Task_t& task);
+
+    /**
+     * @brief wait for the tasks started with Run()
+     */
+    void Wait();
+
+    /**
+     * @brief the number of CPUs, at least 1
+     */
+    static size_t GetCPUCount();
+};
+
+#endif // CLWORKERPOOL_H
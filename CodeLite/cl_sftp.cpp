@@ -29,8 +29,23 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <wx/filefn.h>
+#include <wx/stopwatch.h>
 #include <libssh/sftp.h>
 #include "cl_standard_paths.h"
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+// The size of a single read or write request
+#define SFTP_CHUNK_SIZE (64 * 1024)
+// The number of read requests kept in flight
+#define SFTP_MAX_PENDING_READS 16
+// The number of bytes compared before resuming a transfer
+#define SFTP_RESUME_CHECK_SIZE 4096
+// A file is transferred into a file with this suffix, which is renamed once the transfer completed
+#define SFTP_PARTIAL_SUFFIX ".codelitesftp"
+// Don't report the progress of a transfer more often than this (milliseconds)
+#define SFTP_PROGRESS_INTERVAL 500
 
 class SFTPDirCloser
 {
@@ -44,6 +59,120 @@ public:
     ~SFTPDirCloser() { sftp_closedir(m_dir); }
 };
 
+class SFTPFileCloser
+{
+    sftp_file m_file;
+
+public:
+    SFTPFileCloser(sftp_file f)
+        : m_file(f)
+    {
+    }
+    ~SFTPFileCloser() { sftp_close(m_file); }
+};
+
+/**
+ * @brief the asynchronous read requests that were sent, in the order they were sent
+ */
+class SFTPPendingReads
+{
+    sftp_file m_file;
+    std::deque<std::pair<int, uint32_t> > m_requests; // request id, length
+    std::vector<char> m_discard;
+
+public:
+    SFTPPendingReads(sftp_file file)
+        : m_file(file)
+    {
+    }
+    ~SFTPPendingReads() { Clear(); }
+
+    size_t Count() const { return m_requests.size(); }
+    void Push(int id, uint32_t len) { m_requests.push_back(std::make_pair(id, len)); }
+
+    /**
+     * @brief wait for the reply of the oldest request
+     * @param len [output] the requested length ('buffer' must be at least SFTP_CHUNK_SIZE bytes)
+     */
+    int ReadNext(char* buffer, uint32_t& len)
+    {
+        std::pair<int, uint32_t> request = m_requests.front();
+        m_requests.pop_front();
+        len = request.second;
+        return sftp_async_read(m_file, buffer, request.second, request.first);
+    }
+
+    /**
+     * @brief drop the pending requests. libssh keeps a reply until it is read, so read them
+     */
+    void Clear()
+    {
+        m_discard.resize(SFTP_CHUNK_SIZE);
+        while(!m_requests.empty()) {
+            sftp_async_read(m_file, &m_discard[0], m_requests.front().second, m_requests.front().first);
+            m_requests.pop_front();
+        }
+    }
+};
+
+/**
+ * @brief report the progress and the throughput of a transfer
+ */
+class SFTPTransferProgress
+{
+    clSFTPTransferCallback* m_callback;
+    wxInt64 m_total;
+    wxInt64 m_done;
+    wxInt64 m_resumed; // the bytes transferred before the transfer was resumed
+    wxStopWatch m_sw;
+    long m_lastReport;
+
+public:
+    SFTPTransferProgress(clSFTPTransferCallback* callback, wxInt64 total, wxInt64 resumed)
+        : m_callback(callback)
+        , m_total(total)
+        , m_done(resumed)
+        , m_resumed(resumed)
+        , m_lastReport(0)
+    {
+    }
+
+    /**
+     * @brief 'bytes' more bytes were transferred. Return false if the transfer should be aborted
+     */
+    bool Update(wxInt64 bytes, bool force = false)
+    {
+        m_done += bytes;
+        if(!m_callback) return true;
+
+        long elapsed = m_sw.Time();
+        if(!force && (elapsed - m_lastReport) < SFTP_PROGRESS_INTERVAL) return true;
+        m_lastReport = elapsed;
+
+        double bytesPerSecond = elapsed > 0 ? ((double)(m_done - m_resumed) * 1000.0 / elapsed) : 0.0;
+        return m_callback->OnTransferProgress(m_done, m_total, bytesPerSecond);
+    }
+};
+
+/**
+ * @brief return true if the 'size' first bytes of the local and the remote files end with the same bytes
+ */
+static bool SFTPTailMatches(sftp_file file, wxFFile& fp, wxInt64 size)
+{
+    size_t len = (size_t)std::min((wxInt64)SFTP_RESUME_CHECK_SIZE, size);
+    std::vector<char> remote(len), local(len);
+    if(sftp_seek64(file, size - len) < 0 || !fp.Seek(size - len)) return false;
+    if(fp.Read(&local[0], len) != len) return false;
+
+    size_t total = 0;
+    while(total < len) {
+        wxInt64 nbytes = sftp_read(file, &remote[total], len - total);
+        if(nbytes <= 0) return false;
+        total += nbytes;
+    }
+    return memcmp(&remote[0], &local[0], len) == 0;
+}
+
 clSFTP::clSFTP(clSSH::Ptr_t ssh)
     : m_ssh(ssh)
     , m_sftp(NULL)
@@ -82,7 +211,8 @@ void clSFTP::Close()
 
 void clSFTP::Write(const wxFileName& localFile,
                    const wxString& remotePath,
-                   SFTPAttribute::Ptr_t attributes) 
+                   SFTPAttribute::Ptr_t attributes,
+                   clSFTPTransferCallback* callback) 
 {
     if(!m_connected) {
         throw clException("scp is not initialized!");
@@ -97,20 +227,58 @@ void clSFTP::Write(const wxFileName& localFile,
         throw clException(wxString() << "scp::Write could not open file '" << localFile.GetFullPath() << "'. "
                                      << ::strerror(errno));
     }
+    wxInt64 fileSize = fp.Length();
 
-    char buffer[4096];
-    wxMemoryBuffer memBuffer;
-    size_t nbytes(0);
-    while(!fp.Eof()) {
-        nbytes = fp.Read(buffer, sizeof(buffer));
-        if(nbytes == 0) break;
-        memBuffer.AppendData(buffer, nbytes);
+    wxString tmpRemoteFile = remotePath;
+    tmpRemoteFile << SFTP_PARTIAL_SUFFIX;
+
+    // Resume a previous upload of this file: the temporary remote file must not be larger than the local file,
+    // must be newer than it and must end with the same bytes
+    wxInt64 offset = 0;
+    sftp_file file = NULL;
+    sftp_attributes partAttr = sftp_stat(m_sftp, tmpRemoteFile.mb_str(wxConvUTF8).data());
+    if(partAttr) {
+        wxInt64 partSize = partAttr->size;
+        time_t partTime = partAttr->mtime;
+        sftp_attributes_free(partAttr);
+        if(partSize > 0 && partSize <= fileSize && partTime >= localFile.GetModificationTime().GetTicks()) {
+            file = sftp_open(m_sftp, tmpRemoteFile.mb_str(wxConvUTF8).data(), O_RDWR, 0);
+            if(file && SFTPTailMatches(file, fp, partSize)) {
+                offset = partSize;
+            } else if(file) {
+                sftp_close(file);
+                file = NULL;
+            }
+        }
     }
-    fp.Close();
-    Write(memBuffer, remotePath);
-    if(attributes && attributes->GetPermissions()) {
-        Chmod(remotePath, attributes->GetPermissions());
+
+    if(!file) {
+        file = sftp_open(m_sftp, tmpRemoteFile.mb_str(wxConvUTF8).data(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+    if(file == NULL) {
+        throw clException(wxString() << _("Can't open file: ") << tmpRemoteFile << ". "
+                                     << ssh_get_error(m_ssh->GetSession()),
+                          sftp_get_error(m_sftp));
+    }
+
+    {
+        SFTPFileCloser closer(file);
+        if(!fp.Seek(offset)) {
+            throw clException(wxString() << "scp::Write could not read file '" << localFile.GetFullPath() << "'");
+        }
+        DoWriteFile(file, tmpRemoteFile, offset, fileSize,
+                    [&](char* data, size_t len) {
+                        size_t nbytes = fp.Read(data, len);
+                        if(nbytes == 0 && fp.Error()) {
+                            throw clException(wxString() << "scp::Write could not read file '"
+                                                         << localFile.GetFullPath() << "'");
+                        }
+                        return nbytes;
+                    },
+                    callback);
     }
+    fp.Close();
+    DoReplaceRemoteFile(tmpRemoteFile, remotePath, attributes);
 }
 
 void clSFTP::Write(const wxMemoryBuffer& fileContent,
@@ -124,7 +292,7 @@ void clSFTP::Write(const wxMemoryBuffer& fileContent,
     int access_type = O_WRONLY | O_CREAT | O_TRUNC;
     sftp_file file;
     wxString tmpRemoteFile = remotePath;
-    tmpRemoteFile << ".codelitesftp";
+    tmpRemoteFile << SFTP_PARTIAL_SUFFIX;
 
     file = sftp_open(m_sftp, tmpRemoteFile.mb_str(wxConvUTF8).data(), access_type, 0644);
     if(file == NULL) {
@@ -133,24 +301,27 @@ void clSFTP::Write(const wxMemoryBuffer& fileContent,
                           sftp_get_error(m_sftp));
     }
 
-    char* p = (char*)fileContent.GetData();
-    const int maxChunkSize = 65536;
-    wxInt64 bytesLeft = fileContent.GetDataLen();
-
-    while(bytesLeft > 0) {
-        wxInt64 chunkSize = bytesLeft > maxChunkSize ? maxChunkSize : bytesLeft;
-        wxInt64 bytesWritten = sftp_write(file, p, chunkSize);
-        if(bytesWritten < 0) {
-            sftp_close(file);
-            throw clException(wxString() << _("Can't write data to file: ") << tmpRemoteFile << ". "
-                                         << ssh_get_error(m_ssh->GetSession()),
-                              sftp_get_error(m_sftp));
-        }
-        bytesLeft -= bytesWritten;
-        p += bytesWritten;
-    }
-    sftp_close(file);
+    {
+        SFTPFileCloser closer(file);
+        const char* p = (const char*)fileContent.GetData();
+        size_t bytesLeft = fileContent.GetDataLen();
+        DoWriteFile(file, tmpRemoteFile, 0, bytesLeft,
+                    [&](char* data, size_t len) {
+                        size_t nbytes = std::min(len, bytesLeft);
+                        memcpy(data, p, nbytes);
+                        p += nbytes;
+                        bytesLeft -= nbytes;
+                        return nbytes;
+                    },
+                    NULL);
+    }
+    DoReplaceRemoteFile(tmpRemoteFile, remotePath, attributes);
+}
 
+void clSFTP::DoReplaceRemoteFile(const wxString& tmpRemoteFile,
+                                 const wxString& remotePath,
+                                 SFTPAttribute::Ptr_t attributes)
+{
     // Unlink the original file if it exists
     bool needUnlink = false;
     {
@@ -180,6 +351,45 @@ void clSFTP::Write(const wxMemoryBuffer& fileContent,
     }
 }
 
+void clSFTP::DoWriteFile(SFTPFile_t file,
+                         const wxString& remotePath,
+                         wxInt64 offset,
+                         wxInt64 fileSize,
+                         const std::function<size_t(char*, size_t)>& source,
+                         clSFTPTransferCallback* callback)
+{
+    if(offset > 0 && sftp_seek64(file, offset) < 0) {
+        throw clException(wxString() << _("Can't write data to file: ") << remotePath << ". "
+                                     << ssh_get_error(m_ssh->GetSession()),
+                          sftp_get_error(m_sftp));
+    }
+
+    // libssh has no asynchronous write: the file is written one chunk at a time, so only a single chunk is kept
+    // in memory
+    SFTPTransferProgress progress(callback, fileSize, offset);
+    std::vector<char> buffer(SFTP_CHUNK_SIZE);
+    while(true) {
+        size_t chunkSize = source(&buffer[0], buffer.size());
+        if(chunkSize == 0) break;
+
+        const char* p = &buffer[0];
+        while(chunkSize > 0) {
+            wxInt64 bytesWritten = sftp_write(file, p, chunkSize);
+            if(bytesWritten < 0) {
+                throw clException(wxString() << _("Can't write data to file: ") << remotePath << ". "
+                                             << ssh_get_error(m_ssh->GetSession()),
+                                  sftp_get_error(m_sftp));
+            }
+            chunkSize -= bytesWritten;
+            p += bytesWritten;
+            if(!progress.Update(bytesWritten)) {
+                throw clException(wxString() << _("Transfer cancelled: ") << remotePath);
+            }
+        }
+    }
+    progress.Update(0, true);
+}
+
 SFTPAttribute::List_t clSFTP::List(const wxString& folder, size_t flags, const wxString& filter) 
 {
     sftp_dir dir;
@@ -253,38 +463,152 @@ SFTPAttribute::Ptr_t clSFTP::Read(const wxString& remotePath, wxMemoryBuffer& bu
                                      << ssh_get_error(m_ssh->GetSession()),
                           sftp_get_error(m_sftp));
     }
+    SFTPFileCloser closer(file);
 
     SFTPAttribute::Ptr_t fileAttr = Stat(remotePath);
-    if(!fileAttr) {
-        throw clException(wxString() << _("Could not stat file:") << remotePath << ". "
+    wxInt64 fileSize = fileAttr->GetSize();
+    if(fileSize == 0) return fileAttr;
+
+    // Read the entire file content
+    buffer.SetBufSize(fileSize);
+    try {
+        DoReadFile(file, remotePath, 0, fileSize,
+                   [&](const char* data, size_t len) { buffer.AppendData(data, len); }, NULL);
+    } catch(clException&) {
+        buffer.Clear();
+        throw;
+    }
+    return fileAttr;
+}
+
+SFTPAttribute::Ptr_t clSFTP::Download(const wxString& remotePath,
+                                      const wxFileName& localFile,
+                                      clSFTPTransferCallback* callback) 
+{
+    if(!m_sftp) {
+        throw clException("SFTP is not initialized");
+    }
+
+    sftp_file file = sftp_open(m_sftp, remotePath.mb_str(wxConvUTF8).data(), O_RDONLY, 0);
+    if(file == NULL) {
+        throw clException(wxString() << _("Failed to open remote file: ") << remotePath << ". "
                                      << ssh_get_error(m_ssh->GetSession()),
                           sftp_get_error(m_sftp));
     }
+    SFTPFileCloser closer(file);
+
+    SFTPAttribute::Ptr_t fileAttr = Stat(remotePath);
     wxInt64 fileSize = fileAttr->GetSize();
-    if(fileSize == 0) return fileAttr;
 
-    // Allocate buffer for the file content
-    char pBuffer[65536]; // buffer
+    wxString partFile = localFile.GetFullPath();
+    partFile << SFTP_PARTIAL_SUFFIX;
+
+    // Resume a previous download of this file: the partial file must not be larger than the remote file, must be
+    // newer than it and must end with the same bytes
+    wxInt64 offset = 0;
+    wxFFile fp;
+    if(wxFileName::FileExists(partFile) &&
+       wxFileName(partFile).GetModificationTime().GetTicks() >= fileAttr->GetModificationTime() &&
+       fp.Open(partFile, "r+b")) {
+        wxInt64 partSize = fp.Length();
+        if(partSize > 0 && partSize <= fileSize && SFTPTailMatches(file, fp, partSize)) {
+            offset = partSize;
+        } else {
+            fp.Close();
+        }
+    }
 
-    // Read the entire file content
-    wxInt64 bytesLeft = fileSize;
-    wxInt64 bytesRead = 0;
-    while(bytesLeft > 0) {
-        wxInt64 nbytes = sftp_read(file, pBuffer, sizeof(pBuffer));
-        bytesRead += nbytes;
-        bytesLeft -= nbytes;
-        buffer.AppendData(pBuffer, nbytes);
+    if(!fp.IsOpened() && !fp.Open(partFile, "wb")) {
+        throw clException(wxString() << _("Could not open file: ") << partFile << ". " << ::strerror(errno));
+    }
+    if(!fp.Seek(offset)) {
+        throw clException(wxString() << _("Could not write file: ") << partFile);
     }
 
-    if(bytesRead != fileSize) {
-        sftp_close(file);
-        buffer.Clear();
+    DoReadFile(file, remotePath, offset, fileSize,
+               [&](const char* data, size_t len) {
+                   if(fp.Write(data, len) != len) {
+                       throw clException(wxString() << _("Could not write file: ") << partFile << ". "
+                                                    << ::strerror(errno));
+                   }
+               },
+               callback);
+
+    if(!fp.Close() || !::wxRenameFile(partFile, localFile.GetFullPath(), true)) {
+        throw clException(wxString() << _("Could not write file: ") << localFile.GetFullPath());
+    }
+    return fileAttr;
+}
+
+void clSFTP::DoReadFile(SFTPFile_t file,
+                        const wxString& remotePath,
+                        wxInt64 offset,
+                        wxInt64 fileSize,
+                        const std::function<void(const char*, size_t)>& sink,
+                        clSFTPTransferCallback* callback)
+{
+    if(offset > 0 && sftp_seek64(file, offset) < 0) {
+        throw clException(wxString() << _("Could not read file:") << remotePath << ". "
+                                     << ssh_get_error(m_ssh->GetSession()),
+                          sftp_get_error(m_sftp));
+    }
+
+    // Keep several read requests in flight, so the transfer is not bound by the round trip time.
+    // The replies are consumed in the order of the requests
+    SFTPTransferProgress progress(callback, fileSize, offset);
+    SFTPPendingReads pending(file);
+    std::vector<char> buffer(SFTP_CHUNK_SIZE);
+    wxInt64 requested = offset; // the offset of the next request
+    wxInt64 received = offset;
+    while(received < fileSize) {
+        while(pending.Count() < SFTP_MAX_PENDING_READS && requested < fileSize) {
+            uint32_t len = (uint32_t)std::min((wxInt64)SFTP_CHUNK_SIZE, fileSize - requested);
+            int id = sftp_async_read_begin(file, len);
+            if(id < 0) {
+                throw clException(wxString() << _("Could not read file:") << remotePath << ". "
+                                             << ssh_get_error(m_ssh->GetSession()),
+                                  sftp_get_error(m_sftp));
+            }
+            pending.Push(id, len);
+            requested += len;
+        }
+
+        uint32_t len = 0;
+        int nbytes = pending.ReadNext(&buffer[0], len);
+        if(nbytes < 0) {
+            throw clException(wxString() << _("Could not read file:") << remotePath << ". "
+                                         << ssh_get_error(m_ssh->GetSession()),
+                              sftp_get_error(m_sftp));
+        }
+        if(nbytes == 0) {
+            // The file is shorter than expected
+            break;
+        }
+
+        sink(&buffer[0], nbytes);
+        received += nbytes;
+        if((uint32_t)nbytes < len && received < fileSize) {
+            // A short read: the replies of the following requests don't follow this one, ask for them again
+            pending.Clear();
+            if(sftp_seek64(file, received) < 0) {
+                throw clException(wxString() << _("Could not read file:") << remotePath << ". "
+                                             << ssh_get_error(m_ssh->GetSession()),
+                                  sftp_get_error(m_sftp));
+            }
+            requested = received;
+        }
+
+        if(!progress.Update(nbytes)) {
+            throw clException(wxString() << _("Transfer cancelled: ") << remotePath);
+        }
+    }
+    progress.Update(0, true);
+
+    if(received != fileSize) {
         throw clException(wxString() << _("Could not read file:") << remotePath << ". "
                                      << ssh_get_error(m_ssh->GetSession()),
                           sftp_get_error(m_sftp));
     }
-    sftp_close(file);
-    return fileAttr;
 }
 
 void clSFTP::CreateDir(const wxString& dirname) 
@@ -408,10 +732,11 @@ void clSFTP::Mkpath(const wxString& remoteDirFullpath)
 
 void clSFTP::CreateRemoteFile(const wxString& remoteFullPath,
                               const wxFileName& localFile,
-                              SFTPAttribute::Ptr_t attr) 
+                              SFTPAttribute::Ptr_t attr,
+                              clSFTPTransferCallback* callback) 
 {
     Mkpath(wxFileName(remoteFullPath).GetPath());
-    Write(localFile, remoteFullPath, attr);
+    Write(localFile, remoteFullPath, attr, callback);
 }
 
 void clSFTP::Chmod(const wxString& remotePath, size_t permissions) 
@@ -33,11 +33,34 @@
 #include <wx/filename.h>
 #include "codelite_exports.h"
 #include "cl_sftp_attribute.h"
+#include <functional>
 #include <wx/buffer.h>
 
 // We do it this way to avoid exposing the include to <libssh/sftp.h> to files including this header
 struct sftp_session_struct;
 typedef struct sftp_session_struct* SFTPSession_t;
+struct sftp_file_struct;
+typedef struct sftp_file_struct* SFTPFile_t;
+
+/**
+ * @class clSFTPTransferCallback
+ * @brief receives the progress of a file transfer
+ */
+class WXDLLIMPEXP_CL clSFTPTransferCallback
+{
+public:
+    clSFTPTransferCallback() {}
+    virtual ~clSFTPTransferCallback() {}
+
+    /**
+     * @brief called periodically while a file is transferred, and once the transfer completed
+     * @param bytesDone the number of bytes transferred so far (including the bytes of a resumed transfer)
+     * @param totalBytes the file size
+     * @param bytesPerSecond the throughput of this transfer
+     * @return false to abort the transfer
+     */
+    virtual bool OnTransferProgress(wxInt64 bytesDone, wxInt64 totalBytes, double bytesPerSecond) = 0;
+};
 
 class WXDLLIMPEXP_CL clSFTP
 {
@@ -47,6 +70,14 @@ class WXDLLIMPEXP_CL clSFTP
     wxString m_currentFolder;
     wxString m_account;
 
+protected:
+    void DoReadFile(SFTPFile_t file, const wxString& remotePath, wxInt64 offset, wxInt64 fileSize,
+                    const std::function<void(const char*, size_t)>& sink, clSFTPTransferCallback* callback);
+    void DoWriteFile(SFTPFile_t file, const wxString& remotePath, wxInt64 offset, wxInt64 fileSize,
+                     const std::function<size_t(char*, size_t)>& source, clSFTPTransferCallback* callback);
+    void DoReplaceRemoteFile(const wxString& tmpRemoteFile, const wxString& remotePath,
+                             SFTPAttribute::Ptr_t attributes);
+
 public:
     typedef wxSharedPtr<clSFTP> Ptr_t;
     enum {
@@ -83,13 +114,17 @@ public:
     void Close();
 
     /**
-     * @brief write the content of local file into a remote file
+     * @brief write the content of local file into a remote file. The file is streamed, only a small part of it is
+     * kept in memory. The file is uploaded to a temporary remote file which replaces 'remotePath' once completed,
+     * an upload that was interrupted is resumed from where it stopped
      * @param localFile the local file
      * @param remotePath the remote path (abs path)
+     * @param callback receives the progress of the transfer (can be NULL)
      */
     void Write(const wxFileName& localFile,
                const wxString& remotePath,
-               SFTPAttribute::Ptr_t attributes = SFTPAttribute::Ptr_t(NULL)) ;
+               SFTPAttribute::Ptr_t attributes = SFTPAttribute::Ptr_t(NULL),
+               clSFTPTransferCallback* callback = NULL) ;
 
     /**
      * @brief write the content of 'fileContent' into the remote file represented by remotePath
@@ -104,6 +139,17 @@ public:
      */
     SFTPAttribute::Ptr_t Read(const wxString& remotePath, wxMemoryBuffer& buffer) ;
 
+    /**
+     * @brief download a remote file into a local file. The file is streamed, several read requests are kept in
+     * flight and only a small part of the file is kept in memory. The file is downloaded to a temporary local file
+     * which replaces 'localFile' once completed, a download that was interrupted is resumed from where it stopped
+     * @param callback receives the progress of the transfer (can be NULL)
+     * @return the remote file attributes
+     */
+    SFTPAttribute::Ptr_t Download(const wxString& remotePath,
+                                  const wxFileName& localFile,
+                                  clSFTPTransferCallback* callback = NULL) ;
+
     /**
      * @brief list the content of a folder
      * @param folder
@@ -132,7 +178,8 @@ public:
      */
     void CreateRemoteFile(const wxString& remoteFullPath,
                           const wxFileName& localFile,
-                          SFTPAttribute::Ptr_t attr) ;
+                          SFTPAttribute::Ptr_t attr,
+                          clSFTPTransferCallback* callback = NULL) ;
 
     /**
      * @brief create path . If the directory does not exist, create it (all sub paths if needed)
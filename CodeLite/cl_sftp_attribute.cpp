@@ -56,6 +56,7 @@ void SFTPAttribute::DoClear()
     m_name.Clear();
     m_flags = 0;
     m_size = 0;
+    m_modificationTime = 0;
     m_permissions = 0;
 }
 
@@ -66,6 +67,7 @@ void SFTPAttribute::DoConstruct()
 
     m_name = m_attributes->name;
     m_size = m_attributes->size;
+    m_modificationTime = m_attributes->mtime;
     m_permissions = m_attributes->permissions;
     m_flags = 0;
 
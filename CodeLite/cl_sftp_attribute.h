@@ -41,7 +41,8 @@ class WXDLLIMPEXP_CL SFTPAttribute : public wxClientData
 {
     wxString m_name;
     size_t m_flags;
-    size_t m_size;
+    wxUint64 m_size;
+    time_t m_modificationTime;
     SFTPAttribute_t m_attributes;
     size_t m_permissions;
 
@@ -73,7 +74,8 @@ public:
      */
     void Assign(SFTPAttribute_t attr);
 
-    size_t GetSize() const { return m_size; }
+    wxUint64 GetSize() const { return m_size; }
+    time_t GetModificationTime() const { return m_modificationTime; }
     wxString GetTypeAsString() const;
     const wxString& GetName() const { return m_name; }
 
@@ -30,6 +30,7 @@
 #include "stringaccessor.h"
 #include "dirsaver.h"
 #include "ctags_manager.h"
+#include "clFileContentCache.h"
 
 CppWordScanner::CppWordScanner(const wxString& fileName)
     : m_filename(fileName)
@@ -37,18 +38,8 @@ CppWordScanner::CppWordScanner(const wxString& fileName)
 {
     // disable log
     wxLogNull nolog;
-    wxCSConv fontEncConv(wxFONTENCODING_ISO8859_1);
-
-    wxFFile thefile(m_filename, wxT("rb"));
-    if(thefile.IsOpened()) {
-        m_text.Clear();
-        thefile.ReadAll(&m_text, fontEncConv);
-        if(m_text.IsEmpty()) {
-            // Try another converter
-            fontEncConv = wxFONTENCODING_UTF8;
-            thefile.ReadAll(&m_text, fontEncConv);
-        }
-    }
+    clFileContent::Ptr_t file = clFileContentCache::Get().Load(m_filename);
+    if(file) { m_text = file->GetText(wxFONTENCODING_ISO8859_1); }
     doInit();
 }
 
@@ -26,8 +26,11 @@
 #include "CxxVariable.h"
 #include "CxxVariableScanner.h"
 #include "asyncprocess.h"
+#include "clFileContentCache.h"
 #include "cl_indexer_reply.h"
 #include "cl_indexer_request.h"
+#include "cl_indexer_session.h"
+#include "cl_indexer_tags.h"
 #include "cl_standard_paths.h"
 #include "clindexerprotocol.h"
 #include "code_completion_api.h"
@@ -140,6 +143,7 @@ TagsManager::TagsManager()
     : wxEvtHandler()
     , m_codeliteIndexerPath(wxT("codelite_indexer"))
     , m_codeliteIndexerProcess(NULL)
+    , m_indexerRestartPending(false)
     , m_canRestartIndexer(true)
     , m_lang(NULL)
     , m_evtHandler(NULL)
@@ -149,6 +153,7 @@ TagsManager::TagsManager()
 
     m_db = new TagsStorageSQLite();
     m_db->SetSingleSearchLimit(MAX_SEARCH_LIMIT);
+    m_db->SetUseSymbolIndex(true);
 
     // Create databases
     m_ctagsCmd = wxT("  --excmd=pattern --sort=no --fields=aKmSsnit --c-kinds=+p --C++-kinds=+p ");
@@ -177,14 +182,9 @@ TagsManager::~TagsManager()
 
 #ifndef __WXMSW__
         // Clear the socket file
-        std::stringstream s;
-        s << wxGetProcessId();
-
-        char channel_name[1024];
-        memset(channel_name, 0, sizeof(channel_name));
-        sprintf(channel_name, PIPE_NAME, s.str().c_str());
-        ::unlink(channel_name);
-        ::remove(channel_name);
+        std::string channel_name = GetIndexerChannel();
+        ::unlink(channel_name.c_str());
+        ::remove(channel_name.c_str());
 #endif
     }
 }
@@ -224,16 +224,20 @@ void TagsManager::OpenDatabase(const wxFileName& fileName)
 
 TagTreePtr TagsManager::ParseSourceFile(const wxFileName& fp, std::vector<CommentPtr>* comments)
 {
-    wxString tags;
-
-    if(!m_codeliteIndexerProcess) {
+    if(!IsIndexerRunning()) {
         clWARNING() << "Indexer process is not running..." << clEndl;
         return TagTreePtr(NULL);
     }
-    SourceToTags(fp, tags);
 
-    int dummy;
-    TagTreePtr ttp = TagTreePtr(TreeFromTags(tags, dummy));
+    clIndexerReply reply;
+    if(!DoSourceToTags(fp, clIndexerRequest::CLI_REPLY_BINARY_TAGS, reply) ||
+       (reply.getCompletionCode() == clIndexerReply::CLI_COMPLETION_ERROR)) {
+        clWARNING() << "Failed to parse file:" << fp.GetFullPath() << clEndl;
+        return TagTreePtr(NULL);
+    }
+
+    int dummy(0);
+    TagTreePtr ttp = TreeFromBinaryTags(reply.getTags(), dummy);
 
     if(comments && GetParseComments()) {
         // parse comments
@@ -242,6 +246,80 @@ TagTreePtr TagsManager::ParseSourceFile(const wxFileName& fp, std::vector<Commen
     return ttp;
 }
 
+bool TagsManager::ParseSourceFiles(clIndexerSession& session, const wxArrayString& files,
+                                   std::vector<TagTreePtr>& trees, int* count)
+{
+    return ParseSourceFiles(session, files, m_tagsOptions.ToString(), m_encoding, trees, count);
+}
+
+bool TagsManager::ParseSourceFiles(clIndexerSession& session, const wxArrayString& files,
+                                   const wxString& ctagsOptions, wxFontEncoding encoding,
+                                   std::vector<TagTreePtr>& trees, int* count)
+{
+    trees.clear();
+    trees.resize(files.GetCount());
+    if(files.IsEmpty()) { return true; }
+
+    if(!IsIndexerRunning()) {
+        clWARNING() << "Indexer process is not running..." << clEndl;
+        return false;
+    }
+
+    if(!session.connect()) {
+        clWARNING() << "Failed to connect to indexer process. Indexer ID:" << wxGetProcessId() << clEndl;
+        return false;
+    }
+
+    std::vector<std::string> sources;
+    sources.reserve(files.GetCount());
+    for(size_t i = 0; i < files.GetCount(); ++i) {
+        sources.push_back(files.Item(i).mb_str(wxConvUTF8).data());
+    }
+
+    // set ctags options to be used
+    wxString ctagsCmd;
+    ctagsCmd << wxT(" ") << ctagsOptions
+             << wxT(" --excmd=pattern --sort=no --fields=aKmSsnit --c-kinds=+p --C++-kinds=+p ");
+
+    size_t firstRequestId(0);
+    if(!session.sendBatch(sources, ctagsCmd.mb_str(wxConvUTF8).data(), firstRequestId,
+                          clIndexerRequest::CLI_REPLY_BINARY_TAGS)) {
+        clWARNING() << "Failed to send batch request to indexer. Indexer ID:" << wxGetProcessId() << clEndl;
+        return false;
+    }
+
+    // The replies may arrive in any order, use the request id to place them
+    for(size_t i = 0; i < sources.size(); ++i) {
+        clIndexerReply reply;
+        try {
+            std::string errmsg;
+            if(!session.readReply(reply, errmsg)) {
+                clWARNING() << "Failed to read indexer reply: " << (wxString() << errmsg) << clEndl;
+                RestartCodeLiteIndexer();
+                return false;
+            }
+        } catch(std::bad_alloc& ex) {
+            clWARNING() << "std::bad_alloc exception caught" << clEndl;
+            session.disconnect();
+            return false;
+        }
+
+        size_t index = reply.getRequestId() - firstRequestId;
+        if(index >= trees.size()) {
+            clWARNING() << "Indexer replied with an unknown request id:" << reply.getRequestId() << clEndl;
+            continue;
+        }
+
+        // The tree of a file that failed stays NULL, so the file is not marked as parsed
+        if(reply.getCompletionCode() == clIndexerReply::CLI_COMPLETION_ERROR) { continue; }
+
+        int tagsCount(0);
+        trees[index] = TreeFromBinaryTags(reply.getTags(), tagsCount, encoding);
+        if(count) { *count += tagsCount; }
+    }
+    return true;
+}
+
 TagTreePtr TagsManager::ParseSourceFile2(const wxFileName& fp, const wxString& tags, std::vector<CommentPtr>* comments)
 {
     //	return ParseTagsFile(tags, project);
@@ -306,37 +384,61 @@ void TagsManager::StartCodeLiteIndexer()
 
     if(m_codeliteIndexerPath.FileExists() == false) {
         CL_ERROR(wxT("ERROR: Could not locate indexer: %s"), m_codeliteIndexerPath.GetFullPath().c_str());
+        wxCriticalSectionLocker locker(m_indexerLock);
         m_codeliteIndexerProcess = NULL;
+        m_indexerRestartPending = false;
         return;
     }
 
     // concatenate the PID to identifies this channel to this instance of codelite
     cmd << wxT("\"") << m_codeliteIndexerPath.GetFullPath() << wxT("\" ") << uid << wxT(" --pid");
-    m_codeliteIndexerProcess =
-        CreateAsyncProcess(this, cmd, IProcessCreateDefault, clStandardPaths::Get().GetUserDataDir());
+
+    // use as many indexer workers as we have parser threads
+    size_t workers = m_tagsOptions.GetParserThreads();
+    if(workers == 0) { workers = (wxThread::GetCPUCount() > 0) ? (size_t)wxThread::GetCPUCount() : 1; }
+    cmd << wxT(" --workers ") << workers;
+    IProcess* process = CreateAsyncProcess(this, cmd, IProcessCreateDefault, clStandardPaths::Get().GetUserDataDir());
+
+    wxCriticalSectionLocker locker(m_indexerLock);
+    m_codeliteIndexerProcess = process;
+    m_indexerRestartPending = false;
 }
 
 void TagsManager::RestartCodeLiteIndexer()
 {
-    if(m_codeliteIndexerProcess) { m_codeliteIndexerProcess->Terminate(); }
+    // Several parser workers may fail on the same dead indexer, only the first one terminates it
+    wxCriticalSectionLocker locker(m_indexerLock);
+    if(m_codeliteIndexerProcess && !m_indexerRestartPending) {
+        m_indexerRestartPending = true;
+        m_codeliteIndexerProcess->Terminate();
+    }
 
     // no need to call StartCodeLiteIndexer(), since it will be called automatically
     // by the termination handler
 }
 
+bool TagsManager::IsIndexerRunning()
+{
+    wxCriticalSectionLocker locker(m_indexerLock);
+    return m_codeliteIndexerProcess != NULL;
+}
+
 void TagsManager::SetCodeLiteIndexerPath(const wxString& path) { m_codeliteIndexerPath = path; }
 
 void TagsManager::OnIndexerTerminated(clProcessEvent& event)
 {
     wxUnusedVar(event);
-    wxDELETE(m_codeliteIndexerProcess);
+    {
+        wxCriticalSectionLocker locker(m_indexerLock);
+        wxDELETE(m_codeliteIndexerProcess);
+    }
     StartCodeLiteIndexer();
 }
 
 //---------------------------------------------------------------------
 // Parsing
 //---------------------------------------------------------------------
-void TagsManager::SourceToTags(const wxFileName& source, wxString& tags)
+std::string TagsManager::GetIndexerChannel() const
 {
     std::stringstream s;
     s << wxGetProcessId();
@@ -344,13 +446,19 @@ void TagsManager::SourceToTags(const wxFileName& source, wxString& tags)
     char channel_name[1024];
     memset(channel_name, 0, sizeof(channel_name));
     sprintf(channel_name, PIPE_NAME, s.str().c_str());
+    return channel_name;
+}
 
-    clNamedPipeClient client(channel_name);
+bool TagsManager::DoSourceToTags(const wxFileName& source, size_t flags, clIndexerReply& reply)
+{
+    std::string channel_name = GetIndexerChannel();
+    clNamedPipeClient client(channel_name.c_str());
 
     // Build a request for the indexer
     clIndexerRequest req;
     // set the command
     req.setCmd(clIndexerRequest::CLI_PARSE);
+    req.setFlags(flags);
 
     // prepare list of files to be parsed
     std::vector<std::string> files;
@@ -367,27 +475,36 @@ void TagsManager::SourceToTags(const wxFileName& source, wxString& tags)
     // connect to the indexer
     if(!client.connect()) {
         clWARNING() << "Failed to connect to indexer process. Indexer ID:" << wxGetProcessId() << clEndl;
-        return;
+        return false;
     }
 
     // send the request
     if(!clIndexerProtocol::SendRequest(&client, req)) {
         clWARNING() << "Failed to send request to indexer. Indexer ID:" << wxGetProcessId() << clEndl;
-        return;
+        return false;
     }
 
     // read the reply
-    clIndexerReply reply;
     clDEBUG1() << "SourceToTags: reading indexer reply" << clEndl;
     try {
         std::string errmsg;
         if(!clIndexerProtocol::ReadReply(&client, reply, errmsg)) {
             clWARNING() << "Failed to read indexer reply: " << (wxString() << errmsg) << clEndl;
             RestartCodeLiteIndexer();
-            return;
+            return false;
         }
     } catch(std::bad_alloc& ex) {
         clWARNING() << "std::bad_alloc exception caught" << clEndl;
+        reply.setTags("");
+        return false;
+    }
+    return true;
+}
+
+void TagsManager::SourceToTags(const wxFileName& source, wxString& tags)
+{
+    clIndexerReply reply;
+    if(!DoSourceToTags(source, 0, reply)) {
         tags.Clear();
         return;
     }
@@ -395,15 +512,27 @@ void TagsManager::SourceToTags(const wxFileName& source, wxString& tags)
     clDEBUG1() << "SourceToTags: [" << reply.getTags() << "]" << clEndl;
 
     // convert the data into wxString
-    if(m_encoding == wxFONTENCODING_DEFAULT || m_encoding == wxFONTENCODING_SYSTEM)
-        tags = wxString(reply.getTags().c_str(), wxConvUTF8);
-    else
-        tags = wxString(reply.getTags().c_str(), wxCSConv(m_encoding));
-    if(tags.empty()) { tags = wxString::From8BitData(reply.getTags().c_str()); }
+    DoConvertIndexerTags(reply.getTags(), tags);
 
     clDEBUG1() << "Tags:\n" << tags << clEndl;
 }
 
+void TagsManager::SourceToTags(const wxFileName& source, std::vector<TagEntryPtr>& tags)
+{
+    clIndexerReply reply;
+    if(!DoSourceToTags(source, clIndexerRequest::CLI_REPLY_BINARY_TAGS, reply)) { return; }
+    TagsFromBinaryTags(reply.getTags(), tags);
+}
+
+void TagsManager::DoConvertIndexerTags(const std::string& indexerTags, wxString& tags)
+{
+    if(m_encoding == wxFONTENCODING_DEFAULT || m_encoding == wxFONTENCODING_SYSTEM)
+        tags = wxString(indexerTags.c_str(), wxConvUTF8);
+    else
+        tags = wxString(indexerTags.c_str(), wxCSConv(m_encoding));
+    if(tags.empty()) { tags = wxString::From8BitData(indexerTags.c_str()); }
+}
+
 TagTreePtr TagsManager::TreeFromTags(const wxString& tags, int& count)
 {
     // Load the records and build a language tree
@@ -432,6 +561,109 @@ TagTreePtr TagsManager::TreeFromTags(const wxString& tags, int& count)
     return tree;
 }
 
+/**
+ * @class IndexerTagsConverter
+ * @brief builds TagEntry objects straight from an indexer binary reply. The interned strings
+ * (file names, kinds, field keys...) are converted into wxString once per block
+ */
+class IndexerTagsConverter
+{
+    clIndexerTagsReader m_reader;
+    wxCSConv* m_csConv;
+    std::vector<wxString> m_strings;
+    size_t m_block;
+
+protected:
+    wxString DoConvert(const clIndexerTagString& str) const
+    {
+        if(str.m_len == 0) { return wxEmptyString; }
+        wxString s = m_csConv ? wxString(str.m_data, *m_csConv, str.m_len) : wxString(str.m_data, wxConvUTF8, str.m_len);
+        if(s.IsEmpty()) { s = wxString::From8BitData(str.m_data, str.m_len); }
+        return s;
+    }
+
+    wxString ToString(const clIndexerTagString& str) const
+    {
+        if(str.m_interned != wxNOT_FOUND) { return m_strings[str.m_interned]; }
+        return DoConvert(str);
+    }
+
+public:
+    IndexerTagsConverter(const std::string& tags, wxFontEncoding encoding)
+        : m_reader(tags.data(), tags.length())
+        , m_csConv(NULL)
+        , m_block(0)
+    {
+        if(encoding != wxFONTENCODING_DEFAULT && encoding != wxFONTENCODING_SYSTEM) {
+            m_csConv = new wxCSConv(encoding);
+        }
+    }
+    ~IndexerTagsConverter() { wxDELETE(m_csConv); }
+
+    bool Next(TagEntry& tag)
+    {
+        clIndexerTagRecord record;
+        if(!m_reader.next(record)) {
+            if(!m_reader.isOk()) { clWARNING() << "Indexer sent malformed binary tags" << clEndl; }
+            return false;
+        }
+
+        if(m_block != m_reader.getBlock()) {
+            // new block, convert its interned strings
+            m_block = m_reader.getBlock();
+            const std::vector<clIndexerTagString>& strings = m_reader.getStrings();
+            m_strings.clear();
+            m_strings.reserve(strings.size());
+            for(size_t i = 0; i < strings.size(); ++i) {
+                m_strings.push_back(DoConvert(strings[i]));
+            }
+        }
+
+        wxStringMap_t extFields;
+        for(size_t i = 0; i < record.m_fields.size(); ++i) {
+            extFields[ToString(record.m_fields[i].first)] = ToString(record.m_fields[i].second);
+        }
+        tag.FromFields(ToString(record.m_file), ToString(record.m_name), record.m_line, ToString(record.m_pattern),
+                       ToString(record.m_kind), extFields);
+        return true;
+    }
+};
+
+TagTreePtr TagsManager::TreeFromBinaryTags(const std::string& tags, int& count)
+{
+    return TreeFromBinaryTags(tags, count, m_encoding);
+}
+
+TagTreePtr TagsManager::TreeFromBinaryTags(const std::string& tags, int& count, wxFontEncoding encoding)
+{
+    // Load the records and build a language tree
+    TagEntry root;
+    root.SetName(wxT("<ROOT>"));
+
+    TagTreePtr tree(new TagTree(wxT("<ROOT>"), root));
+
+    IndexerTagsConverter converter(tags, encoding);
+    while(true) {
+        TagEntry tag;
+        if(!converter.Next(tag)) { break; }
+
+        // Add the tag to the tree, locals are not added to the tree
+        count++;
+        if(tag.GetKind() != wxT("local")) tree->AddEntry(tag);
+    }
+    return tree;
+}
+
+void TagsManager::TagsFromBinaryTags(const std::string& tags, std::vector<TagEntryPtr>& entries)
+{
+    IndexerTagsConverter converter(tags, m_encoding);
+    while(true) {
+        TagEntryPtr tag(new TagEntry());
+        if(!converter.Next(*tag)) { break; }
+        entries.push_back(tag);
+    }
+}
+
 bool TagsManager::IsValidCtagsFile(const wxFileName& filename) const
 {
     wxLogNull PreventMissingFileLogErrorMessages;
@@ -1650,6 +1882,7 @@ void TagsManager::CloseDatabase()
     m_db = new TagsStorageSQLite();
     m_db->SetSingleSearchLimit(m_tagsOptions.GetCcNumberOfDisplayItems());
     m_db->SetUseCache(true);
+    m_db->SetUseSymbolIndex(true);
 }
 
 DoxygenComment TagsManager::GenerateDoxygenComment(const wxString& file, const int line, wxChar keyPrefix)
@@ -2224,50 +2457,58 @@ void TagsManager::DeleteTagsByFilePrefix(const wxString& dbfileName, const wxStr
     delete db;
 }
 
-void TagsManager::UpdateFilesRetagTimestamp(const wxArrayString& files, ITagsStoragePtr db)
+void TagsManager::UpdateFilesRetagTimestamp(const wxArrayString& files, const clFileFingerprint::Vec_t& fingerprints,
+                                            ITagsStoragePtr db)
 {
     db->Begin();
     for(size_t i = 0; i < files.GetCount(); i++) {
         db->InsertFileEntry(files.Item(i), (int)time(NULL));
+        if(i < fingerprints.size() && fingerprints[i].IsOk()) {
+            db->StoreFileFingerprint(files.Item(i), fingerprints[i]);
+        }
     }
     db->Commit();
 }
 
 void TagsManager::FilterNonNeededFilesForRetaging(wxArrayString& strFiles, ITagsStoragePtr db)
 {
+    wxStopWatch sw;
     std::vector<FileEntryPtr> files_entries;
     db->GetFiles(files_entries);
-    std::unordered_set<wxString> files_set;
-
-    for(size_t i = 0; i < strFiles.GetCount(); i++) {
-        files_set.insert(strFiles.Item(i));
+    std::unordered_map<wxString, int> retagged;
+    for(size_t i = 0; i < files_entries.size(); i++) {
+        retagged[files_entries.at(i)->GetFile()] = files_entries.at(i)->GetLastRetaggedTimestamp();
     }
 
-    for(size_t i = 0; i < files_entries.size(); i++) {
-        FileEntryPtr fe = files_entries.at(i);
+    clFileFingerprint::Map_t fingerprints;
+    db->GetFileFingerprints(fingerprints);
 
-        // does the file exist in both lists?
-        std::unordered_set<wxString>::iterator iter = files_set.find(fe->GetFile());
-        if(iter != files_set.end()) {
-            // get the actual modifiaction time of the file from the disk
-            struct stat buff;
-            int modified(0);
+    // remove duplicate entries
+    std::unordered_set<wxString> files_set;
+    wxArrayString files;
+    files.Alloc(strFiles.GetCount());
+    for(size_t i = 0; i < strFiles.GetCount(); i++) {
+        if(files_set.insert(strFiles.Item(i)).second) { files.Add(strFiles.Item(i)); }
+    }
 
-            const wxCharBuffer cname = _C((*iter));
-            if(stat(cname.data(), &buff) == 0) { modified = (int)buff.st_mtime; }
+    // only re-tag the files whose content was modified
+    wxArrayString modified;
+    clFileFingerprint::Map_t updated;
+    clFileFingerprint::FindModified(files, retagged, fingerprints, modified, updated);
 
-            // if the timestamp from the database < then the actual timestamp, re-tag the file
-            if(fe->GetLastRetaggedTimestamp() >= modified) { files_set.erase(iter); }
+    // Keep the new fingerprints of the files that were touched but not modified, so they are not hashed again
+    if(!updated.empty()) {
+        db->Begin();
+        clFileFingerprint::Map_t::const_iterator iter = updated.begin();
+        for(; iter != updated.end(); ++iter) {
+            db->StoreFileFingerprint(iter->first, iter->second);
         }
+        db->Commit();
     }
 
-    // copy back the files to the array
-    std::unordered_set<wxString>::iterator iter = files_set.begin();
-    strFiles.Clear();
-    strFiles.Alloc(files_set.size());
-    for(; iter != files_set.end(); iter++) {
-        strFiles.Add(*iter);
-    }
+    clDEBUG() << "Retag:" << modified.GetCount() << "out of" << files.GetCount() << "files were modified ("
+              << sw.Time() << "ms)" << clEndl;
+    strFiles = modified;
 }
 
 void TagsManager::DoFilterNonNeededFilesForRetaging(wxArrayString& strFiles, ITagsStoragePtr db)
@@ -2550,20 +2791,8 @@ void TagsManager::DoParseModifiedText(const wxString& text, std::vector<TagEntry
     if(fp.IsOpened()) {
         fp.Write(text);
         fp.Close();
-        wxString tagsStr;
-        SourceToTags(wxFileName(fileName), tagsStr);
-
-        // Create tags from the string
-        wxArrayString tagsLines = wxStringTokenize(tagsStr, wxT("\n"), wxTOKEN_STRTOK);
-        for(size_t i = 0; i < tagsLines.GetCount(); i++) {
-            wxString line = tagsLines.Item(i).Trim().Trim(false);
-            if(line.IsEmpty()) continue;
+        SourceToTags(wxFileName(fileName), tags);
 
-            TagEntryPtr tag(new TagEntry());
-            tag->FromLine(line);
-
-            tags.push_back(tag);
-        }
         // Delete the modified file
         clRemoveFile(fileName);
     }
@@ -2572,35 +2801,18 @@ void TagsManager::DoParseModifiedText(const wxString& text, std::vector<TagEntry
 bool TagsManager::IsBinaryFile(const wxString& filepath)
 {
     // If the file is a C++ file, avoid testing the content return false based on the extension
-    FileExtManager::FileType type = FileExtManager::GetType(filepath);
-    if(type == FileExtManager::TypeHeader || type == FileExtManager::TypeSourceC ||
-       type == FileExtManager::TypeSourceCpp)
-        return false;
+    if(IsSourceFile(filepath)) return false;
 
-    // examine the file based on the content of the first 4K (max) bytes
-    FILE* fp = fopen(filepath.To8BitData(), "rb");
-    if(fp) {
-
-        char buffer[1];
-        int textLen(0);
-        const int maxTextToExamine(4096);
-
-        // examine up to maxTextToExamine first chars in the file and search for '\0'
-        while(fread(buffer, sizeof(char), sizeof(buffer), fp) == 1 && textLen < maxTextToExamine) {
-            textLen++;
-            // if we found a NULL, return true
-            if(buffer[0] == 0) {
-                fclose(fp);
-                return true;
-            }
-        }
-
-        fclose(fp);
-        return false;
-    }
+    // examine the file based on the content of the first 4K (max) bytes, if we could not open it, return true.
+    // A file that is already in the file content cache is not read again
+    return clFileContentCache::Get().IsBinary(filepath);
+}
 
-    // if we could not open it, return true
-    return true;
+bool TagsManager::IsSourceFile(const wxString& filepath)
+{
+    FileExtManager::FileType type = FileExtManager::GetType(filepath);
+    return type == FileExtManager::TypeHeader || type == FileExtManager::TypeSourceC ||
+           type == FileExtManager::TypeSourceCpp;
 }
 
 wxString TagsManager::WrapLines(const wxString& str)
@@ -2874,7 +3086,7 @@ void TagsManager::GetCXXKeywords(wxArrayString& words)
 
 TagEntryPtrVector_t TagsManager::ParseBuffer(const wxString& content, const wxString& filename)
 {
-    if(!m_codeliteIndexerProcess) { return TagEntryPtrVector_t(); }
+    if(!IsIndexerRunning()) { return TagEntryPtrVector_t(); }
 
     // Write the content into temporary file
     wxString tmpfilename = wxFileName::CreateTempFileName("ctagstemp");
@@ -2883,8 +3095,8 @@ TagEntryPtrVector_t TagsManager::ParseBuffer(const wxString& content, const wxSt
     fp.Write(content, wxConvUTF8);
     fp.Close();
 
-    wxString tags;
-    SourceToTags(tmpfilename, tags);
+    TagEntryPtrVector_t tags;
+    SourceToTags(wxFileName(tmpfilename), tags);
 
     {
         wxLogNull noLog;
@@ -2892,14 +3104,8 @@ TagEntryPtrVector_t TagsManager::ParseBuffer(const wxString& content, const wxSt
     }
 
     TagEntryPtrVector_t tagsVec;
-    wxArrayString lines = ::wxStringTokenize(tags, "\n", wxTOKEN_STRTOK);
-    for(size_t i = 0; i < lines.GetCount(); ++i) {
-        wxString& line = lines.Item(i);
-        line.Trim().Trim(false);
-        if(line.IsEmpty()) continue;
-
-        TagEntryPtr tag(new TagEntry());
-        tag->FromLine(line);
+    for(size_t i = 0; i < tags.size(); ++i) {
+        TagEntryPtr tag = tags[i];
 
         // If the caller provided a filename, set it
         if(!filename.IsEmpty()) { tag->SetFile(filename); }
@@ -56,6 +56,8 @@
 
 /// Forward declaration
 class DirTraverser;
+class clIndexerReply;
+class clIndexerSession;
 class Language;
 class Language;
 class IProcess;
@@ -145,6 +147,9 @@ public:
 private:
     wxFileName m_codeliteIndexerPath;
     IProcess* m_codeliteIndexerProcess;
+    // The parser workers check and restart the indexer while the main thread replaces it
+    wxCriticalSection m_indexerLock;
+    bool m_indexerRestartPending;
     wxString m_ctagsCmd;
     wxStopWatch m_watch;
     TagsOptionsData m_tagsOptions;
@@ -226,6 +231,7 @@ public:
     void SetCtagsOptions(const TagsOptionsData& options);
 
     void SetEncoding(const wxFontEncoding& encoding);
+    const wxFontEncoding& GetEncoding() const { return m_encoding; }
 
     /**
      * Locate symbol by name in database
@@ -239,11 +245,29 @@ public:
      * This function throws a std::exception*.
      * @param fp Source file name
      * @param comments if not null, comments will be parsed as well, and will be returned as vector
-     * @return tag tree
+     * @return tag tree (empty if the file has no tags), NULL if the file could not be parsed
      */
     TagTreePtr ParseSourceFile(const wxFileName& fp, std::vector<CommentPtr>* comments = NULL);
     TagTreePtr ParseSourceFile2(const wxFileName& fp, const wxString& tags, std::vector<CommentPtr>* comments = NULL);
 
+    /**
+     * @brief parse a batch of source files over an open indexer session and construct a TagTree per file.
+     * All the files are streamed to the indexer over the session, and the trees are built directly
+     * from the binary replies. trees[i] is the tree of files[i] (it might be NULL if the file could not be parsed)
+     * @param count [output] if not NULL, incremented by the number of tags found
+     * @return false if the session failed (the session is disconnected in that case)
+     */
+    bool ParseSourceFiles(clIndexerSession& session, const wxArrayString& files, std::vector<TagTreePtr>& trees,
+                          int* count = NULL);
+
+    /**
+     * @brief same as above, using the given ctags options and encoding instead of the current ones.
+     * This is the version to call from a thread other than the ParseThread: the options and the encoding
+     * are copied before the thread starts, since the main thread may change them at any time
+     */
+    bool ParseSourceFiles(clIndexerSession& session, const wxArrayString& files, const wxString& ctagsOptions,
+                          wxFontEncoding encoding, std::vector<TagTreePtr>& trees, int* count = NULL);
+
     /**
      * @brief Set the full path to ctags executable, else TagsManager will use relative path ctags.
      * So, if for example, ctags is located at: $/home/eran/bin$, you simply call this function
@@ -302,6 +326,7 @@ public:
      * Restart ctags process.
      */
     void RestartCodeLiteIndexer();
+    bool IsIndexerRunning();
 
     /**
      * Test if filename matches the current ctags file spec.
@@ -532,6 +557,17 @@ public:
      */
     void SourceToTags(const wxFileName& source, wxString& tags);
 
+    /**
+     * @brief same as above, but the tags are built directly from the indexer binary reply
+     * without going through the ctags text output
+     */
+    void SourceToTags(const wxFileName& source, std::vector<TagEntryPtr>& tags);
+
+    /**
+     * @brief return the channel name of the indexer process serving this instance of codelite
+     */
+    std::string GetIndexerChannel() const;
+
     /**
      * return list of files from the database(s). The returned list is ordered
      * by name (ascending)
@@ -771,10 +807,13 @@ public:
 
     /**
      * @brief update the 'last_retagged' column in the 'files' table for the current timestamp
+     * and store the files fingerprints
      * @param files list of files
+     * @param fingerprints the fingerprints of 'files', taken before they were parsed
      * @brief db    database to use
      */
-    void UpdateFilesRetagTimestamp(const wxArrayString& files, ITagsStoragePtr db);
+    void UpdateFilesRetagTimestamp(const wxArrayString& files, const clFileFingerprint::Vec_t& fingerprints,
+                                   ITagsStoragePtr db);
 
     /**
      * @brief accept as input ctags pattern of a function and tries to evaluate the
@@ -784,7 +823,7 @@ public:
      */
     wxString GetFunctionReturnValueFromPattern(TagEntryPtr tag);
     /**
-     * @brief fileter a recently tagged files from the strFiles array
+     * @brief fileter from the strFiles array the files whose content did not change since they were tagged
      * @param strFiles
      * @param db
      */
@@ -798,6 +837,17 @@ public:
      */
     TagTreePtr TreeFromTags(const wxString& tags, int& count);
 
+    /**
+     * @brief same as TreeFromTags(), for tags in the indexer binary format (see cl_indexer_tags.h)
+     */
+    TagTreePtr TreeFromBinaryTags(const std::string& tags, int& count);
+    TagTreePtr TreeFromBinaryTags(const std::string& tags, int& count, wxFontEncoding encoding);
+
+    /**
+     * @brief convert tags in the indexer binary format into TagEntry objects
+     */
+    void TagsFromBinaryTags(const std::string& tags, std::vector<TagEntryPtr>& entries);
+
     /**
      * @brief clear the underlying caching mechanism
      */
@@ -873,6 +923,12 @@ public:
      */
     bool IsBinaryFile(const wxString& filepath);
 
+    /**
+     * @brief return true if the file is a C/C++ source or header file. IsBinaryFile() does not examine
+     * the content of these files
+     */
+    static bool IsSourceFile(const wxString& filepath);
+
     /**
      * @brief given an input string 'str', wrap the string so each line will
      * not be longer than MAX_TIP_LINE_SIZE bytes
@@ -910,6 +966,8 @@ protected:
     void FilterDeclarations(const std::vector<TagEntryPtr>& src, std::vector<TagEntryPtr>& tags);
     wxString DoReplaceMacros(const wxString& name);
     void DoFilterNonNeededFilesForRetaging(wxArrayString& strFiles, ITagsStoragePtr db);
+    void DoConvertIndexerTags(const std::string& indexerTags, wxString& tags);
+    bool DoSourceToTags(const wxFileName& source, size_t flags, clIndexerReply& reply);
     void DoGetFunctionTipForEmptyExpression(const wxString& word, const wxString& text, std::vector<TagEntryPtr>& tips,
                                             bool globalScopeOnly = false);
     void TryFindImplDeclUsingNS(const wxString& scope, const wxString& word, bool imp,
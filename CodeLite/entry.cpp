@@ -503,27 +503,6 @@ void TagEntry::FromLine(const wxString& line)
             if(key == wxT("line") && !val.IsEmpty()) {
                 val.ToLong(&lineNumber);
             } else {
-                if(key == wxT("union") || key == wxT("struct")) {
-
-                    // remove the anonymous part of the struct / union
-                    if(!val.StartsWith(wxT("__anon"))) {
-                        // an internal anonymous union / struct
-                        // remove all parts of the
-                        wxArrayString scopeArr;
-                        wxString tmp, new_val;
-
-                        scopeArr = wxStringTokenize(val, wxT(":"), wxTOKEN_STRTOK);
-                        for(size_t i = 0; i < scopeArr.GetCount(); i++) {
-                            if(scopeArr.Item(i).StartsWith(wxT("__anon")) == false) {
-                                tmp << scopeArr.Item(i) << wxT("::");
-                            }
-                        }
-
-                        tmp.EndsWith(wxT("::"), &new_val);
-                        val = new_val;
-                    }
-                }
-
                 extFields[key] = val;
             }
         }
@@ -534,6 +513,38 @@ void TagEntry::FromLine(const wxString& line)
     fileName = fileName.Trim();
     pattern = pattern.Trim();
 
+    FromFields(fileName, name, lineNumber, pattern, kind, extFields);
+}
+
+void TagEntry::FromFields(const wxString& fileName, const wxString& name, int lineNumber, const wxString& pattern,
+                          const wxString& kind, wxStringMap_t& extFields)
+{
+    wxStringMap_t::iterator iter = extFields.begin();
+    for(; iter != extFields.end(); ++iter) {
+        const wxString& key = iter->first;
+        wxString& val = iter->second;
+        if(key == wxT("union") || key == wxT("struct")) {
+
+            // remove the anonymous part of the struct / union
+            if(!val.StartsWith(wxT("__anon"))) {
+                // an internal anonymous union / struct
+                // remove all parts of the
+                wxArrayString scopeArr;
+                wxString tmp, new_val;
+
+                scopeArr = wxStringTokenize(val, wxT(":"), wxTOKEN_STRTOK);
+                for(size_t i = 0; i < scopeArr.GetCount(); i++) {
+                    if(scopeArr.Item(i).StartsWith(wxT("__anon")) == false) {
+                        tmp << scopeArr.Item(i) << wxT("::");
+                    }
+                }
+
+                tmp.EndsWith(wxT("::"), &new_val);
+                val = new_val;
+            }
+        }
+    }
+
     if(kind == "enumerator" && extFields.count("enum")) {
         // Remove the last parent
         wxString& scope = extFields["enum"];
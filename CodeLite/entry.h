@@ -134,6 +134,13 @@ public:
 
     void FromLine(const wxString& line);
 
+    /**
+     * @brief construct the tag from fields that were already split (e.g. a record of the
+     * indexer binary tags format). Applies the same fixups as FromLine()
+     */
+    void FromFields(const wxString& fileName, const wxString& name, int lineNumber, const wxString& pattern,
+                    const wxString& kind, wxStringMap_t& extFields);
+
     /**
      * Copy constructor.
      */
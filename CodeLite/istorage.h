@@ -30,6 +30,7 @@
 #include "pptable.h"
 #include "tag_tree.h"
 #include "fileentry.h"
+#include "clFileFingerprint.h"
 #include "entry.h"
 
 #define MAX_SEARCH_LIMIT 250
@@ -48,6 +49,7 @@ protected:
     int m_singleSearchLimit;
     int m_maxWorkspaceTagToColour;
     bool m_useCache;
+    bool m_useSymbolIndex;
     bool m_enableCaseInsensitive;
 
 public:
@@ -58,6 +60,7 @@ public:
         : m_singleSearchLimit(MAX_SEARCH_LIMIT)
         , m_maxWorkspaceTagToColour(1000)
         , m_useCache(false)
+        , m_useSymbolIndex(false)
         , m_enableCaseInsensitive(true)
     {
     }
@@ -68,6 +71,14 @@ public:
 
     virtual bool GetUseCache() const { return m_useCache; }
 
+    /**
+     * @brief answer the most common lookups from an in-memory index of the symbols instead of the storage.
+     * The index is loaded on the first lookup, so only enable it for a long lived storage
+     */
+    virtual void SetUseSymbolIndex(bool useSymbolIndex) { this->m_useSymbolIndex = useSymbolIndex; }
+
+    virtual bool GetUseSymbolIndex() const { return m_useSymbolIndex; }
+
     /**
      * @brief clear the storage cache
      */
@@ -242,6 +253,16 @@ public:
      */
     virtual int UpdateFileEntry(const wxString& filename, int timestamp) = 0;
 
+    /**
+     * @brief return the fingerprints of the parsed files
+     */
+    virtual void GetFileFingerprints(clFileFingerprint::Map_t& fingerprints) = 0;
+
+    /**
+     * @brief store the fingerprint of a file, taken before the file was parsed
+     */
+    virtual void StoreFileFingerprint(const wxString& filename, const clFileFingerprint& fingerprint) = 0;
+
     // -------------------------- TagEntry -------------------------------------------
     /**
      * Return a result set of tags according to file name.
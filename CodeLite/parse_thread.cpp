@@ -24,8 +24,11 @@
 //////////////////////////////////////////////////////////////////////////////
 #include "CxxScannerTokens.h"
 #include "CxxVariableScanner.h"
+#include "cl_indexer_session.h"
 #include "cl_command_event.h"
 #include "cl_standard_paths.h"
+#include "clFileContentCache.h"
+#include "clWorkerPool.h"
 #include "cpp_scanner.h"
 #include "crawler_include.h"
 #include "ctags_manager.h"
@@ -37,9 +40,11 @@
 #include "pptable.h"
 #include "precompiled_header.h"
 #include "tags_storage_sqlite3.h"
+#include <algorithm>
 #include <set>
 #include <tags_options_data.h>
 #include <wx/ffile.h>
+#include <wx/msgqueue.h>
 #include <wx/stopwatch.h>
 #include <wx/tokenzr.h>
 
@@ -93,8 +98,172 @@ static const wxString& WriteCodeLiteCCHelperFile()
     return filepath;
 }
 
+// Number of files to store before we commit the transaction when retagging with multiple workers
+#define PARSE_WORKERS_COMMIT_BATCH 500
+// Number of files a parser worker sends to the indexer in a single request
+#define PARSE_WORKERS_INDEXER_BATCH 16
+
+/**
+ * @brief the outcome of parsing a single file by a ParseWorkerThread
+ */
+struct ParseWorkerResult {
+    wxString m_filename;
+    TagTreePtr m_tree;
+    clFileFingerprint m_fingerprint;
+    bool m_skipped;
+
+    ParseWorkerResult()
+        : m_skipped(false)
+    {
+    }
+};
+
+/**
+ * @brief a file to parse, as handed to a parser worker
+ */
+struct ParseWorkerFile {
+    wxString m_filename;
+    bool m_sourceFile;               // C/C++ files are never tested for binary content
+    clFileFingerprint m_fingerprint; // the fingerprint stored by the previous retag (not Ok if there is none)
+
+    ParseWorkerFile()
+        : m_sourceFile(false)
+    {
+    }
+};
+
+/**
+ * @brief state shared between the ParseThread (the only database writer) and its parser workers.
+ * The TagsManager settings that the workers need are copied here before the workers start: the main
+ * thread may change them during the retag
+ */
+class ParseWorkersContext
+{
+    std::vector<ParseWorkerFile> m_files;
+    size_t m_next;
+    bool m_cancelled;
+    wxCriticalSection m_cs;
+    wxString m_ctagsOptions;
+    wxFontEncoding m_encoding;
+    std::string m_indexerChannel;
+
+public:
+    wxMessageQueue<ParseWorkerResult*> m_results;
+
+public:
+    ParseWorkersContext(const std::vector<std::string>& files, const clFileFingerprint::Map_t& fingerprints)
+        : m_next(0)
+        , m_cancelled(false)
+    {
+        m_files.resize(files.size());
+        for(size_t i = 0; i < files.size(); ++i) {
+            ParseWorkerFile& file = m_files[i];
+            file.m_filename = wxString(files[i].c_str(), wxConvUTF8);
+            file.m_sourceFile = TagsManager::IsSourceFile(file.m_filename);
+            clFileFingerprint::Map_t::const_iterator iter = fingerprints.find(file.m_filename);
+            if(iter != fingerprints.end()) { file.m_fingerprint = iter->second; }
+        }
+
+        TagsManager* tagmgr = TagsManagerST::Get();
+        // make deep copies, these strings are going to be used by other threads
+        m_ctagsOptions = tagmgr->GetCtagsOptions().ToString().c_str();
+        m_encoding = tagmgr->GetEncoding();
+        m_indexerChannel = tagmgr->GetIndexerChannel();
+    }
+
+    size_t GetCount() const { return m_files.size(); }
+    const wxString& GetCtagsOptions() const { return m_ctagsOptions; }
+    wxFontEncoding GetEncoding() const { return m_encoding; }
+    const std::string& GetIndexerChannel() const { return m_indexerChannel; }
+
+    /**
+     * @brief fetch the next batch of files to parse (up to maxFiles). Return false when there are no
+     * more files or when the retag was cancelled
+     */
+    bool NextBatch(std::vector<ParseWorkerFile>& batch, size_t maxFiles)
+    {
+        batch.clear();
+        wxCriticalSectionLocker locker(m_cs);
+        if(m_cancelled) { return false; }
+        while((m_next < m_files.size()) && (batch.size() < maxFiles)) {
+            batch.push_back(m_files[m_next++]);
+            // make a deep copy, this string is going to be used by another thread
+            batch.back().m_filename = batch.back().m_filename.c_str();
+        }
+        return !batch.empty();
+    }
+
+    void Cancel()
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        m_cancelled = true;
+    }
+};
+
+/**
+ * @brief the indexer always replies with a tree, it is empty when the file has no tags
+ */
+static bool HasTags(TagTreePtr tree) { return tree && !tree->GetRoot()->GetChilds().empty(); }
+
+/**
+ * @brief convert the next batch of files into TagTree objects. The trees are passed back to the ParseThread
+ * which stores them into the database. Return false when there are no more files
+ */
+static bool ParseNextBatch(ParseWorkersContext& context, clIndexerSession& session)
+{
+    std::vector<ParseWorkerFile> batch;
+    if(!context.NextBatch(batch, PARSE_WORKERS_INDEXER_BATCH)) { return false; }
+
+    wxArrayString files;
+    clFileFingerprint::Vec_t fingerprints;
+    for(size_t i = 0; i < batch.size(); ++i) {
+        const ParseWorkerFile& file = batch[i];
+        // Same as TagsManager::IsBinaryFile(), the file type was computed before the workers started
+        if(!file.m_sourceFile && clFileContentCache::Get().IsBinary(file.m_filename)) {
+            ParseWorkerResult* result = new ParseWorkerResult();
+            result->m_filename = file.m_filename;
+            result->m_skipped = true;
+            context.m_results.Post(result);
+            continue;
+        }
+
+        // Take the fingerprints before parsing: a file modified while it is parsed is parsed again by the
+        // next retag. The content of a file whose size and modification time did not change is not hashed again
+        files.Add(file.m_filename);
+        fingerprints.push_back(clFileFingerprint());
+        fingerprints.back().Read(file.m_filename, file.m_fingerprint);
+    }
+
+    std::vector<TagTreePtr> trees;
+    TagsManagerST::Get()->ParseSourceFiles(session, files, context.GetCtagsOptions(), context.GetEncoding(), trees);
+    for(size_t i = 0; i < files.GetCount(); ++i) {
+        ParseWorkerResult* result = new ParseWorkerResult();
+        result->m_filename = files.Item(i);
+        result->m_tree = trees[i];
+        result->m_fingerprint = fingerprints[i];
+        // Drop our reference before the result is posted: the tree is owned by the
+        // ParseThread from this point on
+        trees[i].Reset(NULL);
+        context.m_results.Post(result);
+    }
+    return true;
+}
+
+/**
+ * @brief the parser workers body
+ */
+static void ParseWorkerMain(ParseWorkersContext& context)
+{
+    // Each worker streams its files to the indexer over its own session
+    clIndexerSession session(context.GetIndexerChannel());
+    while(ParseNextBatch(context, session)) {
+    }
+}
+
 ParseThread::ParseThread()
     : WorkerThread()
+    , m_crawlerEnabled(true)
+    , m_parserThreads(0)
 {
 }
 
@@ -152,14 +321,8 @@ void ParseThread::ParseIncludeFiles(ParseRequest* req, const wxString& filename,
     ParseAndStoreFiles(req, arrFiles, initalCount, db);
 }
 
-TagTreePtr ParseThread::DoTreeFromTags(const wxString& tags, int& count)
+void ParseThread::DoStoreTags(TagTreePtr ttp, const wxString& filename, ITagsStoragePtr db)
 {
-    return TagsManagerST::Get()->TreeFromTags(tags, count);
-}
-
-void ParseThread::DoStoreTags(const wxString& tags, const wxString& filename, int& count, ITagsStoragePtr db)
-{
-    TagTreePtr ttp = DoTreeFromTags(tags, count);
     db->Begin();
     db->DeleteByFileName(wxFileName(), filename, false);
     db->Store(ttp, wxFileName(), false);
@@ -186,6 +349,22 @@ void ParseThread::SetSearchPaths(const wxArrayString& paths, const wxArrayString
     }
 }
 
+void ParseThread::SetParserThreadsCount(size_t count)
+{
+    wxCriticalSectionLocker locker(m_cs);
+    m_parserThreads = count;
+}
+
+size_t ParseThread::GetParserThreadsCount()
+{
+    wxCriticalSectionLocker locker(m_cs);
+    if(m_parserThreads == 0) {
+        int cpus = wxThread::GetCPUCount();
+        return (cpus > 0) ? (size_t)cpus : 1;
+    }
+    return m_parserThreads;
+}
+
 bool ParseThread::IsCrawlerEnabled()
 {
     wxCriticalSectionLocker locker(m_cs);
@@ -236,20 +415,22 @@ void ParseThread::ProcessSimple(ParseRequest* req)
     db->OpenDatabase(dbfile);
 
     // convert the file content into tags
-    wxString tags;
     wxString file_name(req->getFile());
-    tagmgr->SourceToTags(file_name, tags);
-
-    clDEBUG1() << "Parsed file output: [" << tags << "]" << clEndl;
-
-    int count;
-    DoStoreTags(tags, file_name, count, db);
+    clFileFingerprint fingerprint;
+    fingerprint.Read(file_name);
+    TagTreePtr ttp = tagmgr->ParseSourceFile(file_name);
+    if(!ttp) {
+        // Keep the tags, the file entry and the fingerprint of the file so it is parsed again by the next retag
+        return;
+    }
+    DoStoreTags(ttp, file_name, db);
 
     db->Begin();
     ///////////////////////////////////////////
     // update the file retag timestamp
     ///////////////////////////////////////////
     db->InsertFileEntry(file, (int)time(NULL));
+    if(fingerprint.IsOk()) { db->StoreFileFingerprint(file, fingerprint); }
 
     ////////////////////////////////////////////////
     // Parse and store the macros found in this file
@@ -324,21 +505,41 @@ void ParseThread::ParseAndStoreFiles(ParseRequest* req, const wxArrayString& arr
     // Loop over the files and parse them
     int totalSymbols(0);
     DEBUG_MESSAGE(wxString::Format(wxT("Parsing and saving files to database....")));
-    for(size_t i = 0; i < arrFiles.GetCount(); i++) {
+    clIndexerSession session(TagsManagerST::Get()->GetIndexerChannel());
+
+    // Take the fingerprints before parsing: a file modified while it is parsed is parsed again by the next retag
+    clFileFingerprint::Vec_t allFingerprints;
+    clFileFingerprint::Compute(arrFiles, allFingerprints);
+
+    // The files that were parsed, only their retagging timestamp is updated
+    wxArrayString parsedFiles;
+    clFileFingerprint::Vec_t fingerprints;
+
+    for(size_t i = 0; i < arrFiles.GetCount(); i += PARSE_WORKERS_INDEXER_BATCH) {
 
         // give a shutdown request a chance
         TEST_DESTROY();
 
-        wxString tags; // output
-        TagsManagerST::Get()->SourceToTags(arrFiles.Item(i), tags);
+        wxArrayString batch;
+        for(size_t j = i; (j < arrFiles.GetCount()) && (batch.GetCount() < PARSE_WORKERS_INDEXER_BATCH); ++j) {
+            batch.Add(arrFiles.Item(j));
+        }
 
-        if(tags.IsEmpty() == false) { DoStoreTags(tags, arrFiles.Item(i), totalSymbols, db); }
+        std::vector<TagTreePtr> trees; // output
+        TagsManagerST::Get()->ParseSourceFiles(session, batch, trees, &totalSymbols);
+        for(size_t j = 0; j < trees.size(); ++j) {
+            if(!trees[j]) { continue; }
+            // A file without tags keeps the tags it had
+            if(HasTags(trees[j])) { DoStoreTags(trees[j], batch.Item(j), db); }
+            parsedFiles.Add(batch.Item(j));
+            fingerprints.push_back(allFingerprints[i + j]);
+        }
     }
 
     DEBUG_MESSAGE(wxString(wxT("Done")));
 
     // Update the retagging timestamp
-    TagsManagerST::Get()->UpdateFilesRetagTimestamp(arrFiles, db);
+    TagsManagerST::Get()->UpdateFilesRetagTimestamp(parsedFiles, fingerprints, db);
 
     if(req->_evtHandler) {
         wxCommandEvent e(wxEVT_PARSE_THREAD_MESSAGE);
@@ -387,50 +588,56 @@ void ParseThread::ProcessParseAndStore(ParseRequest* req)
 {
     wxString dbfile = req->getDbfile();
 
-    // convert the file to tags
-    double maxVal = (double)req->_workspaceFiles.size();
-    if(maxVal == 0.0) { return; }
-
-    // we report every 10%
-    double reportingPoint = maxVal / 100.0;
-    reportingPoint = ceil(reportingPoint);
-    if(reportingPoint == 0.0) { reportingPoint = 1.0; }
+    if(req->_workspaceFiles.empty()) { return; }
 
     ITagsStoragePtr db(new TagsStorageSQLite());
     db->OpenDatabase(dbfile);
 
-    // We commit every 10 files
-    db->Begin();
-    int precent(0);
-    int lastPercentageReported(0);
-
     // Prepend our hack file to the list of files to parse
     const wxString& hackfile = WriteCodeLiteCCHelperFile();
     req->_workspaceFiles.insert(req->_workspaceFiles.begin(), hackfile.ToStdString());
     PPTable::Instance()->Clear();
 
-    for(size_t i = 0; i < maxVal; i++) {
+    // The files are converted into tags by a pool of workers while this thread
+    // is the only one that writes into the database
+    clFileFingerprint::Map_t fingerprints;
+    db->GetFileFingerprints(fingerprints);
+    ParseWorkersContext context(req->_workspaceFiles, fingerprints);
+    size_t workersCount = std::min(GetParserThreadsCount(), context.GetCount());
+    clWorkerPool workers(workersCount);
+    size_t started = workers.Run(workersCount, [&]() { ParseWorkerMain(context); });
+    clDEBUG() << "Retagging" << context.GetCount() << "files using" << started << "parser workers" << clEndl;
+
+    // When no worker could be started, this thread parses the files itself
+    clIndexerSession serialSession(context.GetIndexerChannel());
+    if(started == 0) { clWARNING() << "Failed to start the parser workers, parsing on the parser thread" << clEndl; }
+
+    double maxVal = (double)context.GetCount();
+    int precent(0);
+    int lastPercentageReported(0);
+    size_t received(0);
+    size_t storedSinceCommit(0);
+    bool cancelled(false);
+
+    db->Begin();
+    while(received < context.GetCount()) {
 
         // give a shutdown request a chance
         if(TestDestroy()) {
-            // Do an ordered shutdown:
-            // rollback any transaction
-            // and close the database
-            db->Rollback();
-            return;
+            cancelled = true;
+            break;
         }
 
-        wxFileName curFile(wxString(req->_workspaceFiles[i].c_str(), wxConvUTF8));
-
-        // Skip binary files
-        if(TagsManagerST::Get()->IsBinaryFile(curFile.GetFullPath())) {
-            DEBUG_MESSAGE(wxString::Format(wxT("Skipping binary file %s"), curFile.GetFullPath().c_str()));
+        ParseWorkerResult* result = NULL;
+        if(context.m_results.ReceiveTimeout(started ? 100 : 0, result) != wxMSGQUEUE_NO_ERROR) {
+            // All the results of the previous batch were stored
+            if(started == 0 && !ParseNextBatch(context, serialSession)) { break; }
             continue;
         }
+        ++received;
 
         // Send notification to the main window with our progress report
-        precent = (int)((i / maxVal) * 100);
-
+        precent = (int)((received / maxVal) * 100);
         if(req->_evtHandler && lastPercentageReported != precent) {
             lastPercentageReported = precent;
             wxCommandEvent retaggingProgressEvent(wxEVT_PARSE_THREAD_RETAGGING_PROGRESS);
@@ -438,22 +645,55 @@ void ParseThread::ProcessParseAndStore(ParseRequest* req)
             req->_evtHandler->AddPendingEvent(retaggingProgressEvent);
         }
 
-        TagTreePtr tree = TagsManagerST::Get()->ParseSourceFile(curFile);
-        PPScan(curFile.GetFullPath(), false);
+        if(result->m_skipped) {
+            DEBUG_MESSAGE(wxString::Format(wxT("Skipping binary file %s"), result->m_filename.c_str()));
+            wxDELETE(result);
+            continue;
+        }
 
-        db->Store(tree, wxFileName(), false);
-        if(db->InsertFileEntry(curFile.GetFullPath(), (int)time(NULL)) == TagExist) {
-            db->UpdateFileEntry(curFile.GetFullPath(), (int)time(NULL));
+        if(!result->m_tree) {
+            // The indexer failed to parse the file: leave the file entry and the fingerprint as they are so it is
+            // parsed again by the next retag
+            clWARNING() << "Failed to parse file:" << result->m_filename << clEndl;
+            wxDELETE(result);
+            continue;
+        }
+
+        PPScan(result->m_filename, false);
+        db->Store(result->m_tree, wxFileName(), false);
+        if(db->InsertFileEntry(result->m_filename, (int)time(NULL)) == TagExist) {
+            db->UpdateFileEntry(result->m_filename, (int)time(NULL));
         }
+        if(result->m_fingerprint.IsOk()) { db->StoreFileFingerprint(result->m_filename, result->m_fingerprint); }
+        wxDELETE(result);
 
-        if(i % 50 == 0) {
-            // Commit what we got so far
+        if(++storedSinceCommit >= PARSE_WORKERS_COMMIT_BATCH) {
+            // Commit what we got so far and start a new transaction
+            storedSinceCommit = 0;
             db->Commit();
-            // Start a new transaction
             db->Begin();
         }
     }
 
+    // Stop the workers. On a normal completion they already exited
+    context.Cancel();
+    workers.Wait();
+
+    // Free any result that was not consumed
+    ParseWorkerResult* leftover = NULL;
+    while(context.m_results.ReceiveTimeout(0, leftover) == wxMSGQUEUE_NO_ERROR) {
+        wxDELETE(leftover);
+    }
+
+    if(cancelled) {
+        // Do an ordered shutdown:
+        // rollback any transaction
+        // and close the database
+        db->Rollback();
+        PPTable::Instance()->Clear();
+        return;
+    }
+
     // Process the macros
     // PPTable::Instance()->Squeeze();
     const std::map<wxString, PPToken>& table = PPTable::Instance()->GetTable();
@@ -125,10 +125,17 @@ class WXDLLIMPEXP_CL ParseThread : public WorkerThread
     wxArrayString m_searchPaths;
     wxArrayString m_excludePaths;
     bool m_crawlerEnabled;
+    size_t m_parserThreads;
     wxCriticalSection m_cs;
 
 public:
     void SetCrawlerEnabeld(bool b);
+    /**
+     * @brief set the number of parser workers to use when retagging the workspace.
+     * 0 means: use the number of CPUs on this machine
+     */
+    void SetParserThreadsCount(size_t count);
+    size_t GetParserThreadsCount();
     void SetSearchPaths(const wxArrayString& paths, const wxArrayString& exlucdePaths);
     void GetSearchPaths(wxArrayString& paths, wxArrayString& excludePaths);
     bool IsCrawlerEnabled();
@@ -144,8 +151,7 @@ private:
      */
     virtual ~ParseThread();
 
-    void DoStoreTags(const wxString& tags, const wxString& filename, int& count, ITagsStoragePtr db);
-    TagTreePtr DoTreeFromTags(const wxString& tags, int& count);
+    void DoStoreTags(TagTreePtr ttp, const wxString& filename, ITagsStoragePtr db);
     void DoNotifyReady(wxEvtHandler* caller, int requestType);
 
 private:
@@ -22,21 +22,29 @@
 //
 //////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////
+#include "clFileContentCache.h"
 #include "clFilesCollector.h"
+#include "clTrigramIndex.h"
+#include "clWorkerPool.h"
 #include "cppwordscanner.h"
 #include "dirtraverser.h"
+#include "file_logger.h"
 #include "fileutils.h"
 #include "macros.h"
 #include "search_thread.h"
 #include "wx/event.h"
 #include <algorithm>
 #include <iostream>
+#include <map>
 #include <set>
+#include <string.h>
 #include <wx/dir.h>
 #if wxUSE_GUI
 #include <wx/fontmap.h>
 #endif
 #include <wx/log.h>
+#include <wx/msgqueue.h>
+#include <wx/thread.h>
 #include <wx/tokenzr.h>
 #include <wx/txtstrm.h>
 #include <wx/wfstream.h>
@@ -58,12 +66,73 @@ wxDEFINE_EVENT(wxEVT_SEARCH_THREAD_SEARCHSTARTED, wxCommandEvent);
     }                                         \
     wxThread::Sleep(1);
 
+// The number of results sent to the UI per wxEVT_SEARCH_THREAD_MATCHFOUND event
+#define SEARCH_RESULTS_BATCH_SIZE 500
+
+// The search pauses when the UI has that many batches to process
+#define SEARCH_RESULTS_MAX_PENDING_BATCHES 4
+
+// How far the workers can get ahead of the first file whose results were not delivered yet
+#define SEARCH_MAX_FILES_AHEAD 256
+
 //----------------------------------------------------------------
 // SearchData
 //----------------------------------------------------------------
 
 const wxString& SearchData::GetExtensions() const { return m_validExt; }
 
+//----------------------------------------------------------------
+// SearchResult
+//----------------------------------------------------------------
+
+const wxString& SearchResult::GetEmptyString()
+{
+    static const wxString empty;
+    return empty;
+}
+
+//----------------------------------------------------------------
+// SearchResultsThrottle
+//----------------------------------------------------------------
+
+SearchResultsThrottle::SearchResultsThrottle()
+    : m_condition(m_mutex)
+    , m_pending(0)
+    , m_generation(0)
+{
+}
+
+SearchResultsThrottle::~SearchResultsThrottle() {}
+
+size_t SearchResultsThrottle::Add()
+{
+    wxMutexLocker locker(m_mutex);
+    ++m_pending;
+    return m_generation;
+}
+
+void SearchResultsThrottle::Release(size_t generation)
+{
+    wxMutexLocker locker(m_mutex);
+    if(generation != m_generation) { return; }
+    if(m_pending) { --m_pending; }
+    m_condition.Signal();
+}
+
+void SearchResultsThrottle::Reset()
+{
+    wxMutexLocker locker(m_mutex);
+    m_pending = 0;
+    ++m_generation;
+}
+
+bool SearchResultsThrottle::Wait(size_t maxPending, unsigned long ms)
+{
+    wxMutexLocker locker(m_mutex);
+    if(m_pending >= maxPending) { m_condition.WaitTimeout(ms); }
+    return m_pending < maxPending;
+}
+
 //----------------------------------------------------------------
 // SearchThread
 //----------------------------------------------------------------
@@ -71,7 +140,7 @@ const wxString& SearchData::GetExtensions() const { return m_validExt; }
 SearchThread::SearchThread()
     : WorkerThread()
     , m_wordChars(wxT("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_"))
-    , m_reExpr(wxT(""))
+    , m_throttle(new SearchResultsThrottle())
 {
     IndexWordChars();
 }
@@ -92,31 +161,14 @@ void SearchThread::SetWordChars(const wxString& chars)
     IndexWordChars();
 }
 
-wxRegEx& SearchThread::GetRegex(const wxString& expr, bool matchCase)
-{
-    if(m_reExpr == expr && matchCase == m_matchCase) {
-        return m_regex;
-    } else {
-        m_reExpr = expr;
-        m_matchCase = matchCase;
-#ifndef __WXMAC__
-        int flags = wxRE_ADVANCED;
-#else
-        int flags = wxRE_DEFAULT;
-#endif
-
-        if(!matchCase) flags |= wxRE_ICASE;
-        m_regex.Compile(m_reExpr, flags);
-    }
-    return m_regex;
-}
-
 void SearchThread::PerformSearch(const SearchData& data) { Add(new SearchData(data)); }
 
 void SearchThread::ProcessRequest(ThreadRequest* req)
 {
     wxStopWatch sw;
     m_summary = SearchSummary();
+    // batches left over from a previous search must not slow this one down
+    m_throttle->Reset();
     DoSearchFiles(req);
     m_summary.SetElapsedTime(sw.Time());
 
@@ -155,6 +207,253 @@ void SearchThread::GetFiles(const SearchData* data, wxArrayString& files)
     std::for_each(scannedFiles.begin(), scannedFiles.end(), [&](const wxString& file) { files.Add(file); });
 }
 
+static void CompileRegex(wxRegEx& re, const wxString& expr, bool matchCase)
+{
+#ifndef __WXMAC__
+    int flags = wxRE_ADVANCED;
+#else
+    int flags = wxRE_DEFAULT;
+#endif
+
+    if(!matchCase) flags |= wxRE_ICASE;
+    re.Compile(expr, flags);
+}
+
+/**
+ * @brief ASCII case insensitive comparison of 'len' bytes
+ */
+static bool AsciiEqualsNoCase(const char* a, const char* b, size_t len)
+{
+    for(size_t i = 0; i < len; ++i) {
+        char ca = a[i];
+        char cb = b[i];
+        if(ca >= 'A' && ca <= 'Z') ca += ('a' - 'A');
+        if(cb >= 'A' && cb <= 'Z') cb += ('a' - 'A');
+        if(ca != cb) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief return true if 'buffer' contains 'needle'. The candidates are located with memchr, which
+ * is vectorized by the C runtime
+ */
+static bool BufferContains(const char* buffer, size_t len, const std::string& needle, bool matchCase)
+{
+    if(needle.empty()) return true;
+    if(needle.length() > len) return false;
+
+    char first = needle[0];
+    char firstAlt = first;
+    if(!matchCase) {
+        if(first >= 'a' && first <= 'z') {
+            firstAlt = first - ('a' - 'A');
+        } else if(first >= 'A' && first <= 'Z') {
+            firstAlt = first + ('a' - 'A');
+        }
+    }
+
+    const char* p = buffer;
+    const char* end = buffer + (len - needle.length() + 1); // a match must start before this point
+    while(p < end) {
+        const char* candidate = (const char*)memchr(p, first, end - p);
+        if(firstAlt != first) {
+            // look for the other case of the first char, up to the first candidate found so far
+            const char* alt = (const char*)memchr(p, firstAlt, (candidate ? candidate : end) - p);
+            if(alt) { candidate = alt; }
+        }
+        if(!candidate) return false;
+
+        bool match = matchCase ? (memcmp(candidate + 1, needle.c_str() + 1, needle.length() - 1) == 0)
+                               : AsciiEqualsNoCase(candidate + 1, needle.c_str() + 1, needle.length() - 1);
+        if(match) return true;
+        p = candidate + 1;
+    }
+    return false;
+}
+
+/**
+ * @brief convert 'findWhat' into the bytes that represent it in a file. This is only possible for ASCII strings
+ * in an encoding that stores ASCII as is (UTF-8, ISO-8859-*...)
+ */
+static bool GetRawString(const wxString& findWhat, const wxMBConv& conv, std::string& raw)
+{
+    if(!findWhat.IsAscii()) return false;
+
+    raw = findWhat.mb_str(wxConvUTF8).data();
+    wxCharBuffer encoded = conv.cWC2MB(findWhat.wc_str());
+    // the file encoding does not store ASCII as is
+    return encoded.data() && (raw == encoded.data());
+}
+
+/**
+ * @brief check, before decoding it, whether the raw content of a file can contain 'findWhat'.
+ * The check is only conclusive when GetRawString() succeeds (a pure ASCII 'findWhat'), in any other case this
+ * function returns true
+ */
+static bool FileMayContain(const char* data, size_t len, const wxString& findWhat, bool matchCase, const wxMBConv& conv)
+{
+    std::string needle;
+    if(!GetRawString(findWhat, conv, needle)) return true;
+    return BufferContains(data, len, needle, matchCase);
+}
+
+/**
+ * @brief find 'lowerWhat' (lower case) in 'str' from 'from', ignoring the case of 'str' and without making a lower
+ * case copy of it. An ASCII 'lowerWhat' only matches ASCII chars, like the byte check of FileMayContain()
+ */
+static size_t FindNoCase(const wxString& str, const wxString& lowerWhat, size_t from)
+{
+    size_t len = str.length();
+    size_t whatLen = lowerWhat.length();
+    if(whatLen == 0) return (from <= len) ? from : wxString::npos;
+
+    bool asciiOnly = lowerWhat.IsAscii();
+    for(size_t i = from; (i + whatLen) <= len; ++i) {
+        size_t j = 0;
+        for(; j < whatLen; ++j) {
+            wxChar ch = str[i + j];
+            if(asciiOnly) {
+                if(ch >= 'A' && ch <= 'Z') { ch += ('a' - 'A'); }
+            } else {
+                ch = (wxChar)wxTolower(ch);
+            }
+            if(ch != lowerWhat[j]) break;
+        }
+        if(j == whatLen) return i;
+    }
+    return wxString::npos;
+}
+
+/**
+ * @brief keep only the files that may contain a match according to the trigram index
+ * @param stale [output] true for every file that was not indexed or was modified since it was indexed
+ * @return false if the index can not be used for this search
+ */
+static bool FilterFilesWithIndex(clTrigramIndex* index, const SearchData* data, wxArrayString& files,
+                                 std::vector<bool>& stale)
+{
+    // The string that every match must contain
+    wxString literal;
+    if(data->IsRegularExpression()) {
+        literal = clTrigramIndex::GetRegexLiteral(data->GetFindString());
+    } else if(data->IsEnablePipeSupport() && (data->GetFindString().Find('|') != wxNOT_FOUND)) {
+        literal = data->GetFindString().BeforeFirst('|');
+    } else {
+        literal = data->GetFindString();
+    }
+
+#if wxUSE_GUI
+    wxFontEncoding enc = wxFontMapper::GetEncodingFromName(data->GetEncoding().c_str());
+    wxCSConv fontEncConv(enc);
+#else
+    const wxMBConv& fontEncConv = wxConvLibc;
+#endif
+
+    std::string raw;
+    if(!GetRawString(literal, fontEncConv, raw)) { return false; }
+
+    size_t count = files.GetCount();
+    if(!index->Filter(raw, files, stale)) { return false; }
+    clDEBUG() << "Find in files: the trigram index narrowed" << count << "files down to" << files.GetCount()
+              << clEndl;
+    return true;
+}
+
+/**
+ * @brief the outcome of searching a single file by a search worker
+ */
+struct SearchFileResult {
+    size_t m_index;
+    wxString m_filename;
+    SearchResultList m_results;
+    bool m_failed;
+
+    SearchFileResult()
+        : m_index(0)
+        , m_failed(false)
+    {
+    }
+};
+
+/**
+ * @brief state shared between the SearchThread and its workers
+ */
+class SearchWorkersContext
+{
+    std::vector<wxString> m_files;
+    clTrigramIndex::Ptr_t m_index;
+    std::vector<bool> m_stale;
+    size_t m_next;
+    size_t m_delivered;
+    bool m_cancelled;
+    wxMutex m_mutex;
+    wxCondition m_condition;
+
+public:
+    wxMessageQueue<SearchFileResult*> m_results;
+
+public:
+    SearchWorkersContext(const wxArrayString& files)
+        : m_next(0)
+        , m_delivered(0)
+        , m_cancelled(false)
+        , m_condition(m_mutex)
+    {
+        m_files.reserve(files.GetCount());
+        for(size_t i = 0; i < files.GetCount(); ++i) {
+            // make a deep copy, these strings are going to be used by other threads
+            m_files.push_back(files.Item(i).c_str());
+        }
+    }
+
+    size_t GetCount() const { return m_files.size(); }
+
+    /**
+     * @brief set the trigram index that the files flagged in 'stale' should be (re)indexed into
+     */
+    void SetIndex(clTrigramIndex::Ptr_t index, const std::vector<bool>& stale)
+    {
+        m_index = index;
+        m_stale = stale;
+    }
+
+    /**
+     * @brief fetch the next file to search. Return false when there are no more files or when
+     * the search was cancelled. Blocks while the workers are too far ahead of the delivered results
+     * @param trigramIndex [output] the trigram index to update with the file content, or NULL
+     */
+    bool Next(size_t& index, wxString& filename, clTrigramIndex*& trigramIndex)
+    {
+        wxMutexLocker locker(m_mutex);
+        while(!m_cancelled && (m_next >= m_delivered + SEARCH_MAX_FILES_AHEAD)) {
+            m_condition.Wait();
+        }
+        if(m_cancelled || (m_next >= m_files.size())) { return false; }
+        index = m_next++;
+        filename = m_files[index];
+        trigramIndex = (m_index && (index < m_stale.size()) && m_stale[index]) ? m_index.get() : NULL;
+        return true;
+    }
+
+    /**
+     * @brief the results of all the files before 'index' were delivered
+     */
+    void SetDelivered(size_t index)
+    {
+        wxMutexLocker locker(m_mutex);
+        m_delivered = index;
+        m_condition.Broadcast();
+    }
+
+    void Cancel()
+    {
+        wxMutexLocker locker(m_mutex);
+        m_cancelled = true;
+        m_condition.Broadcast();
+    }
+};
+
 void SearchThread::DoSearchFiles(ThreadRequest* req)
 {
     SearchData* data = static_cast<SearchData*>(req);
@@ -169,6 +468,12 @@ void SearchThread::DoSearchFiles(ThreadRequest* req)
     wxArrayString fileList;
     GetFiles(data, fileList);
 
+    // Skip the files that can not contain a match according to the trigram index. The files that the index knows
+    // nothing about are searched, and indexed on the way
+    clTrigramIndex::Ptr_t trigramIndex = GetTrigramIndex();
+    std::vector<bool> staleFiles;
+    if(trigramIndex && !FilterFilesWithIndex(trigramIndex.get(), data, fileList, staleFiles)) { trigramIndex.reset(); }
+
     wxStopWatch sw;
 
     // Send startup message to main thread
@@ -183,17 +488,91 @@ void SearchThread::DoSearchFiles(ThreadRequest* req)
         }
     }
 
-    for(size_t i = 0; i < fileList.Count(); i++) {
-        m_summary.SetNumFileScanned((int)i + 1);
+    if(fileList.IsEmpty()) { return; }
+
+    // Search the files with a pool of workers
+    SearchWorkersContext context(fileList);
+    if(trigramIndex) { context.SetIndex(trigramIndex, staleFiles); }
+    size_t workersCount = std::min(clWorkerPool::GetCPUCount(), fileList.GetCount());
+    clWorkerPool workers(workersCount);
+    size_t started = workers.Run(workersCount, [&]() {
+        // wxRegEx is not thread safe, each worker uses its own
+        wxRegEx re;
+        if(data->IsRegularExpression()) { CompileRegex(re, data->GetFindString(), data->IsMatchCase()); }
+
+        size_t index(0);
+        wxString filename;
+        clTrigramIndex* trigramIndex(NULL);
+        while(context.Next(index, filename, trigramIndex)) {
+            SearchFileResult* result = new SearchFileResult();
+            result->m_index = index;
+            result->m_filename = filename;
+            result->m_failed = !DoSearchFile(filename, data, re, result->m_results, trigramIndex);
+            context.m_results.Post(result);
+        }
+    });
 
+    if(started == 0) {
+        clWARNING() << "Find in files: failed to start search workers" << clEndl;
+        return;
+    }
+
+    // The workers complete the files in any order, but the results are delivered in the order of the file list
+    std::map<size_t, SearchFileResult*> pending;
+    size_t nextIndex(0);
+    bool cancelled(false);
+    while(nextIndex < context.GetCount()) {
         // give user chance to cancel the search ...
-        if(TestStopSearch()) {
-            // Send cancel event
-            SendEvent(wxEVT_SEARCH_THREAD_SEARCHCANCELED, data->GetOwner());
-            StopSearch(false);
+        if(TestStopSearch() || TestDestroy()) {
+            cancelled = true;
+            break;
+        }
+
+        SearchFileResult* result(NULL);
+        if(context.m_results.ReceiveTimeout(100, result) != wxMSGQUEUE_NO_ERROR) { continue; }
+        pending.insert(std::make_pair(result->m_index, result));
+
+        std::map<size_t, SearchFileResult*>::iterator iter = pending.find(nextIndex);
+        while(iter != pending.end()) {
+            SearchFileResult* fileResult = iter->second;
+            pending.erase(iter);
+
+            m_summary.SetNumFileScanned((int)nextIndex + 1);
+            if(fileResult->m_failed) { m_summary.GetFailedFiles().Add(fileResult->m_filename); }
+            if(!fileResult->m_results.empty()) {
+                m_summary.SetNumMatchesFound(m_summary.GetNumMatchesFound() + (int)fileResult->m_results.size());
+                m_results.splice(m_results.end(), fileResult->m_results);
+            }
+            delete fileResult;
+
+            ++nextIndex;
+            context.SetDelivered(nextIndex);
+            iter = pending.find(nextIndex);
+        }
+
+        // Send the complete batches, this waits for the UI to catch up
+        if(!SendResults(data->GetOwner(), false)) {
+            cancelled = true;
             break;
         }
-        DoSearchFile(fileList.Item(i), data);
+    }
+
+    if(cancelled) { context.Cancel(); }
+    workers.Wait();
+
+    if(cancelled) {
+        // discard the results that were not delivered
+        m_results.clear();
+        SearchFileResult* result(NULL);
+        while(context.m_results.ReceiveTimeout(0, result) == wxMSGQUEUE_NO_ERROR) {
+            delete result;
+        }
+        std::for_each(pending.begin(), pending.end(),
+                      [&](const std::pair<size_t, SearchFileResult*>& p) { delete p.second; });
+
+        // Send cancel event
+        SendEvent(wxEVT_SEARCH_THREAD_SEARCHCANCELED, data->GetOwner());
+        StopSearch(false);
     }
 }
 
@@ -213,107 +592,136 @@ void SearchThread::StopSearch(bool stop)
     m_stopSearch = stop;
 }
 
-void SearchThread::DoSearchFile(const wxString& fileName, const SearchData* data)
+void SearchThread::SetTrigramIndex(clTrigramIndex::Ptr_t index)
+{
+    wxCriticalSectionLocker locker(m_cs);
+    m_trigramIndex = index;
+}
+
+clTrigramIndex::Ptr_t SearchThread::GetTrigramIndex()
+{
+    wxCriticalSectionLocker locker(m_cs);
+    return m_trigramIndex;
+}
+
+bool SearchThread::DoSearchFile(const wxString& fileName, const SearchData* data, wxRegEx& re,
+                                SearchResultList& results, clTrigramIndex* index)
 {
     // Process single lines
     int lineNumber = 1;
-    if(!wxFileName::FileExists(fileName)) {
-        return;
+    wxInt64 lastModified(0);
+    size_t fileSize(0);
+    if(index && !clTrigramIndex::GetFileAttributes(fileName, lastModified, fileSize)) { index = NULL; }
+
+    // Searching the same files again (or files that were just parsed) does not read them from the disk
+    clFileContent::Ptr_t file = clFileContentCache::Get().Load(fileName);
+    if(!file) {
+        if(index) { index->Remove(fileName); }
+        // a file that no longer exists is not a failure
+        return !wxFileName::FileExists(fileName);
     }
-    
-    size_t size = FileUtils::GetFileSize(fileName);
-    if(size == 0) { return; }
-    wxString fileData;
-    fileData.Alloc(size);
+
+    // We have the file content at hand, update the index
+    if(index) { index->Update(fileName, file->GetData(), file->GetSize(), lastModified, fileSize); }
+
+    if(file->GetSize() == 0) { return true; }
 
 #if wxUSE_GUI
     // support for other encoding
     wxFontEncoding enc = wxFontMapper::GetEncodingFromName(data->GetEncoding().c_str());
-    wxCSConv fontEncConv(enc);
-    if(!FileUtils::ReadFileContent(fileName, fileData, fontEncConv)) {
-        m_summary.GetFailedFiles().Add(fileName);
-        return;
-    }
 #else
-    if(!FileUtils::ReadFileContent(fileName, fileData, wxConvLibc)) {
-        m_summary.GetFailedFiles().Add(fileName);
-        return;
-    }
+    wxFontEncoding enc = wxFONTENCODING_SYSTEM;
 #endif
-    // take a wild guess and see if we really need to construct
-    // a TextStatesPtr object (it is quite an expensive operation)
-    bool shouldCreateStates(true);
-    if(data->IsMatchCase() && !data->IsRegularExpression()) {
-        shouldCreateStates = (fileData.Find(data->GetFindString()) != wxNOT_FOUND);
+    wxCSConv fontEncConv(enc);
 
-    } else if(!data->IsMatchCase() && !data->IsRegularExpression()) {
-        // !data->IsMatchCase()
-        wxString tmpData = fileData;
-        shouldCreateStates = (tmpData.MakeLower().Find(data->GetFindString()) != wxNOT_FOUND);
+    wxString findString;
+    wxArrayString filters;
+    findString = data->GetFindString();
+    if(!data->IsRegularExpression() && data->IsEnablePipeSupport()) {
+        if(data->GetFindString().Find('|') != wxNOT_FOUND) {
+            findString = data->GetFindString().BeforeFirst('|');
+
+            wxString filtersString = data->GetFindString().AfterFirst('|');
+            filters = ::wxStringTokenize(filtersString, "|", wxTOKEN_STRTOK);
+            if(!data->IsMatchCase()) {
+                for(size_t i = 0; i < filters.size(); ++i) {
+                    filters.Item(i).MakeLower();
+                }
+            }
+        }
     }
 
-    wxStringTokenizer tkz(fileData, wxT("\n"), wxTOKEN_RET_EMPTY_ALL);
+    // Skip files that can not contain a match before paying for the conversion into wxString
+    if(!data->IsRegularExpression() &&
+       !FileMayContain(file->GetData(), file->GetSize(), findString, data->IsMatchCase(), fontEncConv)) {
+        return true;
+    }
+
+    // The decoded content is cached as well
+    wxString fileData = file->GetText(enc);
+    file.reset(NULL);
+
+    // All the matches of this file share the same file name and find-what strings
+    SearchResult resultTemplate;
+    resultTemplate.SetFileName(fileName);
+    resultTemplate.SetFindWhat(data->GetFindString());
+    resultTemplate.SetFlags(data->m_flags);
 
     // Incase one of the C++ options is enabled,
     // create a text states object
     TextStatesPtr states(NULL);
-    if(data->HasCppOptions() && shouldCreateStates && false) {
+    if(data->HasCppOptions() && false) {
         CppWordScanner scanner("", fileData.mb_str().data(), 0);
         states = scanner.states();
     }
 
-    int lineOffset = 0;
     if(data->IsRegularExpression()) {
         // regular expression search
+        wxStringTokenizer tkz(fileData, wxT("\n"), wxTOKEN_RET_EMPTY_ALL);
+        int lineOffset = 0;
         while(tkz.HasMoreTokens()) {
             // Read the next line
             wxString line = tkz.NextToken();
-            DoSearchLineRE(line, lineNumber, lineOffset, fileName, data, states);
+            DoSearchLineRE(line, lineNumber, lineOffset, resultTemplate, data, states, re, results);
             lineOffset += line.Length() + 1;
             lineNumber++;
         }
     } else {
-        // simple search
-        wxString findString;
-        wxArrayString filters;
-        findString = data->GetFindString();
-        if(data->IsEnablePipeSupport()) {
-            if(data->GetFindString().Find('|') != wxNOT_FOUND) {
-                findString = data->GetFindString().BeforeFirst('|');
-
-                wxString filtersString = data->GetFindString().AfterFirst('|');
-                filters = ::wxStringTokenize(filtersString, "|", wxTOKEN_STRTOK);
-                if(!data->IsMatchCase()) {
-                    for(size_t i = 0; i < filters.size(); ++i) {
-                        filters.Item(i).MakeLower();
-                    }
+        // simple search: search the whole content and split lines only around the matches
+        if(!data->IsMatchCase()) { findString.MakeLower(); }
+
+        size_t lineStart = 0; // the offset of line 'lineNumber'
+        while(lineStart < fileData.length()) {
+            size_t where = data->IsMatchCase() ? fileData.find(findString, lineStart)
+                                               : FindNoCase(fileData, findString, lineStart);
+            if(where == wxString::npos) { break; }
+
+            // move to the line of the match
+            for(size_t i = lineStart; i < where; ++i) {
+                if(fileData[i] == '\n') {
+                    lineStart = i + 1;
+                    lineNumber++;
                 }
             }
-        }
 
-        if(!data->IsMatchCase()) {
-            findString.MakeLower();
-        }
+            size_t lineEnd = fileData.find('\n', where);
+            if(lineEnd == wxString::npos) { lineEnd = fileData.length(); }
 
-        while(tkz.HasMoreTokens()) {
+            wxString line = fileData.Mid(lineStart, lineEnd - lineStart);
+            DoSearchLine(line, lineNumber, (int)lineStart, resultTemplate, data, findString, filters, states, results);
 
-            // Read the next line
-            wxString line = tkz.NextToken();
-            DoSearchLine(line, lineNumber, lineOffset, fileName, data, findString, filters, states);
-            lineOffset += line.Length() + 1;
+            // continue from the next line
+            lineStart = lineEnd + 1;
             lineNumber++;
         }
     }
-
-    if(m_results.empty() == false) {
-        SendEvent(wxEVT_SEARCH_THREAD_MATCHFOUND, data->GetOwner());
-    }
+    return true;
 }
 
 void SearchThread::DoSearchLineRE(const wxString& line, const int lineNum, const int lineOffset,
-                                  const wxString& fileName, const SearchData* data, TextStatesPtr statesPtr)
+                                  const SearchResult& resultTemplate, const SearchData* data, TextStatesPtr statesPtr,
+                                  wxRegEx& re, SearchResultList& results)
 {
-    wxRegEx& re = GetRegex(data->GetFindString(), data->IsMatchCase());
     size_t col = 0;
     int iCorrectedCol = 0;
     int iCorrectedLen = 0;
@@ -328,17 +736,14 @@ void SearchThread::DoSearchLineRE(const wxString& line, const int lineNum, const
             // correct search Pos and Length owing to non plain ASCII multibyte characters
             iCorrectedCol = FileUtils::UTF8Length(line.c_str(), col);
             iCorrectedLen = FileUtils::UTF8Length(line.c_str(), col + len) - iCorrectedCol;
-            SearchResult result;
+            SearchResult result(resultTemplate);
             result.SetPosition(lineOffset + col);
             result.SetColumnInChars((int)col);
             result.SetColumn(iCorrectedCol);
             result.SetLineNumber(lineNum);
             result.SetPattern(line);
-            result.SetFileName(fileName);
             result.SetLenInChars((int)len);
             result.SetLen(iCorrectedLen);
-            result.SetFlags(data->m_flags);
-            result.SetFindWhat(data->GetFindString());
 
             // Make sure our match is not on a comment
             int position(wxNOT_FOUND);
@@ -378,10 +783,7 @@ void SearchThread::DoSearchLineRE(const wxString& line, const int lineNum, const
                 }
             }
 
-            if(canAdd) {
-                m_results.push_back(result);
-                m_summary.SetNumMatchesFound(m_summary.GetNumMatchesFound() + 1);
-            }
+            if(canAdd) { results.push_back(result); }
 
             col += len;
 
@@ -392,9 +794,9 @@ void SearchThread::DoSearchLineRE(const wxString& line, const int lineNum, const
     }
 }
 
-void SearchThread::DoSearchLine(const wxString& line, const int lineNum, const int lineOffset, const wxString& fileName,
-                                const SearchData* data, const wxString& findWhat, const wxArrayString& filters,
-                                TextStatesPtr statesPtr)
+void SearchThread::DoSearchLine(const wxString& line, const int lineNum, const int lineOffset,
+                                const SearchResult& resultTemplate, const SearchData* data, const wxString& findWhat,
+                                const wxArrayString& filters, TextStatesPtr statesPtr, SearchResultList& results)
 {
     wxString modLine = line;
 
@@ -456,18 +858,15 @@ void SearchThread::DoSearchLine(const wxString& line, const int lineNum, const i
             // correct search Pos and Length owing to non plain ASCII multibyte characters
             iCorrectedCol = FileUtils::UTF8Length(line.c_str(), col);
             iCorrectedLen = FileUtils::UTF8Length(findWhat.c_str(), findWhat.Length());
-            SearchResult result;
+            SearchResult result(resultTemplate);
             result.SetPosition(lineOffset + col);
             result.SetColumnInChars(col);
             result.SetColumn(iCorrectedCol);
             result.SetLineNumber(lineNum);
             // Dont use match pattern larger than 500 chars
             result.SetPattern(line.length() > 500 ? line.Mid(0, 500) : line);
-            result.SetFileName(fileName);
             result.SetLenInChars((int)findWhat.Length());
             result.SetLen(iCorrectedLen);
-            result.SetFindWhat(data->GetFindString());
-            result.SetFlags(data->m_flags);
 
             int position(wxNOT_FOUND);
             bool canAdd(true);
@@ -507,10 +906,7 @@ void SearchThread::DoSearchLine(const wxString& line, const int lineNum, const i
                 }
             }
 
-            if(canAdd) {
-                m_results.push_back(result);
-                m_summary.SetNumMatchesFound(m_summary.GetNumMatchesFound() + 1);
-            }
+            if(canAdd) { results.push_back(result); }
 
             if(!AdjustLine(modLine, pos, findWhat)) {
                 break;
@@ -536,44 +932,54 @@ void SearchThread::SendEvent(wxEventType type, wxEvtHandler* owner)
 {
     if(!m_notifiedWindow && !owner) return;
 
-    static int counter(0);
-
     wxCommandEvent event(type, GetId());
-
-    if(type == wxEVT_SEARCH_THREAD_MATCHFOUND && counter == 10) {
-        // match found and we scanned 10 files
-        counter = 0;
-        event.SetClientData(new SearchResultList(m_results));
-        m_results.clear();
-        SEND_ST_EVENT();
-
-    } else if(type == wxEVT_SEARCH_THREAD_MATCHFOUND) {
-        // a match event, but we did not meet the minimum number of files
-        counter++;
-        wxThread::Sleep(10);
+    if(type == wxEVT_SEARCH_THREAD_MATCHFOUND) {
+        SendResults(owner, false);
 
     } else if((type == wxEVT_SEARCH_THREAD_SEARCHEND) || (type == wxEVT_SEARCH_THREAD_SEARCHCANCELED)) {
         // search eneded, if we got any matches "buffed" send them before the
         // the summary event
-        if(m_results.empty() == false) {
-            wxCommandEvent evt(wxEVT_SEARCH_THREAD_MATCHFOUND, GetId());
-            evt.SetClientData(new SearchResultList(m_results));
-            if(owner) {
-                wxPostEvent(owner, evt);
-            } else if(m_notifiedWindow) {
-                wxPostEvent(m_notifiedWindow, evt);
-            }
-        }
-
+        SendResults(owner, true);
         m_results.clear();
-        counter = 0;
-        
+
         // Now send the summary event
         event.SetClientData(type == wxEVT_SEARCH_THREAD_SEARCHEND ? new SearchSummary(m_summary) : nullptr);
         SEND_ST_EVENT();
     }
 }
 
+bool SearchThread::SendResults(wxEvtHandler* owner, bool all)
+{
+    if(!m_notifiedWindow && !owner) {
+        m_results.clear();
+        return true;
+    }
+
+    while(!m_results.empty() && (all || (m_results.size() >= SEARCH_RESULTS_BATCH_SIZE))) {
+        // Let the UI process the previous batches first
+        while(!m_throttle->Wait(SEARCH_RESULTS_MAX_PENDING_BATCHES, 100)) {
+            if(TestStopSearch() || TestDestroy()) { return false; }
+        }
+
+        SearchResultList::iterator end = m_results.begin();
+        std::advance(end, std::min(m_results.size(), (size_t)SEARCH_RESULTS_BATCH_SIZE));
+        SearchResultList* batch = new SearchResultList();
+        batch->splice(batch->end(), m_results, m_results.begin(), end);
+
+        wxCommandEvent event(wxEVT_SEARCH_THREAD_MATCHFOUND, GetId());
+        event.SetClientData(batch);
+        wxEvtHandler* handler = owner ? owner : m_notifiedWindow;
+        wxPostEvent(handler, event);
+
+        // The events of a handler are processed in order, so this call runs once the handler is done with the
+        // batch, whatever the handler does with the results
+        size_t generation = m_throttle->Add();
+        SearchResultsThrottle::Ptr_t throttle = m_throttle;
+        handler->CallAfter([=]() { throttle->Release(generation); });
+    }
+    return true;
+}
+
 void SearchThread::FilterFiles(wxArrayString& files, const SearchData* data)
 {
     wxArrayString tmpFiles;
@@ -607,7 +1013,7 @@ SearchThread* SearchThreadST::Get()
 JSONElement SearchResult::ToJSON() const
 {
     JSONElement json = JSONElement::createObject();
-    json.addProperty("file", m_fileName);
+    json.addProperty("file", GetFileName());
     json.addProperty("line", m_lineNumber);
     json.addProperty("col", m_column);
     json.addProperty("pos", m_position);
@@ -628,7 +1034,7 @@ void SearchResult::FromJSON(const JSONElement& json)
     m_column = json.namedObject("col").toInt(m_column);
     m_lineNumber = json.namedObject("line").toInt(m_lineNumber);
     m_pattern = json.namedObject("pattern").toString(m_pattern);
-    m_fileName = json.namedObject("file").toString(m_fileName);
+    SetFileName(json.namedObject("file").toString(GetFileName()));
     m_len = json.namedObject("len").toInt(m_len);
     m_flags = json.namedObject("flags").toSize_t(m_flags);
     m_columnInChars = json.namedObject("columnInChars").toInt(m_columnInChars);
@@ -25,6 +25,7 @@
 #ifndef SEARCH_THREAD_H
 #define SEARCH_THREAD_H
 
+#include "clTrigramIndex.h"
 #include "codelite_exports.h"
 #include "cppwordscanner.h"
 #include "singleton.h"
@@ -36,7 +37,9 @@
 #include <list>
 #include <map>
 #include <wx/regex.h>
+#include <wx/sharedptr.h>
 #include <wx/string.h>
+#include <wx/thread.h>
 #include "json_node.h"
 
 class wxEvtHandler;
@@ -170,13 +173,18 @@ public:
 //------------------------------------------
 class WXDLLIMPEXP_CL SearchResult : public wxObject
 {
+public:
+    /// A string shared by many results (e.g. the file name). Shared strings are never modified
+    typedef wxSharedPtr<wxString> SharedString_t;
+
+private:
     wxString m_pattern;
     int m_position;
     int m_lineNumber;
     int m_column;
-    wxString m_fileName;
+    SharedString_t m_fileName;
     int m_len;
-    wxString m_findWhat;
+    SharedString_t m_findWhat;
     size_t m_flags;
     int m_columnInChars;
     int m_lenInChars;
@@ -198,9 +206,9 @@ public:
         m_column = rhs.m_column;
         m_lineNumber = rhs.m_lineNumber;
         m_pattern = rhs.m_pattern.c_str();
-        m_fileName = rhs.m_fileName.c_str();
+        m_fileName = rhs.m_fileName;
         m_len = rhs.m_len;
-        m_findWhat = rhs.m_findWhat.c_str();
+        m_findWhat = rhs.m_findWhat;
         m_flags = rhs.m_flags;
         m_columnInChars = rhs.m_columnInChars;
         m_lenInChars = rhs.m_lenInChars;
@@ -223,21 +231,23 @@ public:
     void SetPosition(const int& position) { m_position = position; }
     void SetLineNumber(const int& line) { m_lineNumber = line; }
     void SetColumn(const int& col) { m_column = col; }
-    void SetFileName(const wxString& fileName) { m_fileName = fileName.c_str(); }
+    void SetFileName(const wxString& fileName) { m_fileName.reset(new wxString(fileName.c_str())); }
+    void SetFileName(const SharedString_t& fileName) { m_fileName = fileName; }
 
     const int& GetPosition() const { return m_position; }
     const int& GetLineNumber() const { return m_lineNumber; }
     const int& GetColumn() const { return m_column; }
     const wxString& GetPattern() const { return m_pattern; }
-    const wxString& GetFileName() const { return m_fileName; }
+    const wxString& GetFileName() const { return m_fileName ? *m_fileName : GetEmptyString(); }
 
     void SetLen(const int& len) { this->m_len = len; }
     const int& GetLen() const { return m_len; }
 
     // Setters
-    void SetFindWhat(const wxString& findWhat) { this->m_findWhat = findWhat.c_str(); }
+    void SetFindWhat(const wxString& findWhat) { this->m_findWhat.reset(new wxString(findWhat.c_str())); }
+    void SetFindWhat(const SharedString_t& findWhat) { this->m_findWhat = findWhat; }
     // Getters
-    const wxString& GetFindWhat() const { return m_findWhat; }
+    const wxString& GetFindWhat() const { return m_findWhat ? *m_findWhat : GetEmptyString(); }
 
     void SetColumnInChars(const int& col) { this->m_columnInChars = col; }
     const int& GetColumnInChars() const { return m_columnInChars; }
@@ -258,6 +268,46 @@ public:
             << wxT("): ") << GetPattern();
         return msg;
     }
+
+private:
+    static const wxString& GetEmptyString();
+};
+
+/**
+ * @class SearchResultsThrottle
+ * @brief counts the batches of results that were sent to the UI and not processed yet. The search thread waits
+ * on it when the UI falls behind
+ */
+class WXDLLIMPEXP_CL SearchResultsThrottle
+{
+    wxMutex m_mutex;
+    wxCondition m_condition;
+    size_t m_pending;
+    size_t m_generation;
+
+public:
+    typedef wxSharedPtr<SearchResultsThrottle> Ptr_t;
+
+    SearchResultsThrottle();
+    virtual ~SearchResultsThrottle();
+
+    /**
+     * @brief count a batch that was sent
+     * @return the generation to pass to Release()
+     */
+    size_t Add();
+
+    /**
+     * @brief a batch was processed. Batches that were sent before the last Reset() are ignored
+     */
+    void Release(size_t generation);
+    void Reset();
+
+    /**
+     * @brief wait up to 'ms' milliseconds for the number of pending batches to drop below 'maxPending'
+     * @return true if there are less than 'maxPending' pending batches
+     */
+    bool Wait(size_t maxPending, unsigned long ms);
 };
 
 typedef std::list<SearchResult> SearchResultList;
@@ -343,11 +393,10 @@ class WXDLLIMPEXP_CL SearchThread : public WorkerThread
     wxString m_wordChars;
     std::unordered_map<wxChar, bool> m_wordCharsMap; //< Internal
     SearchResultList m_results;
+    SearchResultsThrottle::Ptr_t m_throttle;
     bool m_stopSearch;
     SearchSummary m_summary;
-    wxString m_reExpr;
-    wxRegEx m_regex;
-    bool m_matchCase;
+    clTrigramIndex::Ptr_t m_trigramIndex;
     wxCriticalSection m_cs;
 
 private:
@@ -388,7 +437,16 @@ public:
      */
     void SetWordChars(const wxString& chars);
 
+    /**
+     * @brief set the trigram index used to skip files that can not contain a match. The files that are not
+     * indexed yet (or were modified since) are searched and indexed. Pass an empty pointer to disable
+     * \note This call can be called from the context of other thread (e.g. main thread)
+     */
+    void SetTrigramIndex(clTrigramIndex::Ptr_t index);
+
 private:
+    clTrigramIndex::Ptr_t GetTrigramIndex();
+
     /**
      * Return files to search
      * \param files output
@@ -410,23 +468,36 @@ private:
      */
     void DoSearchFiles(ThreadRequest* data);
 
-    // Perform search on a single file
-    void DoSearchFile(const wxString& fileName, const SearchData* data);
+    /**
+     * Perform search on a single file. This function is called by the search workers
+     * and must not modify the state of the search thread
+     * \param re the regular expression to use (one per worker, wxRegEx is not thread safe)
+     * \param results [output] the matches found in the file
+     * \param index when not NULL, the trigram index to update with the file content
+     * \return false if the file could not be read
+     */
+    bool DoSearchFile(const wxString& fileName, const SearchData* data, wxRegEx& re, SearchResultList& results,
+                      clTrigramIndex* index = NULL);
 
-    // Perform search on a line
-    void DoSearchLine(const wxString& line, const int lineNum, const int lineOffset, const wxString& fileName,
+    // Perform search on a line. The matches are copied from 'resultTemplate' (file name, find-what and flags)
+    void DoSearchLine(const wxString& line, const int lineNum, const int lineOffset, const SearchResult& resultTemplate,
                       const SearchData* data, const wxString& findWhat, const wxArrayString& filters,
-                      TextStatesPtr statesPtr);
+                      TextStatesPtr statesPtr, SearchResultList& results);
 
     // Perform search on a line using regular expression
-    void DoSearchLineRE(const wxString& line, const int lineNum, const int lineOffset, const wxString& fileName,
-                        const SearchData* data, TextStatesPtr statesPtr);
+    void DoSearchLineRE(const wxString& line, const int lineNum, const int lineOffset,
+                        const SearchResult& resultTemplate, const SearchData* data, TextStatesPtr statesPtr, wxRegEx& re,
+                        SearchResultList& results);
 
     // Send an event to the notified window
     void SendEvent(wxEventType type, wxEvtHandler* owner);
 
-    // return a compiled regex object for the expression
-    wxRegEx& GetRegex(const wxString& expr, bool matchCase);
+    /**
+     * @brief send the results collected so far, in batches of a fixed size. When 'all' is false, the results
+     * that do not fill a complete batch are kept for later. Wait for the UI to consume the previous batches first
+     * @return false if the search was cancelled while waiting
+     */
+    bool SendResults(wxEvtHandler* owner, bool all);
 
     // Internal function
     bool AdjustLine(wxString& line, int& pos, const wxString& findString);
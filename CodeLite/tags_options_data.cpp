@@ -84,6 +84,7 @@ TagsOptionsData::TagsOptionsData()
     , m_clangBinary(wxT(""))
     , m_clangCachePolicy(TagsOptionsData::CLANG_CACHE_ON_FILE_LOAD)
     , m_ccNumberOfDisplayItems(500)
+    , m_parserThreads(0)
     , m_version(0)
 {
     // Initialize defaults
@@ -390,6 +391,7 @@ void TagsOptionsData::FromJSON(const JSONElement& json)
     m_clangMacros = json.namedObject(wxT("m_clangMacros")).toString();
     m_clangCachePolicy = json.namedObject(wxT("m_clangCachePolicy")).toString();
     m_ccNumberOfDisplayItems = json.namedObject(wxT("m_ccNumberOfDisplayItems")).toSize_t(m_ccNumberOfDisplayItems);
+    m_parserThreads = json.namedObject(wxT("m_parserThreads")).toSize_t(m_parserThreads);
 
     if(!m_fileSpec.Contains("*.hxx")) {
         m_fileSpec = "*.cpp;*.cc;*.cxx;*.h;*.hpp;*.c;*.c++;*.tcc;*.hxx;*.h++";
@@ -423,6 +425,7 @@ JSONElement TagsOptionsData::ToJSON() const
     json.addProperty("m_clangMacros", m_clangMacros);
     json.addProperty("m_clangCachePolicy", m_clangCachePolicy);
     json.addProperty("m_ccNumberOfDisplayItems", m_ccNumberOfDisplayItems);
+    json.addProperty("m_parserThreads", m_parserThreads);
     return json;
 }
 
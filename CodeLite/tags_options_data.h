@@ -105,6 +105,7 @@ protected:
     wxString m_clangMacros;
     wxString m_clangCachePolicy;
     size_t m_ccNumberOfDisplayItems;
+    size_t m_parserThreads;
     size_t m_version;
 
 public:
@@ -135,6 +136,11 @@ public:
         this->m_ccNumberOfDisplayItems = ccNumberOfDisplayItems;
     }
     size_t GetCcNumberOfDisplayItems() const { return m_ccNumberOfDisplayItems; }
+    /**
+     * @brief number of parser workers used when retagging the workspace. 0 means "number of CPUs"
+     */
+    void SetParserThreads(size_t parserThreads) { this->m_parserThreads = parserThreads; }
+    size_t GetParserThreads() const { return m_parserThreads; }
     void SetClangCachePolicy(const wxString& clangCachePolicy) { this->m_clangCachePolicy = clangCachePolicy; }
     const wxString& GetClangCachePolicy() const { return m_clangCachePolicy; }
     void SetClangMacros(const wxString& clangMacros) { this->m_clangMacros = clangMacros; }
@@ -28,6 +28,7 @@
 #include "tags_storage_sqlite3.h"
 #include <algorithm>
 #include <wx/longlong.h>
+#include <wx/stopwatch.h>
 #include <wx/tokenzr.h>
 
 //-------------------------------------------------
@@ -60,6 +61,10 @@ void TagsStorageSQLite::OpenDatabase(const wxFileName& fileName)
     // do have an open database, so we will use it
     if(!fileName.IsOk()) return;
 
+    // The symbol index belongs to the previous database
+    m_symbolIndex.Clear();
+    m_symbolIndexVersion.Clear();
+
     try {
         if(!m_fileName.IsOk()) {
             // First time we open the db
@@ -113,6 +118,10 @@ void TagsStorageSQLite::CreateSchema()
                   "integer);");
         m_db->ExecuteUpdate(sql);
 
+        sql = wxT("create  table if not exists FILE_FINGERPRINTS (file string PRIMARY KEY, size integer, mtime "
+                  "integer, hash integer);");
+        m_db->ExecuteUpdate(sql);
+
         sql = wxT("create  table if not exists MACROS (ID INTEGER PRIMARY KEY AUTOINCREMENT, file string, line "
                   "integer, name string, is_function_like int, replacement string, signature string);");
         m_db->ExecuteUpdate(sql);
@@ -195,6 +204,7 @@ void TagsStorageSQLite::CreateSchema()
 
 void TagsStorageSQLite::RecreateDatabase()
 {
+    m_symbolIndex.Clear();
     try {
         // commit any open transactions
         Commit();
@@ -214,6 +224,7 @@ void TagsStorageSQLite::RecreateDatabase()
             m_db->ExecuteUpdate(wxT("DROP TABLE IF EXISTS TAGS_VERSION"));
             m_db->ExecuteUpdate(wxT("DROP TABLE IF EXISTS VARIABLES"));
             m_db->ExecuteUpdate(wxT("DROP TABLE IF EXISTS FILES"));
+            m_db->ExecuteUpdate(wxT("DROP TABLE IF EXISTS FILE_FINGERPRINTS"));
             m_db->ExecuteUpdate(wxT("DROP TABLE IF EXISTS MACROS"));
             m_db->ExecuteUpdate(wxT("DROP TABLE IF EXISTS SIMPLE_MACROS"));
             m_db->ExecuteUpdate(wxT("DROP TABLE IF EXISTS GLOBAL_TAGS"));
@@ -291,6 +302,7 @@ void TagsStorageSQLite::Store(TagTreePtr tree, const wxFileName& path, bool auto
 
             DoInsertTagEntry(walker.GetNode()->GetData());
         }
+        m_symbolIndex.MarkDirty();
 
         if(autoCommit) m_db->Commit();
 
@@ -310,15 +322,15 @@ void TagsStorageSQLite::SelectTagsByFile(const wxString& file, std::vector<TagEn
     path.IsOk() == false ? databaseFileName = m_fileName : databaseFileName = path;
     OpenDatabase(databaseFileName);
 
-    wxString query;
-    query << wxT("select * from tags where file='") << file << "' ";
+    clSqliteQuery query(wxT("select * from tags where file="));
+    query.Bind(file);
     //#ifdef __WXMSW__
     //    // Under Windows, the file-crawler changes the file path
     //    // to lowercase. However, the database matches the file name
     //    // by case-sensitive
     //    query << "COLLATE NOCASE ";
     //#endif
-    query << wxT("order by line asc");
+    query.Append(wxT(" order by line asc"));
     DoFetchTags(query, tags);
 }
 
@@ -330,12 +342,14 @@ void TagsStorageSQLite::DeleteByFileName(const wxFileName& path, const wxString&
 
         if(autoCommit) m_db->Begin();
 
-        wxString sql = wxString::Format(wxT("Delete from tags where File='%s'"), fileName.GetData());
+        clSqliteQuery query(wxT("Delete from tags where File="));
+        query.Bind(fileName);
         //#ifdef __WXMSW__
         //        sql << " COLLATE NOCASE ";
         //#endif
-        CL_DEBUG("TagsStorageSQLite: DeleteByFileName: '%s'", sql);
-        m_db->ExecuteUpdate(sql);
+        CL_DEBUG("TagsStorageSQLite: DeleteByFileName: '%s'", fileName);
+        m_db->ExecutePreparedUpdate(query);
+        m_symbolIndex.MarkFileDirty(fileName);
 
         if(autoCommit) m_db->Commit();
     } catch(wxSQLite3Exception& e) {
@@ -371,7 +385,6 @@ const bool TagsStorageSQLite::IsOpen() const { return m_db->IsOpen(); }
 void TagsStorageSQLite::GetFilesForCC(const wxString& userTyped, wxArrayString& matches)
 {
     try {
-        wxString query;
         wxString tmpName(userTyped);
 
         // Files are kept in native format in the database
@@ -380,23 +393,25 @@ void TagsStorageSQLite::GetFilesForCC(const wxString& userTyped, wxArrayString&
         tmpName.Replace("\\", "/");
         tmpName.Replace("/", wxString() << wxFILE_SEP_PATH);
         tmpName.Replace(wxT("_"), wxT("^_"));
-        query << wxT("select * from files where file like '%%") << tmpName << wxT("%%' ESCAPE '^' ")
-              << wxT("order by file");
+
+        clSqliteQuery query(wxT("select * from files where file like "));
+        query.Bind(wxString() << wxT("%") << tmpName << wxT("%"));
+        query.Append(wxT(" ESCAPE '^' order by file"));
 
         wxString pattern = userTyped;
         pattern.Replace("\\", "/");
 
-        wxSQLite3ResultSet res = m_db->ExecuteQuery(query);
-        while(res.NextRow()) {
+        m_db->ExecutePreparedQuery(query, [&](wxSQLite3ResultSet& res) {
             // Keep the part from where the user typed and until the end of the file name
             wxString matchedFile = res.GetString(1);
             matchedFile.Replace("\\", "/");
 
             int where = matchedFile.Find(pattern);
-            if(where == wxNOT_FOUND) continue;
+            if(where == wxNOT_FOUND) return true;
             matchedFile = matchedFile.Mid(where);
             matches.Add(matchedFile);
-        }
+            return true;
+        });
 
     } catch(wxSQLite3Exception& e) {
         wxUnusedVar(e);
@@ -408,15 +423,22 @@ void TagsStorageSQLite::GetFiles(const wxString& partialName, std::vector<FileEn
     try {
         bool match_path = (!partialName.IsEmpty() && partialName.Last() == wxFileName::GetPathSeparator());
 
-        wxString query;
         wxString tmpName(partialName);
         tmpName.Replace(wxT("_"), wxT("^_"));
-        query << wxT("select * from files where file like '%%") << tmpName << wxT("%%' ESCAPE '^' ")
-              << wxT("order by file");
+        clSqliteQuery query(wxT("select * from files where file like "));
+        query.Bind(wxString() << wxT("%") << tmpName << wxT("%"));
+        query.Append(wxT(" ESCAPE '^' order by file"));
 
-        wxSQLite3ResultSet res = m_db->ExecuteQuery(query);
-        while(res.NextRow()) {
+// Under Windows, all files are stored as lower case in the
+// database (see fc_fileopener.cpp normalize_path method
+#ifdef __WXMSW__
+        wxString lowerCasePartialName(partialName);
+        lowerCasePartialName.MakeLower();
+#else
+        wxString lowerCasePartialName(partialName);
+#endif
 
+        m_db->ExecutePreparedQuery(query, [&](wxSQLite3ResultSet& res) {
             FileEntryPtr fe(new FileEntry());
             fe->SetId(res.GetInt(0));
             fe->SetFile(res.GetString(1));
@@ -424,18 +446,12 @@ void TagsStorageSQLite::GetFiles(const wxString& partialName, std::vector<FileEn
 
             wxFileName fileName(fe->GetFile());
             wxString match = match_path ? fileName.GetFullPath() : fileName.GetFullName();
-
-// Under Windows, all files are stored as lower case in the
-// database (see fc_fileopener.cpp normalize_path method
 #ifdef __WXMSW__
-            wxString lowerCasePartialName(partialName);
-            lowerCasePartialName.MakeLower();
             match.MakeLower();
-#else
-            wxString lowerCasePartialName(partialName);
 #endif
             if(match.StartsWith(lowerCasePartialName)) { files.push_back(fe); }
-        }
+            return true;
+        });
     } catch(wxSQLite3Exception& e) {
         wxUnusedVar(e);
     }
@@ -453,12 +469,13 @@ void TagsStorageSQLite::DeleteByFilePrefix(const wxFileName& dbpath, const wxStr
 
     try {
         OpenDatabase(dbpath);
-        wxString sql;
         wxString name(filePrefix);
         name.Replace(wxT("_"), wxT("^_"));
 
-        sql << wxT("delete from tags where file like '") << name << wxT("%%' ESCAPE '^' ");
-        m_db->ExecuteUpdate(sql);
+        clSqliteQuery query(wxT("delete from tags where file like "));
+        query.Bind(name + wxT("%")).Append(wxT(" ESCAPE '^' "));
+        m_db->ExecutePreparedUpdate(query);
+        m_symbolIndex.MarkOutOfDate();
 
     } catch(wxSQLite3Exception& e) {
         wxUnusedVar(e);
@@ -468,18 +485,16 @@ void TagsStorageSQLite::DeleteByFilePrefix(const wxFileName& dbpath, const wxStr
 void TagsStorageSQLite::GetFiles(std::vector<FileEntryPtr>& files)
 {
     try {
-        wxString query(wxT("select * from files order by file"));
-        wxSQLite3ResultSet res = m_db->ExecuteQuery(query);
-
-        while(res.NextRow()) {
-
+        clSqliteQuery query(wxT("select * from files order by file"));
+        m_db->ExecutePreparedQuery(query, [&](wxSQLite3ResultSet& res) {
             FileEntryPtr fe(new FileEntry());
             fe->SetId(res.GetInt(0));
             fe->SetFile(res.GetString(1));
             fe->SetLastRetaggedTimestamp(res.GetInt(2));
 
             files.push_back(fe);
-        }
+            return true;
+        });
 
     } catch(wxSQLite3Exception& e) {
         wxUnusedVar(e);
@@ -490,19 +505,16 @@ void TagsStorageSQLite::DeleteFromFiles(const wxArrayString& files)
 {
     if(files.IsEmpty()) { return; }
 
-    wxString query;
-    query << wxT("delete from FILES where file in (");
-
-    for(size_t i = 0; i < files.GetCount(); i++) {
-        query << wxT("'") << files.Item(i) << wxT("',");
-    }
-
-    // remove last ','
-    query.RemoveLast();
-    query << wxT(")");
-
     try {
-        m_db->ExecuteQuery(query);
+        clSqliteQuery::ForEachChunk(files, [&](const wxArrayString& chunk) {
+            clSqliteQuery query(wxT("delete from FILES where file in ("));
+            query.BindList(chunk).Append(wxT(")"));
+            m_db->ExecutePreparedUpdate(query);
+
+            clSqliteQuery fingerprintsQuery(wxT("delete from FILE_FINGERPRINTS where file in ("));
+            fingerprintsQuery.BindList(chunk).Append(wxT(")"));
+            m_db->ExecutePreparedUpdate(fingerprintsQuery);
+        });
     } catch(wxSQLite3Exception& e) {
         wxUnusedVar(e);
     }
@@ -514,12 +526,16 @@ void TagsStorageSQLite::DeleteFromFilesByPrefix(const wxFileName& dbpath, const
 
     try {
         OpenDatabase(dbpath);
-        wxString sql;
         wxString name(filePrefix);
         name.Replace(wxT("_"), wxT("^_"));
 
-        sql << wxT("delete from FILES where file like '") << name << wxT("%%' ESCAPE '^' ");
-        m_db->ExecuteUpdate(sql);
+        clSqliteQuery query(wxT("delete from FILES where file like "));
+        query.Bind(name + wxT("%")).Append(wxT(" ESCAPE '^' "));
+        m_db->ExecutePreparedUpdate(query);
+
+        clSqliteQuery fingerprintsQuery(wxT("delete from FILE_FINGERPRINTS where file like "));
+        fingerprintsQuery.Bind(name + wxT("%")).Append(wxT(" ESCAPE '^' "));
+        m_db->ExecutePreparedUpdate(fingerprintsQuery);
 
     } catch(wxSQLite3Exception& e) {
         wxUnusedVar(e);
@@ -566,70 +582,64 @@ TagEntry* TagsStorageSQLite::FromSQLite3ResultSet(wxSQLite3ResultSet& rs)
     return entry;
 }
 
-void TagsStorageSQLite::DoFetchTags(const wxString& sql, std::vector<TagEntryPtr>& tags)
+void TagsStorageSQLite::DoFetchTags(const clSqliteQuery& query, std::vector<TagEntryPtr>& tags)
 {
+    wxString key;
     if(GetUseCache()) {
-        clDEBUG1() << "Testing cache for" << sql << clEndl;
-        if(m_cache.Get(sql, tags) == true) {
-            clDEBUG1() << "[CACHED ITEMS]" << sql << clEndl;
+        key = query.GetKey();
+        clDEBUG1() << "Testing cache for" << key << clEndl;
+        if(m_cache.Get(key, tags) == true) {
+            clDEBUG1() << "[CACHED ITEMS]" << key << clEndl;
             return;
         }
     }
 
-    clDEBUG1() << "Entry not found in cache" << sql << clEndl;
+    clDEBUG1() << "Entry not found in cache" << query.GetSql() << clEndl;
     clDEBUG1() << "Fetching from disk..." << clEndl;
-    tags.reserve(500);
+    std::vector<TagEntryPtr> fetched;
+    fetched.reserve(500);
     try {
-        wxSQLite3ResultSet ex_rs;
-        ex_rs = Query(sql);
-
-        // add results from external database to the workspace database
-        while(ex_rs.NextRow()) {
+        m_db->ExecutePreparedQuery(query, [&](wxSQLite3ResultSet& rs) {
             // Construct a TagEntry from the rescord set
-            TagEntryPtr tag(FromSQLite3ResultSet(ex_rs));
-            // conver the path to be real path
-            tags.push_back(tag);
-        }
-        ex_rs.Finalize();
+            fetched.push_back(TagEntryPtr(FromSQLite3ResultSet(rs)));
+            return true;
+        });
     } catch(wxSQLite3Exception& e) {
         clWARNING() << "TagsStorageSQLite::DoFetchTags() error:" << e.GetMessage() << clEndl;
     }
     clDEBUG1() << "Fetching from disk...done" << clEndl;
     if(GetUseCache()) {
         clDEBUG1() << "Updating cache" << clEndl;
-        m_cache.Store(sql, tags);
-        clDEBUG1() << "Updating cache...done (" << tags.size() << "entries)" << clEndl;
+        m_cache.Store(key, fetched);
+        clDEBUG1() << "Updating cache...done (" << fetched.size() << "entries)" << clEndl;
     }
+    tags.insert(tags.end(), fetched.begin(), fetched.end());
 }
 
-void TagsStorageSQLite::DoFetchTags(const wxString& sql, std::vector<TagEntryPtr>& tags, const wxArrayString& kinds)
+void TagsStorageSQLite::DoFetchTags(const clSqliteQuery& query, std::vector<TagEntryPtr>& tags,
+                                    const wxArrayString& kinds)
 {
+    wxString key;
     if(GetUseCache()) {
-        CL_DEBUG1(wxT("Testing cache for: %s"), sql);
-        if(m_cache.Get(sql, kinds, tags) == true) {
-            CL_DEBUG1(wxT("[CACHED ITEMS] %s"), sql);
+        key = query.GetKey();
+        CL_DEBUG1(wxT("Testing cache for: %s"), key);
+        if(m_cache.Get(key, kinds, tags) == true) {
+            CL_DEBUG1(wxT("[CACHED ITEMS] %s"), key);
             return;
         }
     }
 
     CL_DEBUG1("Fetching from disk");
+    std::vector<TagEntryPtr> fetched;
     try {
-        wxSQLite3ResultSet ex_rs;
-        ex_rs = Query(sql);
-
-        // add results from external database to the workspace database
-        while(ex_rs.NextRow()) {
+        m_db->ExecutePreparedQuery(query, [&](wxSQLite3ResultSet& rs) {
             // check if this kind is accepted
-            if(kinds.Index(ex_rs.GetString(4)) != wxNOT_FOUND) {
-
+            if(kinds.Index(rs.GetString(4)) != wxNOT_FOUND) {
                 // Construct a TagEntry from the rescord set
-                TagEntryPtr tag(FromSQLite3ResultSet(ex_rs));
-
-                // conver the path to be real path
-                tags.push_back(tag);
+                fetched.push_back(TagEntryPtr(FromSQLite3ResultSet(rs)));
             }
-        }
-        ex_rs.Finalize();
+            return true;
+        });
 
     } catch(wxSQLite3Exception& e) {
         wxUnusedVar(e);
@@ -637,9 +647,22 @@ void TagsStorageSQLite::DoFetchTags(const wxString& sql, std::vector<TagEntryPtr
     CL_DEBUG1("Fetching from disk...done");
     if(GetUseCache()) {
         CL_DEBUG1("updating cache");
-        m_cache.Store(sql, kinds, tags);
+        m_cache.Store(key, kinds, fetched);
         CL_DEBUG1("updating cache...done");
     }
+    tags.insert(tags.end(), fetched.begin(), fetched.end());
+}
+
+void TagsStorageSQLite::DoFetchStrings(const clSqliteQuery& query, wxArrayString& strings)
+{
+    try {
+        m_db->ExecutePreparedQuery(query, [&](wxSQLite3ResultSet& rs) {
+            strings.Add(rs.GetString(0));
+            return true;
+        });
+    } catch(wxSQLite3Exception& e) {
+        clWARNING() << "TagsStorageSQLite::DoFetchStrings() error:" << e.GetMessage() << clEndl;
+    }
 }
 
 void TagsStorageSQLite::GetTagsByScopeAndName(const wxString& scope, const wxString& name, bool partialNameAllowed,
@@ -647,88 +670,80 @@ void TagsStorageSQLite::GetTagsByScopeAndName(const wxString& scope, const wxStr
 {
     if(name.IsEmpty()) return;
 
-    wxString sql;
-    sql << wxT("select * from tags where ");
+    if(DoPrepareSymbolIndex()) {
+        clTagsSymbolIndex::SymbolPtrVec_t symbols;
+        m_symbolIndex.FindByScopeAndName(scope.IsEmpty() ? wxString(wxT("<global>")) : scope, name,
+                                         partialNameAllowed, m_enableCaseInsensitive, GetSingleSearchLimit(),
+                                         symbols);
+        if(DoFetchTagsBySymbols(symbols, tags)) return;
+    }
+
+    clSqliteQuery query(wxT("select * from tags where "));
 
     // did we get scope?
     if(scope.IsEmpty() || scope == wxT("<global>")) {
-        sql << wxT("ID IN (select tag_id from global_tags where ");
-        DoAddNamePartToQuery(sql, name, partialNameAllowed, false);
-        sql << wxT(" ) ");
+        query.Append(wxT("ID IN (select tag_id from global_tags where "));
+        DoAddNamePartToQuery(query, name, partialNameAllowed, false);
+        query.Append(wxT(" ) "));
 
     } else {
-        sql << " scope = '" << scope << "' ";
-        DoAddNamePartToQuery(sql, name, partialNameAllowed, true);
+        query.Append(wxT(" scope = ")).Bind(scope);
+        DoAddNamePartToQuery(query, name, partialNameAllowed, true);
     }
 
-    sql << wxT(" LIMIT ") << this->GetSingleSearchLimit();
+    query.Append(wxT(" LIMIT ")).Bind(this->GetSingleSearchLimit());
 
     // get get the tags
-    DoFetchTags(sql, tags);
+    DoFetchTags(query, tags);
 }
 
 void TagsStorageSQLite::GetTagsByScope(const wxString& scope, std::vector<TagEntryPtr>& tags)
 {
-    wxString sql;
-
     // Build the SQL statement
-    sql << wxT("select * from tags where scope='") << scope << wxT("' ORDER BY NAME limit ") << GetSingleSearchLimit();
+    clSqliteQuery query(wxT("select * from tags where scope="));
+    query.Bind(scope).Append(wxT(" ORDER BY NAME limit ")).Bind(GetSingleSearchLimit());
 
-    DoFetchTags(sql, tags);
+    DoFetchTags(query, tags);
 }
 
 void TagsStorageSQLite::GetTagsByKind(const wxArrayString& kinds, const wxString& orderingColumn, int order,
                                       std::vector<TagEntryPtr>& tags)
 {
-    wxString sql;
-    sql << wxT("select * from tags where kind in (");
-    for(size_t i = 0; i < kinds.GetCount(); i++) {
-        sql << wxT("'") << kinds.Item(i) << wxT("',");
-    }
-    sql.RemoveLast();
-    sql << wxT(") ");
-
-    if(orderingColumn.IsEmpty() == false) {
-        sql << wxT("order by ") << orderingColumn;
-        switch(order) {
-        case ITagsStorage::OrderAsc:
-            sql << wxT(" ASC");
-            break;
-        case ITagsStorage::OrderDesc:
-            sql << wxT(" DESC");
-            break;
-        case ITagsStorage::OrderNone:
-        default:
-            break;
-        }
-    }
+    if(kinds.IsEmpty()) return;
 
-    DoFetchTags(sql, tags);
+    clSqliteQuery query(wxT("select * from tags where kind in ("));
+    query.BindList(kinds).Append(wxT(") "));
+    DoAddOrderPartToQuery(query, orderingColumn, order);
+    DoFetchTags(query, tags);
 }
 
 void TagsStorageSQLite::GetTagsByPath(const wxArrayString& path, std::vector<TagEntryPtr>& tags)
 {
     if(path.empty()) return;
 
-    wxString sql;
-
-    sql << wxT("select * from tags where path IN(");
-    for(size_t i = 0; i < path.GetCount(); i++) {
-        sql << wxT("'") << path.Item(i) << wxT("',");
+    if(DoPrepareSymbolIndex()) {
+        clTagsSymbolIndex::SymbolPtrVec_t symbols;
+        for(size_t i = 0; i < path.GetCount(); i++) {
+            m_symbolIndex.FindByPath(path.Item(i), 0, symbols);
+        }
+        if(DoFetchTagsBySymbols(symbols, tags)) return;
     }
-    sql.RemoveLast();
-    sql << wxT(")");
-    DoFetchTags(sql, tags);
+
+    clSqliteQuery::ForEachChunk(path, [&](const wxArrayString& chunk) {
+        clSqliteQuery query(wxT("select * from tags where path IN("));
+        query.BindList(chunk).Append(wxT(")"));
+        DoFetchTags(query, tags);
+    });
 }
 
 void TagsStorageSQLite::GetTagsByNameAndParent(const wxString& name, const wxString& parent,
                                                std::vector<TagEntryPtr>& tags)
 {
-    wxString sql;
-    sql << wxT("select * from tags where name='") << name << wxT("' LIMIT ") << GetSingleSearchLimit();
+    clSqliteQuery query(wxT("select * from tags where name="));
+    query.Bind(name).Append(wxT(" LIMIT ")).Bind(GetSingleSearchLimit());
 
     std::vector<TagEntryPtr> tmpResults;
-    DoFetchTags(sql, tmpResults);
+    DoFetchTags(query, tmpResults);
 
     // Filter by parent
     for(size_t i = 0; i < tmpResults.size(); i++) {
@@ -741,25 +756,32 @@ void TagsStorageSQLite::GetTagsByKindAndPath(const wxArrayString& kinds, const w
 {
     if(kinds.empty()) { return; }
 
-    wxString sql;
-    sql << wxT("select * from tags where path='") << path << wxT("' LIMIT ") << GetSingleSearchLimit();
+    if(DoPrepareSymbolIndex()) {
+        clTagsSymbolIndex::SymbolPtrVec_t symbols;
+        m_symbolIndex.FindByPath(path, GetSingleSearchLimit(), symbols);
+        clTagsSymbolIndex::FilterByKind(kinds, symbols);
+        if(DoFetchTagsBySymbols(symbols, tags)) return;
+    }
+
+    clSqliteQuery query(wxT("select * from tags where path="));
+    query.Bind(path).Append(wxT(" LIMIT ")).Bind(GetSingleSearchLimit());
 
-    DoFetchTags(sql, tags, kinds);
+    DoFetchTags(query, tags, kinds);
 }
 
 void TagsStorageSQLite::GetTagsByFileAndLine(const wxString& file, int line, std::vector<TagEntryPtr>& tags)
 {
-    wxString sql;
-    sql << wxT("select * from tags where file='") << file << wxT("' and line=") << line << wxT(" ");
-    DoFetchTags(sql, tags);
+    clSqliteQuery query(wxT("select * from tags where file="));
+    query.Bind(file).Append(wxT(" and line=")).Bind(line);
+    DoFetchTags(query, tags);
 }
 
 TagEntryPtr TagsStorageSQLite::GetTagAboveFileAndLine(const wxString& file, int line)
 {
-    wxString sql;
-    sql << wxT("select * from tags where file='") << file << wxT("' and line<=") << line << wxT(" LIMIT 1");
+    clSqliteQuery query(wxT("select * from tags where file="));
+    query.Bind(file).Append(wxT(" and line<=")).Bind(line).Append(wxT(" LIMIT 1"));
     TagEntryPtrVector_t tags;
-    DoFetchTags(sql, tags);
+    DoFetchTags(query, tags);
     if(!tags.empty()) { return tags.at(0); }
     return NULL;
 }
@@ -769,10 +791,18 @@ void TagsStorageSQLite::GetTagsByScopeAndKind(const wxString& scope, const wxArr
 {
     if(kinds.empty()) { return; }
 
-    wxString sql;
-    sql << wxT("select * from tags where scope='") << scope << wxT("' ");
-    if(applyLimit) { sql << wxT(" LIMIT ") << GetSingleSearchLimit(); }
-    DoFetchTags(sql, tags, kinds);
+    if(DoPrepareSymbolIndex()) {
+        clTagsSymbolIndex::SymbolPtrVec_t symbols;
+        m_symbolIndex.FindByScopeAndName(scope, wxEmptyString, false, false, applyLimit ? GetSingleSearchLimit() : 0,
+                                         symbols);
+        clTagsSymbolIndex::FilterByKind(kinds, symbols);
+        if(DoFetchTagsBySymbols(symbols, tags)) return;
+    }
+
+    clSqliteQuery query(wxT("select * from tags where scope="));
+    query.Bind(scope);
+    if(applyLimit) { query.Append(wxT(" LIMIT ")).Bind(GetSingleSearchLimit()); }
+    DoFetchTags(query, tags, kinds);
 }
 
 void TagsStorageSQLite::GetTagsByKindAndFile(const wxArrayString& kind, const wxString& fileName,
@@ -780,39 +810,24 @@ void TagsStorageSQLite::GetTagsByKindAndFile(const wxArrayString& kind, const wx
 {
     if(kind.empty()) { return; }
 
-    wxString sql;
-    sql << wxT("select * from tags where file='") << fileName << wxT("' and kind in (");
-
-    for(size_t i = 0; i < kind.GetCount(); i++) {
-        sql << wxT("'") << kind.Item(i) << wxT("',");
-    }
-    sql.RemoveLast();
-    sql << wxT(")");
-
-    if(orderingColumn.IsEmpty() == false) {
-        sql << wxT("order by ") << orderingColumn;
-        switch(order) {
-        case ITagsStorage::OrderAsc:
-            sql << wxT(" ASC");
-            break;
-        case ITagsStorage::OrderDesc:
-            sql << wxT(" DESC");
-            break;
-        case ITagsStorage::OrderNone:
-        default:
-            break;
-        }
-    }
-    DoFetchTags(sql, tags);
+    clSqliteQuery query(wxT("select * from tags where file="));
+    query.Bind(fileName).Append(wxT(" and kind in (")).BindList(kind).Append(wxT(") "));
+    DoAddOrderPartToQuery(query, orderingColumn, order);
+    DoFetchTags(query, tags);
 }
 
 int TagsStorageSQLite::DeleteFileEntry(const wxString& filename)
 {
     try {
-        wxSQLite3Statement statement = m_db->GetPrepareStatement(wxT("DELETE FROM FILES WHERE FILE=?"));
+        wxSQLite3Statement& statement = m_db->GetPrepareStatement(wxT("DELETE FROM FILES WHERE FILE=?"));
         statement.Bind(1, filename);
         statement.ExecuteUpdate();
 
+        wxSQLite3Statement& fingerprintStatement =
+            m_db->GetPrepareStatement(wxT("DELETE FROM FILE_FINGERPRINTS WHERE FILE=?"));
+        fingerprintStatement.Bind(1, filename);
+        fingerprintStatement.ExecuteUpdate();
+
     } catch(wxSQLite3Exception& exc) {
         if(exc.ErrorCodeAsString(exc.GetErrorCode()) == wxT("SQLITE_CONSTRAINT")) return TagExist;
         return TagError;
@@ -823,7 +838,7 @@ int TagsStorageSQLite::DeleteFileEntry(const wxString& filename)
 int TagsStorageSQLite::InsertFileEntry(const wxString& filename, int timestamp)
 {
     try {
-        wxSQLite3Statement statement =
+        wxSQLite3Statement& statement =
             m_db->GetPrepareStatement(wxT("INSERT OR REPLACE INTO FILES VALUES(NULL, ?, ?)"));
         statement.Bind(1, filename);
         statement.Bind(2, timestamp);
@@ -838,7 +853,7 @@ int TagsStorageSQLite::InsertFileEntry(const wxString& filename, int timestamp)
 int TagsStorageSQLite::UpdateFileEntry(const wxString& filename, int timestamp)
 {
     try {
-        wxSQLite3Statement statement =
+        wxSQLite3Statement& statement =
             m_db->GetPrepareStatement(wxT("UPDATE OR REPLACE FILES SET last_retagged=? WHERE file=?"));
         statement.Bind(1, timestamp);
         statement.Bind(2, filename);
@@ -850,6 +865,39 @@ int TagsStorageSQLite::UpdateFileEntry(const wxString& filename, int timestamp)
     return TagOk;
 }
 
+void TagsStorageSQLite::GetFileFingerprints(clFileFingerprint::Map_t& fingerprints)
+{
+    try {
+        clSqliteQuery query(wxT("select file, size, mtime, hash from FILE_FINGERPRINTS"));
+        m_db->ExecutePreparedQuery(query, [&](wxSQLite3ResultSet& res) {
+            clFileFingerprint& fingerprint = fingerprints[res.GetString(0)];
+            fingerprint.m_size = res.GetInt64(1).GetValue();
+            fingerprint.m_mtime = res.GetInt64(2).GetValue();
+            fingerprint.m_hash = (wxUint64)res.GetInt64(3).GetValue();
+            return true;
+        });
+
+    } catch(wxSQLite3Exception& e) {
+        clWARNING() << "TagsStorageSQLite::GetFileFingerprints() error:" << e.GetMessage() << clEndl;
+    }
+}
+
+void TagsStorageSQLite::StoreFileFingerprint(const wxString& filename, const clFileFingerprint& fingerprint)
+{
+    try {
+        wxSQLite3Statement& statement =
+            m_db->GetPrepareStatement(wxT("INSERT OR REPLACE INTO FILE_FINGERPRINTS VALUES(?, ?, ?, ?)"));
+        statement.Bind(1, filename);
+        statement.Bind(2, wxLongLong(fingerprint.m_size));
+        statement.Bind(3, wxLongLong(fingerprint.m_mtime));
+        statement.Bind(4, wxLongLong((wxLongLong_t)fingerprint.m_hash));
+        statement.ExecuteUpdate();
+
+    } catch(wxSQLite3Exception& e) {
+        clWARNING() << "TagsStorageSQLite::StoreFileFingerprint() error:" << e.GetMessage() << clEndl;
+    }
+}
+
 int TagsStorageSQLite::DoInsertTagEntry(const TagEntry& tag)
 {
     // If this node is a dummy, (IsOk() == false) we dont insert it to database
@@ -859,7 +907,7 @@ int TagsStorageSQLite::DoInsertTagEntry(const TagEntry& tag)
     if(GetUseCache()) { ClearCache(); }
 
     try {
-        wxSQLite3Statement statement = m_db->GetPrepareStatement(
+        wxSQLite3Statement& statement = m_db->GetPrepareStatement(
             wxT("INSERT OR REPLACE INTO TAGS VALUES (NULL, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"));
         statement.Bind(1, tag.GetName());
         statement.Bind(2, tag.GetFile());
@@ -883,8 +931,6 @@ int TagsStorageSQLite::DoInsertTagEntry(const TagEntry& tag)
 
 bool TagsStorageSQLite::IsTypeAndScopeContainer(wxString& typeName, wxString& scope)
 {
-    wxString sql;
-
     // Break the typename to 'name' and scope
     wxString typeNameNoScope(typeName.AfterLast(wxT(':')));
     wxString scopeOne(typeName.BeforeLast(wxT(':')));
@@ -900,13 +946,46 @@ bool TagsStorageSQLite::IsTypeAndScopeContainer(wxString& typeName, wxString& sc
         combinedScope << scopeOne;
     }
 
-    sql << wxT("select scope,kind from tags where name='") << typeNameNoScope << wxT("'");
-
     bool found_global(false);
 
+    // The parser thread may have added the type after the last sync, so only a match is answered from the index
+    if(DoPrepareSymbolIndex()) {
+        clTagsSymbolIndex::SymbolPtrVec_t symbols;
+        m_symbolIndex.FindByName(typeNameNoScope, 0, symbols);
+        const clTagsSymbolIndex::Symbol* match = NULL;
+        const clTagsSymbolIndex::Symbol* globalMatch = NULL;
+        wxString matchScope;
+        for(size_t i = 0; i < symbols.size() && !match; i++) {
+            wxString scopeFounded(symbols.at(i)->m_scope->c_str(), wxConvUTF8);
+            const std::string& kindFounded = *symbols.at(i)->m_kind;
+
+            bool containerKind = kindFounded == "struct" || kindFounded == "class" || kindFounded == "cenum";
+            if(containerKind && (scopeFounded == combinedScope || scopeFounded == scopeOne)) {
+                match = symbols.at(i);
+                matchScope = scopeFounded;
+
+            } else if(containerKind && !globalMatch && scopeFounded == wxT("<global>")) {
+                globalMatch = symbols.at(i);
+            }
+        }
+
+        if(!match && globalMatch) {
+            match = globalMatch;
+            matchScope = wxT("<global>");
+        }
+        if(match && DoIsSymbolValid(match)) {
+            scope = matchScope;
+            typeName = typeNameNoScope;
+            return true;
+        }
+    }
+
+    clSqliteQuery query(wxT("select scope,kind from tags where name="));
+    query.Bind(typeNameNoScope);
+
+    bool found(false);
     try {
-        wxSQLite3ResultSet rs = Query(sql);
-        while(rs.NextRow()) {
+        m_db->ExecutePreparedQuery(query, [&](wxSQLite3ResultSet& rs) {
             wxString scopeFounded(rs.GetString(0));
             wxString kindFounded(rs.GetString(1));
 
@@ -915,7 +994,7 @@ bool TagsStorageSQLite::IsTypeAndScopeContainer(wxString& typeName, wxString& sc
                 scope = combinedScope;
                 typeName = typeNameNoScope;
                 // we got an exact match
-                return true;
+                found = true;
 
             } else if(scopeFounded == scopeOne && containerKind) {
                 // this is equal to cases like this:
@@ -928,17 +1007,20 @@ bool TagsStorageSQLite::IsTypeAndScopeContainer(wxString& typeName, wxString& sc
                 scope = scopeOne;
                 typeName = typeNameNoScope;
                 // we got an exact match
-                return true;
+                found = true;
 
             } else if(containerKind && scopeFounded == wxT("<global>")) {
                 found_global = true;
             }
-        }
+            return !found;
+        });
 
     } catch(wxSQLite3Exception& e) {
         wxUnusedVar(e);
     }
 
+    if(found) { return true; }
+
     // if we reached here, it means we did not find any exact match
     if(found_global) {
         scope = wxT("<global>");
@@ -951,7 +1033,6 @@ bool TagsStorageSQLite::IsTypeAndScopeContainer(wxString& typeName, wxString& sc
 
 bool TagsStorageSQLite::IsTypeAndScopeExist(wxString& typeName, wxString& scope)
 {
-    wxString sql;
     wxString strippedName;
     wxString secondScope;
     wxString bestScope;
@@ -965,8 +1046,8 @@ bool TagsStorageSQLite::IsTypeAndScopeExist(wxString& typeName, wxString& scope)
 
     if(strippedName.IsEmpty()) return false;
 
-    sql << wxT("select scope,parent from tags where name='") << strippedName
-        << wxT("' and kind in ('class', 'struct', 'typedef') LIMIT 50");
+    clSqliteQuery query(wxT("select scope,parent from tags where name="));
+    query.Bind(strippedName).Append(wxT(" and kind in ('class', 'struct', 'typedef') LIMIT 50"));
     int foundOther(0);
     wxString scopeFounded;
     wxString parentFounded;
@@ -975,18 +1056,16 @@ bool TagsStorageSQLite::IsTypeAndScopeExist(wxString& typeName, wxString& scope)
 
     parent = tmpScope.AfterLast(wxT(':'));
 
+    bool found(false);
     try {
-        wxSQLite3ResultSet rs = Query(sql);
-        while(rs.NextRow()) {
-
+        m_db->ExecutePreparedQuery(query, [&](wxSQLite3ResultSet& rs) {
             scopeFounded = rs.GetString(0);
             parentFounded = rs.GetString(1);
 
             if(scopeFounded == tmpScope) {
                 // exact match
-                scope = scopeFounded;
-                typeName = strippedName;
-                return true;
+                found = true;
+                return false;
 
             } else if(parentFounded == parent) {
                 bestScope = scopeFounded;
@@ -994,12 +1073,19 @@ bool TagsStorageSQLite::IsTypeAndScopeExist(wxString& typeName, wxString& scope)
             } else {
                 foundOther++;
             }
-        }
+            return true;
+        });
 
     } catch(wxSQLite3Exception& e) {
         wxUnusedVar(e);
     }
 
+    if(found) {
+        scope = scopeFounded;
+        typeName = strippedName;
+        return true;
+    }
+
     // if we reached here, it means we did not find any exact match
     if(bestScope.IsEmpty() == false) {
         scope = bestScope;
@@ -1016,85 +1102,41 @@ bool TagsStorageSQLite::IsTypeAndScopeExist(wxString& typeName, wxString& scope)
 
 void TagsStorageSQLite::GetScopesFromFileAsc(const wxFileName& fileName, std::vector<wxString>& scopes)
 {
-    wxString sql;
-    sql << wxT("select distinct scope from tags where file = '") << fileName.GetFullPath() << wxT("' ")
-        << wxT(" and kind in('prototype', 'function', 'enum')") << wxT(" order by scope ASC");
+    clSqliteQuery query(wxT("select distinct scope from tags where file = "));
+    query.Bind(fileName.GetFullPath())
+        .Append(wxT(" and kind in('prototype', 'function', 'enum')"))
+        .Append(wxT(" order by scope ASC"));
 
-    // we take the first entry
-    try {
-        wxSQLite3ResultSet rs = Query(sql);
-        while(rs.NextRow()) {
-            scopes.push_back(rs.GetString(0));
-        }
-        rs.Finalize();
-    } catch(wxSQLite3Exception& e) {
-        wxUnusedVar(e);
-    }
+    wxArrayString arr;
+    DoFetchStrings(query, arr);
+    scopes.insert(scopes.end(), arr.begin(), arr.end());
 }
 
 void TagsStorageSQLite::GetTagsByFileScopeAndKind(const wxFileName& fileName, const wxString& scopeName,
                                                   const wxArrayString& kind, std::vector<TagEntryPtr>& tags)
 {
-    wxString sql;
-    sql << wxT("select * from tags where file = '") << fileName.GetFullPath() << wxT("' ") << wxT(" and scope='")
-        << scopeName << wxT("' ");
+    clSqliteQuery query(wxT("select * from tags where file = "));
+    query.Bind(fileName.GetFullPath()).Append(wxT(" and scope=")).Bind(scopeName);
 
-    if(kind.IsEmpty() == false) {
-        sql << wxT(" and kind in(");
-        for(size_t i = 0; i < kind.GetCount(); i++) {
-            sql << wxT("'") << kind.Item(i) << wxT("',");
-        }
-        sql.RemoveLast();
-        sql << wxT(")");
-    }
+    if(kind.IsEmpty() == false) { query.Append(wxT(" and kind in(")).BindList(kind).Append(wxT(")")); }
 
-    DoFetchTags(sql, tags);
+    DoFetchTags(query, tags);
 }
 
 void TagsStorageSQLite::GetAllTagsNames(wxArrayString& names)
 {
-    try {
-
-        wxString query(wxT("SELECT distinct name FROM tags order by name ASC LIMIT "));
-        query << GetMaxWorkspaceTagToColour();
-
-        wxSQLite3ResultSet res = Query(query);
-        while(res.NextRow()) {
-            // add unique strings only
-            names.Add(res.GetString(0));
-        }
-
-    } catch(wxSQLite3Exception& e) {
-        wxUnusedVar(e);
-    }
+    clSqliteQuery query(wxT("SELECT distinct name FROM tags order by name ASC LIMIT "));
+    query.Bind(GetMaxWorkspaceTagToColour());
+    DoFetchStrings(query, names);
 }
 
 void TagsStorageSQLite::GetTagsNames(const wxArrayString& kind, wxArrayString& names)
 {
     if(kind.IsEmpty()) return;
-    try {
-
-        wxString whereClause;
-        whereClause << wxT(" kind IN (");
-        for(size_t i = 0; i < kind.GetCount(); i++) {
-            whereClause << wxT("'") << kind.Item(i) << wxT("',");
-        }
-
-        whereClause = whereClause.BeforeLast(wxT(','));
-        whereClause << wxT(") ");
 
-        wxString query(wxT("SELECT distinct name FROM tags WHERE "));
-        query << whereClause << wxT(" order by name ASC LIMIT ") << GetMaxWorkspaceTagToColour();
-
-        wxSQLite3ResultSet res = Query(query);
-        while(res.NextRow()) {
-            // add unique strings only
-            names.Add(res.GetString(0));
-        }
-
-    } catch(wxSQLite3Exception& e) {
-        wxUnusedVar(e);
-    }
+    clSqliteQuery query(wxT("SELECT distinct name FROM tags WHERE kind IN ("));
+    query.BindList(kind).Append(wxT(") order by name ASC LIMIT ")).Bind(GetMaxWorkspaceTagToColour());
+    DoFetchStrings(query, names);
 }
 
 void TagsStorageSQLite::GetTagsByScopesAndKind(const wxArrayString& scopes, const wxArrayString& kinds,
@@ -1102,15 +1144,10 @@ void TagsStorageSQLite::GetTagsByScopesAndKind(const wxArrayString& scopes, cons
 {
     if(kinds.empty() || scopes.empty()) { return; }
 
-    wxString sql;
-    sql << wxT("select * from tags where scope in (");
-    for(size_t i = 0; i < scopes.GetCount(); i++) {
-        sql << wxT("'") << scopes.Item(i) << wxT("',");
-    }
-    sql.RemoveLast();
-    sql << wxT(") ORDER BY NAME ");
-    DoAddLimitPartToQuery(sql, tags);
-    DoFetchTags(sql, tags, kinds);
+    clSqliteQuery query(wxT("select * from tags where scope in ("));
+    query.BindList(scopes).Append(wxT(") ORDER BY NAME "));
+    DoAddLimitPartToQuery(query, tags);
+    DoFetchTags(query, tags, kinds);
 }
 
 void TagsStorageSQLite::GetTagsByScopesAndKindNoLimit(const wxArrayString& scopes, const wxArrayString& kinds,
@@ -1118,15 +1155,9 @@ void TagsStorageSQLite::GetTagsByScopesAndKindNoLimit(const wxArrayString& scope
 {
     if(kinds.empty() || scopes.empty()) { return; }
 
-    wxString sql;
-    sql << wxT("select * from tags where scope in (");
-    for(size_t i = 0; i < scopes.GetCount(); i++) {
-        sql << wxT("'") << scopes.Item(i) << wxT("',");
-    }
-    sql.RemoveLast();
-    sql << wxT(") ORDER BY NAME");
-
-    DoFetchTags(sql, tags, kinds);
+    clSqliteQuery query(wxT("select * from tags where scope in ("));
+    query.BindList(scopes).Append(wxT(") ORDER BY NAME"));
+    DoFetchTags(query, tags, kinds);
 }
 
 void TagsStorageSQLite::GetTagsByTyperefAndKind(const wxArrayString& typerefs, const wxArrayString& kinds,
@@ -1134,24 +1165,25 @@ void TagsStorageSQLite::GetTagsByTyperefAndKind(const wxArrayString& typerefs, c
 {
     if(kinds.empty() || typerefs.empty()) { return; }
 
-    wxString sql;
-    sql << wxT("select * from tags where typeref in (");
-    for(size_t i = 0; i < typerefs.GetCount(); i++) {
-        sql << wxT("'") << typerefs.Item(i) << wxT("',");
-    }
-    sql.RemoveLast();
-    sql << wxT(") ORDER BY NAME ");
-    DoAddLimitPartToQuery(sql, tags);
-    DoFetchTags(sql, tags, kinds);
+    clSqliteQuery query(wxT("select * from tags where typeref in ("));
+    query.BindList(typerefs).Append(wxT(") ORDER BY NAME "));
+    DoAddLimitPartToQuery(query, tags);
+    DoFetchTags(query, tags, kinds);
 }
 
 void TagsStorageSQLite::GetTagsByPath(const wxString& path, std::vector<TagEntryPtr>& tags, int limit)
 {
     if(path.empty()) return;
 
-    wxString sql;
-    sql << wxT("select * from tags where path ='") << path << wxT("' LIMIT ") << limit;
-    DoFetchTags(sql, tags);
+    if(limit > 0 && DoPrepareSymbolIndex()) {
+        clTagsSymbolIndex::SymbolPtrVec_t symbols;
+        m_symbolIndex.FindByPath(path, limit, symbols);
+        if(DoFetchTagsBySymbols(symbols, tags)) return;
+    }
+
+    clSqliteQuery query(wxT("select * from tags where path ="));
+    query.Bind(path).Append(wxT(" LIMIT ")).Bind(limit);
+    DoFetchTags(query, tags);
 }
 
 void TagsStorageSQLite::GetTagsByScopeAndName(const wxArrayString& scope, const wxString& name, bool partialNameAllowed,
@@ -1171,43 +1203,44 @@ void TagsStorageSQLite::GetTagsByScopeAndName(const wxArrayString& scope, const
         GetTagsByScopeAndName(wxString(wxT("<global>")), name, partialNameAllowed, tags);
     }
 
-    if(scopes.IsEmpty() == false) {
-        wxString sql;
-        sql << wxT("select * from tags where scope in(");
-
-        for(size_t i = 0; i < scopes.GetCount(); i++) {
-            sql << wxT("'") << scopes.Item(i) << wxT("',");
+    if(scopes.IsEmpty() == false && DoPrepareSymbolIndex()) {
+        // Same limit as DoAddLimitPartToQuery()
+        size_t limit = (tags.size() >= (size_t)GetSingleSearchLimit()) ? 1 : (GetSingleSearchLimit() - tags.size());
+        clTagsSymbolIndex::SymbolPtrVec_t symbols;
+        for(size_t i = 0; i < scopes.GetCount() && symbols.size() < limit; i++) {
+            m_symbolIndex.FindByScopeAndName(scopes.Item(i), name, partialNameAllowed, m_enableCaseInsensitive,
+                                             limit - symbols.size(), symbols);
         }
-        sql.RemoveLast();
-        sql << wxT(") ");
+        if(DoFetchTagsBySymbols(symbols, tags)) return;
+    }
+
+    if(scopes.IsEmpty() == false) {
+        clSqliteQuery query(wxT("select * from tags where scope in("));
+        query.BindList(scopes).Append(wxT(") "));
 
-        DoAddNamePartToQuery(sql, name, partialNameAllowed, true);
-        DoAddLimitPartToQuery(sql, tags);
+        DoAddNamePartToQuery(query, name, partialNameAllowed, true);
+        DoAddLimitPartToQuery(query, tags);
         // get get the tags
-        DoFetchTags(sql, tags);
+        DoFetchTags(query, tags);
     }
 }
 
 void TagsStorageSQLite::GetGlobalFunctions(std::vector<TagEntryPtr>& tags)
 {
-    wxString sql;
-    sql << wxT("select * from tags where scope = '<global>' AND kind IN ('function', 'prototype')");
-    DoAddLimitPartToQuery(sql, tags);
-    DoFetchTags(sql, tags);
+    clSqliteQuery query(wxT("select * from tags where scope = '<global>' AND kind IN ('function', 'prototype')"));
+    DoAddLimitPartToQuery(query, tags);
+    DoFetchTags(query, tags);
 }
 
 void TagsStorageSQLite::GetTagsByFiles(const wxArrayString& files, std::vector<TagEntryPtr>& tags)
 {
     if(files.IsEmpty()) return;
 
-    wxString sql;
-    sql << wxT("select * from tags where file in (");
-    for(size_t i = 0; i < files.GetCount(); i++) {
-        sql << wxT("'") << files.Item(i) << wxT("',");
-    }
-    sql.RemoveLast();
-    sql << wxT(")");
-    DoFetchTags(sql, tags);
+    clSqliteQuery::ForEachChunk(files, [&](const wxArrayString& chunk) {
+        clSqliteQuery query(wxT("select * from tags where file in ("));
+        query.BindList(chunk).Append(wxT(")"));
+        DoFetchTags(query, tags);
+    });
 }
 
 void TagsStorageSQLite::GetTagsByFilesAndScope(const wxArrayString& files, const wxString& scope,
@@ -1215,16 +1248,13 @@ void TagsStorageSQLite::GetTagsByFilesAndScope(const wxArrayString& files, const
 {
     if(files.IsEmpty()) return;
 
-    wxString sql;
-    sql << wxT("select * from tags where file in (");
-    for(size_t i = 0; i < files.GetCount(); i++) {
-        sql << wxT("'") << files.Item(i) << wxT("',");
-    }
-    sql.RemoveLast();
-    sql << wxT(")");
+    clSqliteQuery::ForEachChunk(files, [&](const wxArrayString& chunk) {
+        clSqliteQuery query(wxT("select * from tags where file in ("));
+        query.BindList(chunk).Append(wxT(")"));
 
-    sql << wxT(" AND scope='") << scope << wxT("'");
-    DoFetchTags(sql, tags);
+        query.Append(wxT(" AND scope=")).Bind(scope);
+        DoFetchTags(query, tags);
+    });
 }
 
 void TagsStorageSQLite::GetTagsByFilesKindAndScope(const wxArrayString& files, const wxArrayString& kinds,
@@ -1232,16 +1262,13 @@ void TagsStorageSQLite::GetTagsByFilesKindAndScope(const wxArrayString& files, c
 {
     if(files.IsEmpty()) return;
 
-    wxString sql;
-    sql << wxT("select * from tags where file in (");
-    for(size_t i = 0; i < files.GetCount(); i++) {
-        sql << wxT("'") << files.Item(i) << wxT("',");
-    }
-    sql.RemoveLast();
-    sql << wxT(")");
+    clSqliteQuery::ForEachChunk(files, [&](const wxArrayString& chunk) {
+        clSqliteQuery query(wxT("select * from tags where file in ("));
+        query.BindList(chunk).Append(wxT(")"));
 
-    sql << wxT(" AND scope='") << scope << wxT("'");
-    DoFetchTags(sql, tags, kinds);
+        query.Append(wxT(" AND scope=")).Bind(scope);
+        DoFetchTags(query, tags, kinds);
+    });
 }
 
 void TagsStorageSQLite::GetTagsByFilesScopeTyperefAndKind(const wxArrayString& files, const wxArrayString& kinds,
@@ -1250,84 +1277,319 @@ void TagsStorageSQLite::GetTagsByFilesScopeTyperefAndKind(const wxArrayString& f
 {
     if(files.IsEmpty()) return;
 
-    wxString sql;
-    sql << wxT("select * from tags where file in (");
-    for(size_t i = 0; i < files.GetCount(); i++) {
-        sql << wxT("'") << files.Item(i) << wxT("',");
-    }
-    sql.RemoveLast();
-    sql << wxT(")");
+    clSqliteQuery::ForEachChunk(files, [&](const wxArrayString& chunk) {
+        clSqliteQuery query(wxT("select * from tags where file in ("));
+        query.BindList(chunk).Append(wxT(")"));
 
-    sql << wxT(" AND scope='") << scope << wxT("'");
-    sql << wxT(" AND typeref='") << typeref << wxT("'");
-    DoFetchTags(sql, tags, kinds);
+        query.Append(wxT(" AND scope=")).Bind(scope);
+        query.Append(wxT(" AND typeref=")).Bind(typeref);
+        DoFetchTags(query, tags, kinds);
+    });
 }
 
 void TagsStorageSQLite::GetTagsByKindLimit(const wxArrayString& kinds, const wxString& orderingColumn, int order,
                                            int limit, const wxString& partName, std::vector<TagEntryPtr>& tags)
 {
-    wxString sql;
-    sql << wxT("select * from tags where kind in (");
-    for(size_t i = 0; i < kinds.GetCount(); i++) {
-        sql << wxT("'") << kinds.Item(i) << wxT("',");
-    }
-    sql.RemoveLast();
-    sql << wxT(") ");
-
-    if(orderingColumn.IsEmpty() == false) {
-        sql << wxT("order by ") << orderingColumn;
-        switch(order) {
-        case ITagsStorage::OrderAsc:
-            sql << wxT(" ASC");
-            break;
-        case ITagsStorage::OrderDesc:
-            sql << wxT(" DESC");
-            break;
-        case ITagsStorage::OrderNone:
-        default:
-            break;
-        }
-    }
+    if(kinds.IsEmpty()) return;
+
+    clSqliteQuery query(wxT("select * from tags where kind in ("));
+    query.BindList(kinds).Append(wxT(") "));
 
-    DoAddNamePartToQuery(sql, partName, true, true);
-    if(limit > 0) { sql << wxT(" LIMIT ") << limit; }
+    // the name condition must come before the 'order by' clause
+    DoAddNamePartToQuery(query, partName, true, true);
+    DoAddOrderPartToQuery(query, orderingColumn, order);
+    if(limit > 0) { query.Append(wxT(" LIMIT ")).Bind(limit); }
 
-    DoFetchTags(sql, tags);
+    DoFetchTags(query, tags);
 }
 bool TagsStorageSQLite::IsTypeAndScopeExistLimitOne(const wxString& typeName, const wxString& scope)
 {
-    wxString sql;
     wxString path;
 
     // Build the path
     if(scope.IsEmpty() == false && scope != wxT("<global>")) path << scope << wxT("::");
 
     path << typeName;
-    sql << wxT("select ID from tags where path='") << path
-        << wxT("' and kind in ('class', 'struct', 'typedef') LIMIT 1");
 
+    // Only a match is answered from the index, see IsTypeAndScopeContainer()
+    if(DoPrepareSymbolIndex()) {
+        clTagsSymbolIndex::SymbolPtrVec_t symbols;
+        m_symbolIndex.FindByPath(path, 0, symbols);
+        for(size_t i = 0; i < symbols.size(); i++) {
+            const std::string& kind = *symbols.at(i)->m_kind;
+            if(kind == "class" || kind == "struct" || kind == "typedef") {
+                if(DoIsSymbolValid(symbols.at(i))) { return true; }
+                break;
+            }
+        }
+    }
+
+    clSqliteQuery query(wxT("select ID from tags where path="));
+    query.Bind(path).Append(wxT(" and kind in ('class', 'struct', 'typedef') LIMIT 1"));
+
+    bool found(false);
     try {
-        wxSQLite3ResultSet rs = Query(sql);
-        if(rs.NextRow()) { return true; }
+        m_db->ExecutePreparedQuery(query, [&](wxSQLite3ResultSet& rs) {
+            found = true;
+            return false;
+        });
 
     } catch(wxSQLite3Exception& e) {
         wxUnusedVar(e);
     }
-    return false;
+    return found;
 }
 
 void TagsStorageSQLite::GetDereferenceOperator(const wxString& scope, std::vector<TagEntryPtr>& tags)
 {
-    wxString sql;
-    sql << wxT("select * from tags where scope ='") << scope << wxT("' and name like 'operator%->%' LIMIT 1");
-    DoFetchTags(sql, tags);
+    clSqliteQuery query(wxT("select * from tags where scope ="));
+    query.Bind(scope).Append(wxT(" and name like 'operator%->%' LIMIT 1"));
+    DoFetchTags(query, tags);
 }
 
 void TagsStorageSQLite::GetSubscriptOperator(const wxString& scope, std::vector<TagEntryPtr>& tags)
 {
-    wxString sql;
-    sql << wxT("select * from tags where scope ='") << scope << wxT("' and name like 'operator%[%]%' LIMIT 1");
-    DoFetchTags(sql, tags);
+    clSqliteQuery query(wxT("select * from tags where scope ="));
+    query.Bind(scope).Append(wxT(" and name like 'operator%[%]%' LIMIT 1"));
+    DoFetchTags(query, tags);
+}
+
+//---------------------------------------------------------------------
+//-----------------------------clSqliteQuery --------------------------
+//---------------------------------------------------------------------
+
+clSqliteQuery& clSqliteQuery::Bind(const wxString& value)
+{
+    Arg arg;
+    arg.m_isInt = false;
+    arg.m_int = 0;
+    arg.m_str = value;
+    m_args.push_back(arg);
+    m_sql << wxT("?");
+    return *this;
+}
+
+clSqliteQuery& clSqliteQuery::Bind(long value)
+{
+    Arg arg;
+    arg.m_isInt = true;
+    arg.m_int = value;
+    m_args.push_back(arg);
+    m_sql << wxT("?");
+    return *this;
+}
+
+// Pad the lists to a power of 2, so every query has only a few shapes to prepare and cache
+static size_t GetBindListSize(size_t count)
+{
+    if(count > SQLITE_MAX_LIST_SIZE) {
+        clWARNING() << "clSqliteQuery: a list of" << count << "values is truncated to" << SQLITE_MAX_LIST_SIZE
+                    << "values" << clEndl;
+        return SQLITE_MAX_LIST_SIZE;
+    }
+
+    size_t size = 1;
+    while(size < count) {
+        size <<= 1;
+    }
+    return std::min(size, (size_t)SQLITE_MAX_LIST_SIZE);
+}
+
+clSqliteQuery& clSqliteQuery::BindList(const wxArrayString& values)
+{
+    if(values.IsEmpty()) { return *this; }
+
+    size_t size = GetBindListSize(values.GetCount());
+    for(size_t i = 0; i < size; ++i) {
+        if(i) { m_sql << wxT(","); }
+        Bind(values.Item(std::min(i, values.GetCount() - 1)));
+    }
+    return *this;
+}
+
+clSqliteQuery& clSqliteQuery::BindList(const std::vector<long>& values)
+{
+    if(values.empty()) { return *this; }
+
+    size_t size = GetBindListSize(values.size());
+    for(size_t i = 0; i < size; ++i) {
+        if(i) { m_sql << wxT(","); }
+        Bind(values.at(std::min(i, values.size() - 1)));
+    }
+    return *this;
+}
+
+void clSqliteQuery::ForEachChunk(const wxArrayString& values, const std::function<void(const wxArrayString&)>& func,
+                                 size_t chunkSize)
+{
+    chunkSize = std::max((size_t)1, std::min(chunkSize, (size_t)SQLITE_MAX_LIST_SIZE));
+    for(size_t first = 0; first < values.GetCount(); first += chunkSize) {
+        size_t last = std::min(first + chunkSize, values.GetCount());
+        wxArrayString chunk;
+        chunk.reserve(last - first);
+        for(size_t i = first; i < last; ++i) {
+            chunk.Add(values.Item(i));
+        }
+        func(chunk);
+    }
+}
+
+void clSqliteQuery::ForEachChunk(const std::vector<long>& values,
+                                 const std::function<void(const std::vector<long>&)>& func, size_t chunkSize)
+{
+    chunkSize = std::max((size_t)1, std::min(chunkSize, (size_t)SQLITE_MAX_LIST_SIZE));
+    for(size_t first = 0; first < values.size(); first += chunkSize) {
+        size_t last = std::min(first + chunkSize, values.size());
+        func(std::vector<long>(values.begin() + first, values.begin() + last));
+    }
+}
+
+wxString clSqliteQuery::GetKey() const
+{
+    wxString key = m_sql;
+    for(size_t i = 0; i < m_args.size(); ++i) {
+        key << wxT('\x01');
+        if(m_args.at(i).m_isInt) {
+            key << m_args.at(i).m_int;
+        } else {
+            key << m_args.at(i).m_str;
+        }
+    }
+    return key;
+}
+
+void clSqliteQuery::BindTo(wxSQLite3Statement& statement) const
+{
+    for(size_t i = 0; i < m_args.size(); ++i) {
+        if(m_args.at(i).m_isInt) {
+            statement.Bind(i + 1, wxLongLong(m_args.at(i).m_int));
+        } else {
+            statement.Bind(i + 1, m_args.at(i).m_str);
+        }
+    }
+}
+
+//---------------------------------------------------------------------
+//-----------------------------clSqliteDB -----------------------------
+//---------------------------------------------------------------------
+
+// Queries that take longer than this (in milliseconds) are always logged
+#define SQLITE_SLOW_QUERY_TIME 50
+
+clSqliteDB::~clSqliteDB() { Close(); }
+
+void clSqliteDB::Close()
+{
+    LogStats();
+
+    // The statements must be finalized before the database is closed
+    m_statements.clear();
+    m_stats.clear();
+    if(IsOpen()) wxSQLite3Database::Close();
+}
+
+wxSQLite3Statement& clSqliteDB::GetPrepareStatement(const wxString& sql)
+{
+    std::unordered_map<wxString, wxSQLite3Statement>::iterator iter = m_statements.find(sql);
+    if(iter == m_statements.end()) {
+        wxSQLite3Statement statement = PrepareStatement(sql);
+        iter = m_statements.insert(std::make_pair(sql, wxSQLite3Statement())).first;
+        iter->second = statement;
+
+    } else {
+        try {
+            iter->second.Reset();
+        } catch(wxSQLite3Exception& e) {
+            // the error belongs to the previous run of the statement, it can be used again
+            wxUnusedVar(e);
+        }
+    }
+    return iter->second;
+}
+
+void clSqliteDB::ExecutePreparedQuery(const clSqliteQuery& query,
+                                      const std::function<bool(wxSQLite3ResultSet&)>& onRow)
+{
+    wxStopWatch sw;
+    wxSQLite3Statement& statement = GetPrepareStatement(query.GetSql());
+    try {
+        query.BindTo(statement);
+        wxSQLite3ResultSet res = statement.ExecuteQuery();
+        while(res.NextRow()) {
+            if(!onRow(res)) break;
+        }
+        statement.Reset();
+
+    } catch(wxSQLite3Exception&) {
+        try {
+            statement.Reset();
+        } catch(wxSQLite3Exception& resetError) {
+            // don't keep a statement in an unknown state
+            wxUnusedVar(resetError);
+            m_statements.erase(query.GetSql());
+        }
+        DoUpdateStats(query.GetSql(), sw.Time());
+        throw;
+    }
+    DoUpdateStats(query.GetSql(), sw.Time());
+}
+
+int clSqliteDB::ExecutePreparedUpdate(const clSqliteQuery& query)
+{
+    wxStopWatch sw;
+    wxSQLite3Statement& statement = GetPrepareStatement(query.GetSql());
+    int rowsChanged = 0;
+    try {
+        query.BindTo(statement);
+        // ExecuteUpdate() resets the statement
+        rowsChanged = statement.ExecuteUpdate();
+
+    } catch(wxSQLite3Exception&) {
+        DoUpdateStats(query.GetSql(), sw.Time());
+        throw;
+    }
+    DoUpdateStats(query.GetSql(), sw.Time());
+    return rowsChanged;
+}
+
+void clSqliteDB::DoUpdateStats(const wxString& sql, long elapsed)
+{
+    std::unordered_map<wxString, QueryStats>::iterator iter = m_stats.find(sql);
+    if(iter == m_stats.end()) {
+        QueryStats stats;
+        stats.m_count = 0;
+        stats.m_totalTime = 0;
+        stats.m_maxTime = 0;
+        iter = m_stats.insert(std::make_pair(sql, stats)).first;
+    }
+    QueryStats& stats = iter->second;
+    ++stats.m_count;
+    stats.m_totalTime += elapsed;
+    stats.m_maxTime = std::max(stats.m_maxTime, elapsed);
+
+    if(elapsed >= SQLITE_SLOW_QUERY_TIME) {
+        clDEBUG() << "Slow query (" << elapsed << "ms):" << sql << clEndl;
+    } else {
+        clDEBUG1() << "Query (" << elapsed << "ms):" << sql << clEndl;
+    }
+}
+
+void clSqliteDB::LogStats()
+{
+    if(m_stats.empty()) return;
+
+    std::vector<std::pair<wxString, QueryStats> > stats(m_stats.begin(), m_stats.end());
+    std::sort(stats.begin(), stats.end(),
+              [](const std::pair<wxString, QueryStats>& a, const std::pair<wxString, QueryStats>& b) {
+                  return a.second.m_totalTime > b.second.m_totalTime;
+              });
+
+    clDEBUG() << "Tags database queries statistics:" << clEndl;
+    for(size_t i = 0; i < stats.size(); ++i) {
+        const QueryStats& queryStats = stats.at(i).second;
+        clDEBUG() << "  count:" << queryStats.m_count << "total:" << queryStats.m_totalTime
+                  << "ms max:" << queryStats.m_maxTime << "ms sql:" << stats.at(i).first << clEndl;
+    }
 }
 
 //---------------------------------------------------------------------
@@ -1386,21 +1648,109 @@ void TagsStorageSQLiteCache::DoStore(const wxString& key, const std::vector<TagE
     m_cache[key] = tags;
 }
 
-void TagsStorageSQLite::ClearCache() { m_cache.Clear(); }
+void TagsStorageSQLite::ClearCache()
+{
+    m_cache.Clear();
+
+    // The database was modified, check it for modified files on the next lookup
+    m_symbolIndex.MarkDirty();
+}
 
 void TagsStorageSQLite::SetUseCache(bool useCache) { ITagsStorage::SetUseCache(useCache); }
 
+void TagsStorageSQLite::SetUseSymbolIndex(bool useSymbolIndex)
+{
+    ITagsStorage::SetUseSymbolIndex(useSymbolIndex);
+    if(!useSymbolIndex) { m_symbolIndex.Clear(); }
+}
+
+bool TagsStorageSQLite::DoPrepareSymbolIndex()
+{
+    if(!GetUseSymbolIndex() || !IsOpen()) return false;
+
+    // The parser thread writes to the database through its own connection, so we can't rely on being told
+    wxString version = DoGetDatabaseVersion();
+    if(version != m_symbolIndexVersion) {
+        m_symbolIndexVersion = version;
+        m_symbolIndex.MarkDirty();
+    }
+    return m_symbolIndex.Sync(m_db);
+}
+
+wxString TagsStorageSQLite::DoGetDatabaseVersion()
+{
+    // The journal is off, so every commit writes to the database file
+    wxString version;
+    wxDateTime modified;
+    if(m_fileName.GetTimes(NULL, &modified, NULL)) { version << modified.GetValue().ToString(); }
+    version << wxT(":") << m_fileName.GetSize().ToString();
+    try {
+        // Changes of this connection that are not committed yet
+        version << wxT(":") << m_db->ExecuteScalar(wxT("select total_changes()"));
+    } catch(wxSQLite3Exception& e) {
+        wxUnusedVar(e);
+    }
+    return version;
+}
+
+bool TagsStorageSQLite::DoIsSymbolValid(const clTagsSymbolIndex::Symbol* symbol)
+{
+    bool found(false);
+    try {
+        clSqliteQuery query(wxT("select ID from tags where ID="));
+        query.Bind(symbol->m_id);
+        m_db->ExecutePreparedQuery(query, [&](wxSQLite3ResultSet& rs) {
+            found = true;
+            return false;
+        });
+    } catch(wxSQLite3Exception& e) {
+        wxUnusedVar(e);
+    }
+
+    if(!found) { m_symbolIndex.MarkOutOfDate(); }
+    return found;
+}
+
+bool TagsStorageSQLite::DoFetchTagsBySymbols(const clTagsSymbolIndex::SymbolPtrVec_t& symbols,
+                                             std::vector<TagEntryPtr>& tags)
+{
+    if(symbols.empty()) return true;
+
+    std::vector<long> ids;
+    ids.reserve(symbols.size());
+    for(size_t i = 0; i < symbols.size(); i++) {
+        ids.push_back(symbols.at(i)->m_id);
+    }
+    // A symbol can be found more than once (e.g. the same path was requested twice), its tag is fetched once
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    size_t count = tags.size();
+    clSqliteQuery::ForEachChunk(ids, [&](const std::vector<long>& chunk) {
+        clSqliteQuery query(wxT("select * from tags where ID IN("));
+        query.BindList(chunk).Append(wxT(")"));
+        DoFetchTags(query, tags);
+    });
+    if((tags.size() - count) != ids.size()) {
+        // The database was modified behind our back (e.g. by the parser thread)
+        clDEBUG1() << "Symbol index is out of date, falling back to SQL" << clEndl;
+        tags.erase(tags.begin() + count, tags.end());
+        m_symbolIndex.MarkOutOfDate();
+        return false;
+    }
+    return true;
+}
+
 PPToken TagsStorageSQLite::GetMacro(const wxString& name)
 {
     PPToken token;
     try {
-        wxString sql;
-        sql << wxT("select * from MACROS where name = '") << name << wxT("'");
-        wxSQLite3ResultSet res = m_db->ExecuteQuery(sql);
-        if(res.NextRow()) {
+        clSqliteQuery query(wxT("select * from MACROS where name = "));
+        query.Bind(name);
+        m_db->ExecutePreparedQuery(query, [&](wxSQLite3ResultSet& res) {
             PPTokenFromSQlite3ResultSet(res, token);
-            return token;
-        }
+            return false;
+        });
     } catch(wxSQLite3Exception& exc) {
         wxUnusedVar(exc);
     }
@@ -1411,9 +1761,9 @@ PPToken TagsStorageSQLite::GetMacro(const wxString& name)
 void TagsStorageSQLite::StoreMacros(const std::map<wxString, PPToken>& table)
 {
     try {
-        wxSQLite3Statement stmntCC =
+        wxSQLite3Statement& stmntCC =
             m_db->GetPrepareStatement(wxT("insert or replace into MACROS values(NULL, ?, ?, ?, ?, ?, ?)"));
-        wxSQLite3Statement stmntSimple =
+        wxSQLite3Statement& stmntSimple =
             m_db->GetPrepareStatement(wxT("insert or replace into SIMPLE_MACROS values(NULL, ?, ?)"));
 
         std::map<wxString, PPToken>::const_iterator iter = table.begin();
@@ -1454,72 +1804,63 @@ void TagsStorageSQLite::GetMacrosDefined(const std::set<std::string>& files, con
 {
     if(files.empty() || usedMacros.empty()) { return; }
 
-    // Create the file list SQL string, used for IN operator
-    wxString sFileList;
+    // The file list and the used macros list, used for IN operator
+    wxArrayString fileList;
     for(std::set<std::string>::const_iterator itFile = files.begin(); itFile != files.end(); ++itFile) {
-        sFileList << wxT("'") << wxString::From8BitData(itFile->c_str()) << wxT("',");
+        fileList.Add(wxString::From8BitData(itFile->c_str()));
     }
-    sFileList.RemoveLast();
 
-    // Create the used macros list SQL string, used for IN operator
-    wxString sMacroList;
+    wxArrayString macroList;
     for(std::set<wxString>::const_iterator itUsedMacro = usedMacros.begin(); itUsedMacro != usedMacros.end();
         ++itUsedMacro) {
-        sMacroList << wxT("'") << *itUsedMacro << wxT("',");
-    }
-    sMacroList.RemoveLast();
-
-    try {
-        // Step 1 : Retrieve defined macros in MACROS table
-        wxString req;
-        req << wxT("select name from MACROS where file in (") << sFileList << wxT(")") << wxT(" and name in (")
-            << sMacroList << wxT(")");
-        wxSQLite3ResultSet res = m_db->ExecuteQuery(req);
-        while(res.NextRow()) {
-            defMacros.push_back(res.GetString(0));
-        }
-
-        // Step 2 : Retrieve defined macros in SIMPLE_MACROS table
-        req.Clear();
-        req << wxT("select name from SIMPLE_MACROS where file in (") << sFileList << wxT(")") << wxT(" and name in (")
-            << sMacroList << wxT(")");
-        res = m_db->ExecuteQuery(req);
-        while(res.NextRow()) {
-            defMacros.push_back(res.GetString(0));
-        }
-    } catch(wxSQLite3Exception& exc) {
-        CL_DEBUG(wxT("%s"), exc.GetMessage().c_str());
-    }
+        macroList.Add(*itUsedMacro);
+    }
+
+    // Both lists are bound in the same statement, so each gets half of the variables
+    clSqliteQuery::ForEachChunk(
+        fileList,
+        [&](const wxArrayString& files) {
+            clSqliteQuery::ForEachChunk(
+                macroList,
+                [&](const wxArrayString& macros) {
+                    // Step 1 : Retrieve defined macros in MACROS table
+                    clSqliteQuery query(wxT("select name from MACROS where file in ("));
+                    query.BindList(files).Append(wxT(") and name in (")).BindList(macros).Append(wxT(")"));
+                    DoFetchStrings(query, defMacros);
+
+                    // Step 2 : Retrieve defined macros in SIMPLE_MACROS table
+                    clSqliteQuery simpleQuery(wxT("select name from SIMPLE_MACROS where file in ("));
+                    simpleQuery.BindList(files).Append(wxT(") and name in (")).BindList(macros).Append(wxT(")"));
+                    DoFetchStrings(simpleQuery, defMacros);
+                },
+                SQLITE_MAX_PAIRED_LIST_SIZE);
+        },
+        SQLITE_MAX_PAIRED_LIST_SIZE);
 }
 
 void TagsStorageSQLite::GetTagsByName(const wxString& prefix, std::vector<TagEntryPtr>& tags, bool exactMatch)
 {
-    try {
-        if(prefix.IsEmpty()) return;
-
-        wxString sql;
-        sql << wxT("select * from tags where ");
-        DoAddNamePartToQuery(sql, prefix, !exactMatch, false);
-        DoAddLimitPartToQuery(sql, tags);
-        DoFetchTags(sql, tags);
+    if(prefix.IsEmpty()) return;
 
-    } catch(wxSQLite3Exception& e) {
-        CL_DEBUG(wxT("%s"), e.GetMessage().c_str());
-    }
+    clSqliteQuery query(wxT("select * from tags where "));
+    DoAddNamePartToQuery(query, prefix, !exactMatch, false);
+    DoAddLimitPartToQuery(query, tags);
+    DoFetchTags(query, tags);
 }
 
-void TagsStorageSQLite::DoAddNamePartToQuery(wxString& sql, const wxString& name, bool partial, bool prependAnd)
+void TagsStorageSQLite::DoAddNamePartToQuery(clSqliteQuery& query, const wxString& name, bool partial,
+                                             bool prependAnd)
 {
     if(name.empty()) return;
-    if(prependAnd) { sql << wxT(" AND "); }
+    if(prependAnd) { query.Append(wxT(" AND ")); }
 
     if(m_enableCaseInsensitive) {
         wxString tmpName(name);
         tmpName.Replace(wxT("_"), wxT("^_"));
         if(partial) {
-            sql << wxT(" name LIKE '") << tmpName << wxT("%%' ESCAPE '^' ");
+            query.Append(wxT(" name LIKE ")).Bind(tmpName + wxT("%")).Append(wxT(" ESCAPE '^' "));
         } else {
-            sql << wxT(" name ='") << name << wxT("' ");
+            query.Append(wxT(" name =")).Bind(name);
         }
     } else {
         // Don't use LIKE
@@ -1531,61 +1872,76 @@ void TagsStorageSQLite::DoAddNamePartToQuery(wxString& sql, const wxString& name
 
         // add the name condition
         if(partial) {
-            sql << wxT(" name >= '") << from << wxT("' AND  name < '") << until << wxT("'");
+            query.Append(wxT(" name >= ")).Bind(from).Append(wxT(" AND  name < ")).Bind(until);
         } else {
-            sql << wxT(" name ='") << name << wxT("' ");
+            query.Append(wxT(" name =")).Bind(name);
         }
     }
 }
 
-void TagsStorageSQLite::DoAddLimitPartToQuery(wxString& sql, const std::vector<TagEntryPtr>& tags)
+void TagsStorageSQLite::DoAddOrderPartToQuery(clSqliteQuery& query, const wxString& orderingColumn, int order)
 {
-    if(tags.size() >= (size_t)GetSingleSearchLimit()) {
-        sql << wxT(" LIMIT 1 ");
-    } else {
-        sql << wxT(" LIMIT ") << (size_t)GetSingleSearchLimit() - tags.size();
+    // A column name can not be bound, it is always provided by the caller code
+    if(orderingColumn.IsEmpty()) return;
+
+    query.Append(wxT(" order by ")).Append(orderingColumn);
+    switch(order) {
+    case ITagsStorage::OrderAsc:
+        query.Append(wxT(" ASC"));
+        break;
+    case ITagsStorage::OrderDesc:
+        query.Append(wxT(" DESC"));
+        break;
+    case ITagsStorage::OrderNone:
+    default:
+        break;
     }
 }
 
-TagEntryPtr TagsStorageSQLite::GetTagsByNameLimitOne(const wxString& name)
+size_t TagsStorageSQLite::DoGetRemainingLimit(const std::vector<TagEntryPtr>& tags)
 {
-    try {
-        if(name.IsEmpty()) return NULL;
+    if(tags.size() >= (size_t)GetSingleSearchLimit()) { return 1; }
+    return (size_t)GetSingleSearchLimit() - tags.size();
+}
 
-        std::vector<TagEntryPtr> tags;
-        wxString sql;
-        sql << wxT("select * from tags where ");
-        DoAddNamePartToQuery(sql, name, false, false);
-        sql << wxT(" LIMIT 1 ");
+void TagsStorageSQLite::DoAddLimitPartToQuery(clSqliteQuery& query, const std::vector<TagEntryPtr>& tags)
+{
+    query.Append(wxT(" LIMIT ")).Bind((long)DoGetRemainingLimit(tags));
+}
 
-        DoFetchTags(sql, tags);
-        if(tags.size() == 1)
-            return tags.at(0);
-        else
-            return NULL;
+TagEntryPtr TagsStorageSQLite::GetTagsByNameLimitOne(const wxString& name)
+{
+    if(name.IsEmpty()) return NULL;
 
-    } catch(wxSQLite3Exception& e) {
-        CL_DEBUG(wxT("%s"), e.GetMessage().c_str());
-    }
-    return NULL;
+    std::vector<TagEntryPtr> tags;
+    clSqliteQuery query(wxT("select * from tags where "));
+    DoAddNamePartToQuery(query, name, false, false);
+    query.Append(wxT(" LIMIT 1 "));
+
+    DoFetchTags(query, tags);
+    if(tags.size() == 1)
+        return tags.at(0);
+    else
+        return NULL;
 }
 
 void TagsStorageSQLite::GetTagsByPartName(const wxString& partname, std::vector<TagEntryPtr>& tags)
 {
-    try {
-        if(partname.IsEmpty()) return;
+    if(partname.IsEmpty()) return;
 
-        wxString tmpName(partname);
-        tmpName.Replace(wxT("_"), wxT("^_"));
+    if(DoPrepareSymbolIndex()) {
+        clTagsSymbolIndex::SymbolPtrVec_t symbols;
+        m_symbolIndex.FindByNameSubstring(partname, DoGetRemainingLimit(tags), symbols);
+        if(DoFetchTagsBySymbols(symbols, tags)) return;
+    }
 
-        wxString sql;
-        sql << wxT("select * from tags where name like '%%") << tmpName << wxT("%%' ESCAPE '^' ");
-        DoAddLimitPartToQuery(sql, tags);
-        DoFetchTags(sql, tags);
+    wxString tmpName(partname);
+    tmpName.Replace(wxT("_"), wxT("^_"));
 
-    } catch(wxSQLite3Exception& e) {
-        CL_DEBUG(wxT("%s"), e.GetMessage().c_str());
-    }
+    clSqliteQuery query(wxT("select * from tags where name like "));
+    query.Bind(wxString() << wxT("%") << tmpName << wxT("%")).Append(wxT(" ESCAPE '^' "));
+    DoAddLimitPartToQuery(query, tags);
+    DoFetchTags(query, tags);
 }
 
 void TagsStorageSQLite::RemoveNonWorkspaceSymbols(const std::vector<wxString>& symbols,
@@ -1604,45 +1960,26 @@ void TagsStorageSQLite::RemoveNonWorkspaceSymbols(const std::vector<wxString>& s
         kindSQL << " AND KIND IN ('class', 'enum', 'cenum', 'prototype', 'macro', 'namespace', 'function', "
                    "'struct','typedef')";
 
-        // Split the input vector into arrays of up to 500 elements each
-        std::vector<std::vector<wxString> > v;
-        int chunks = (symbols.size() / 250) + 1;
-        int offset = 0;
-        int left = symbols.size();
-        for(int i = 0; i < chunks; ++i) {
-            int amountToCopy = left > 250 ? 250 : left;
-            left -= amountToCopy;
-            if(amountToCopy > 0) {
-                std::vector<wxString> vChunk(symbols.begin() + offset, symbols.begin() + (offset + amountToCopy));
-                offset += amountToCopy;
-                v.push_back(vChunk);
-            }
-        }
+        wxArrayString symbolsList;
+        symbolsList.insert(symbolsList.end(), symbols.begin(), symbols.end());
 
         std::vector<wxString> allSymbols;
-        for(size_t i = 0; i < v.size(); ++i) {
-            sql.Clear();
-            sql << "SELECT distinct name,kind FROM tags where name in (";
-            for(size_t n = 0; n < v[i].size(); ++n) {
-                sql << "'" << v[i][n] << "',";
-            }
-
-            // remove the last comma
-            sql.RemoveLast();
-            sql << ")";
-            sql << kindSQL;
+        clSqliteQuery::ForEachChunk(symbolsList, [&](const wxArrayString& names) {
+            clSqliteQuery query("SELECT distinct name,kind FROM tags where name in (");
+            query.BindList(names).Append(")").Append(kindSQL);
+            sql = query.GetSql();
 
             // Run the query
-            wxSQLite3ResultSet res = m_db->ExecuteQuery(sql);
-            while(res.NextRow()) {
+            m_db->ExecutePreparedQuery(query, [&](wxSQLite3ResultSet& res) {
                 wxString name = res.GetString(0);
                 wxString kind = res.GetString(1);
                 allSymbols.push_back(name);
                 if((kind != "function") && (kind != "prototype") && (kind != "macro")) {
                     workspaceSymbols.push_back(name);
                 }
-            }
-        }
+                return true;
+            });
+        });
 
         std::sort(workspaceSymbols.begin(), workspaceSymbols.end());
         std::sort(allSymbols.begin(), allSymbols.end());
@@ -1662,22 +1999,23 @@ const wxString& TagsStorageSQLite::GetVersion() const
 
 void TagsStorageSQLite::GetTagsByPartName(const wxArrayString& parts, std::vector<TagEntryPtr>& tags)
 {
-    wxString sql;
-    try {
-        if(parts.IsEmpty()) { return; }
+    if(parts.IsEmpty()) { return; }
 
-        wxString filterQuery = "where ";
-        for(size_t i = 0; i < parts.size(); ++i) {
-            wxString tmpName = parts.Item(i);
-            tmpName.Replace(wxT("_"), wxT("^_"));
-            filterQuery << "path like '%%" << tmpName << "%%' " << ((i == (parts.size() - 1)) ? "" : "AND ");
+    if(DoPrepareSymbolIndex()) {
+        clTagsSymbolIndex::SymbolPtrVec_t symbols;
+        if(m_symbolIndex.FindByPathSubstrings(parts, DoGetRemainingLimit(tags), symbols) &&
+           DoFetchTagsBySymbols(symbols, tags)) {
+            return;
         }
+    }
 
-        sql << "select * from tags " << filterQuery << " ESCAPE '^' ";
-        DoAddLimitPartToQuery(sql, tags);
-        DoFetchTags(sql, tags);
-
-    } catch(wxSQLite3Exception& e) {
-        clWARNING() << sql << ":" << e.GetMessage() << clEndl;
+    clSqliteQuery query(wxT("select * from tags where "));
+    for(size_t i = 0; i < parts.size(); ++i) {
+        wxString tmpName = parts.Item(i);
+        tmpName.Replace(wxT("_"), wxT("^_"));
+        if(i) { query.Append(wxT(" AND ")); }
+        query.Append(wxT("path like ")).Bind(wxString() << wxT("%") << tmpName << wxT("%")).Append(wxT(" ESCAPE '^'"));
     }
+    DoAddLimitPartToQuery(query, tags);
+    DoFetchTags(query, tags);
 }
@@ -34,6 +34,9 @@
 #include <wx/wxsqlite3.h>
 #include "codelite_exports.h"
 #include "wxStringHash.h"
+#include "clTagsSymbolIndex.h"
+#include <functional>
+#include <vector>
 
 /**
  * TagsDatabase is a wrapper around wxSQLite3 database with tags specific functions.
@@ -74,6 +77,14 @@
  * | file         | String | Full path of the file
  * | last_retagged| Number | Timestamp for the last time this file was retagged
  *
+ * Table Name: FILE_FINGERPRINTS
+ *
+ * || Column Name || Type || Description
+ * | file         | String | Full path of the file
+ * | size         | Number | The file size when it was last retagged
+ * | mtime        | Number | The file modification time (in nanoseconds) when it was last retagged
+ * | hash         | Number | Hash of the file content when it was last retagged
+ *
  * Table Name: MACROS
  *
  * || Column Name   || Type || Description
@@ -109,9 +120,96 @@ public:
     void Clear();
 };
 
+// The maximum number of values that BindList() binds. SQLite allows 999 variables in a statement, longer lists
+// are split with clSqliteQuery::ForEachChunk()
+#define SQLITE_MAX_LIST_SIZE 500
+// The chunks size of a statement that binds two lists, so that together they stay within the 999 variables
+#define SQLITE_MAX_PAIRED_LIST_SIZE 256
+
+/**
+ * @class clSqliteQuery
+ * @brief an SQL statement with '?' placeholders and the values bound to them.
+ * Only the SQL text is used to find the prepared statement, so queries that differ only by their values share it.
+ * The lists bound by BindList() are padded to a few fixed sizes, so a query has a bounded number of shapes
+ */
+class WXDLLIMPEXP_CL clSqliteQuery
+{
+public:
+    struct Arg {
+        bool m_isInt;
+        long m_int;
+        wxString m_str;
+    };
+
+protected:
+    wxString m_sql;
+    std::vector<Arg> m_args;
+
+public:
+    clSqliteQuery(const wxString& sql = wxEmptyString)
+        : m_sql(sql)
+    {
+    }
+
+    /**
+     * @brief append SQL text. Values must never be added with this method, use Bind() instead
+     */
+    clSqliteQuery& Append(const wxString& sql)
+    {
+        m_sql << sql;
+        return *this;
+    }
+
+    /**
+     * @brief append a '?' placeholder and bind 'value' to it
+     */
+    clSqliteQuery& Bind(const wxString& value);
+    clSqliteQuery& Bind(long value);
+
+    /**
+     * @brief append a comma separated list of placeholders (for the IN operator) and bind 'values' to them.
+     * The list is padded to the next power of 2 by repeating its last value. At most SQLITE_MAX_LIST_SIZE values
+     * are bound, use ForEachChunk() for lists that can be longer
+     */
+    clSqliteQuery& BindList(const wxArrayString& values);
+    clSqliteQuery& BindList(const std::vector<long>& values);
+
+    /**
+     * @brief call 'func' with consecutive chunks of 'values' that BindList() accepts
+     * @param chunkSize the maximum size of a chunk, at most SQLITE_MAX_LIST_SIZE
+     */
+    static void ForEachChunk(const wxArrayString& values, const std::function<void(const wxArrayString&)>& func,
+                             size_t chunkSize = SQLITE_MAX_LIST_SIZE);
+    static void ForEachChunk(const std::vector<long>& values, const std::function<void(const std::vector<long>&)>& func,
+                             size_t chunkSize = SQLITE_MAX_LIST_SIZE);
+
+    const wxString& GetSql() const { return m_sql; }
+    const std::vector<Arg>& GetArgs() const { return m_args; }
+
+    /**
+     * @brief return a key which is unique for the SQL text and its values
+     */
+    wxString GetKey() const;
+
+    /**
+     * @brief bind the values to 'statement'
+     */
+    void BindTo(wxSQLite3Statement& statement) const;
+};
+
 class WXDLLIMPEXP_CL clSqliteDB : public wxSQLite3Database
 {
+    struct QueryStats {
+        size_t m_count;
+        long m_totalTime;
+        long m_maxTime;
+    };
+
     std::unordered_map<wxString, wxSQLite3Statement> m_statements;
+    std::unordered_map<wxString, QueryStats> m_stats;
+
+protected:
+    void DoUpdateStats(const wxString& sql, long elapsed);
 
 public:
     clSqliteDB()
@@ -119,40 +217,96 @@ public:
     {
     }
 
-    void Close()
-    {
-        if(IsOpen()) wxSQLite3Database::Close();
+    virtual ~clSqliteDB();
 
-        m_statements.clear();
-    }
+    void Close();
+
+    /**
+     * @brief return a prepared statement for 'sql'. The statement is prepared once and cached until the
+     * database is closed. Values must be bound (see clSqliteQuery), so the SQL text of a query takes only a few
+     * shapes and the cache stays small. The returned statement is reset and must not be copied: copying a wxSQLite3Statement
+     * takes its ownership away from the cache
+     */
+    wxSQLite3Statement& GetPrepareStatement(const wxString& sql);
 
-    wxSQLite3Statement GetPrepareStatement(const wxString& sql) { return wxSQLite3Database::PrepareStatement(sql); }
+    /**
+     * @brief run 'query' using a cached prepared statement and call 'onRow' for every row.
+     * Stop when 'onRow' returns false. The statement is reset before returning, so it does not keep a read lock
+     * on the database
+     */
+    void ExecutePreparedQuery(const clSqliteQuery& query, const std::function<bool(wxSQLite3ResultSet&)>& onRow);
+
+    /**
+     * @brief run an update 'query' using a cached prepared statement
+     * @return the number of modified rows
+     */
+    int ExecutePreparedUpdate(const clSqliteQuery& query);
+
+    /**
+     * @brief log the number of runs and the time spent in each query since the database was opened
+     */
+    void LogStats();
 };
 
 class WXDLLIMPEXP_CL TagsStorageSQLite : public ITagsStorage
 {
     clSqliteDB* m_db;
     TagsStorageSQLiteCache m_cache;
+    clTagsSymbolIndex m_symbolIndex;
+    wxString m_symbolIndexVersion;
 
 private:
     /**
      * @brief fetch tags from the database
-     * @param sql
+     * @param query
      * @param tags
      */
-    void DoFetchTags(const wxString& sql, std::vector<TagEntryPtr>& tags);
+    void DoFetchTags(const clSqliteQuery& query, std::vector<TagEntryPtr>& tags);
 
     /**
-     * @brief
-     * @param sql
+     * @brief same as above, but only keep the tags that their kind is one of 'kinds'
+     * @param query
      * @param tags
      */
-    void DoFetchTags(const wxString& sql, std::vector<TagEntryPtr>& tags, const wxArrayString& kinds);
+    void DoFetchTags(const clSqliteQuery& query, std::vector<TagEntryPtr>& tags, const wxArrayString& kinds);
 
-    void DoAddNamePartToQuery(wxString& sql, const wxString& name, bool partial, bool prependAnd);
-    void DoAddLimitPartToQuery(wxString& sql, const std::vector<TagEntryPtr>& tags);
+    /**
+     * @brief fetch a list of strings (the first column of every row) from the database
+     */
+    void DoFetchStrings(const clSqliteQuery& query, wxArrayString& strings);
+
+    void DoAddNamePartToQuery(clSqliteQuery& query, const wxString& name, bool partial, bool prependAnd);
+    /**
+     * @brief the number of tags that a search may still add to 'tags' (at least 1)
+     */
+    size_t DoGetRemainingLimit(const std::vector<TagEntryPtr>& tags);
+    void DoAddLimitPartToQuery(clSqliteQuery& query, const std::vector<TagEntryPtr>& tags);
+    void DoAddOrderPartToQuery(clSqliteQuery& query, const wxString& orderingColumn, int order);
     int DoInsertTagEntry(const TagEntry& tag);
 
+    /**
+     * @brief make sure that the symbol index is loaded and up to date
+     * @return true if the lookups can be answered from the symbol index
+     */
+    bool DoPrepareSymbolIndex();
+
+    /**
+     * @brief fetch the tags of the given symbols from the database by their ID
+     * @return false if some of the symbols no longer exist. In this case 'tags' is not modified
+     * and the symbol index will be synced on the next lookup
+     */
+    bool DoFetchTagsBySymbols(const clTagsSymbolIndex::SymbolPtrVec_t& symbols, std::vector<TagEntryPtr>& tags);
+
+    /**
+     * @brief does the tag of 'symbol' still exist in the database?
+     */
+    bool DoIsSymbolValid(const clTagsSymbolIndex::Symbol* symbol);
+
+    /**
+     * @brief return a string that changes whenever the database is modified, by this connection or another one
+     */
+    wxString DoGetDatabaseVersion();
+
 public:
     static TagEntry* FromSQLite3ResultSet(wxSQLite3ResultSet& rs);
     static void PPTokenFromSQlite3ResultSet(wxSQLite3ResultSet& rs, PPToken& token);
@@ -178,6 +332,7 @@ public:
     virtual ~TagsStorageSQLite();
 
     virtual void SetUseCache(bool useCache);
+    virtual void SetUseSymbolIndex(bool useSymbolIndex);
 
     /**
      * Return the currently opened database.
@@ -503,6 +658,9 @@ public:
     */
     virtual int UpdateFileEntry(const wxString& filename, int timestamp);
 
+    virtual void GetFileFingerprints(clFileFingerprint::Map_t& fingerprints);
+    virtual void StoreFileFingerprint(const wxString& filename, const clFileFingerprint& fingerprint);
+
     /**
      * @brief return true if type exist under a given scope.
      * Incase it exist but under the <global> scope, 'scope' will be modified
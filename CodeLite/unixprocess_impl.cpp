@@ -28,8 +28,10 @@
 
 #if defined(__WXMAC__) || defined(__WXGTK__)
 
+#include "clProcessReactor.h"
 #include "procutils.h"
 #include <errno.h>
+#include <fcntl.h>
 #include <signal.h>
 #include <string.h>
 #include <sys/select.h>
@@ -52,9 +54,6 @@
 #include <util.h>
 #endif
 
-static char** argv = NULL;
-static int argc = 0;
-
 // ----------------------------------------------
 #define ISBLANK(ch) ((ch) == ' ' || (ch) == '\t')
 #define BUFF_SIZE 1024 * 64
@@ -224,67 +223,17 @@ char** buildargv(const char* input)
 
 //-----------------------------------------------------
 
-static void make_argv(const wxString& cmd)
+// Processes may be launched from several threads at the same time, so the argument vector is owned by the caller
+static char** make_argv(const wxString& cmd, int& argc)
 {
-    if(argc) {
-        freeargv(argv);
-        argc = 0;
-    }
-
-    argv = buildargv(cmd.mb_str(wxConvUTF8).data());
+    char** argv = buildargv(cmd.mb_str(wxConvUTF8).data());
     argc = 0;
+    if(argv == NULL) { return NULL; }
 
     for(char** targs = argv; *targs != NULL; targs++) {
         argc++;
     }
-}
-
-#define BUFF_STATE_NORMAL 0
-#define BUFF_STATE_IN_ESC 1
-
-static void RemoveTerminalColoring(char* buffer)
-{
-    char* saved_buff = buffer;
-    char tmpbuf[BUFF_SIZE + 1];
-    memset(tmpbuf, 0, sizeof(tmpbuf));
-
-    short state = BUFF_STATE_NORMAL;
-    size_t i(0);
-
-    while((*buffer) != 0) {
-        switch(state) {
-        case BUFF_STATE_NORMAL:
-            if(*buffer == 0x1B) { // found ESC char
-                state = BUFF_STATE_IN_ESC;
-
-            } else {
-                tmpbuf[i] = *buffer;
-                i++;
-            }
-            break;
-        case BUFF_STATE_IN_ESC:
-            switch((*buffer)) {
-            case 'm':
-            case 'K':
-            case 'G':
-            case 'J':
-            case 'H':
-            case 'X':
-            case 'B':
-            case 'C':
-            case 'D':
-            case 'd':
-                state = BUFF_STATE_NORMAL;
-                break;
-            default:
-                break;
-            }
-            break;
-        }
-        buffer++;
-    }
-    memset(saved_buff, 0, BUFF_SIZE);
-    memcpy(saved_buff, tmpbuf, strlen(tmpbuf));
+    return argv;
 }
 
 UnixProcessImpl::UnixProcessImpl(wxEvtHandler* parent)
@@ -292,6 +241,8 @@ UnixProcessImpl::UnixProcessImpl(wxEvtHandler* parent)
     , m_readHandle(-1)
     , m_writeHandle(-1)
     , m_thr(NULL)
+    , m_watched(false)
+    , m_inEscape(false)
 {
 }
 
@@ -299,16 +250,12 @@ UnixProcessImpl::~UnixProcessImpl() { Cleanup(); }
 
 void UnixProcessImpl::Cleanup()
 {
+    // Stop reading before the handles are closed
+    StopReaderThread();
+
     close(GetReadHandle());
     close(GetWriteHandle());
 
-    if(m_thr) {
-        // Stop the reader thread
-        m_thr->Stop();
-        delete m_thr;
-    }
-    m_thr = NULL;
-
     if(GetPid() != wxNOT_FOUND) {
         wxKill(GetPid(), GetHardKill() ? wxSIGKILL : wxSIGTERM, NULL, wxKILL_CHILDREN);
         // The Zombie cleanup is done in app.cpp in ::ChildTerminatedSingalHandler() signal handler
@@ -341,20 +288,19 @@ bool UnixProcessImpl::Read(wxString& buff)
 
     } else if(rc > 0) {
         // there is something to read
-        char buffer[BUFF_SIZE + 1]; // our read buffer
-        memset(buffer, 0, sizeof(buffer));
+        char buffer[BUFF_SIZE]; // our read buffer
         int bytesRead = read(GetReadHandle(), buffer, sizeof(buffer));
         if(bytesRead > 0) {
-            buffer[BUFF_SIZE] = 0; // allways place a terminator
-
             // Remove coloring chars from the incomnig buffer
             // colors are marked with ESC and terminates with lower case 'm'
-            RemoveTerminalColoring(buffer);
-
-            wxString convBuff = wxString(buffer, wxConvUTF8);
-            if(convBuff.IsEmpty()) { convBuff = wxString::From8BitData(buffer); }
+            m_pendingBytes.append(buffer, clProcessReactor::RemoveTerminalColoring(buffer, bytesRead, m_inEscape));
+            buff = clProcessReactor::ConvertOutput(m_pendingBytes, false);
+            return true;
+        }
 
-            buff = convBuff;
+        // The process is gone: hand out what is left of its output before reporting it
+        if(!m_pendingBytes.empty()) {
+            buff = clProcessReactor::ConvertOutput(m_pendingBytes, true);
             return true;
         }
         return false;
@@ -394,23 +340,30 @@ IProcess* UnixProcessImpl::Execute(wxEvtHandler* parent, const wxString& cmd, si
         clDEBUG1() << "Executing command:" << newCmd << clEndl;
     }
 
-    make_argv(newCmd);
-    if(argc == 0) { return NULL; }
-
-    // fork the child process
-    wxString curdir = wxGetCwd();
+    int argc = 0;
+    char** argv = make_argv(newCmd, argc);
+    if(argc == 0) {
+        freeargv(argv);
+        return NULL;
+    }
 
     // Prentend that we are a terminal...
     int master, slave;
     openpty(&master, &slave, NULL, NULL, NULL);
 
+    // Don't leak the terminal into the processes that other threads fork meanwhile: a child holding our slave
+    // end would keep the output open after our process exits
+    fcntl(master, F_SETFD, FD_CLOEXEC);
+    fcntl(slave, F_SETFD, FD_CLOEXEC);
+
     int rc = fork();
     if(rc == 0) {
         login_tty(slave);
         close(master); // close the un-needed master end
 
         // at this point, slave is used as stdin/stdout/stderr
-        // Child process
+        // Child process. The working directory is changed in the child only, the parent's one is shared by all
+        // its threads
         if(workingDirectory.IsEmpty() == false) { wxSetWorkingDirectory(workingDirectory); }
 
         // execute the process
@@ -422,10 +375,9 @@ IProcess* UnixProcessImpl::Execute(wxEvtHandler* parent, const wxString& cmd, si
 
     } else if(rc < 0) {
         // Error
-
-        // restore the working directory
-        wxSetWorkingDirectory(curdir);
-
+        close(master);
+        close(slave);
+        freeargv(argv);
         return NULL;
 
     } else {
@@ -433,7 +385,6 @@ IProcess* UnixProcessImpl::Execute(wxEvtHandler* parent, const wxString& cmd, si
         // Parent
         close(slave);
         freeargv(argv);
-        argc = 0;
 
         // disable ECHO
         struct termios termio;
@@ -442,9 +393,6 @@ IProcess* UnixProcessImpl::Execute(wxEvtHandler* parent, const wxString& cmd, si
         termio.c_oflag = ONOCR | ONLRET;
         tcsetattr(master, TCSANOW, &termio);
 
-        // restore the working directory
-        wxSetWorkingDirectory(curdir);
-
         UnixProcessImpl* proc = new UnixProcessImpl(parent);
         proc->m_callback = cb;
         proc->SetReadHandle(master);
@@ -459,6 +407,12 @@ IProcess* UnixProcessImpl::Execute(wxEvtHandler* parent, const wxString& cmd, si
 
 void UnixProcessImpl::StartReaderThread()
 {
+    // The output of a redirected process is read by the shared reactor thread
+    if(IsRedirect() && clProcessReactor::Watch(this, GetReadHandle(), m_parent)) {
+        m_watched = true;
+        return;
+    }
+
     // Launch the 'Reader' thread
     m_thr = new ProcessReaderThread();
     m_thr->SetProcess(this);
@@ -466,6 +420,21 @@ void UnixProcessImpl::StartReaderThread()
     m_thr->Start();
 }
 
+void UnixProcessImpl::StopReaderThread()
+{
+    if(m_watched) {
+        clProcessReactor::Unwatch(GetReadHandle());
+        m_watched = false;
+    }
+
+    if(m_thr) {
+        // Stop the reader thread
+        m_thr->Stop();
+        delete m_thr;
+    }
+    m_thr = NULL;
+}
+
 void UnixProcessImpl::Terminate()
 {
     wxKill(GetPid(), GetHardKill() ? wxSIGKILL : wxSIGTERM, NULL, wxKILL_CHILDREN);
@@ -484,14 +453,6 @@ bool UnixProcessImpl::WriteToConsole(const wxString& buff)
     return bytes == (int)tmpbuf.length();
 }
 
-void UnixProcessImpl::Detach()
-{
-    if(m_thr) {
-        // Stop the reader thread
-        m_thr->Stop();
-        delete m_thr;
-    }
-    m_thr = NULL;
-}
+void UnixProcessImpl::Detach() { StopReaderThread(); }
 
 #endif //#if defined(__WXMAC )||defined(__WXGTK__)
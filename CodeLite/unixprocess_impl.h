@@ -30,6 +30,7 @@
 #include "asyncprocess.h"
 #include "processreaderthread.h"
 #include "codelite_exports.h"
+#include <string>
 
 class wxTerminal;
 class WXDLLIMPEXP_CL UnixProcessImpl : public IProcess
@@ -37,10 +38,14 @@ class WXDLLIMPEXP_CL UnixProcessImpl : public IProcess
     int                  m_readHandle;
     int                  m_writeHandle;
     ProcessReaderThread *m_thr;
+    bool                 m_watched; // the output is read by the clProcessReactor
+    std::string          m_pendingBytes; // Read(): an incomplete UTF-8 sequence, completed by the next read
+    bool                 m_inEscape;     // Read(): the last read ended inside a terminal colour sequence
 
     friend class wxTerminal;
 private:
     void StartReaderThread();
+    void StopReaderThread();
 
 public:
     UnixProcessImpl(wxEvtHandler *parent);
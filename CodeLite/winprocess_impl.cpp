@@ -30,6 +30,7 @@
 #include "winprocess_impl.h"
 #include <memory>
 #include <wx/filefn.h>
+#include <wx/thread.h>
 
 #ifdef _WIN32_WINNT
 #undef _WIN32_WINNT
@@ -78,6 +79,11 @@ IProcess* WinProcessImpl::Execute(wxEvtHandler* parent, const wxString& cmd, wxS
     SECURITY_ATTRIBUTES saAttr;
     BOOL fSuccess;
 
+    // The working directory and the standard handles that the child inherits are process wide, processes launched
+    // from several threads at the same time must not interleave here
+    static wxCriticalSection s_launchLock;
+    wxCriticalSectionLocker launchLocker(s_launchLock);
+
     MyDirGuard dg;
 
     wxString wd(workingDir);
@@ -88,12 +88,6 @@ static wxRegEx reInfoProgram2(wxT("child process ([0-9]+)"));
 // Using the running image of child thread 4124.0x117c
 static wxRegEx reInfoProgram3(wxT("Using the running image of child thread ([0-9]+)"));
 
-#ifdef __WXMSW__
-static wxRegEx reConnectionRefused(
-    wxT("[0-9a-zA-Z/\\\\-\\_]*:[0-9]+: No connection could be made because the target machine actively refused it."));
-#else
-static wxRegEx reConnectionRefused(wxT("[0-9a-zA-Z/\\\\-\\_]*:[0-9]+: Connection refused."));
-#endif
 DebuggerInfo GetDebuggerInfo()
 {
     DebuggerInfo info = { wxT("GNU gdb debugger"), wxT("CreateDebuggerGDB"), wxT("v2.0"), wxT("Eran Ifrah") };
@@ -111,23 +105,6 @@ IDebugger* CreateDebuggerGDB()
     return &theGdbDebugger;
 }
 
-// Removes MI additional characters from string
-static void StripString(wxString& string)
-{
-    string.Replace(wxT("\\n\""), wxT("\""));
-    string = string.AfterFirst(wxT('"'));
-    string = string.BeforeLast(wxT('"'));
-    string.Replace(wxT("\\\""), wxT("\""));
-    string.Replace(wxT("\\\\"), wxT("\\"));
-    string.Replace(wxT("\\\\r\\\\n"), wxT("\r\n"));
-    string.Replace(wxT("\\\\n"), wxT("\n"));
-    string.Replace(wxT("\\\\r"), wxT("\r"));
-#ifdef __WXMSW__
-    string.Replace("\\r\\n", "\r\n");
-#endif
-    string = string.Trim();
-}
-
 static wxString MakeId()
 {
     static unsigned int counter(0);
@@ -139,6 +116,8 @@ static wxString MakeId()
 DbgGdb::DbgGdb()
     : m_debuggeePid(wxNOT_FOUND)
     , m_cliHandler(NULL)
+    , m_gdbOutputReader(NULL)
+    , m_gdbOutputSession(0)
     , m_break_at_main(false)
     , m_attachedMode(false)
     , m_goingDown(false)
@@ -181,6 +160,10 @@ DbgGdb::~DbgGdb()
         Kernel32Dll = NULL;
     }
 #endif
+    if(m_gdbOutputReader) {
+        m_gdbOutputReader->Stop();
+        wxDELETE(m_gdbOutputReader);
+    }
     EventNotifier::Get()->Disconnect(wxEVT_GDB_STOP_DEBUGGER, wxCommandEventHandler(DbgGdb::OnKillGDB), NULL, this);
 }
 
@@ -347,12 +330,17 @@ void DbgGdb::DoCleanup()
     SetIsRemoteDebugging(false);
     SetIsRemoteExtended(false);
     EmptyQueue();
-    m_gdbOutputArr.Clear();
     m_bpList.clear();
     m_debuggeeProjectName.Clear();
 
-    // Clear any bufferd output
-    m_gdbOutputIncompleteLine.Clear();
+    // Clear any bufferd output. Records of this session that are still on their way from the reader thread
+    // are dropped by OnMIRecords()
+    m_gdbOutputQueue.clear();
+    ++m_gdbOutputSession;
+    if(m_gdbOutputReader) {
+        m_gdbOutputReader->Stop();
+        wxDELETE(m_gdbOutputReader);
+    }
 
     // Free allocated console for this session
     m_consoleFinder.FreeConsole();
@@ -641,7 +629,7 @@ bool DbgGdb::RemoveBreak(double bid)
 bool DbgGdb::FilterMessage(const wxString& msg)
 {
     wxString tmpmsg(msg);
-    StripString(tmpmsg);
+    GdbMIRecord::StripString(tmpmsg);
     tmpmsg.Trim().Trim(false);
 
     if(tmpmsg.Contains(wxT("Variable object not found")) || msg.Contains(wxT("Variable object not found"))) {
@@ -675,26 +663,24 @@ bool DbgGdb::FilterMessage(const wxString& msg)
 
 void DbgGdb::Poke()
 {
-    static wxRegEx reCommand(wxT("^([0-9]{8})"));
-
     // poll the debugger output
-    wxString curline;
-    if(!m_gdbProcess || m_gdbOutputArr.IsEmpty()) {
+    if(!m_gdbProcess || m_gdbOutputQueue.empty()) {
         return;
     }
 
-    while(DoGetNextLine(curline)) {
+    while(!m_gdbOutputQueue.empty()) {
+        // The records were split and classified by the reader thread
+        GdbMIRecord record;
+        record.Swap(m_gdbOutputQueue.front());
+        m_gdbOutputQueue.pop_front();
+        wxString& curline = record.m_line;
 
         GetDebugeePID(curline);
 
-        // For string manipulations without damaging the original line read
-        wxString tmpline(curline);
-        StripString(tmpline);
-        tmpline.Trim().Trim(false);
         if(m_info.enableDebugLog) {
             // Is logging enabled?
 
-            if(curline.IsEmpty() == false && !tmpline.StartsWith(wxT(">"))) {
+            if(!record.m_isShell) {
                 wxString strdebug(wxT("DEBUG>>"));
                 strdebug << curline;
                 clDEBUG() << strdebug << clEndl;
@@ -702,8 +688,8 @@ void DbgGdb::Poke()
             }
         }
 
-        if(reConnectionRefused.Matches(curline)) {
-            StripString(curline);
+        if(record.m_connectionRefused) {
+            curline = record.m_stripped;
 #ifdef __WXGTK__
             m_consoleFinder.FreeConsole();
 #endif
@@ -724,32 +710,24 @@ void DbgGdb::Poke()
             return;
         }
 
-        if(tmpline.StartsWith(wxT(">"))) {
+        if(record.m_isShell) {
             // Shell line, probably user command line
             continue;
         }
 
-        if(curline.StartsWith(wxT("~")) || curline.StartsWith(wxT("&")) || curline.StartsWith("@")) {
+        if(record.m_token.IsEmpty() && record.IsStream()) {
 
             // lines starting with ~ are considered "console stream" message
             // and are important to the CLI handler
-            bool consoleStream(false);
-            bool targetConsoleStream(false);
-
-            if(curline.StartsWith(wxT("~"))) {
-                consoleStream = true;
-            }
-
-            if(curline.StartsWith(wxT("@"))) {
-                targetConsoleStream = true;
-            }
+            bool consoleStream = (record.m_type == GdbMIRecord::kConsoleStream);
+            bool targetConsoleStream = (record.m_type == GdbMIRecord::kTargetStream);
 
             // Filter out some gdb error lines...
             if(FilterMessage(curline)) {
                 continue;
             }
 
-            StripString(curline);
+            curline = record.m_stripped;
 
             // If we got a valid "CLI Handler" instead of writing the output to
             // the output view, concatenate it into the handler buffer
@@ -764,10 +742,10 @@ void DbgGdb::Poke()
                 m_observer->UpdateAddLine(curline);
             }
 
-        } else if(reCommand.Matches(curline)) {
+        } else if(!record.m_token.IsEmpty()) {
 
             // not a gdb message, get the command associated with the message
-            wxString id = reCommand.GetMatch(curline, 1);
+            wxString& id = record.m_token;
 
             if(GetCliHandler() && GetCliHandler()->GetCommandId() == id) {
                 // probably the "^done" message of the CLI command
@@ -810,7 +788,7 @@ void DbgGdb::DoProcessAsyncCommand(wxString& line, wxString& id)
             delete handler;
         }
 
-        StripString(line);
+        GdbMIRecord::StripString(line);
 
         // We also need to pass the control back to the program
         if(!errorProcessed) {
@@ -934,6 +912,17 @@ bool DbgGdb::SelectThread(long threadId)
 }
 
 void DbgGdb::OnProcessEnd(clProcessEvent& e)
+{
+    // gdb may have written its last output just before it exited. Let the reader thread split what it still has,
+    // and clean up only after its last batch was handled: the CallAfter() calls are processed in order
+    if(m_gdbOutputReader) {
+        m_gdbOutputReader->Drain();
+        wxDELETE(m_gdbOutputReader);
+    }
+    CallAfter(&DbgGdb::OnProcessEndAfterOutput);
+}
+
+void DbgGdb::OnProcessEndAfterOutput()
 {
     DoCleanup();
     m_observer->UpdateGotControl(DBG_EXITED_NORMALLY);
@@ -1200,58 +1189,35 @@ bool DbgGdb::EvaluateVariableObject(const wxString& name, int userReason)
 void DbgGdb::OnDataRead(clProcessEvent& e)
 {
     // Data arrived from the debugger
-    wxString bufferRead;
-    bufferRead << e.GetOutput();
-
     if(!m_gdbProcess || !m_gdbProcess->IsAlive()) return;
 
-    CL_DEBUG("GDB>> %s", bufferRead);
-    wxArrayString lines = wxStringTokenize(bufferRead, wxT("\n"), wxTOKEN_STRTOK);
-    if(lines.IsEmpty()) return;
+    CL_DEBUG("GDB>> %s", e.GetOutput());
 
-    // Prepend the partially saved line from previous iteration to the first line
-    // of this iteration
-    lines.Item(0).Prepend(m_gdbOutputIncompleteLine);
-    m_gdbOutputIncompleteLine.Clear();
-
-    // If the last line is in-complete, remove it from the array and keep it for next iteration
-    if(!bufferRead.EndsWith(wxT("\n"))) {
-        m_gdbOutputIncompleteLine = lines.Last();
-        lines.RemoveAt(lines.GetCount() - 1);
+    // Split the output into records on the reader thread, the records are handed back to OnMIRecords()
+    if(!m_gdbOutputReader) {
+        m_gdbOutputReader = new GdbMIReaderThread(this);
+        m_gdbOutputReader->Start();
     }
+    m_gdbOutputReader->Add(new GdbMIReaderRequest(m_gdbOutputSession, e.GetOutput()));
+}
 
-    for(size_t i = 0; i < lines.GetCount(); i++) {
-        wxString line = lines.Item(i);
-
-        line.Replace(wxT("(gdb)"), wxT(""));
-        line.Trim().Trim(false);
-        if(line.IsEmpty() == false) {
-            m_gdbOutputArr.Add(line);
+void DbgGdb::OnMIRecords(GdbMIRecordsBatch* batch)
+{
+    // Drop the records of a session that was already cleaned up
+    if(m_gdbProcess && batch->m_session == m_gdbOutputSession) {
+        for(size_t i = 0; i < batch->m_records.size(); ++i) {
+            m_gdbOutputQueue.push_back(GdbMIRecord());
+            m_gdbOutputQueue.back().Swap(batch->m_records[i]);
         }
     }
+    wxDELETE(batch);
 
-    if(m_gdbOutputArr.IsEmpty() == false) {
+    if(!m_gdbOutputQueue.empty()) {
         // Trigger GDB processing
         Poke();
     }
 }
 
-bool DbgGdb::DoGetNextLine(wxString& line)
-{
-    line.Clear();
-    if(m_gdbOutputArr.IsEmpty()) {
-        return false;
-    }
-    line = m_gdbOutputArr.Item(0);
-    m_gdbOutputArr.RemoveAt(0);
-    line.Replace(wxT("(gdb)"), wxT(""));
-    line.Trim().Trim(false);
-    if(line.IsEmpty()) {
-        return false;
-    }
-    return true;
-}
-
 void DbgGdb::SetInternalMainBpID(int bpId) { m_internalBpId = bpId; }
 
 bool DbgGdb::Restart() { return WriteCommand(wxT("-exec-run "), new DbgCmdHandlerExecRun(m_observer, this)); }
@@ -32,6 +32,8 @@
 #include <wx/hashmap.h>
 #include "consolefinder.h"
 #include "cl_command_event.h"
+#include "gdbmi_reader_thread.h"
+#include <deque>
 
 #ifdef MSVC_VER
 // declare the debugger function creation
@@ -63,8 +65,9 @@ class DbgGdb : public wxEvtHandler, public IDebugger
     std::vector<BreakpointInfo> m_bpList;
     DbgCmdCLIHandler* m_cliHandler;
     IProcess* m_gdbProcess;
-    wxArrayString m_gdbOutputArr;
-    wxString m_gdbOutputIncompleteLine;
+    std::deque<GdbMIRecord> m_gdbOutputQueue;
+    GdbMIReaderThread* m_gdbOutputReader;
+    size_t m_gdbOutputSession;
     bool m_break_at_main;
     bool m_attachedMode;
     bool m_goingDown;
@@ -80,7 +83,6 @@ protected:
     DbgCmdHandler* PopHandler(const wxString& id);
     void EmptyQueue();
     bool FilterMessage(const wxString& msg);
-    bool DoGetNextLine(wxString& line);
     void DoCleanup();
 
     // wrapper for convinience
@@ -173,5 +175,7 @@ public:
     void OnProcessEnd(clProcessEvent& e);
     void OnDataRead(clProcessEvent& e);
     void OnKillGDB(wxCommandEvent& e);
+    void OnMIRecords(GdbMIRecordsBatch* batch);
+    void OnProcessEndAfterOutput();
 };
 #endif // DBGINTERFACE_H
@@ -0,0 +1,190 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2014 Eran Ifrah
+// file name            : gdbmi_reader_thread.cpp
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#include "gdbmi_reader_thread.h"
+#include "debuggergdb.h"
+#include "macros.h"
+#include <algorithm>
+#include <wx/regex.h>
+
+#define GDB_PROMPT "(gdb)"
+#define GDB_TOKEN_LEN 8
+
+void GdbMIRecord::StripString(wxString& str)
+{
+    str.Replace(wxT("\\n\""), wxT("\""));
+    str = str.AfterFirst(wxT('"'));
+    str = str.BeforeLast(wxT('"'));
+    str.Replace(wxT("\\\""), wxT("\""));
+    str.Replace(wxT("\\\\"), wxT("\\"));
+    str.Replace(wxT("\\\\r\\\\n"), wxT("\r\n"));
+    str.Replace(wxT("\\\\n"), wxT("\n"));
+    str.Replace(wxT("\\\\r"), wxT("\r"));
+#ifdef __WXMSW__
+    str.Replace("\\r\\n", "\r\n");
+#endif
+    str = str.Trim();
+}
+
+void GdbMIRecord::Swap(GdbMIRecord& other)
+{
+    m_line.swap(other.m_line);
+    m_token.swap(other.m_token);
+    m_stripped.swap(other.m_stripped);
+    std::swap(m_type, other.m_type);
+    std::swap(m_isShell, other.m_isShell);
+    std::swap(m_connectionRefused, other.m_connectionRefused);
+}
+
+void GdbMIRecord::Parse(const wxString& line)
+{
+    // Used only by the reader thread
+#ifdef __WXMSW__
+    static wxRegEx reConnectionRefused(
+        wxT("[0-9a-zA-Z/\\\\-\\_]*:[0-9]+: No connection could be made because the target machine actively refused it."));
+#else
+    static wxRegEx reConnectionRefused(wxT("[0-9a-zA-Z/\\\\-\\_]*:[0-9]+: Connection refused."));
+#endif
+
+    m_line = line;
+    m_token.Clear();
+    m_type = kUnknown;
+
+    // A command output is prefixed with the command ID
+    size_t start = 0;
+    while(start < GDB_TOKEN_LEN && start < m_line.length() && wxIsdigit(m_line.GetChar(start))) {
+        ++start;
+    }
+    if(start == GDB_TOKEN_LEN) {
+        m_token = m_line.Mid(0, GDB_TOKEN_LEN);
+    } else {
+        start = 0;
+    }
+
+    if(start < m_line.length()) {
+        switch((wxChar)m_line.GetChar(start)) {
+        case '~':
+            m_type = kConsoleStream;
+            break;
+        case '@':
+            m_type = kTargetStream;
+            break;
+        case '&':
+            m_type = kLogStream;
+            break;
+        case '^':
+            m_type = kResult;
+            break;
+        case '*':
+            m_type = kExecAsync;
+            break;
+        case '+':
+            m_type = kStatusAsync;
+            break;
+        case '=':
+            m_type = kNotifyAsync;
+            break;
+        default:
+            break;
+        }
+    }
+
+    m_stripped = m_line;
+    StripString(m_stripped);
+    m_isShell = wxString(m_stripped).Trim(false).StartsWith(wxT(">"));
+    m_connectionRefused = reConnectionRefused.Matches(m_line);
+}
+
+GdbMIReaderThread::GdbMIReaderThread(DbgGdb* gdb)
+    : m_gdb(gdb)
+    , m_session(0)
+{
+}
+
+GdbMIReaderThread::~GdbMIReaderThread() {}
+
+void GdbMIReaderThread::ProcessRequest(ThreadRequest* request)
+{
+    GdbMIReaderRequest* req = dynamic_cast<GdbMIReaderRequest*>(request);
+    CHECK_PTR_RET(req);
+
+    if(req->m_session != m_session) {
+        // A new debug session, drop the leftovers of the previous one
+        m_session = req->m_session;
+        m_incompleteLine.Clear();
+    }
+
+    GdbMIRecordsBatch* batch = new GdbMIRecordsBatch();
+    batch->m_session = m_session;
+
+    const wxString& output = req->m_output;
+    size_t lineStart = 0;
+    while(lineStart < output.length()) {
+        size_t lineEnd = output.find(wxT('\n'), lineStart);
+        if(lineEnd == wxString::npos) {
+            // In-complete line, keep it for the next chunk
+            m_incompleteLine << output.Mid(lineStart);
+            break;
+        }
+
+        wxString line = m_incompleteLine;
+        m_incompleteLine.Clear();
+        line << output.Mid(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+
+        line.Trim().Trim(false);
+        while(line.StartsWith(GDB_PROMPT)) {
+            line.Remove(0, wxStrlen(GDB_PROMPT));
+            line.Trim(false);
+        }
+        if(line.IsEmpty()) {
+            continue;
+        }
+
+        batch->m_records.push_back(GdbMIRecord());
+        batch->m_records.back().Parse(line);
+    }
+
+    if(batch->m_records.empty()) {
+        wxDELETE(batch);
+        return;
+    }
+    m_gdb->CallAfter(&DbgGdb::OnMIRecords, batch);
+}
+
+void GdbMIReaderThread::Drain()
+{
+    Stop();
+
+    ThreadRequest* request = NULL;
+    while(m_queue.ReceiveTimeout(0, request) == wxMSGQUEUE_NO_ERROR) {
+        ProcessRequest(request);
+        wxDELETE(request);
+    }
+
+    // gdb is gone, its last line will not be completed
+    GdbMIReaderRequest lastLine(m_session, wxT("\n"));
+    ProcessRequest(&lastLine);
+}
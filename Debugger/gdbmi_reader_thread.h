@@ -0,0 +1,138 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2014 Eran Ifrah
+// file name            : gdbmi_reader_thread.h
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef GDBMIREADERTHREAD_H
+#define GDBMIREADERTHREAD_H
+
+#include "worker_thread.h"
+#include <vector>
+#include <wx/string.h>
+
+class DbgGdb;
+
+/**
+ * @class GdbMIRecord
+ * @brief a single line of gdb output, classified by its MI record type
+ */
+class GdbMIRecord
+{
+public:
+    enum eType {
+        kUnknown = 0,
+        kConsoleStream, // ~"text"
+        kTargetStream,  // @"text"
+        kLogStream,     // &"text"
+        kResult,        // ^done, ^error ...
+        kExecAsync,     // *stopped, *running ...
+        kStatusAsync,   // +download ...
+        kNotifyAsync,   // =thread-created ...
+    };
+    typedef std::vector<GdbMIRecord> Vec_t;
+
+    wxString m_line;     // the line as sent by gdb (without the "(gdb)" prompt)
+    wxString m_token;    // the 8 digits command ID that prefixes the line (if any)
+    wxString m_stripped; // the line content with the MI quotes and escapes removed
+    eType m_type;
+    bool m_isShell;           // an echo of a shell line (the content starts with '>')
+    bool m_connectionRefused; // remote debugging: the connection to the gdbserver was refused
+
+public:
+    GdbMIRecord()
+        : m_type(kUnknown)
+        , m_isShell(false)
+        , m_connectionRefused(false)
+    {
+    }
+
+    bool IsStream() const { return m_type == kConsoleStream || m_type == kTargetStream || m_type == kLogStream; }
+
+    /**
+     * @brief swap the content of this record with 'other' (without copying the strings)
+     */
+    void Swap(GdbMIRecord& other);
+
+    /**
+     * @brief classify 'line' and fill the record fields
+     */
+    void Parse(const wxString& line);
+
+    /**
+     * @brief remove the MI additional characters (quotes and escapes) from 'str'
+     */
+    static void StripString(wxString& str);
+};
+
+/**
+ * @class GdbMIRecordsBatch
+ * @brief the records read from a single chunk of gdb output
+ */
+struct GdbMIRecordsBatch {
+    size_t m_session;
+    GdbMIRecord::Vec_t m_records;
+};
+
+/**
+ * @class GdbMIReaderRequest
+ * @brief a chunk of raw gdb output to split into records
+ */
+class GdbMIReaderRequest : public ThreadRequest
+{
+public:
+    size_t m_session;
+    wxString m_output;
+
+public:
+    GdbMIReaderRequest(size_t session, const wxString& output)
+        : m_session(session)
+        , m_output(output)
+    {
+    }
+    virtual ~GdbMIReaderRequest() {}
+};
+
+/**
+ * @class GdbMIReaderThread
+ * @brief splits the gdb output into lines and classifies them into MI records, away from the main thread.
+ * The records are handed to DbgGdb::OnMIRecords() in batches, in the order gdb wrote them
+ */
+class GdbMIReaderThread : public WorkerThread
+{
+    DbgGdb* m_gdb;
+    size_t m_session;
+    wxString m_incompleteLine; // the last line of the previous chunk, if it did not end with a newline
+
+public:
+    GdbMIReaderThread(DbgGdb* gdb);
+    virtual ~GdbMIReaderThread();
+    virtual void ProcessRequest(ThreadRequest* request);
+
+    /**
+     * @brief stop the thread and process the output that it did not process yet on the calling thread.
+     * The batches are still handed to DbgGdb::OnMIRecords() with CallAfter(), after the ones already sent
+     */
+    void Drain();
+};
+
+#endif // GDBMIREADERTHREAD_H
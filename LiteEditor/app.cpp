@@ -68,6 +68,7 @@
 //////////////////////////////////////////////
 
 #if defined(__WXMAC__) || defined(__WXGTK__)
+#include "clProcessReactor.h"
 #include <signal.h> // sigprocmask
 #include <sys/wait.h>
 #endif
@@ -691,6 +692,9 @@ int CodeLiteApp::OnExit()
     CL_DEBUG(wxT("Bye"));
     EditorConfigST::Free();
     ConfFileLocator::Release();
+#if defined(__WXMAC__) || defined(__WXGTK__)
+    clProcessReactor::Release();
+#endif
     return 0;
 }
 
@@ -0,0 +1,189 @@
+#include "clSemanticHighlighter.h"
+#include "cl_editor.h"
+#include <algorithm>
+#include <wx/tokenzr.h>
+
+static inline bool IsWordChar(char ch)
+{
+    return ((ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') || ch == '_' ||
+            ((unsigned char)ch >= 0x80));
+}
+
+static void SplitTokens(const wxString& str, wxStringSet_t& tokens)
+{
+    tokens.clear();
+    wxStringTokenizer tokenizer(str, " ", wxTOKEN_STRTOK);
+    while(tokenizer.HasMoreTokens()) {
+        tokens.insert(tokenizer.GetNextToken());
+    }
+}
+
+clSemanticHighlighter::clSemanticHighlighter(clEditor* editor)
+    : m_editor(editor)
+{
+    m_editor->Bind(wxEVT_STC_UPDATEUI, &clSemanticHighlighter::OnUpdateUI, this);
+    m_editor->Bind(wxEVT_STC_MODIFIED, &clSemanticHighlighter::OnModified, this);
+}
+
+clSemanticHighlighter::~clSemanticHighlighter()
+{
+    m_editor->Unbind(wxEVT_STC_UPDATEUI, &clSemanticHighlighter::OnUpdateUI, this);
+    m_editor->Unbind(wxEVT_STC_MODIFIED, &clSemanticHighlighter::OnModified, this);
+}
+
+void clSemanticHighlighter::ApplySettings()
+{
+#if wxVERSION_NUMBER >= 3101
+    // Use the colours of the lexer styles that were used for the classes / locals keywords
+    m_editor->IndicatorSetStyle(SEMANTIC_CLASS_INDICATOR, wxSTC_INDIC_TEXTFORE);
+    m_editor->IndicatorSetForeground(SEMANTIC_CLASS_INDICATOR, m_editor->StyleGetForeground(wxSTC_C_WORD2));
+    m_editor->IndicatorSetStyle(SEMANTIC_LOCAL_INDICATOR, wxSTC_INDIC_TEXTFORE);
+    m_editor->IndicatorSetForeground(SEMANTIC_LOCAL_INDICATOR, m_editor->StyleGetForeground(wxSTC_C_GLOBALCLASS));
+#endif
+}
+
+void clSemanticHighlighter::SetTokens(const wxString& classes, const wxString& locals)
+{
+    if(classes == m_classesStr && locals == m_localsStr) {
+        // Nothing changed (e.g. the file was saved again): keep the coloured lines
+        return;
+    }
+
+    if(classes.IsEmpty() && locals.IsEmpty()) {
+        Clear();
+        return;
+    }
+
+    m_classesStr = classes;
+    m_localsStr = locals;
+    SplitTokens(classes, m_classes);
+    SplitTokens(locals, m_locals);
+    DoInvalidateAll();
+    DoColourVisibleLines();
+}
+
+void clSemanticHighlighter::Clear()
+{
+    bool hadTokens = !m_classes.empty() || !m_locals.empty();
+    m_classes.clear();
+    m_locals.clear();
+    m_classesStr.Clear();
+    m_localsStr.Clear();
+    m_lines.clear();
+    if(!hadTokens) { return; }
+
+    int length = m_editor->GetLength();
+    m_editor->SetIndicatorCurrent(SEMANTIC_CLASS_INDICATOR);
+    m_editor->IndicatorClearRange(0, length);
+    m_editor->SetIndicatorCurrent(SEMANTIC_LOCAL_INDICATOR);
+    m_editor->IndicatorClearRange(0, length);
+}
+
+void clSemanticHighlighter::DoInvalidateAll() { m_lines.assign(m_editor->GetLineCount(), false); }
+
+void clSemanticHighlighter::DoInvalidateLines(int fromLine, int toLine)
+{
+    fromLine = std::max(fromLine, 0);
+    toLine = std::min(toLine, (int)m_lines.size() - 1);
+    for(int line = fromLine; line <= toLine; ++line) {
+        m_lines[line] = false;
+    }
+}
+
+void clSemanticHighlighter::OnModified(wxStyledTextEvent& event)
+{
+    event.Skip();
+    if(m_classes.empty() && m_locals.empty()) { return; }
+
+    int type = event.GetModificationType();
+    if(type & (wxSTC_MOD_INSERTTEXT | wxSTC_MOD_DELETETEXT)) {
+        // Keep the lines state aligned with the document lines
+        int line = m_editor->LineFromPosition(event.GetPosition());
+        int linesAdded = event.GetLinesAdded();
+        size_t where = std::min((size_t)(line + 1), m_lines.size());
+        if(linesAdded > 0) {
+            m_lines.insert(m_lines.begin() + where, linesAdded, false);
+        } else if(linesAdded < 0) {
+            size_t until = std::min(where - linesAdded, m_lines.size());
+            m_lines.erase(m_lines.begin() + where, m_lines.begin() + until);
+        }
+        DoInvalidateLines(line, line);
+
+    } else if(type & wxSTC_MOD_CHANGESTYLE) {
+        // The lexer restyled these lines (e.g. a comment was opened above them)
+        DoInvalidateLines(m_editor->LineFromPosition(event.GetPosition()),
+                          m_editor->LineFromPosition(event.GetPosition() + event.GetLength()));
+    }
+}
+
+void clSemanticHighlighter::OnUpdateUI(wxStyledTextEvent& event)
+{
+    event.Skip();
+    if(m_classes.empty() && m_locals.empty()) { return; }
+    DoColourVisibleLines();
+}
+
+void clSemanticHighlighter::DoColourVisibleLines()
+{
+    int lineCount = m_editor->GetLineCount();
+    if((int)m_lines.size() != lineCount) {
+        // Should not happen, but never index outside of the document
+        m_lines.resize(lineCount, false);
+    }
+
+    int firstVisible = m_editor->GetFirstVisibleLine();
+    int firstLine = m_editor->DocLineFromVisible(firstVisible);
+    int lastLine = std::min(m_editor->DocLineFromVisible(firstVisible + m_editor->LinesOnScreen()), lineCount - 1);
+    for(int line = firstLine; line <= lastLine; ++line) {
+        if(!m_lines[line]) {
+            DoColourLine(line);
+            m_lines[line] = true;
+        }
+    }
+}
+
+void clSemanticHighlighter::DoColourLine(int line)
+{
+    int startPos = m_editor->PositionFromLine(line);
+    int endPos = m_editor->GetLineEndPosition(line);
+
+    m_editor->SetIndicatorCurrent(SEMANTIC_CLASS_INDICATOR);
+    m_editor->IndicatorClearRange(startPos, endPos - startPos);
+    m_editor->SetIndicatorCurrent(SEMANTIC_LOCAL_INDICATOR);
+    m_editor->IndicatorClearRange(startPos, endPos - startPos);
+    if(endPos <= startPos) { return; }
+
+    // We only colour identifiers, so the line must be styled by the lexer
+    if(m_editor->GetEndStyled() < endPos) { m_editor->Colourise(m_editor->GetEndStyled(), endPos); }
+
+    wxCharBuffer text = m_editor->GetTextRangeRaw(startPos, endPos);
+    const char* p = text.data();
+    int length = endPos - startPos;
+    int i = 0;
+    while(i < length) {
+        if(!IsWordChar(p[i])) {
+            ++i;
+            continue;
+        }
+
+        int wordStart = i;
+        while(i < length && IsWordChar(p[i])) {
+            ++i;
+        }
+
+        // Skip numbers, comments, strings, inactive code etc
+        if((p[wordStart] >= '0' && p[wordStart] <= '9') ||
+           m_editor->GetStyleAt(startPos + wordStart) != wxSTC_C_IDENTIFIER) {
+            continue;
+        }
+
+        wxString word = wxString::FromUTF8(p + wordStart, i - wordStart);
+        if(m_classes.count(word)) {
+            m_editor->SetIndicatorCurrent(SEMANTIC_CLASS_INDICATOR);
+            m_editor->IndicatorFillRange(startPos + wordStart, i - wordStart);
+        } else if(m_locals.count(word)) {
+            m_editor->SetIndicatorCurrent(SEMANTIC_LOCAL_INDICATOR);
+            m_editor->IndicatorFillRange(startPos + wordStart, i - wordStart);
+        }
+    }
+}
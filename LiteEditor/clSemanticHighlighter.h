@@ -0,0 +1,59 @@
+#ifndef CLSEMANTICHIGHLIGHTER_H
+#define CLSEMANTICHIGHLIGHTER_H
+
+#include "macros.h"
+#include <vector>
+#include <wx/event.h>
+#include <wx/stc/stc.h>
+
+class clEditor;
+
+/**
+ * @class clSemanticHighlighter
+ * @brief colour the identifiers of an editor that were classified by the parser thread (workspace symbols and
+ * locals). Instead of passing the tokens to the lexer as keywords (which makes Scintilla rebuild its word lists
+ * and restyle the whole document), the identifiers are coloured with indicators, one line at a time: only the
+ * visible lines are coloured, and a line is coloured again only when it was modified, restyled or when the
+ * classified tokens changed.
+ * Text foreground indicators require wxWidgets 3.1.1, with older versions the tokens are passed to the lexer
+ */
+class clSemanticHighlighter : public wxEvtHandler
+{
+    clEditor* m_editor;
+    wxStringSet_t m_classes;
+    wxStringSet_t m_locals;
+    wxString m_classesStr; // the tokens as received, m_classes and m_locals are rebuilt only when they change
+    wxString m_localsStr;
+    std::vector<bool> m_lines; // true if the line is coloured with the current tokens
+
+protected:
+    void OnUpdateUI(wxStyledTextEvent& event);
+    void OnModified(wxStyledTextEvent& event);
+
+    void DoInvalidateAll();
+    void DoInvalidateLines(int fromLine, int toLine);
+    void DoColourVisibleLines();
+    void DoColourLine(int line);
+
+public:
+    clSemanticHighlighter(clEditor* editor);
+    virtual ~clSemanticHighlighter();
+
+    /**
+     * @brief set the indicators colours from the current lexer
+     */
+    void ApplySettings();
+
+    /**
+     * @brief set the classified tokens (space delimited). When the tokens did not change since the last call,
+     * the coloured lines are kept as is
+     */
+    void SetTokens(const wxString& classes, const wxString& locals);
+
+    /**
+     * @brief remove the tokens and their colouring
+     */
+    void Clear();
+};
+
+#endif // CLSEMANTICHIGHLIGHTER_H
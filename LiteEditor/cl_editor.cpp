@@ -33,6 +33,7 @@
 #include "clPrintout.h"
 #include "clResizableTooltip.h"
 #include "clSTCLineKeeper.h"
+#include "clSemanticHighlighter.h"
 #include "cl_command_event.h"
 #include "cl_editor.h"
 #include "cl_editor_tip_window.h"
@@ -317,6 +318,7 @@ clEditor::clEditor(wxWindow* parent)
 #else
     wxStyledTextCtrl::Create(parent, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxNO_BORDER);
 #endif
+    m_semanticHighlighter = new clSemanticHighlighter(this);
 
     Bind(wxEVT_STC_CHARADDED, &clEditor::OnCharAdded, this);
     Bind(wxEVT_STC_MARGINCLICK, &clEditor::OnMarginClick, this);
@@ -423,6 +425,7 @@ clEditor::~clEditor()
 
     // find deltas
     wxDELETE(m_deltas);
+    wxDELETE(m_semanticHighlighter);
 
     if(this->HasCapture()) { this->ReleaseMouse(); }
 }
@@ -432,6 +435,7 @@ time_t clEditor::GetFileLastModifiedTime() const { return GetFileModificationTim
 void clEditor::SetSyntaxHighlight(const wxString& lexerName)
 {
     ClearDocumentStyle();
+    m_semanticHighlighter->Clear();
     m_context = ContextManager::Get()->NewContext(this, lexerName);
 
     // Apply the lexer fonts and colours before we call
@@ -451,6 +455,7 @@ void clEditor::SetSyntaxHighlight(const wxString& lexerName)
 void clEditor::SetSyntaxHighlight(bool bUpdateColors)
 {
     ClearDocumentStyle();
+    m_semanticHighlighter->Clear();
     m_context = ContextManager::Get()->NewContextByFileName(this, m_fileName);
 
     SetProperties();
@@ -3799,6 +3804,7 @@ void clEditor::UpdateColours()
         m_context->OnFileSaved();
 
     } else {
+        m_semanticHighlighter->Clear();
         if(m_context->GetName() == wxT("C++")) {
             SetKeyWords(1, wxEmptyString); // Classes
             SetKeyWords(2, wxEmptyString);
@@ -55,6 +55,8 @@
 #define HYPERLINK_INDICATOR 4
 #define MARKER_FIND_BAR_WORD_HIGHLIGHT 5
 #define MARKER_CONTEXT_WORD_HIGHLIGHT 6
+#define SEMANTIC_CLASS_INDICATOR 12
+#define SEMANTIC_LOCAL_INDICATOR 13
 #define CUR_LINE_NUMBER_STYLE (wxSTC_STYLE_MAX - 1)
 
 #if(wxVERSION_NUMBER < 3101)
@@ -76,6 +78,7 @@ class CCBox;
 class clEditorTipWindow;
 class DisplayVariableDlg;
 class EditorDeltasHolder;
+class clSemanticHighlighter;
 
 enum sci_annotation_styles { eAnnotationStyleError = 128, eAnnotationStyleWarning };
 
@@ -211,6 +214,7 @@ protected:
     wxStopWatch m_watch;
     ContextBasePtr m_context;
     EditorDeltasHolder* m_deltas; // Holds any text position changes, in case they affect FindinFiles results
+    clSemanticHighlighter* m_semanticHighlighter;
     std::vector<wxMenuItem*> m_dynItems;
     std::vector<BPtoMarker> m_BPstoMarkers;
     static FindReplaceDialog* m_findReplaceDlg;
@@ -335,6 +339,7 @@ public:
     virtual const wxString& GetKeywordLocals() const { return m_keywordLocals; }
     virtual void SetKeywordClasses(const wxString& keywordClasses) { this->m_keywordClasses = keywordClasses; }
     virtual void SetKeywordLocals(const wxString& keywordLocals) { this->m_keywordLocals = keywordLocals; }
+    clSemanticHighlighter* GetSemanticHighlighter() { return m_semanticHighlighter; }
 
     /**
      * @brief split the current selection into multiple carets.
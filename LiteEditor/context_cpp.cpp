@@ -32,6 +32,7 @@
 #include "buildtabsettingsdata.h"
 #include "clEditorStateLocker.h"
 #include "clSelectSymbolDialog.h"
+#include "clSemanticHighlighter.h"
 #include "cl_command_event.h"
 #include "cl_editor.h"
 #include "cl_editor_tip_window.h"
@@ -1962,6 +1963,7 @@ void ContextCpp::ApplySettings()
     rCtrl.SetKeyWords(2, doxyKeyWords);
 
     DoApplySettings(lexPtr);
+    rCtrl.GetSemanticHighlighter()->ApplySettings();
 
     // create all images used by the cpp context
     if(!m_cppFileBmp.IsOk()) {
@@ -3069,12 +3071,20 @@ void ContextCpp::ColourContextTokens(const wxString& workspaceTokensStr, const w
     // Classes
     //------------------------------------------
     wxString flatStrClasses = cc_flags & CC_COLOUR_VARS ? workspaceTokensStr : "";
-    ctrl.SetKeyWords(1, flatStrClasses);
     ctrl.SetKeywordClasses(flatStrClasses);
 
     wxString flatStrLocals = cc_flags & CC_COLOUR_VARS ? localsTokensStr : "";
-    ctrl.SetKeyWords(3, flatStrLocals);
     ctrl.SetKeywordLocals(flatStrLocals);
+
+#if wxVERSION_NUMBER >= 3101
+    // The tokens are not passed to the lexer as keywords: this would restyle the entire document. Instead, only
+    // the visible lines are coloured (with indicators), and only when they are modified or the tokens changed
+    ctrl.GetSemanticHighlighter()->SetTokens(flatStrClasses, flatStrLocals);
+#else
+    // No text foreground indicators with this version of wxWidgets, let the lexer colour the tokens
+    ctrl.SetKeyWords(1, flatStrClasses);
+    ctrl.SetKeyWords(3, flatStrLocals);
+#endif
 }
 
 wxMenu* ContextCpp::GetMenu()
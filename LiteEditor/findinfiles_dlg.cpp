@@ -207,6 +207,14 @@ FindInFilesDialogBase::FindInFilesDialogBase(wxWindow* parent, wxWindowID id, co
 
     fgSizer3->Add(m_checkBoxSaveFilesBeforeSearching, 0, wxALL | wxEXPAND, WXC_FROM_DIP(5));
 
+    m_checkBoxUseTrigramIndex = new wxCheckBox(m_panelMainPanel, wxID_ANY, _("Use the trigram index"), wxDefaultPosition,
+                                               wxDLG_UNIT(m_panelMainPanel, wxSize(-1, -1)), 0);
+    m_checkBoxUseTrigramIndex->SetValue(false);
+    m_checkBoxUseTrigramIndex->SetToolTip(
+        _("Index the workspace files in the background and only scan the files that may contain the searched text"));
+
+    fgSizer3->Add(m_checkBoxUseTrigramIndex, 0, wxALL | wxEXPAND, WXC_FROM_DIP(5));
+
     SetName(wxT("FindInFilesDialogBase"));
     SetSize(wxDLG_UNIT(this, wxSize(-1, -1)));
     if(GetSizer()) { GetSizer()->Fit(this); }
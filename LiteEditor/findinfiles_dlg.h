@@ -65,6 +65,7 @@ protected:
     wxCheckBox* m_checkBoxPipeForGrep;
     wxCheckBox* m_regualrExpression;
     wxCheckBox* m_checkBoxSaveFilesBeforeSearching;
+    wxCheckBox* m_checkBoxUseTrigramIndex;
 
 protected:
     virtual void OnFind(wxCommandEvent& event) { event.Skip(); }
@@ -100,6 +101,7 @@ public:
     wxCheckBox* GetCheckBoxPipeForGrep() { return m_checkBoxPipeForGrep; }
     wxCheckBox* GetRegualrExpression() { return m_regualrExpression; }
     wxCheckBox* GetCheckBoxSaveFilesBeforeSearching() { return m_checkBoxSaveFilesBeforeSearching; }
+    wxCheckBox* GetCheckBoxUseTrigramIndex() { return m_checkBoxUseTrigramIndex; }
     wxPanel* GetPanelMainPanel() { return m_panelMainPanel; }
     FindInFilesDialogBase(wxWindow* parent, wxWindowID id = wxID_ANY, const wxString& title = _("Find In Files"), const wxPoint& pos = wxDefaultPosition, const wxSize& size = wxSize(-1,-1), long style = wxDEFAULT_DIALOG_STYLE|wxRESIZE_BORDER);
     virtual ~FindInFilesDialogBase();
@@ -74,6 +74,7 @@ FindInFilesDialog::FindInFilesDialog(wxWindow* parent, const wxString& dataName,
     m_regualrExpression->SetValue(m_data.GetFlags() & wxFRD_REGULAREXPRESSION);
     m_checkBoxSaveFilesBeforeSearching->SetValue(m_data.GetFlags() & wxFRD_SAVE_BEFORE_SEARCH);
     m_checkBoxPipeForGrep->SetValue(m_data.GetFlags() & wxFRD_ENABLE_PIPE_SUPPORT);
+    m_checkBoxUseTrigramIndex->SetValue(TrigramIndexHandler::IsEnabled());
     // Set encoding
     wxArrayString astrEncodings;
     wxFontEncoding fontEnc;
@@ -130,6 +131,7 @@ FindInFilesDialog::~FindInFilesDialog()
     }
 
     clConfig::Get().WriteItem(&m_data);
+    DoApplyTrigramIndexSetting();
     SessionManager::Get().UpdateFindInFilesMaskForCurrentWorkspace(m_data.GetSelectedMask());
 
     // Notify about the dialog dismissal
@@ -192,6 +194,7 @@ void FindInFilesDialog::DoSearchReplace()
     SearchData data = DoGetSearchData();
     data.SetOwner(clMainFrame::Get()->GetOutputPane()->GetReplaceResultsTab());
     DoSaveOpenFiles();
+    DoApplyTrigramIndexSetting();
     SearchThreadST::Get()->PerformSearch(data);
     EndModal(wxID_OK);
 }
@@ -203,6 +206,7 @@ void FindInFilesDialog::DoSearch()
 
     // check to see if we require to save the files
     DoSaveOpenFiles();
+    DoApplyTrigramIndexSetting();
     SearchThreadST::Get()->PerformSearch(data);
     EndModal(wxID_OK);
 }
@@ -422,6 +426,11 @@ void FindInFilesDialog::DoSaveOpenFiles()
     if(m_checkBoxSaveFilesBeforeSearching->IsChecked()) { clMainFrame::Get()->GetMainBook()->SaveAll(false, false); }
 }
 
+void FindInFilesDialog::DoApplyTrigramIndexSetting()
+{
+    clMainFrame::Get()->GetTrigramIndexHandler().SetEnabled(m_checkBoxUseTrigramIndex->IsChecked());
+}
+
 void FindInFilesDialog::OnFindWhatUI(wxUpdateUIEvent& event)
 {
     event.Enable(!m_findString->GetValue().IsEmpty() && !m_listPaths->IsEmpty());
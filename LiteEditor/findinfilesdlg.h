@@ -50,6 +50,7 @@ protected:
     void DoSaveSearchPaths();
     SearchData DoGetSearchData();
     void DoSaveOpenFiles();
+    void DoApplyTrigramIndexSetting();
     void DoSetFileMask();
     void DoAddProjectFiles(const wxString& projectName, wxArrayString& files);
     
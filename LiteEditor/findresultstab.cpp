@@ -168,25 +168,27 @@ void FindResultsTab::OnSearchMatch(wxCommandEvent& e)
     SearchResultList* res = (SearchResultList*)e.GetClientData();
     if(!res) return;
 
+    // Build the text of the whole batch and append it at once
+    wxString text;
+    std::vector<std::pair<int, int> > indicators; // line, offset in the line
+    std::vector<int> indicatorsLen;
+    int lineno = m_sci->GetLineCount() - 1;
+    SearchData* d = GetSearchData();
+
     SearchResultList::iterator iter = res->begin();
     for(; iter != res->end(); ++iter) {
         if(m_matchInfo.empty() || m_matchInfo.rbegin()->second.GetFileName() != iter->GetFileName()) {
-            if(!m_matchInfo.empty()) { AppendText("\n"); }
+            if(!m_matchInfo.empty()) {
+                text << "\n";
+                ++lineno;
+            }
             wxFileName fn(iter->GetFileName());
             fn.MakeRelativeTo();
-            AppendText(fn.GetFullPath() + wxT("\n"));
+            text << fn.GetFullPath() << "\n";
+            ++lineno;
         }
 
-        int lineno = m_sci->GetLineCount() - 1;
-        m_matchInfo.insert(std::make_pair(lineno, *iter));
-        wxString text = iter->GetPattern();
-        // int delta = -text.Length();
-        // text.Trim(false);
-        // delta += text.Length();
-        // text.Trim();
-
         wxString linenum = wxString::Format(wxT(" %5u: "), iter->GetLineNumber());
-        SearchData* d = GetSearchData();
         // Print the scope name
         if(d->GetDisplayScope()) {
             TagEntryPtr tag = TagsManagerST::Get()->FunctionFromFileLine(iter->GetFileName(), iter->GetLineNumber());
@@ -196,14 +198,21 @@ void FindResultsTab::OnSearchMatch(wxCommandEvent& e)
             linenum << wxT("[ ") << scopeName << wxT(" ] ");
             iter->SetScope(scopeName);
         }
+        m_matchInfo.insert(std::make_pair(lineno, *iter));
 
-        AppendText(linenum + text + wxT("\n"));
-        int indicatorStartPos = m_sci->PositionFromLine(lineno) + iter->GetColumn() + linenum.Length();
-        int indicatorLen = iter->GetLen();
-        m_indicators.push_back(indicatorStartPos);
-        m_sci->IndicatorFillRange(indicatorStartPos, indicatorLen);
+        text << linenum << iter->GetPattern() << "\n";
+        indicators.push_back(std::make_pair(lineno, iter->GetColumn() + (int)linenum.Length()));
+        indicatorsLen.push_back(iter->GetLen());
+        ++lineno;
     }
     wxDELETE(res);
+
+    AppendText(text);
+    for(size_t i = 0; i < indicators.size(); ++i) {
+        int indicatorStartPos = m_sci->PositionFromLine(indicators[i].first) + indicators[i].second;
+        m_indicators.push_back(indicatorStartPos);
+        m_sci->IndicatorFillRange(indicatorStartPos, indicatorsLen[i]);
+    }
 }
 
 void FindResultsTab::OnSearchEnded(wxCommandEvent& e)
@@ -36,6 +36,7 @@
 #include "clBootstrapWizard.h"
 #include "clCustomiseToolBarDlg.h"
 #include "clEditorBar.h"
+#include "clFuzzySearchService.h"
 #include "clGotoAnythingManager.h"
 #include "clMainFrameHelper.h"
 #include "clSingleChoiceDialog.h"
@@ -818,6 +819,9 @@ clMainFrame::clMainFrame(wxWindow* pParent, wxWindowID id, const wxString& title
     // Start the code completion manager, we do this by calling it once
     CodeCompletionManager::Get();
 
+    // Start the fuzzy search service, it indexes the workspace files for "Open Resource"
+    clFuzzySearchService::Get();
+
     // Register keyboard shortcuts
     clKeyboardManager::Get()->AddGlobalAccelerator("selection_to_multi_caret", "Ctrl-Shift-L",
                                                    _("Edit::Split selection into multiple carets"));
@@ -852,6 +856,7 @@ clMainFrame::~clMainFrame(void)
 
     // Free the code completion manager
     CodeCompletionManager::Release();
+    clFuzzySearchService::Release();
 
 // this will make sure that the main menu bar's member m_widget is freed before the we enter wxMenuBar destructor
 // see this wxWidgets bug report for more details:
@@ -1183,6 +1188,7 @@ void clMainFrame::CreateGUIControls()
 
     // Update the parser thread search paths
     ParseThreadST::Get()->SetCrawlerEnabeld(m_tagsOptionsData.GetParserEnabled());
+    ParseThreadST::Get()->SetParserThreadsCount(m_tagsOptionsData.GetParserThreads());
     ParseThreadST::Get()->SetSearchPaths(m_tagsOptionsData.GetParserSearchPaths(),
                                          m_tagsOptionsData.GetParserExcludePaths());
 
@@ -4441,6 +4447,7 @@ void clMainFrame::UpdateTagsOptions(const TagsOptionsData& tod)
     ccConfig.WriteItem(&m_tagsOptionsData);
 
     ParseThreadST::Get()->SetSearchPaths(tod.GetParserSearchPaths(), tod.GetParserExcludePaths());
+    ParseThreadST::Get()->SetParserThreadsCount(tod.GetParserThreads());
 }
 
 void clMainFrame::OnCheckForUpdate(wxCommandEvent& e)
@@ -42,6 +42,7 @@
 #include "parse_thread.h"
 #include "tags_options_dlg.h"
 #include "theme_handler.h"
+#include "trigram_index_handler.h"
 #include "wx/aui/aui.h"
 #include "wx/choice.h"
 #include "wx/combobox.h"
@@ -113,6 +114,7 @@ class clMainFrame : public wxFrame
     MyMenuBar* m_myMenuBar;
     wxMenu* m_bookmarksDropDownMenu;
     ThemeHandler m_themeHandler;
+    TrigramIndexHandler m_trigramIndexHandler;
     bool m_noSavePerspectivePrompt;
 
 #ifndef __WXMSW__
@@ -235,6 +237,8 @@ public:
 
     MainBook* GetMainBook() const { return m_mainBook; }
 
+    TrigramIndexHandler& GetTrigramIndexHandler() { return m_trigramIndexHandler; }
+
     /**
      * @return the output pane (the bottom pane)
      */
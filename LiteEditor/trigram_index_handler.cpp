@@ -0,0 +1,223 @@
+#include "cl_config.h"
+#include "codelite_events.h"
+#include "event_notifier.h"
+#include "file_logger.h"
+#include "ieditor.h"
+#include "search_thread.h"
+#include "trigram_index_handler.h"
+#include "workspace.h"
+#include <wx/msgqueue.h>
+#include <wx/stopwatch.h>
+#include <wx/thread.h>
+
+/**
+ * @class TrigramIndexThread
+ * @brief brings the index up to date with the workspace files, then indexes the files it is asked to
+ */
+class TrigramIndexThread : public wxThread
+{
+    clTrigramIndex::Ptr_t m_index;
+    wxArrayString m_files;
+    wxMessageQueue<wxString> m_queue;
+
+public:
+    TrigramIndexThread(clTrigramIndex::Ptr_t index, const wxArrayString& files)
+        : wxThread(wxTHREAD_JOINABLE)
+        , m_index(index)
+    {
+        // make a deep copy, these strings are used by the thread
+        m_files.reserve(files.size());
+        for(size_t i = 0; i < files.size(); ++i) {
+            m_files.Add(files.Item(i).c_str());
+        }
+    }
+    virtual ~TrigramIndexThread() {}
+
+    bool Start()
+    {
+        if(Create() != wxTHREAD_NO_ERROR) { return false; }
+        SetPriority(wxPRIORITY_MIN);
+        return Run() == wxTHREAD_NO_ERROR;
+    }
+
+    void Stop()
+    {
+        if(IsAlive()) {
+            Delete(NULL, wxTHREAD_WAIT_BLOCK);
+        } else {
+            Wait(wxTHREAD_WAIT_BLOCK);
+        }
+    }
+
+    void UpdateFile(const wxString& filename) { m_queue.Post(filename.c_str()); }
+
+protected:
+    virtual void* Entry()
+    {
+        wxStopWatch sw;
+        m_index->Load();
+
+        size_t count(0);
+        for(size_t i = 0; i < m_files.size(); ++i) {
+            if(TestDestroy()) { return NULL; }
+            if(!m_index->IsUpToDate(m_files.Item(i))) {
+                m_index->Update(m_files.Item(i));
+                ++count;
+            }
+        }
+        m_index->Save();
+        clDEBUG() << "Trigram index:" << count << "out of" << m_files.size() << "files were indexed in" << sw.Time()
+                  << "ms" << clEndl;
+
+        while(!TestDestroy()) {
+            wxString filename;
+            if(m_queue.ReceiveTimeout(100, filename) == wxMSGQUEUE_NO_ERROR) { m_index->Update(filename); }
+        }
+        return NULL;
+    }
+};
+
+TrigramIndexHandler::TrigramIndexHandler()
+    : m_thread(NULL)
+{
+    m_watcher.SetOwner(this);
+    Bind(wxEVT_FILE_MODIFIED, &TrigramIndexHandler::OnFileModified, this);
+    Bind(wxEVT_FILE_NOT_FOUND, &TrigramIndexHandler::OnFileNotFound, this);
+    EventNotifier::Get()->Bind(wxEVT_WORKSPACE_LOADED, &TrigramIndexHandler::OnWorkspaceLoaded, this);
+    EventNotifier::Get()->Bind(wxEVT_WORKSPACE_CLOSED, &TrigramIndexHandler::OnWorkspaceClosed, this);
+    EventNotifier::Get()->Bind(wxEVT_FILE_SAVED, &TrigramIndexHandler::OnFileSaved, this);
+    EventNotifier::Get()->Bind(wxEVT_FILE_LOADED, &TrigramIndexHandler::OnFileLoaded, this);
+    EventNotifier::Get()->Bind(wxEVT_EDITOR_CLOSING, &TrigramIndexHandler::OnEditorClosing, this);
+    EventNotifier::Get()->Bind(wxEVT_FILE_DELETED, &TrigramIndexHandler::OnFileDeleted, this);
+    EventNotifier::Get()->Bind(wxEVT_FILE_RENAMED, &TrigramIndexHandler::OnFileRenamed, this);
+}
+
+TrigramIndexHandler::~TrigramIndexHandler()
+{
+    DoStop();
+    Unbind(wxEVT_FILE_MODIFIED, &TrigramIndexHandler::OnFileModified, this);
+    Unbind(wxEVT_FILE_NOT_FOUND, &TrigramIndexHandler::OnFileNotFound, this);
+    EventNotifier::Get()->Unbind(wxEVT_WORKSPACE_LOADED, &TrigramIndexHandler::OnWorkspaceLoaded, this);
+    EventNotifier::Get()->Unbind(wxEVT_WORKSPACE_CLOSED, &TrigramIndexHandler::OnWorkspaceClosed, this);
+    EventNotifier::Get()->Unbind(wxEVT_FILE_SAVED, &TrigramIndexHandler::OnFileSaved, this);
+    EventNotifier::Get()->Unbind(wxEVT_FILE_LOADED, &TrigramIndexHandler::OnFileLoaded, this);
+    EventNotifier::Get()->Unbind(wxEVT_EDITOR_CLOSING, &TrigramIndexHandler::OnEditorClosing, this);
+    EventNotifier::Get()->Unbind(wxEVT_FILE_DELETED, &TrigramIndexHandler::OnFileDeleted, this);
+    EventNotifier::Get()->Unbind(wxEVT_FILE_RENAMED, &TrigramIndexHandler::OnFileRenamed, this);
+}
+
+bool TrigramIndexHandler::IsEnabled() { return clConfig::Get().Read("FindInFiles/UseTrigramIndex", false); }
+
+void TrigramIndexHandler::SetEnabled(bool enabled)
+{
+    if(enabled == IsEnabled()) { return; }
+    clConfig::Get().Write("FindInFiles/UseTrigramIndex", enabled);
+    if(enabled) {
+        DoStart();
+    } else {
+        DoStop();
+    }
+}
+
+void TrigramIndexHandler::DoStart()
+{
+    DoStop();
+    if(!IsEnabled() || !clCxxWorkspaceST::Get()->IsOpen()) { return; }
+
+    // Keep the index next to the tags database
+    wxFileName indexFile = clCxxWorkspaceST::Get()->GetTagsFileName();
+    indexFile.SetExt("trigrams");
+    m_index.reset(new clTrigramIndex(indexFile));
+
+    wxArrayString files;
+    clCxxWorkspaceST::Get()->GetWorkspaceFiles(files);
+    m_thread = new TrigramIndexThread(m_index, files);
+    if(!m_thread->Start()) {
+        // Without the thread the index is never brought up to date, keep scanning all the files
+        clWARNING() << "Trigram index: could not start the indexer thread, the index is disabled" << clEndl;
+        wxDELETE(m_thread);
+        m_index.reset(NULL);
+        return;
+    }
+
+    // Files that are not indexed yet are searched as usual, so the index can be used right away
+    SearchThreadST::Get()->SetTrigramIndex(m_index);
+    m_watcher.Start();
+}
+
+void TrigramIndexHandler::DoStop()
+{
+    m_watcher.Clear();
+    if(m_index) { SearchThreadST::Get()->SetTrigramIndex(clTrigramIndex::Ptr_t(NULL)); }
+    if(m_thread) {
+        m_thread->Stop();
+        wxDELETE(m_thread);
+    }
+
+    if(m_index) {
+        m_index->Save();
+        m_index.reset(NULL);
+    }
+}
+
+void TrigramIndexHandler::DoUpdateFile(const wxString& filename)
+{
+    if(m_thread) { m_thread->UpdateFile(filename); }
+}
+
+void TrigramIndexHandler::OnWorkspaceLoaded(wxCommandEvent& e)
+{
+    e.Skip();
+    DoStart();
+}
+
+void TrigramIndexHandler::OnWorkspaceClosed(wxCommandEvent& e)
+{
+    e.Skip();
+    DoStop();
+}
+
+void TrigramIndexHandler::OnFileSaved(clCommandEvent& e)
+{
+    e.Skip();
+    DoUpdateFile(e.GetFileName());
+}
+
+void TrigramIndexHandler::OnFileLoaded(clCommandEvent& e)
+{
+    e.Skip();
+    // Watch the opened files, they are the ones most likely to be modified by external tools
+    if(m_index) { m_watcher.AddFile(e.GetFileName()); }
+}
+
+void TrigramIndexHandler::OnEditorClosing(wxCommandEvent& e)
+{
+    e.Skip();
+    IEditor* editor = reinterpret_cast<IEditor*>(e.GetClientData());
+    if(editor) { m_watcher.RemoveFile(editor->GetFileName()); }
+}
+
+void TrigramIndexHandler::OnFileModified(clFileSystemEvent& e)
+{
+    e.Skip();
+    DoUpdateFile(e.GetPath());
+}
+
+void TrigramIndexHandler::OnFileNotFound(clFileSystemEvent& e)
+{
+    e.Skip();
+    if(m_index) { m_index->Remove(e.GetPath()); }
+}
+
+void TrigramIndexHandler::OnFileDeleted(clFileSystemEvent& e)
+{
+    e.Skip();
+    if(m_index) { m_index->Remove(e.GetPath()); }
+}
+
+void TrigramIndexHandler::OnFileRenamed(clFileSystemEvent& e)
+{
+    e.Skip();
+    if(m_index) { m_index->Remove(e.GetPath()); }
+    DoUpdateFile(e.GetNewpath());
+}
@@ -0,0 +1,54 @@
+#ifndef TRIGRAMINDEXHANDLER_H
+#define TRIGRAMINDEXHANDLER_H
+
+#include "clFileSystemWatcher.h"
+#include "clTrigramIndex.h"
+#include "cl_command_event.h"
+#include <wx/event.h> // Base class: wxEvtHandler
+
+class TrigramIndexThread;
+
+/**
+ * @class TrigramIndexHandler
+ * @brief maintains the Find In Files trigram index of the workspace files. The index is stored next to the
+ * workspace tags database and is built in the background when the workspace is loaded. It is then kept up
+ * to date when files are saved, modified outside of CodeLite (for files opened in the editor) or deleted.
+ * The index is disabled by default, it is enabled from the Find In Files dialog
+ */
+class TrigramIndexHandler : public wxEvtHandler
+{
+    clTrigramIndex::Ptr_t m_index;
+    TrigramIndexThread* m_thread;
+    clFileSystemWatcher m_watcher;
+
+protected:
+    void OnWorkspaceLoaded(wxCommandEvent& e);
+    void OnWorkspaceClosed(wxCommandEvent& e);
+    void OnFileSaved(clCommandEvent& e);
+    void OnFileLoaded(clCommandEvent& e);
+    void OnEditorClosing(wxCommandEvent& e);
+    void OnFileModified(clFileSystemEvent& e);
+    void OnFileNotFound(clFileSystemEvent& e);
+    void OnFileDeleted(clFileSystemEvent& e);
+    void OnFileRenamed(clFileSystemEvent& e);
+
+    void DoStart();
+    void DoStop();
+    void DoUpdateFile(const wxString& filename);
+
+public:
+    TrigramIndexHandler();
+    virtual ~TrigramIndexHandler();
+
+    /**
+     * @brief is the trigram index enabled?
+     */
+    static bool IsEnabled();
+
+    /**
+     * @brief enable or disable the index and store the setting. Enabling it indexes the workspace files
+     */
+    void SetEnabled(bool enabled);
+};
+
+#endif // TRIGRAMINDEXHANDLER_H
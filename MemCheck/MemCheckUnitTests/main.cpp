@@ -0,0 +1,169 @@
+#include "imemcheckprocessor.h"
+#include "tester.h"
+#include "valgrindlogparser.h"
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <wx/init.h>
+#include <wx/log.h>
+
+static const char VALGRIND_LOG[] =
+    "<?xml version=\"1.0\"?>\n"
+    "<valgrindoutput>\n"
+    "<protocolversion>4</protocolversion>\n"
+    "<!-- a comment -->\n"
+    "<error>\n"
+    "  <unique>0x0</unique>\n"
+    "  <kind>InvalidRead</kind>\n"
+    "  <what>Invalid read of size 4</what>\n"
+    "  <stack>\n"
+    "    <frame><ip>0x400</ip><obj>/tmp/test</obj><fn>std::vector&lt;int&gt;::at(unsigned long)</fn>"
+    "<dir>/tmp/src</dir><file>main.cpp</file><line>10</line></frame>\n"
+    "    <frame><ip>0x500</ip><obj>/tmp/test</obj><fn>main</fn></frame>\n"
+    "  </stack>\n"
+    "  <auxwhat>Address 0x0 is not stack'd</auxwhat>\n"
+    "  <stack>\n"
+    "    <frame><ip>0x600</ip><fn>free</fn></frame>\n"
+    "  </stack>\n"
+    "  <suppression><sname>insert_a_suppression_name_here</sname>"
+    "<rawtext><![CDATA[{\n   <insert_a_suppression_name_here>\n   Memcheck:Addr4\n}]]></rawtext></suppression>\n"
+    "</error>\n"
+    "<error>\n"
+    "  <unique>0x1</unique>\n"
+    "  <kind>Leak_DefinitelyLost</kind>\n"
+    "  <xwhat><text>8 bytes in 1 blocks are definitely lost</text><leakedbytes>8</leakedbytes></xwhat>\n"
+    "  <stack>\n"
+    "    <frame><ip>0x700</ip><fn>operator new(unsigned long)</fn></frame>\n"
+    "  </stack>\n"
+    "</error>\n"
+    "<errorcounts/>\n"
+    "</valgrindoutput>\n";
+
+static wxString MemCheckErrorsToString(const ErrorList& errors)
+{
+    wxString str;
+    for(ErrorList::const_iterator it = errors.begin(); it != errors.end(); ++it) {
+        str << it->toString() << "\n" << it->suppression << "\n";
+    }
+    return str;
+}
+
+/**
+ * @brief a processor that only exposes the errors list, to test how errors are added to it
+ */
+class MemCheckTestProcessor : public IMemCheckProcessor
+{
+public:
+    MemCheckTestProcessor()
+        : IMemCheckProcessor(NULL)
+    {
+    }
+    virtual ~MemCheckTestProcessor() {}
+
+    using IMemCheckProcessor::AddErrors;
+    using IMemCheckProcessor::ClearErrors;
+
+    virtual wxArrayString GetSuppressionFiles() { return wxArrayString(); }
+    virtual void GetExecutionCommand(const wxString& originalCommand, wxString& command, wxString& command_args) {}
+    virtual void StartProcessing(const wxString& outputLogFileName, bool follow) {}
+    virtual void FinishProcessing() {}
+    virtual void StopProcessing() {}
+    virtual bool IsProcessing() const { return false; }
+};
+
+TEST_FUNC(testValgrindLogParser)
+{
+    ValgrindLogParser parser;
+    ErrorList errors;
+    parser.Feed(VALGRIND_LOG, strlen(VALGRIND_LOG), errors);
+    CHECK_CONDITION(parser.IsValgrindOutput(), "expected a Valgrind log");
+    CHECK_CONDITION(parser.IsComplete(), "expected a complete log");
+    CHECK_SIZE(errors.size(), 2);
+
+    const MemCheckError& invalidRead = errors.front();
+    CHECK_STRING(invalidRead.label.mb_str(wxConvUTF8).data(), "Invalid read of size 4");
+    CHECK_SIZE(invalidRead.locations.size(), 2);
+    CHECK_STRING(invalidRead.locations.front().func.mb_str(wxConvUTF8).data(),
+                 "std::vector<int>::at(unsigned long)");
+    CHECK_STRING(invalidRead.locations.front().file.mb_str(wxConvUTF8).data(), "/tmp/src/main.cpp");
+    CHECK_SIZE(invalidRead.locations.front().line, 10);
+    CHECK_SIZE(invalidRead.nestedErrors.size(), 1);
+    CHECK_STRING(invalidRead.nestedErrors.front().label.mb_str(wxConvUTF8).data(), "Address 0x0 is not stack'd");
+    CHECK_SIZE(invalidRead.nestedErrors.front().locations.size(), 1);
+    CHECK_CONDITION(invalidRead.suppression.Contains("Memcheck:Addr4"), "expected the suppression of the error");
+
+    const MemCheckError& leak = errors.back();
+    CHECK_STRING(leak.label.mb_str(wxConvUTF8).data(), "8 bytes in 1 blocks are definitely lost");
+    CHECK_SIZE(leak.nestedErrors.size(), 0);
+
+    // The log is read while Valgrind writes it, so it may be split anywhere, even inside a tag or an entity
+    wxString expected = MemCheckErrorsToString(errors);
+    size_t length = strlen(VALGRIND_LOG);
+    for(size_t chunk = 1; chunk < length; ++chunk) {
+        ValgrindLogParser chunksParser;
+        ErrorList chunksErrors;
+        for(size_t pos = 0; pos < length; pos += chunk) {
+            chunksParser.Feed(VALGRIND_LOG + pos, std::min(chunk, length - pos), chunksErrors);
+        }
+        CHECK_CONDITION(chunksParser.IsComplete(), "expected a complete log when it is split");
+        CHECK_CONDITION(MemCheckErrorsToString(chunksErrors) == expected,
+                        "expected the same errors when it is split");
+    }
+
+    // A log cut inside the second error is not complete
+    parser.Reset();
+    errors.clear();
+    parser.Feed(VALGRIND_LOG, strstr(VALGRIND_LOG, "<unique>0x1") - VALGRIND_LOG, errors);
+    CHECK_CONDITION(parser.IsValgrindOutput(), "expected a Valgrind log");
+    CHECK_CONDITION(!parser.IsComplete(), "expected an incomplete log");
+    CHECK_SIZE(errors.size(), 1);
+    return true;
+}
+
+TEST_FUNC(testMemCheckDuplicateErrors)
+{
+    ValgrindLogParser parser;
+    ErrorList errors;
+    parser.Feed(VALGRIND_LOG, strlen(VALGRIND_LOG), errors);
+    CHECK_SIZE(errors.size(), 2);
+
+    MemCheckTestProcessor processor;
+    CHECK_SIZE(processor.AddErrors(errors), 2);
+
+    // The same errors are counted, a different one is added
+    MemCheckError other = errors.back();
+    other.locations.front().line = 20;
+    errors.push_back(other);
+    CHECK_SIZE(processor.AddErrors(errors), 1);
+
+    ErrorList& added = processor.GetErrors();
+    CHECK_SIZE(added.size(), 3);
+    ErrorList::const_iterator it = added.begin();
+    CHECK_SIZE(it->count, 2);
+    ++it;
+    CHECK_SIZE(it->count, 2);
+    ++it;
+    CHECK_SIZE(it->count, 1);
+
+    // The suppression is not part of the error
+    errors.clear();
+    errors.push_back(added.front());
+    errors.back().suppression = "another suppression";
+    errors.back().count = 3;
+    CHECK_SIZE(processor.AddErrors(errors), 0);
+    CHECK_SIZE(added.front().count, 5);
+
+    processor.ClearErrors();
+    CHECK_SIZE(processor.GetErrors().size(), 0);
+    CHECK_SIZE(processor.AddErrors(errors), 1);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    wxInitializer initializer(argc, argv);
+    wxLogNull NOLOG;
+    Tester::Instance()->RunTests();
+    Tester::Release();
+    return 0;
+}
@@ -0,0 +1,54 @@
+/**
+ * @file
+ * @copyright GNU General Public License v2
+ */
+
+#include "wxStringHash.h"
+
+#include "imemcheckprocessor.h"
+
+wxDEFINE_EVENT(wxEVT_MEMCHECK_ERRORS_ADDED, wxCommandEvent);
+wxDEFINE_EVENT(wxEVT_MEMCHECK_PROCESSING_DONE, wxCommandEvent);
+
+/**
+ * @brief hash of everything MemCheckError::operator== compares
+ */
+static size_t GetErrorHash(const MemCheckError& error)
+{
+    std::hash<wxString> hashString;
+    size_t hash = hashString(error.label) ^ error.type;
+    for(LocationList::const_iterator it = error.locations.begin(); it != error.locations.end(); ++it)
+        hash = hash * 31 + (hashString(it->func) ^ hashString(it->file) ^ (size_t)it->line);
+    for(ErrorList::const_iterator it = error.nestedErrors.begin(); it != error.nestedErrors.end(); ++it)
+        hash = hash * 31 + GetErrorHash(*it);
+    return hash;
+}
+
+size_t IMemCheckProcessor::AddErrors(const ErrorList& errors)
+{
+    size_t added = 0;
+    for(ErrorList::const_iterator it = errors.begin(); it != errors.end(); ++it) {
+        size_t hash = GetErrorHash(*it);
+        MemCheckError* same = NULL;
+        std::pair<std::unordered_multimap<size_t, MemCheckError*>::iterator,
+                  std::unordered_multimap<size_t, MemCheckError*>::iterator> range = m_errorIndex.equal_range(hash);
+        for(; range.first != range.second && !same; ++range.first)
+            if(*range.first->second == *it) same = range.first->second;
+
+        if(same) {
+            same->count += it->count;
+        } else {
+            // list items never move, so the pointer stays valid until the list is cleared
+            m_errorList.push_back(*it);
+            m_errorIndex.insert(std::make_pair(hash, &m_errorList.back()));
+            ++added;
+        }
+    }
+    return added;
+}
+
+void IMemCheckProcessor::ClearErrors()
+{
+    m_errorIndex.clear();
+    m_errorList.clear();
+}
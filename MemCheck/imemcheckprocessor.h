@@ -35,18 +35,28 @@
 #ifndef _IMEMCHECKPROCESSOR_H_
 #define _IMEMCHECKPROCESSOR_H_
 
+#include <unordered_map>
+#include <wx/event.h>
+
 #include "memcheckerror.h"
 
 class MemCheckSettings;
 
+/// Sent by processor when errors were added to ErrorList (or counts of errors already there increased)
+wxDECLARE_EVENT(wxEVT_MEMCHECK_ERRORS_ADDED, wxCommandEvent);
+/// Sent by processor when processing ends, GetInt() is 1 if the log was processed successfully
+wxDECLARE_EVENT(wxEVT_MEMCHECK_PROCESSING_DONE, wxCommandEvent);
+
 /**
  * @brief Interface for any future error processor - parser.
  *
  * Main goal is to fetch error log from extern analyzer tool to internaly used structure - ErrorList.
  * Plugin creates right type of processor acording to settings.
  * At this time internal data storage for error is property of processor.
+ *
+ * Same errors reported more than once are stored only once, MemCheckError::count says how many times it was reported.
  */
-class IMemCheckProcessor
+class IMemCheckProcessor : public wxEvtHandler
 {
 public:
     /**
@@ -64,10 +74,23 @@ protected:
     MemCheckSettings* m_settings;
     wxString m_outputLogFileName;
     ErrorList m_errorList;
+    std::unordered_multimap<size_t, MemCheckError*> m_errorIndex; ///< errors in m_errorList by their hash
+
+    /**
+     * @brief Appends errors to ErrorList. If same error is already there, only its count is increased.
+     * @param errors new errors
+     * @return number of errors appended
+     */
+    size_t AddErrors(const ErrorList& errors);
+
+    /**
+     * @brief Clears ErrorList
+     */
+    void ClearErrors();
 
 public:
     /**
-     * @brief method "Process" parses external tool output and stores in errorList structure
+     * @brief StartProcessing() parses external tool output and stores in errorList structure
      * @return reference to errorList
      */
     virtual ErrorList& GetErrors() { return m_errorList; };
@@ -90,9 +113,30 @@ public:
     virtual void GetExecutionCommand(const wxString& originalCommand, wxString& command, wxString& command_args) = 0;
 
     /**
-     * @brief Processes data from external tool (log file) to ErrorList.
+     * @brief Processes data from external tool (log file) to ErrorList in background.
+     * @param outputLogFileName log file, if empty the one from GetExecutionCommand() is used
+     * @param follow true if the tool is still writing the log, processing then waits for new data until
+     * FinishProcessing() is called
+     *
+     * ErrorList is cleared. Errors are added to ErrorList as they are parsed and wxEVT_MEMCHECK_ERRORS_ADDED is sent,
+     * wxEVT_MEMCHECK_PROCESSING_DONE is sent at the end.
+     */
+    virtual void StartProcessing(const wxString& outputLogFileName = wxEmptyString, bool follow = false) = 0;
+
+    /**
+     * @brief The tool exited, processing ends at the end of the log.
+     */
+    virtual void FinishProcessing() = 0;
+
+    /**
+     * @brief Stops processing without sending wxEVT_MEMCHECK_PROCESSING_DONE. Errors processed so far are kept.
+     */
+    virtual void StopProcessing() = 0;
+
+    /**
+     * @return true if the log is being processed in background
      */
-    virtual bool Process(const wxString& outputLogFileName = wxEmptyString) = 0;
+    virtual bool IsProcessing() const = 0;
 };
 
 #endif //_IMEMCHECKPROCESSOR_H_
@@ -5,7 +5,6 @@
  * @copyright GNU General Public License v2
  */
 
-#include <wx/busyinfo.h>
 #include <wx/filedlg.h>
 
 #include "async_executable_cmd.h"
@@ -250,7 +249,8 @@ void MemCheckPlugin::OnWorkspaceClosed(wxCommandEvent& event)
 
 bool MemCheckPlugin::IsReady(wxUpdateUIEvent& event)
 {
-    bool ready = !m_mgr->IsBuildInProgress() && !m_terminal.IsRunning();
+    bool ready = !m_mgr->IsBuildInProgress() && !m_terminal.IsRunning() &&
+                 !(m_memcheckProcessor && m_memcheckProcessor->IsProcessing());
     int id = event.GetId();
     if(id == XRCID("memcheck_check_active_project")) {
         ready &= !m_mgr->GetWorkspace()->GetActiveProjectName().IsEmpty();
@@ -262,6 +262,8 @@ void MemCheckPlugin::ApplySettings(bool loadLastErrors)
 {
     wxDELETE(m_memcheckProcessor);
     m_memcheckProcessor = new ValgrindMemcheckProcessor(GetSettings());
+    m_memcheckProcessor->Bind(wxEVT_MEMCHECK_ERRORS_ADDED, &MemCheckPlugin::OnErrorsAdded, this);
+    m_memcheckProcessor->Bind(wxEVT_MEMCHECK_PROCESSING_DONE, &MemCheckPlugin::OnProcessingDone, this);
     if(loadLastErrors) {
         m_outputView->LoadErrors();
 
@@ -328,7 +330,13 @@ void MemCheckPlugin::CheckProject(const wxString& projectName)
     m_memcheckProcessor->GetExecutionCommand(command, cmd, cmdArgs);
     m_mgr->AppendOutputTabText(kOutputTab_Output, wxString()
                                                       << "MemCheck command: " << command << " " << cmdArgs << "\n");
-    m_terminal.ExecuteConsole(cmd, true, cmdArgs, "", wxString::Format("MemCheck: %s", projectName));
+
+    // errors are shown as Valgrind reports them
+    m_memcheckProcessor->StartProcessing(wxEmptyString, true);
+    m_outputView->LoadErrors();
+    if(!m_terminal.ExecuteConsole(cmd, true, cmdArgs, "", wxString::Format("MemCheck: %s", projectName))) {
+        m_memcheckProcessor->StopProcessing();
+    }
 }
 
 void MemCheckPlugin::OnImportLog(wxCommandEvent& event)
@@ -339,13 +347,7 @@ void MemCheckPlugin::OnImportLog(wxCommandEvent& event)
                                 "xml files (*.xml)|*.xml|all files (*.*)|*.*", wxFD_OPEN | wxFD_FILE_MUST_EXIST);
     if(openFileDialog.ShowModal() == wxID_CANCEL) return;
 
-    wxWindowDisabler disableAll;
-    wxBusyInfo wait(wxT(BUSY_MESSAGE));
-    m_mgr->GetTheApp()->Yield();
-
-    if(!m_memcheckProcessor->Process(openFileDialog.GetPath()))
-        wxMessageBox(wxT("Output log file cannot be properly loaded."), wxT("Processing error."), wxICON_ERROR);
-
+    m_memcheckProcessor->StartProcessing(openFileDialog.GetPath());
     m_outputView->LoadErrors();
     SwitchToMyPage();
 }
@@ -376,12 +378,18 @@ void MemCheckPlugin::OnProcessOutput(clCommandEvent& event)
 void MemCheckPlugin::OnProcessTerminated(clCommandEvent& event)
 {
     m_mgr->AppendOutputTabText(kOutputTab_Output, _("\n-- MemCheck process completed\n"));
-    wxWindowDisabler disableAll;
-    wxBusyInfo wait(wxT(BUSY_MESSAGE));
-    m_mgr->GetTheApp()->Yield();
+    // the rest of the log is processed in background, see OnProcessingDone()
+    m_memcheckProcessor->FinishProcessing();
+}
 
-    m_memcheckProcessor->Process();
-    m_outputView->LoadErrors();
+void MemCheckPlugin::OnErrorsAdded(wxCommandEvent& event) { m_outputView->UpdateErrors(false); }
+
+void MemCheckPlugin::OnProcessingDone(wxCommandEvent& event)
+{
+    if(!event.GetInt())
+        wxMessageBox(wxT("Output log file cannot be properly loaded."), wxT("Processing error."), wxICON_ERROR);
+
+    m_outputView->UpdateErrors(true);
     SwitchToMyPage();
 }
 
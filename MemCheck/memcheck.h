@@ -151,6 +151,18 @@ protected:
     void OnProcessOutput(clCommandEvent& event);
     void OnProcessTerminated(clCommandEvent& event);
 
+    /**
+     * @brief Processor parsed more errors from the log, they are shown while processing goes on.
+     * @param event
+     */
+    void OnErrorsAdded(wxCommandEvent& event);
+
+    /**
+     * @brief Processor reached end of the log.
+     * @param event
+     */
+    void OnProcessingDone(wxCommandEvent& event);
+
     /**
      * @brief Analyse can be made independent of CodeLite and log can be load from file.
      * @param event
@@ -41,5 +41,9 @@
 #define FILTER_NONWORKSPACE_PLACEHOLDER "<nonworkspace_errors>"
 #define WAIT_UPDATE_PER_ITEMS 1000
 #define ITEMS_FOR_WAIT_DIALOG 5000
+#define LOG_READ_SIZE (1024 * 1024)  ///< bytes of log parsed at once
+#define LOG_POLL_INTERVAL 250        ///< ms to wait for new data while the log is written
+#define LOG_BATCH_SIZE 1000          ///< errors parsed in background are passed to GUI in batches of this size...
+#define LOG_BATCH_INTERVAL 500       ///< ...or after this time (ms)
 
 #endif
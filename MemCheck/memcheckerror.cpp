@@ -56,7 +56,18 @@ const bool MemCheckErrorLocation::isOutOfWorkspace(const wxString & workspacePat
 
 
 
-MemCheckError::MemCheckError(): suppressed(false) {}
+MemCheckError::MemCheckError(): suppressed(false), count(1) {}
+
+bool MemCheckError::operator==(const MemCheckError & other) const
+{
+    return type == other.type && label == other.label && locations == other.locations
+           && nestedErrors == other.nestedErrors;
+}
+
+bool MemCheckError::operator!=(const MemCheckError & other) const
+{
+    return !(*this == other);
+}
 
 const wxString MemCheckError::toString() const
 {
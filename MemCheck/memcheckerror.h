@@ -144,6 +144,13 @@ struct MemCheckError {
     enum Type { TYPE_ERROR, TYPE_AUXILIARY };
     MemCheckError();
     
+    /**
+     * @brief Errors are same if they have same type, label, stack trace and nested errors.
+     *
+     * Suppression and state are not compared.
+     */
+    bool operator==(const MemCheckError & other) const;
+    bool operator!=(const MemCheckError & other) const;
     
     /**
      * @brief Returns all atributed and atributes of all locations and all atributes from nested errors concatenated to tab separated string.
@@ -178,6 +185,7 @@ struct MemCheckError {
 
     Type type;
     bool suppressed;
+    unsigned int count; ///< how many times was the same error reported in the log
     wxString label;
     wxString suppression;
     LocationList locations;
@@ -8,6 +8,7 @@
 #include <wx/stc/stc.h>
 #include <wx/busyinfo.h>
 #include <wx/clipbrd.h>
+#include <wx/scopedptr.h>
 
 #include "event_notifier.h"
 #include "workspace.h"
@@ -85,6 +86,60 @@ void MemCheckOutputView::LoadErrors()
     ApplyFilterSupp(FILTER_CLEAR);
 }
 
+void MemCheckOutputView::UpdateErrors(bool done)
+{
+    // current page is not full yet (or there was no page)
+    bool reload = done || m_currentPage == 0 ||
+                  m_totalErrorsView < m_currentPage * m_plugin->GetSettings()->GetResultPageSize();
+
+    // errors panel
+    ResetItemsView();
+    if(reload)
+        ShowPageView(m_currentPage, false);
+    else
+        UpdatePageCounts(); // duplicates of the errors shown may have been merged
+
+    // supp panel
+    if(done) {
+        ResetItemsSupp();
+        ApplyFilterSupp(FILTER_CLEAR);
+    }
+}
+
+void MemCheckOutputView::UpdatePageCounts()
+{
+    int col = GetColumnByName(_("Label"));
+    if(col == wxNOT_FOUND) {
+        return;
+    }
+
+    wxDataViewItemArray items;
+    m_dataViewCtrlErrorsModel->GetChildren(wxDataViewItem(0), items);
+    for(wxDataViewItemArray::iterator it = items.begin(); it != items.end(); ++it) {
+        MemCheckErrorReferrer* errorRef =
+            dynamic_cast<MemCheckErrorReferrer*>(m_dataViewCtrlErrorsModel->GetClientObject(*it));
+        if(!errorRef) continue;
+
+        wxVariant variant;
+        m_dataViewCtrlErrorsModel->GetValue(variant, *it, col);
+        wxDataViewIconText iconText;
+        iconText << variant;
+        wxString label = GetErrorLabel(errorRef->Get());
+        if(iconText.GetText() == label) continue;
+
+        iconText.SetText(label);
+        variant << iconText;
+        m_dataViewCtrlErrorsModel->ChangeValue(variant, *it, col);
+    }
+}
+
+wxString MemCheckOutputView::GetErrorLabel(const MemCheckError& error)
+{
+    wxString label = error.label;
+    if(error.count > 1) label << wxString::Format(wxT(" (x%u)"), error.count);
+    return label;
+}
+
 void MemCheckOutputView::ResetItemsView()
 {
     ErrorList& errorList = m_plugin->GetProcessor()->GetErrors();
@@ -129,7 +184,7 @@ void MemCheckOutputView::ResetItemsSupp()
     m_lastToolTipItem = wxNOT_FOUND;
 }
 
-void MemCheckOutputView::ShowPageView(size_t page)
+void MemCheckOutputView::ShowPageView(size_t page, bool showBusy)
 {
     // CL_DEBUG1(PLUGIN_PREFIX("MemCheckOutputView::ShowPage()"));
 
@@ -163,9 +218,9 @@ void MemCheckOutputView::ShowPageView(size_t page)
     // this should never happen if m_totalErrorsView > 0, but...
     if(m_currentPageIsEmptyView) return;
 
-    wxWindowDisabler disableAll;
-    wxBusyInfo wait(wxT(BUSY_MESSAGE));
-    m_mgr->GetTheApp()->Yield();
+    wxWindowDisabler disableAll(showBusy);
+    wxScopedPtr<wxBusyInfo> wait(showBusy ? new wxBusyInfo(wxT(BUSY_MESSAGE)) : NULL);
+    if(showBusy) m_mgr->GetTheApp()->Yield();
 
     unsigned int flags = 0;
     if(m_plugin->GetSettings()->GetOmitNonWorkspace()) flags |= MC_IT_OMIT_NONWORKSPACE;
@@ -176,14 +231,14 @@ void MemCheckOutputView::ShowPageView(size_t page)
     for(; i < iStart && it != errorList.end(); ++i, ++it)
         ; // skipping item before start
     // CL_DEBUG1(PLUGIN_PREFIX("items skiped"));
-    m_mgr->GetTheApp()->Yield();
+    if(showBusy) m_mgr->GetTheApp()->Yield();
     for(; i <= iStop; ++i, ++it) {
         if(it == errorList.end()) {
             CL_WARNING(PLUGIN_PREFIX("Some items skiped. Total errors count mismatches the iterator."));
             break;
         }
         AddTree(wxDataViewItem(0), *it); // CL_DEBUG1(PLUGIN_PREFIX("adding %lu", i));
-        if(!(i % WAIT_UPDATE_PER_ITEMS)) m_mgr->GetTheApp()->Yield();
+        if(showBusy && !(i % WAIT_UPDATE_PER_ITEMS)) m_mgr->GetTheApp()->Yield();
     }
 }
 
@@ -197,7 +252,7 @@ void MemCheckOutputView::AddTree(const wxDataViewItem& parentItem, MemCheckError
     wxVector<wxVariant> cols;
     cols.push_back(variantBitmap);
     cols.push_back(wxVariant(false));
-    cols.push_back(MemCheckDVCErrorsModel::CreateIconTextVariant(error.label,
+    cols.push_back(MemCheckDVCErrorsModel::CreateIconTextVariant(GetErrorLabel(error),
         (error.type == MemCheckError::TYPE_AUXILIARY ? wxXmlResource::Get()->LoadBitmap(wxT("memcheck_auxiliary")) :
                                                        wxXmlResource::Get()->LoadBitmap(wxT("memcheck_error")))));
     cols.push_back(wxString());
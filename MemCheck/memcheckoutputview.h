@@ -133,8 +133,10 @@ protected:
     void MarkTree(const wxDataViewItem &item, bool checked); ///< (un)checks all items (whole one tree) that belong to an error
     unsigned int GetColumnByName(const wxString & name); ///< Finds index of an wxDVC column by its caption
     void JumpToLocation(const wxDataViewItem &item); ///< Opens file specifieed in particular ErrorLocation in editor
-    void ShowPageView(size_t page); ///< Item could be more than is good for wxDVC. So paging is implementetd. This method fills wxDVC with portion of errors.
+    void ShowPageView(size_t page, bool showBusy = true); ///< Item could be more than is good for wxDVC. So paging is implementetd. This method fills wxDVC with portion of errors. showBusy == false means the page is filled without busy info and without yielding.
     void AddTree(const wxDataViewItem & parentItem, MemCheckError & error); ///< Adds one error and all its location into wxDVC as tree
+    void UpdatePageCounts(); ///< Updates the "(xN)" count of the errors shown on current page
+    static wxString GetErrorLabel(const MemCheckError & error); ///< Label of the error with its count if it occurred more than once
     void OnJumpToLocation(wxCommandEvent & event); ///< Callback from wxDVC popupmenu
     void OnUnmarkAllErrors(wxCommandEvent & event); ///< Callback from wxDVC popupmenu
     void OnSuppressError(wxCommandEvent & event); ///< Callback from wxDVC popupmenu
@@ -168,6 +170,14 @@ public:
      * MemCheck plugin calls this method after test ends and after processor parses logfile into ErrorList.
      */
     void LoadErrors();
+    /**
+     * @brief Shows errors the processor added to ErrorList while it processes the log.
+     * @param done true if processing ended
+     *
+     * Number of pages is updated and current page is reloaded only if new errors can appear on it, so the view fills
+     * progressively. Supp page is reloaded when processing is done.
+     */
+    void UpdateErrors(bool done);
     /**
      * @brief clear the content
      */
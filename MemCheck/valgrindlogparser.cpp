@@ -0,0 +1,248 @@
+/**
+ * @file
+ * @copyright GNU General Public License v2
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <utility>
+
+#include "valgrindlogparser.h"
+
+/**
+ * @brief appends 'code' encoded as utf-8
+ */
+static void AppendUTF8(std::string& str, unsigned long code)
+{
+    if(code < 0x80) {
+        str += (char)code;
+    } else if(code < 0x800) {
+        str += (char)(0xC0 | (code >> 6));
+        str += (char)(0x80 | (code & 0x3F));
+    } else if(code < 0x10000) {
+        str += (char)(0xE0 | (code >> 12));
+        str += (char)(0x80 | ((code >> 6) & 0x3F));
+        str += (char)(0x80 | (code & 0x3F));
+    } else if(code < 0x110000) {
+        str += (char)(0xF0 | (code >> 18));
+        str += (char)(0x80 | ((code >> 12) & 0x3F));
+        str += (char)(0x80 | ((code >> 6) & 0x3F));
+        str += (char)(0x80 | (code & 0x3F));
+    }
+}
+
+/**
+ * @brief appends the entity reference 'name' (without '&' and ';') decoded
+ */
+static void AppendEntity(std::string& str, const std::string& name)
+{
+    if(name == "lt") {
+        str += '<';
+    } else if(name == "gt") {
+        str += '>';
+    } else if(name == "amp") {
+        str += '&';
+    } else if(name == "quot") {
+        str += '"';
+    } else if(name == "apos") {
+        str += '\'';
+    } else if(name.length() > 1 && name[0] == '#') {
+        if(name[1] == 'x' || name[1] == 'X')
+            AppendUTF8(str, strtoul(name.c_str() + 2, NULL, 16));
+        else
+            AppendUTF8(str, strtoul(name.c_str() + 1, NULL, 10));
+    } else {
+        // unknown entity, keep it as it is
+        str.append("&").append(name).append(";");
+    }
+}
+
+static inline bool StartsWith(const std::string& str, size_t pos, const char* prefix)
+{
+    return str.compare(pos, strlen(prefix), prefix) == 0;
+}
+
+ValgrindLogParser::ValgrindLogParser() { Reset(); }
+
+ValgrindLogParser::~ValgrindLogParser() {}
+
+void ValgrindLogParser::Reset()
+{
+    m_buffer.clear();
+    m_elements.clear();
+    m_text.clear();
+    m_valgrindOutput = false;
+    m_complete = false;
+    m_inError = false;
+    m_auxiliary = false;
+    m_errors = NULL;
+}
+
+void ValgrindLogParser::Feed(const char* data, size_t length, ErrorList& errors)
+{
+    m_errors = &errors;
+    m_buffer.append(data, length);
+
+    size_t pos = 0;
+    while(pos < m_buffer.length()) {
+        if(m_buffer[pos] != '<') {
+            // text is parsed once it is complete, so an entity is never split between two chunks
+            size_t end = m_buffer.find('<', pos);
+            if(end == std::string::npos) break;
+            if(m_inError) OnText(m_buffer.c_str() + pos, end - pos);
+            pos = end;
+
+        } else if(StartsWith(m_buffer, pos, "<!--")) {
+            size_t end = m_buffer.find("-->", pos + 4);
+            if(end == std::string::npos) break;
+            pos = end + 3;
+
+        } else if(StartsWith(m_buffer, pos, "<![CDATA[")) {
+            size_t end = m_buffer.find("]]>", pos + 9);
+            if(end == std::string::npos) break;
+            if(m_inError) m_text.append(m_buffer, pos + 9, end - pos - 9);
+            pos = end + 3;
+
+        } else if(StartsWith(m_buffer, pos, "<?")) {
+            size_t end = m_buffer.find("?>", pos + 2);
+            if(end == std::string::npos) break;
+            pos = end + 2;
+
+        } else {
+            size_t end = m_buffer.find('>', pos + 1);
+            if(end == std::string::npos) break;
+
+            if(m_buffer[pos + 1] == '!') {
+                // <!DOCTYPE ...>, ignoring
+            } else if(m_buffer[pos + 1] == '/') {
+                size_t nameEnd = m_buffer.find_first_of(" \t\r\n>", pos + 2);
+                OnEndElement(m_buffer.substr(pos + 2, nameEnd - pos - 2));
+            } else {
+                bool empty = m_buffer[end - 1] == '/';
+                size_t nameEnd = m_buffer.find_first_of(" \t\r\n/>", pos + 1);
+                std::string name = m_buffer.substr(pos + 1, nameEnd - pos - 1);
+                OnStartElement(name);
+                if(empty) OnEndElement(name);
+            }
+            pos = end + 1;
+        }
+    }
+
+    m_buffer.erase(0, pos);
+    m_errors = NULL;
+}
+
+const std::string& ValgrindLogParser::GetOpenElement(size_t level) const
+{
+    static const std::string empty;
+    if(level >= m_elements.size()) return empty;
+    return m_elements[m_elements.size() - level - 1];
+}
+
+wxString ValgrindLogParser::GetText() const
+{
+    wxString text = wxString::FromUTF8(m_text.c_str(), m_text.length());
+    if(text.IsEmpty() && !m_text.empty()) text = wxString::From8BitData(m_text.c_str(), m_text.length());
+    return text;
+}
+
+void ValgrindLogParser::OnText(const char* text, size_t length)
+{
+    const char* end = text + length;
+    while(text < end) {
+        const char* amp = (const char*)memchr(text, '&', end - text);
+        if(!amp) {
+            m_text.append(text, end - text);
+            break;
+        }
+        m_text.append(text, amp - text);
+        const char* semicolon = (const char*)memchr(amp, ';', end - amp);
+        if(!semicolon) {
+            m_text.append(amp, end - amp);
+            break;
+        }
+        AppendEntity(m_text, std::string(amp + 1, semicolon - amp - 1));
+        text = semicolon + 1;
+    }
+}
+
+void ValgrindLogParser::OnStartElement(const std::string& name)
+{
+    m_elements.push_back(name);
+    m_text.clear();
+
+    if(m_elements.size() == 1) {
+        m_valgrindOutput = (name == "valgrindoutput");
+
+    } else if(m_elements.size() == 2 && m_valgrindOutput && name == "error") {
+        m_inError = true;
+        m_auxiliary = false;
+        m_error = MemCheckError();
+        m_error.type = MemCheckError::TYPE_ERROR;
+        m_auxiliaryError = MemCheckError();
+
+    } else if(m_inError && name == "frame") {
+        m_location = MemCheckErrorLocation();
+        m_location.line = -1;
+        m_dir.Clear();
+        m_file.Clear();
+    }
+}
+
+void ValgrindLogParser::OnEndElement(const std::string& name)
+{
+    if(m_elements.empty()) return;
+
+    // Auxiliary section is not in subnode. First part of <error> describes particular error, second part (after
+    // <auxwhat>) describes auxiliary info, for which sub MemCheckError is created.
+    if(m_inError) {
+        const std::string& parent = GetOpenElement(1);
+        if(parent == "error") {
+            if(name == "what") {
+                m_error.label = GetText();
+            } else if(name == "auxwhat") {
+                m_auxiliaryError.label = GetText();
+                m_auxiliaryError.type = MemCheckError::TYPE_AUXILIARY;
+                m_auxiliary = true;
+            }
+        } else if(parent == "xwhat") {
+            if(name == "text" && GetOpenElement(2) == "error") m_error.label = GetText();
+        } else if(parent == "suppression") {
+            if(name == "rawtext" && GetOpenElement(2) == "error") m_error.suppression = GetText();
+        } else if(parent == "frame") {
+            if(name == "obj") {
+                m_location.obj = GetText();
+            } else if(name == "fn") {
+                m_location.func = GetText();
+            } else if(name == "dir") {
+                m_dir = GetText();
+            } else if(name == "file") {
+                m_file = GetText();
+            } else if(name == "line") {
+                m_location.line = atoi(m_text.c_str());
+            }
+        } else if(parent == "stack" && name == "frame") {
+            if(!m_dir.IsEmpty() && !m_dir.EndsWith(wxT("/"))) m_dir.Append(wxT("/"));
+            m_location.file = m_dir + m_file;
+            if(m_auxiliary)
+                m_auxiliaryError.locations.push_back(m_location);
+            else
+                m_error.locations.push_back(m_location);
+        }
+
+        if(m_elements.size() == 2 && name == "error") {
+            if(!m_error.suppression)
+                m_error.suppression =
+                    wxT("#Suppresion pattern not present in output log.\n#This plugin requires Valgrind to be "
+                        "run with '--gen-suppressions=all' option");
+            if(m_auxiliary) m_error.nestedErrors.push_back(std::move(m_auxiliaryError));
+            if(m_errors) m_errors->push_back(std::move(m_error));
+            m_inError = false;
+        }
+    }
+
+    if(m_elements.size() == 1 && m_valgrindOutput) m_complete = true;
+
+    m_elements.pop_back();
+    m_text.clear();
+}
@@ -0,0 +1,85 @@
+/**
+ * @file
+ * @copyright GNU General Public License v2
+ *
+ * @brief ValgrindLogParser - incremental (pull) parser of Valgrind's xml log.
+ */
+
+#ifndef _VALGRINDLOGPARSER_H_
+#define _VALGRINDLOGPARSER_H_
+
+#include <string>
+#include <vector>
+
+#include "memcheckerror.h"
+
+/**
+ * @class ValgrindLogParser
+ * @brief Parses Valgrind's xml log as it is read, without loading the document.
+ *
+ * The log is fed in chunks of any size (e.g. while Valgrind is still writing it). Only the markup that is not
+ * complete yet is kept between two chunks, so the memory used does not depend on the size of the log. Each
+ * <error> node is converted to MemCheckError as soon as its end tag is read.
+ */
+class ValgrindLogParser
+{
+public:
+    ValgrindLogParser();
+    virtual ~ValgrindLogParser();
+
+    /**
+     * @brief parses next part of the log
+     * @param data bytes read from the log
+     * @param length number of bytes
+     * @param errors errors completed by this part of the log are appended here
+     */
+    void Feed(const char* data, size_t length, ErrorList& errors);
+
+    /**
+     * @brief forget everything parsed so far, next Feed() starts a new log
+     */
+    void Reset();
+
+    /**
+     * @return true if root node of the log is <valgrindoutput>
+     */
+    bool IsValgrindOutput() const { return m_valgrindOutput; }
+
+    /**
+     * @return true if end of root node was read, i.e. the log is complete
+     */
+    bool IsComplete() const { return m_complete; }
+
+protected:
+    void OnStartElement(const std::string& name);
+    void OnEndElement(const std::string& name);
+    void OnText(const char* text, size_t length);
+
+    /**
+     * @brief name of the open node 'level' levels above the current one (0 is the current node)
+     */
+    const std::string& GetOpenElement(size_t level) const;
+
+    /**
+     * @brief converts text of the current node (utf-8, entities already replaced) to wxString
+     */
+    wxString GetText() const;
+
+    std::string m_buffer;                ///< bytes fed but not parsed yet (incomplete markup)
+    std::vector<std::string> m_elements; ///< stack of open nodes
+    std::string m_text;                  ///< text of the current node
+    bool m_valgrindOutput;
+    bool m_complete;
+
+    // <error> node being parsed
+    bool m_inError;
+    bool m_auxiliary;
+    MemCheckError m_error;
+    MemCheckError m_auxiliaryError;
+    MemCheckErrorLocation m_location;
+    wxString m_dir;
+    wxString m_file;
+    ErrorList* m_errors;
+};
+
+#endif // _VALGRINDLOGPARSER_H_
@@ -5,22 +5,116 @@
  * @copyright GNU General Public License v2
  */
 
+#include <vector>
+#include <wx/file.h>
 #include <wx/stdpaths.h>
+#include <wx/stopwatch.h>
 #include <wx/textfile.h>
 
+#include "clJoinableThread.h"
 #include "file_logger.h"
 #include "workspace.h"
 
 #include "memcheckdefs.h"
 #include "memchecksettings.h"
+#include "valgrindlogparser.h"
 #include "valgrindprocessor.h"
 
+/**
+ * @class ValgrindLogReaderThread
+ * @brief Reads and parses the log in background, parsed errors are passed to the processor in batches.
+ *
+ * If the log is being written by Valgrind, the thread waits for new data until the end of the log is parsed or
+ * Finish() is called.
+ */
+class ValgrindLogReaderThread : public clJoinableThread
+{
+    ValgrindMemcheckProcessor* m_processor;
+    wxString m_filename;
+    size_t m_id;
+    wxCriticalSection m_cs;
+    bool m_follow;
+
+public:
+    ValgrindLogReaderThread(ValgrindMemcheckProcessor* processor, const wxString& filename, size_t id, bool follow)
+        : m_processor(processor)
+        , m_filename(filename.c_str()) // deep copy, used by the thread
+        , m_id(id)
+        , m_follow(follow)
+    {
+    }
+    virtual ~ValgrindLogReaderThread() { Stop(); }
+
+    void Finish()
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        m_follow = false;
+    }
+
+    bool IsFollowing()
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        return m_follow;
+    }
+
+    void* Entry()
+    {
+        ValgrindLogParser parser;
+        ErrorList errors;
+        std::vector<char> buffer(LOG_READ_SIZE);
+        wxFile file;
+        wxStopWatch sw;
+        bool success = false;
+
+        while(!TestDestroy()) {
+            // checked before reading, so everything written before Valgrind exited is read
+            bool follow = IsFollowing();
+            if(!file.IsOpened() && (!wxFileName::FileExists(m_filename) || !file.Open(m_filename))) {
+                if(!follow) break;
+                wxThread::Sleep(LOG_POLL_INTERVAL);
+                continue;
+            }
+
+            ssize_t count = file.Read(buffer.data(), buffer.size());
+            if(count == wxInvalidOffset) break;
+            if(count > 0) parser.Feed(buffer.data(), count, errors);
+
+            if(!errors.empty() && (errors.size() >= LOG_BATCH_SIZE || sw.Time() >= LOG_BATCH_INTERVAL)) {
+                m_processor->CallAfter(&ValgrindMemcheckProcessor::OnErrorsParsed, m_id, errors);
+                errors.clear();
+                sw.Start();
+            }
+
+            if(parser.IsComplete()) {
+                success = true;
+                break;
+            } else if(count == 0) {
+                if(!follow) {
+                    // log is not complete if Valgrind was killed, errors parsed so far are kept
+                    success = parser.IsValgrindOutput();
+                    break;
+                }
+                wxThread::Sleep(LOG_POLL_INTERVAL);
+            }
+        }
+
+        if(TestDestroy()) return NULL;
+        if(!errors.empty()) m_processor->CallAfter(&ValgrindMemcheckProcessor::OnErrorsParsed, m_id, errors);
+        m_processor->CallAfter(&ValgrindMemcheckProcessor::OnProcessingDone, m_id, success);
+        return NULL;
+    }
+};
+
 ValgrindMemcheckProcessor::ValgrindMemcheckProcessor(MemCheckSettings* const settings)
     : IMemCheckProcessor(settings)
+    , m_reader(NULL)
+    , m_readerId(0)
 {
     // CL_DEBUG1(PLUGIN_PREFIX("ValgrindMemcheckProcessor created"));
 }
 
+ValgrindMemcheckProcessor::~ValgrindMemcheckProcessor() { StopProcessing(); }
+
 wxArrayString ValgrindMemcheckProcessor::GetSuppressionFiles()
 {
     wxArrayString suppFiles = m_settings->GetValgrindSettings().GetSuppFiles();
@@ -61,141 +155,52 @@ void ValgrindMemcheckProcessor::GetExecutionCommand(const wxString& originalComm
         suppresions, m_settings->GetValgrindSettings().GetOptions(), originalCommand);
 }
 
-bool ValgrindMemcheckProcessor::Process(const wxString& outputLogFileName)
+void ValgrindMemcheckProcessor::StartProcessing(const wxString& outputLogFileName, bool follow)
 {
-    // CL_DEBUG1(PLUGIN_PREFIX("ValgrindMemcheckProcessor::Process()"));
-
+    StopProcessing();
     if(!outputLogFileName.IsEmpty()) m_outputLogFileName = outputLogFileName;
 
     CL_DEBUG(PLUGIN_PREFIX("Processing file '%s'", m_outputLogFileName));
 
-    wxXmlDocument doc;
-    if(!doc.Load(m_outputLogFileName) || doc.GetRoot()->GetName() != wxT("valgrindoutput")) {
-        CL_WARNING("Error while loading file '%s'", m_outputLogFileName);
-        return false;
-    }
-    m_errorList.clear();
-
-    int i = 0;
-    wxXmlNode* errorNode = doc.GetRoot()->GetChildren();
-    while(errorNode) {
-        if(errorNode->GetName() == wxT("error")) { m_errorList.push_back(ProcessError(doc, errorNode)); }
-        errorNode = errorNode->GetNext();
-
-        if(i < 1000)
-            i++;
-        else {
-            i = 0;
-            // ATTN  m_mgr->GetTheApp()
-            wxTheApp->Yield();
-        }
-    }
-    return true;
+    ClearErrors();
+    // Valgrind creates the log once it starts, log of previous test must not be taken for it
+    if(follow && wxFileName::FileExists(m_outputLogFileName)) wxRemoveFile(m_outputLogFileName);
+
+    m_reader = new ValgrindLogReaderThread(this, m_outputLogFileName, ++m_readerId, follow);
+    m_reader->Start();
 }
 
-MemCheckError ValgrindMemcheckProcessor::ProcessError(wxXmlDocument& doc, wxXmlNode* errorNode)
+void ValgrindMemcheckProcessor::FinishProcessing()
 {
-    // CL_DEBUG1(PLUGIN_PREFIX("ValgrindMemcheckProcessor::ProcessError()"));
-
-    bool auxiliary = false;
-    MemCheckError result;
-    result.type = MemCheckError::TYPE_ERROR;
-    MemCheckError auxiliaryResult;
-
-    wxXmlNode* suberrorNode = errorNode->GetChildren();
-    while(suberrorNode) {
-
-        // retrieving error label
-        if(suberrorNode->GetName() == wxT("what")) {
-            result.label = suberrorNode->GetNodeContent();
-        } else if(suberrorNode->GetName() == wxT("xwhat")) {
-            wxXmlNode* child = suberrorNode->GetChildren();
-            while(child) {
-                if(child->GetName() == wxT("text")) {
-                    result.label = child->GetNodeContent();
-                    break;
-                }
-                child = child->GetNext();
-            }
-        } else if(suberrorNode->GetName() == wxT("auxwhat")) {
-            auxiliaryResult.label = suberrorNode->GetNodeContent();
-            auxiliaryResult.type = MemCheckError::TYPE_AUXILIARY;
-            auxiliary = true;
-        } else if(suberrorNode->GetName() == wxT("stack")) {
-            wxXmlNode* locationNode = suberrorNode->GetChildren();
-            while(locationNode) {
-                if(locationNode->GetName() == wxT("frame")) {
-                    if(auxiliary) {
-                        auxiliaryResult.locations.push_back(ProcessLocation(doc, locationNode));
-                    } else {
-                        result.locations.push_back(ProcessLocation(doc, locationNode));
-                    }
-                }
-                locationNode = locationNode->GetNext();
-            }
-        } else if(suberrorNode->GetName() == wxT("suppression")) {
-            wxXmlNode* child = suberrorNode->GetChildren();
-            while(child) {
-                if(child->GetName() == wxT("rawtext")) {
-                    result.suppression = child->GetNodeContent();
-                    break;
-                }
-                child = child->GetNext();
-            }
-        }
-        suberrorNode = suberrorNode->GetNext();
-    }
-
-    if(!result.suppression)
-        result.suppression = wxT("#Suppresion pattern not present in output log.\n#This plugin requires Valgrind to be "
-                                 "run with '--gen-suppressions=all' option");
+    if(m_reader) m_reader->Finish();
+}
 
-    if(auxiliary) result.nestedErrors.push_back(auxiliaryResult);
+void ValgrindMemcheckProcessor::StopProcessing()
+{
+    if(m_reader) {
+        ++m_readerId;
+        wxDELETE(m_reader);
+    }
+}
 
-    // TODO ? add checout ?
-    // add check for empty locationArrays
-    //  CL_DEBUG1(PLUGIN_PREFIX("\t equal #0 and #1 = %s", (errorArray.Item(0) == errorArray.Item(1)?"true":"false") ));
-    //  CL_DEBUG1(PLUGIN_PREFIX("\t equal #1 and #2 = %s", (*(errorArray.Item(2)) ==
-    //  *(errorArray.Item(1))?"true":"false") )); CL_DEBUG1(PLUGIN_PREFIX("\t equal #2 and #3 = %s", (errorArray.Item(2)
-    //  == errorArray.Item(3)?"true":"false") ));
+void ValgrindMemcheckProcessor::OnErrorsParsed(size_t readerId, const ErrorList& errors)
+{
+    if(readerId != m_readerId) return;
 
-    // check if required fields was found
-    //  CL_ERROR1(PLUGIN_PREFIX("Broken input, tag <what> or <xwhat> not found, can't continue!"));
-    //  CL_ERROR1(PLUGIN_PREFIX("Broken input, tag <stack> not found, can't continue!"));
-    return result;
+    AddErrors(errors);
+    wxCommandEvent event(wxEVT_MEMCHECK_ERRORS_ADDED);
+    ProcessEvent(event);
 }
 
-MemCheckErrorLocation ValgrindMemcheckProcessor::ProcessLocation(wxXmlDocument& doc, wxXmlNode* locationNode)
+void ValgrindMemcheckProcessor::OnProcessingDone(size_t readerId, bool success)
 {
-    // CL_DEBUG1(PLUGIN_PREFIX("ValgrindMemcheckProcessor::ProcessLocation()"));
-
-    MemCheckErrorLocation result;
-    result.line = -1;
-    wxString file;
-    wxString dir;
-
-    wxXmlNode* subframeNode = locationNode->GetChildren();
-    while(subframeNode) {
-
-        if(subframeNode->GetName() == wxT("ip")) {
-            // ignoring
-        } else if(subframeNode->GetName() == wxT("obj")) {
-            result.obj = subframeNode->GetNodeContent();
-        } else if(subframeNode->GetName() == wxT("fn")) {
-            result.func = subframeNode->GetNodeContent();
-        } else if(subframeNode->GetName() == wxT("dir")) {
-            dir = subframeNode->GetNodeContent();
-        } else if(subframeNode->GetName() == wxT("file")) {
-            file = subframeNode->GetNodeContent();
-        } else if(subframeNode->GetName() == wxT("line")) {
-            result.line = wxAtoi(subframeNode->GetNodeContent());
-        }
-        subframeNode = subframeNode->GetNext();
-    }
+    if(readerId != m_readerId) return;
 
-    if(!dir.IsEmpty() && !dir.EndsWith(wxT("/"))) dir.Append(wxT("/"));
-    result.file = dir + file;
+    // the thread has nothing more to do
+    wxDELETE(m_reader);
+    if(!success) CL_WARNING("Error while loading file '%s'", m_outputLogFileName);
 
-    // TODO ? add checkout ?
-    return result;
+    wxCommandEvent event(wxEVT_MEMCHECK_PROCESSING_DONE);
+    event.SetInt(success ? 1 : 0);
+    ProcessEvent(event);
 }
@@ -34,7 +34,8 @@
 #define _VALGRINDPROCESSOR_H_
 
 #include "imemcheckprocessor.h"
-#include <wx/xml/xml.h>
+
+class ValgrindLogReaderThread;
 
 /**
  * @class ValgrindMemcheckProcessor
@@ -44,6 +45,8 @@
  */
 class ValgrindMemcheckProcessor : public IMemCheckProcessor
 {
+    friend class ValgrindLogReaderThread;
+
 public:
     /**
      * @brief interface implementation, does nothing more than inherited ctor
@@ -51,6 +54,11 @@ public:
      */
     ValgrindMemcheckProcessor(MemCheckSettings* const settings);
 
+    /**
+     * @brief stops background processing
+     */
+    virtual ~ValgrindMemcheckProcessor();
+
     /**
      * @brief interface implementation
      * @return list of supp files
@@ -71,32 +79,29 @@ public:
 
     /**
      * @brief interface implementation
-     * @param outputLogFileName
-     * @return
      *
-     * Loads Valgrind's xml log to wxXmlDocument, and goes trought nodes
+     * Log is read by parts and parsed with ValgrindLogParser by ValgrindLogReaderThread, the document is never loaded
+     * whole. If Valgrind is still running, the log is read as Valgrind
+     * writes it, so errors are shown during the test.
      */
-    virtual bool Process(const wxString& outputLogFileName = wxEmptyString);
+    virtual void StartProcessing(const wxString& outputLogFileName = wxEmptyString, bool follow = false);
+    virtual void FinishProcessing();
+    virtual void StopProcessing();
+    virtual bool IsProcessing() const { return m_reader != NULL; }
 
 protected:
+    ValgrindLogReaderThread* m_reader;
+    size_t m_readerId; ///< identifies current processing, results of stopped processing are ignored
+
     /**
-     * @brief creates one MemCheckError object
-     * @param doc whole log document
-     * @param errorNode reference to current processed node in that doc file
-     * @return MemCheckError object
-     *
-     * Auxiliary section is not in subnode. First part of the node describes particular error, second part describes
-     * auxiliary info. For auxiliary is created sub MemCheckError object.
+     * @brief called (in main thread) with errors parsed by ValgrindLogReaderThread
      */
-    MemCheckError ProcessError(wxXmlDocument& doc, wxXmlNode* errorNode);
+    void OnErrorsParsed(size_t readerId, const ErrorList& errors);
 
     /**
-     * @brief creates one MemCheckErrorLocation object
-     * @param doc whole log document
-     * @param locationNode reference to current processed node in that doc file
-     * @return MemCheckErrorLocation object
+     * @brief called (in main thread) when ValgrindLogReaderThread reached end of the log
      */
-    MemCheckErrorLocation ProcessLocation(wxXmlDocument& doc, wxXmlNode* locationNode);
+    void OnProcessingDone(size_t readerId, bool success);
 };
 
 #endif // _VALGRINDPROCESSOR_H_
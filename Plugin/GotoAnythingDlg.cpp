@@ -1,6 +1,5 @@
 #include "GotoAnythingDlg.h"
 #include "bitmap_loader.h"
-#include "clAnagram.h"
 #include "clKeyboardManager.h"
 #include "cl_config.h"
 #include "codelite_events.h"
@@ -17,6 +16,13 @@ GotoAnythingDlg::GotoAnythingDlg(wxWindow* parent, const std::vector<clGotoEntry
     : GotoAnythingBaseDlg(parent)
     , m_allEntries(entries)
 {
+    wxArrayString descriptions;
+    descriptions.reserve(m_allEntries.size());
+    for(size_t i = 0; i < m_allEntries.size(); ++i) {
+        descriptions.Add(m_allEntries[i].GetDesc());
+    }
+    m_catalog.reset(new clFuzzySearchCatalog(descriptions, false));
+
     DoPopulate(m_allEntries);
     CallAfter(&GotoAnythingDlg::UpdateLastSearch);
     WindowAttrManager::Load(this);
@@ -24,6 +30,7 @@ GotoAnythingDlg::GotoAnythingDlg(wxWindow* parent, const std::vector<clGotoEntry
 
 GotoAnythingDlg::~GotoAnythingDlg()
 {
+    clFuzzySearchService::Get().Cancel(this);
     // clConfig::Get().Write("GotoAnything/LastSearch", m_textCtrlSearch->GetValue());
 }
 
@@ -103,24 +110,28 @@ void GotoAnythingDlg::ApplyFilter()
     // Update the last applied filter
     m_currentFilter = filter;
     if(filter.IsEmpty()) {
+        clFuzzySearchService::Get().Cancel(this);
         DoPopulate(m_allEntries);
     } else {
 
-        // Filter the list
-        clAnagram anagram(filter);
-        std::vector<clGotoEntry> matchedEntries;
-        std::vector<int> matchedEntriesIndex;
-        for(size_t i = 0; i < m_allEntries.size(); ++i) {
-            const clGotoEntry& entry = m_allEntries[i];
-            if(anagram.MatchesInOrder(entry.GetDesc())) {
-                matchedEntries.push_back(entry);
-                matchedEntriesIndex.push_back(i);
-            }
-        }
+        // Filter the list in the background, the list is populated when the matches arrive
+        clFuzzySearchService::Get().Search(this, m_catalog, filter, m_allEntries.size(),
+                                           [this](const clFuzzySearchResults& results) { OnFilterResults(results); });
+    }
+}
 
-        // And populate the list
-        DoPopulate(matchedEntries, matchedEntriesIndex);
+void GotoAnythingDlg::OnFilterResults(const clFuzzySearchResults& results)
+{
+    std::vector<clGotoEntry> matchedEntries;
+    std::vector<int> matchedEntriesIndex;
+    for(size_t i = 0; i < results.m_matches.size(); ++i) {
+        size_t index = results.m_matches[i].m_index;
+        matchedEntries.push_back(m_allEntries[index]);
+        matchedEntriesIndex.push_back(index);
     }
+
+    // And populate the list, best match first
+    DoPopulate(matchedEntries, matchedEntriesIndex);
 }
 
 void GotoAnythingDlg::OnItemActivated(wxDataViewEvent& event)
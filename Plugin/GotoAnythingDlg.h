@@ -2,6 +2,7 @@
 #define GOTOANYTHINGDLG_H
 
 #include "GotoAnythingBaseUI.h"
+#include "clFuzzySearchService.h"
 #include "clGotoAnythingManager.h"
 #include "codelite_exports.h"
 #include <vector>
@@ -20,6 +21,7 @@
 class WXDLLIMPEXP_SDK GotoAnythingDlg : public GotoAnythingBaseDlg
 {
     const std::vector<clGotoEntry>& m_allEntries;
+    clFuzzySearchCatalog::Ptr_t m_catalog; // the entries descriptions
     wxString m_currentFilter;
 
 protected:
@@ -29,6 +31,7 @@ protected:
     void DoExecuteActionAndClose();
     void UpdateLastSearch();
     void ApplyFilter();
+    void OnFilterResults(const clFuzzySearchResults& results);
 
 public:
     GotoAnythingDlg(wxWindow* parent, const std::vector<clGotoEntry>& entries);
@@ -0,0 +1,240 @@
+#include "clFuzzyMatcher.h"
+#include <algorithm>
+#include <string.h>
+
+// A match score is: <match kind> * FUZZY_KIND_FACTOR + <fuzzy score>
+#define FUZZY_KIND_FACTOR 100000
+#define FUZZY_BASE_SCORE 50000
+#define FUZZY_BOUNDARY_BONUS 100
+#define FUZZY_CONSECUTIVE_BONUS 50
+
+static inline bool IsLower(char ch) { return ch >= 'a' && ch <= 'z'; }
+static inline bool IsUpper(char ch) { return ch >= 'A' && ch <= 'Z'; }
+static inline bool IsAlnum(char ch) { return IsLower(ch) || IsUpper(ch) || (ch >= '0' && ch <= '9'); }
+
+/**
+ * @brief is 'pos' the start of a word: "Get|File|Name", "get_|file_|name", "file.|cpp"
+ */
+static inline bool IsWordStart(const char* text, size_t pos)
+{
+    if(pos == 0) { return true; }
+    char prev = text[pos - 1];
+    char ch = text[pos];
+    if(IsUpper(ch) && !IsUpper(prev)) { return true; }
+    return IsAlnum(ch) && !IsAlnum(prev) && !((unsigned char)prev & 0x80);
+}
+
+static std::string ToUTF8(const wxString& str)
+{
+    const wxScopedCharBuffer buffer = str.ToUTF8();
+    return std::string(buffer.data(), buffer.length());
+}
+
+/**
+ * @brief find 'ch' in str[from, len). Return 'len' if not found
+ */
+static inline size_t FindChar(const char* str, size_t len, size_t from, char ch)
+{
+    if(from >= len) { return len; }
+    const char* p = (const char*)memchr(str + from, ch, len - from);
+    return p ? (p - str) : len;
+}
+
+static bool IsSubsequence(const char* str, size_t len, size_t from, const std::string& sub, size_t subFrom)
+{
+    for(; subFrom < sub.length(); ++subFrom) {
+        from = FindChar(str, len, from, sub[subFrom]);
+        if(from == len) { return false; }
+        ++from;
+    }
+    return true;
+}
+
+static bool Contains(const char* str, size_t len, const std::string& sub)
+{
+    if(sub.length() > len) { return false; }
+    size_t last = len - sub.length();
+    for(size_t pos = FindChar(str, last + 1, 0, sub[0]); pos <= last; pos = FindChar(str, last + 1, pos + 1, sub[0])) {
+        if(memcmp(str + pos, sub.c_str(), sub.length()) == 0) { return true; }
+    }
+    return false;
+}
+
+clFuzzyMatcher::Pattern::Pattern(const wxString& filter)
+    : m_text(ToUTF8(filter))
+    , m_lower(Fold(m_text))
+{
+}
+
+clFuzzyMatcher::clFuzzyMatcher() {}
+
+clFuzzyMatcher::~clFuzzyMatcher() {}
+
+std::string clFuzzyMatcher::Fold(const std::string& str)
+{
+    std::string folded = str;
+    for(size_t i = 0; i < folded.length(); ++i) {
+        if(IsUpper(folded[i])) { folded[i] = folded[i] - 'A' + 'a'; }
+    }
+    return folded;
+}
+
+void clFuzzyMatcher::SetItems(const std::vector<wxString>& items)
+{
+    Clear();
+    // Keep all the keys in a single buffer
+    m_keys.resize(items.size());
+    for(size_t i = 0; i < items.size(); ++i) {
+        m_keys[i].m_offset = m_text.length();
+        m_text.append(ToUTF8(items[i]));
+        m_keys[i].m_length = m_text.length() - m_keys[i].m_offset;
+    }
+    m_lower = Fold(m_text);
+}
+
+void clFuzzyMatcher::Clear()
+{
+    m_keys.clear();
+    m_text.clear();
+    m_lower.clear();
+    m_lastFilter.clear();
+    m_lastCandidates.clear();
+}
+
+int clFuzzyMatcher::FuzzyScore(const char* text, const char* lower, size_t len, const std::string& lcFilter)
+{
+    if(!IsSubsequence(lower, len, 0, lcFilter, 0)) { return wxNOT_FOUND; }
+
+    // Place each filter character, preferring the start of a word as long as the rest of the filter can still
+    // be matched after it
+    int score = FUZZY_BASE_SCORE;
+    size_t pos = 0;
+    size_t prevPos = len;
+    for(size_t fi = 0; fi < lcFilter.length(); ++fi) {
+        char ch = lcFilter[fi];
+        size_t chosen = FindChar(lower, len, pos, ch);
+        bool consecutive = (prevPos != len && chosen == prevPos + 1);
+        if(!consecutive && !IsWordStart(text, chosen)) {
+            for(size_t p = FindChar(lower, len, chosen + 1, ch); p < len; p = FindChar(lower, len, p + 1, ch)) {
+                if(IsWordStart(text, p) && IsSubsequence(lower, len, p + 1, lcFilter, fi + 1)) {
+                    chosen = p;
+                    break;
+                }
+            }
+        }
+
+        if(IsWordStart(text, chosen)) { score += FUZZY_BOUNDARY_BONUS; }
+        if(consecutive) { score += FUZZY_CONSECUTIVE_BONUS; }
+        // Penalise the skipped characters
+        score -= (int)(chosen - pos);
+        prevPos = chosen;
+        pos = chosen + 1;
+    }
+    // Prefer shorter items
+    score -= (int)(len - pos);
+    return std::min(std::max(score, 0), FUZZY_KIND_FACTOR - 1);
+}
+
+wxString clFuzzyMatcher::GetItem(size_t index) const
+{
+    const Key& key = m_keys[index];
+    return wxString::FromUTF8(m_text.c_str() + key.m_offset, key.m_length);
+}
+
+int clFuzzyMatcher::Score(size_t index, const Pattern& pattern, size_t skip) const
+{
+    const Key& key = m_keys[index];
+    const std::string& filter = pattern.m_text;
+    const std::string& lcFilter = pattern.m_lower;
+    if(skip > key.m_length) { return wxNOT_FOUND; }
+    size_t len = key.m_length - skip;
+    if(len < lcFilter.length()) { return wxNOT_FOUND; }
+
+    const char* text = m_text.c_str() + key.m_offset + skip;
+    const char* lower = m_lower.c_str() + key.m_offset + skip;
+    int kind = wxNOT_FOUND;
+    if(memcmp(lower, lcFilter.c_str(), lcFilter.length()) == 0) {
+        bool caseMatch = (memcmp(text, filter.c_str(), filter.length()) == 0);
+        if(len == lcFilter.length()) {
+            kind = caseMatch ? kExact : kExactI;
+        } else {
+            kind = caseMatch ? kStartsWith : kStartsWithI;
+        }
+
+    } else if(Contains(lower, len, lcFilter)) {
+        kind = Contains(text, len, filter) ? kContains : kContainsI;
+
+    } else if(lcFilter.length() == 1) {
+        // A single character is a subsequence only if it is contained
+        return wxNOT_FOUND;
+    }
+
+    if(kind != wxNOT_FOUND) { return kind * FUZZY_KIND_FACTOR; }
+    return FuzzyScore(text, lower, len, lcFilter);
+}
+
+clFuzzyMatcher::eMatchKind clFuzzyMatcher::GetKind(int score) { return (eMatchKind)(score / FUZZY_KIND_FACTOR); }
+
+void clFuzzyMatcher::Sort(Vec_t& matches)
+{
+    std::sort(matches.begin(), matches.end(), &clFuzzyMatcher::IsBetter);
+}
+
+void clFuzzyMatcher::Filter(const wxString& filter, Vec_t& matches)
+{
+    matches.clear();
+    Pattern pattern(filter);
+    if(pattern.IsEmpty()) {
+        matches.reserve(m_keys.size());
+        for(size_t i = 0; i < m_keys.size(); ++i) {
+            matches.push_back(Match(i, 0));
+        }
+        m_lastFilter.clear();
+        m_lastCandidates.clear();
+        return;
+    }
+
+    // Every match of the new filter is a (fuzzy) match of its prefix: when the user extends the filter, only the
+    // previous matches need to be checked
+    bool incremental = !m_lastFilter.empty() && pattern.m_lower.length() >= m_lastFilter.length() &&
+                       pattern.m_lower.compare(0, m_lastFilter.length(), m_lastFilter) == 0;
+
+    std::vector<size_t> candidates;
+    if(incremental) {
+        candidates.swap(m_lastCandidates);
+    } else {
+        candidates.resize(m_keys.size());
+        for(size_t i = 0; i < m_keys.size(); ++i) {
+            candidates[i] = i;
+        }
+    }
+
+    Vec_t unsorted;
+    unsorted.reserve(candidates.size());
+    m_lastCandidates.clear();
+    m_lastCandidates.reserve(candidates.size());
+    size_t countPerKind[kExact + 1] = { 0 };
+    for(size_t i = 0; i < candidates.size(); ++i) {
+        int score = Score(candidates[i], pattern);
+        if(score != wxNOT_FOUND) {
+            unsorted.push_back(Match(candidates[i], score));
+            m_lastCandidates.push_back(candidates[i]);
+            ++countPerKind[GetKind(score)];
+        }
+    }
+    m_lastFilter = pattern.m_lower;
+
+    // Group the matches by their kind (best first, keeping the items order), then sort the fuzzy matches
+    size_t offsets[kExact + 1];
+    size_t offset = 0;
+    for(int kind = kExact; kind >= kFuzzy; --kind) {
+        offsets[kind] = offset;
+        offset += countPerKind[kind];
+    }
+    matches.resize(unsorted.size(), Match(0, 0));
+    for(size_t i = 0; i < unsorted.size(); ++i) {
+        matches[offsets[GetKind(unsorted[i].m_score)]++] = unsorted[i];
+    }
+    std::stable_sort(matches.end() - countPerKind[kFuzzy], matches.end(),
+                     [](const Match& a, const Match& b) { return a.m_score > b.m_score; });
+}
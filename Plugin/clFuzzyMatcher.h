@@ -0,0 +1,118 @@
+#ifndef CLFUZZYMATCHER_H
+#define CLFUZZYMATCHER_H
+
+#include "codelite_exports.h"
+#include <string>
+#include <vector>
+#include <wx/string.h>
+
+/**
+ * @class clFuzzyMatcher
+ * @brief filter a list of strings by what the user typed, and rank the matches.
+ * The keys used for the matching (the UTF-8 text and its case folded form) are computed once when the items are set,
+ * so filtering does not allocate per item. The matches are ranked (best first): exact match, starts with, contains
+ * (each case sensitive first) and finally a "fuzzy" match: the filter characters appear in the item in order,
+ * preferably at the start of words (e.g. "gfn" matches "GetFileName" and "get_file_name").
+ * When the filter is extended (the user typed another character) only the items that matched the previous filter
+ * are examined
+ */
+class WXDLLIMPEXP_SDK clFuzzyMatcher
+{
+public:
+    enum eMatchKind {
+        kFuzzy = 0,
+        kContainsI,
+        kContains,
+        kStartsWithI,
+        kStartsWith,
+        kExactI,
+        kExact,
+    };
+
+    struct Match {
+        size_t m_index; // the item index
+        int m_score;    // the higher the better
+        Match(size_t index, int score)
+            : m_index(index)
+            , m_score(score)
+        {
+        }
+    };
+    typedef std::vector<Match> Vec_t;
+
+    /**
+     * @brief a filter, converted once for matching many items
+     */
+    struct WXDLLIMPEXP_SDK Pattern {
+        std::string m_text;  // UTF-8
+        std::string m_lower; // m_text with the ASCII letters in lower case
+        Pattern(const wxString& filter);
+        bool IsEmpty() const { return m_text.empty(); }
+    };
+
+protected:
+    struct Key {
+        size_t m_offset; // in m_text and m_lower
+        size_t m_length;
+    };
+
+    std::vector<Key> m_keys;
+    std::string m_text;  // all the items, UTF-8
+    std::string m_lower; // m_text with the ASCII letters in lower case
+    std::string m_lastFilter;            // the case folded filter of the last call to Filter()
+    std::vector<size_t> m_lastCandidates; // the items that matched m_lastFilter, in their original order
+
+protected:
+    static std::string Fold(const std::string& str);
+    static int FuzzyScore(const char* text, const char* lower, size_t len, const std::string& lcFilter);
+
+public:
+    clFuzzyMatcher();
+    virtual ~clFuzzyMatcher();
+
+    /**
+     * @brief set the items to filter, this resets the incremental filtering state
+     */
+    void SetItems(const std::vector<wxString>& items);
+    void Clear();
+    size_t GetCount() const { return m_keys.size(); }
+
+    /**
+     * @brief filter the items
+     * @param matches [output] the matching items, best match first. Items with the same score keep their order.
+     * An empty filter matches all the items, in their original order
+     */
+    void Filter(const wxString& filter, Vec_t& matches);
+
+    /**
+     * @brief return the item at 'index'
+     */
+    wxString GetItem(size_t index) const;
+
+    /**
+     * @brief score a single item. This does not change the matcher, so it may be called from multiple threads
+     * @param skip the number of bytes to ignore at the start of the item (e.g. the directory of a file path)
+     * @return the match score or wxNOT_FOUND if the item does not match. 'pattern' must not be empty
+     */
+    int Score(size_t index, const Pattern& pattern, size_t skip = 0) const;
+
+    /**
+     * @brief is 'a' ranked before 'b': best score first, then by item index
+     */
+    static bool IsBetter(const Match& a, const Match& b)
+    {
+        return (a.m_score > b.m_score) || ((a.m_score == b.m_score) && (a.m_index < b.m_index));
+    }
+
+    /**
+     * @brief sort matches: best score first, then by item index
+     */
+    static void Sort(Vec_t& matches);
+
+    /**
+     * @brief return the kind of a match from its score
+     */
+    static eMatchKind GetKind(int score);
+};
+
+#endif // CLFUZZYMATCHER_H
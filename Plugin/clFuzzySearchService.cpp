@@ -0,0 +1,373 @@
+#include "clFuzzySearchService.h"
+#include "clWorkerPool.h"
+#include "codelite_events.h"
+#include "event_notifier.h"
+#include "file_logger.h"
+#include "macros.h"
+#include "workspace.h"
+#include <algorithm>
+#include <limits.h>
+#include <wx/stopwatch.h>
+#include <wx/tokenzr.h>
+
+// Items are scored in chunks: the query is checked for cancellation and the best matches are merged once per chunk
+#define FUZZY_SEARCH_CHUNK_SIZE 8192
+#define FUZZY_SEARCH_MAX_WORKERS 8
+// The best matches found so far are delivered at most once per interval (milliseconds)
+#define FUZZY_SEARCH_PROGRESS_INTERVAL 100
+// Added to the score of the items whose file name matches, clFuzzyMatcher scores are lower than this
+#define FUZZY_SEARCH_NAME_BONUS 1000000
+
+clFuzzySearchCatalog::clFuzzySearchCatalog(const wxArrayString& items, bool paths)
+{
+    std::vector<wxString> keys;
+    keys.reserve(items.size());
+    if(paths) { m_nameOffsets.reserve(items.size()); }
+    for(size_t i = 0; i < items.size(); ++i) {
+        const wxString& item = items.Item(i);
+        keys.push_back(item);
+        if(paths) {
+            size_t where = item.find_last_of("/\\");
+            m_nameOffsets.push_back((where == wxString::npos) ? 0 : item.Mid(0, where + 1).ToUTF8().length());
+        }
+    }
+    m_matcher.SetItems(keys);
+}
+
+clFuzzySearchCatalog::~clFuzzySearchCatalog() {}
+
+int clFuzzySearchCatalog::Score(size_t index, const std::vector<clFuzzyMatcher::Pattern>& words) const
+{
+    bool paths = !m_nameOffsets.empty();
+    int score = INT_MAX;
+    for(size_t i = 0; i < words.size(); ++i) {
+        int wordScore = m_matcher.Score(index, words[i], paths ? m_nameOffsets[index] : 0);
+        if(wordScore != wxNOT_FOUND) {
+            wordScore += FUZZY_SEARCH_NAME_BONUS;
+
+        } else if(paths) {
+            // A directory matches only if it contains the word, a fuzzy match on a full path is mostly noise
+            wordScore = m_matcher.Score(index, words[i]);
+            if(wordScore == wxNOT_FOUND || clFuzzyMatcher::GetKind(wordScore) == clFuzzyMatcher::kFuzzy) {
+                return wxNOT_FOUND;
+            }
+
+        } else {
+            return wxNOT_FOUND;
+        }
+        score = std::min(score, wordScore);
+    }
+    return score;
+}
+
+/**
+ * @brief keep the 'count' best matches (unsorted)
+ */
+static void KeepBest(clFuzzyMatcher::Vec_t& matches, size_t count)
+{
+    if(matches.size() <= count) { return; }
+    std::nth_element(matches.begin(), matches.begin() + count, matches.end(), &clFuzzyMatcher::IsBetter);
+    matches.resize(count, clFuzzyMatcher::Match(0, 0));
+}
+
+//===------------------------------------------------
+// Worker thread
+//===------------------------------------------------
+
+class clFuzzySearchRequest : public ThreadRequest
+{
+public:
+    wxEvtHandler* m_owner;
+    size_t m_queryId;
+    clFuzzySearchCatalog::Ptr_t m_catalog; // NULL: search the workspace files
+    std::vector<clFuzzyMatcher::Pattern> m_words;
+    size_t m_maxResults;
+
+    clFuzzySearchRequest()
+        : m_owner(NULL)
+        , m_queryId(0)
+        , m_maxResults(0)
+    {
+    }
+    virtual ~clFuzzySearchRequest() {}
+};
+
+class clFuzzyCatalogRequest : public ThreadRequest
+{
+public:
+    wxArrayString m_files;
+    size_t m_buildId;
+
+    clFuzzyCatalogRequest()
+        : m_buildId(0)
+    {
+    }
+    virtual ~clFuzzyCatalogRequest() {}
+};
+
+class clFuzzySearchThread : public WorkerThread
+{
+    clFuzzySearchService* m_service;
+    // The search workers, the thread takes part in the work so one less worker than the CPUs is needed
+    clWorkerPool m_workers;
+
+protected:
+    void DoSearch(clFuzzySearchRequest* req);
+    void DoBuildCatalog(clFuzzyCatalogRequest* req);
+
+public:
+    clFuzzySearchThread(clFuzzySearchService* service)
+        : m_service(service)
+        , m_workers(std::min(clWorkerPool::GetCPUCount() - 1, (size_t)FUZZY_SEARCH_MAX_WORKERS))
+    {
+    }
+    virtual ~clFuzzySearchThread() {}
+
+    virtual void ProcessRequest(ThreadRequest* request)
+    {
+        clFuzzySearchRequest* search = dynamic_cast<clFuzzySearchRequest*>(request);
+        if(search) {
+            DoSearch(search);
+            return;
+        }
+        clFuzzyCatalogRequest* build = dynamic_cast<clFuzzyCatalogRequest*>(request);
+        if(build) { DoBuildCatalog(build); }
+    }
+};
+
+void clFuzzySearchThread::DoSearch(clFuzzySearchRequest* req)
+{
+    // A newer query of the same owner is already queued
+    if(!m_service->IsCurrent(req->m_owner, req->m_queryId)) { return; }
+
+    clFuzzySearchResults results;
+    results.m_owner = req->m_owner;
+    results.m_queryId = req->m_queryId;
+    results.m_catalog = req->m_catalog ? req->m_catalog : m_service->GetWorkspaceFiles();
+    if(!results.m_catalog || req->m_words.empty()) {
+        results.m_complete = true;
+        m_service->PostResults(results);
+        return;
+    }
+
+    wxStopWatch sw;
+    long lastProgress = 0;
+    wxCriticalSection cs;
+    const clFuzzySearchCatalog& catalog = *results.m_catalog;
+    size_t count = catalog.GetCount();
+    size_t chunks = (count + FUZZY_SEARCH_CHUNK_SIZE - 1) / FUZZY_SEARCH_CHUNK_SIZE;
+    m_workers.ForEach(chunks, [&](size_t chunk) {
+        if(!m_service->IsCurrent(req->m_owner, req->m_queryId)) { return; }
+
+        clFuzzyMatcher::Vec_t matches;
+        size_t last = std::min(count, (chunk + 1) * FUZZY_SEARCH_CHUNK_SIZE);
+        for(size_t i = chunk * FUZZY_SEARCH_CHUNK_SIZE; i < last; ++i) {
+            int score = catalog.Score(i, req->m_words);
+            if(score != wxNOT_FOUND) { matches.push_back(clFuzzyMatcher::Match(i, score)); }
+        }
+        KeepBest(matches, req->m_maxResults);
+
+        wxCriticalSectionLocker locker(cs);
+        results.m_matches.insert(results.m_matches.end(), matches.begin(), matches.end());
+        KeepBest(results.m_matches, req->m_maxResults);
+        if((sw.Time() - lastProgress) >= FUZZY_SEARCH_PROGRESS_INTERVAL) {
+            // Let the user see the best matches so far
+            lastProgress = sw.Time();
+            clFuzzySearchResults progress = results;
+            clFuzzyMatcher::Sort(progress.m_matches);
+            m_service->PostResults(progress);
+        }
+    });
+
+    if(!m_service->IsCurrent(req->m_owner, req->m_queryId)) { return; }
+    clFuzzyMatcher::Sort(results.m_matches);
+    results.m_complete = true;
+    m_service->PostResults(results);
+    clDEBUG1() << "Fuzzy search:" << results.m_matches.size() << "matches out of" << count << "items in" << sw.Time()
+               << "ms" << clEndl;
+}
+
+void clFuzzySearchThread::DoBuildCatalog(clFuzzyCatalogRequest* req)
+{
+    wxStopWatch sw;
+    // The same file may belong to multiple projects
+    req->m_files.Sort();
+    wxArrayString files;
+    files.reserve(req->m_files.size());
+    for(size_t i = 0; i < req->m_files.size(); ++i) {
+        if(files.IsEmpty() || (files.Last() != req->m_files.Item(i))) { files.Add(req->m_files.Item(i)); }
+    }
+
+    clFuzzySearchCatalog::Ptr_t catalog(new clFuzzySearchCatalog(files, true));
+    m_service->SetWorkspaceFiles(catalog, req->m_buildId);
+    clDEBUG() << "Fuzzy search: workspace files catalog built with" << files.size() << "files in" << sw.Time()
+              << "ms" << clEndl;
+}
+
+//===------------------------------------------------
+// The service
+//===------------------------------------------------
+
+clFuzzySearchService* clFuzzySearchService::ms_instance = NULL;
+
+clFuzzySearchService::clFuzzySearchService()
+    : m_thread(NULL)
+    , m_lastQueryId(0)
+    , m_workspaceFilesId(0)
+    , m_rebuildPending(false)
+{
+    m_thread = new clFuzzySearchThread(this);
+    m_thread->Start();
+
+    EventNotifier::Get()->Bind(wxEVT_WORKSPACE_LOADED, &clFuzzySearchService::OnWorkspaceLoaded, this);
+    EventNotifier::Get()->Bind(wxEVT_WORKSPACE_CLOSED, &clFuzzySearchService::OnWorkspaceClosed, this);
+    EventNotifier::Get()->Bind(wxEVT_WORKSPACE_RELOAD_ENDED, &clFuzzySearchService::OnProjectFilesChanged, this);
+    EventNotifier::Get()->Bind(wxEVT_PROJ_FILE_ADDED, &clFuzzySearchService::OnProjectFilesChanged, this);
+    EventNotifier::Get()->Bind(wxEVT_PROJ_FILE_REMOVED, &clFuzzySearchService::OnProjectFilesChanged, this);
+    EventNotifier::Get()->Bind(wxEVT_PROJ_ADDED, &clFuzzySearchService::OnProjectFilesChanged, this);
+    EventNotifier::Get()->Bind(wxEVT_PROJ_REMOVED, &clFuzzySearchService::OnProjectFilesChanged, this);
+    if(clCxxWorkspaceST::Get()->IsOpen()) { DoScheduleRebuild(); }
+}
+
+clFuzzySearchService::~clFuzzySearchService()
+{
+    EventNotifier::Get()->Unbind(wxEVT_WORKSPACE_LOADED, &clFuzzySearchService::OnWorkspaceLoaded, this);
+    EventNotifier::Get()->Unbind(wxEVT_WORKSPACE_CLOSED, &clFuzzySearchService::OnWorkspaceClosed, this);
+    EventNotifier::Get()->Unbind(wxEVT_WORKSPACE_RELOAD_ENDED, &clFuzzySearchService::OnProjectFilesChanged, this);
+    EventNotifier::Get()->Unbind(wxEVT_PROJ_FILE_ADDED, &clFuzzySearchService::OnProjectFilesChanged, this);
+    EventNotifier::Get()->Unbind(wxEVT_PROJ_FILE_REMOVED, &clFuzzySearchService::OnProjectFilesChanged, this);
+    EventNotifier::Get()->Unbind(wxEVT_PROJ_ADDED, &clFuzzySearchService::OnProjectFilesChanged, this);
+    EventNotifier::Get()->Unbind(wxEVT_PROJ_REMOVED, &clFuzzySearchService::OnProjectFilesChanged, this);
+
+    {
+        // Let the running search stop at its next chunk
+        wxCriticalSectionLocker locker(m_cs);
+        m_queries.clear();
+    }
+    m_thread->Stop();
+    wxDELETE(m_thread);
+}
+
+clFuzzySearchService& clFuzzySearchService::Get()
+{
+    if(!ms_instance) { ms_instance = new clFuzzySearchService(); }
+    return *ms_instance;
+}
+
+void clFuzzySearchService::Release() { wxDELETE(ms_instance); }
+
+size_t clFuzzySearchService::Search(wxEvtHandler* owner, clFuzzySearchCatalog::Ptr_t catalog, const wxString& filter,
+                                    size_t maxResults, const clFuzzySearchCallback_t& callback)
+{
+    clFuzzySearchRequest* req = new clFuzzySearchRequest();
+    req->m_owner = owner;
+    req->m_catalog = catalog;
+    req->m_maxResults = maxResults;
+    wxStringTokenizer tokenizer(filter, " \t", wxTOKEN_STRTOK);
+    while(tokenizer.HasMoreTokens()) {
+        req->m_words.push_back(clFuzzyMatcher::Pattern(tokenizer.GetNextToken()));
+    }
+
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        req->m_queryId = ++m_lastQueryId;
+        m_queries[owner] = req->m_queryId;
+    }
+    m_callbacks[owner] = callback;
+    m_thread->Add(req);
+    return req->m_queryId;
+}
+
+size_t clFuzzySearchService::SearchWorkspaceFiles(wxEvtHandler* owner, const wxString& filter, size_t maxResults,
+                                                  const clFuzzySearchCallback_t& callback)
+{
+    // The catalog is picked by the thread, after the rebuilds that were requested before this search
+    return Search(owner, clFuzzySearchCatalog::Ptr_t(NULL), filter, maxResults, callback);
+}
+
+void clFuzzySearchService::Cancel(wxEvtHandler* owner)
+{
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        m_queries.erase(owner);
+    }
+    m_callbacks.erase(owner);
+}
+
+bool clFuzzySearchService::IsCurrent(wxEvtHandler* owner, size_t queryId)
+{
+    wxCriticalSectionLocker locker(m_cs);
+    std::unordered_map<wxEvtHandler*, size_t>::const_iterator iter = m_queries.find(owner);
+    return (iter != m_queries.end()) && (iter->second == queryId);
+}
+
+void clFuzzySearchService::PostResults(const clFuzzySearchResults& results)
+{
+    CallAfter(&clFuzzySearchService::OnResults, results);
+}
+
+void clFuzzySearchService::OnResults(const clFuzzySearchResults& results)
+{
+    // The owner may have started another search (or was destroyed) since these results were posted
+    if(!IsCurrent(results.m_owner, results.m_queryId)) { return; }
+    if(!m_callbacks.count(results.m_owner)) { return; }
+
+    // The callback may start a new search of the same owner, so call a copy of it
+    clFuzzySearchCallback_t callback = m_callbacks[results.m_owner];
+    callback(results);
+}
+
+clFuzzySearchCatalog::Ptr_t clFuzzySearchService::GetWorkspaceFiles()
+{
+    wxCriticalSectionLocker locker(m_cs);
+    return m_workspaceFiles;
+}
+
+void clFuzzySearchService::SetWorkspaceFiles(clFuzzySearchCatalog::Ptr_t catalog, size_t buildId)
+{
+    wxCriticalSectionLocker locker(m_cs);
+    if(buildId != m_workspaceFilesId) { return; }
+    m_workspaceFiles = catalog;
+}
+
+void clFuzzySearchService::OnWorkspaceLoaded(wxCommandEvent& e)
+{
+    e.Skip();
+    DoScheduleRebuild();
+}
+
+void clFuzzySearchService::OnWorkspaceClosed(wxCommandEvent& e)
+{
+    e.Skip();
+    wxCriticalSectionLocker locker(m_cs);
+    ++m_workspaceFilesId;
+    m_workspaceFiles.reset(NULL);
+}
+
+void clFuzzySearchService::OnProjectFilesChanged(clCommandEvent& e)
+{
+    e.Skip();
+    DoScheduleRebuild();
+}
+
+void clFuzzySearchService::DoScheduleRebuild()
+{
+    // Adding a folder to a project fires an event per file: rebuild once they were all processed
+    if(m_rebuildPending) { return; }
+    m_rebuildPending = true;
+    CallAfter(&clFuzzySearchService::DoRebuildWorkspaceFiles);
+}
+
+void clFuzzySearchService::DoRebuildWorkspaceFiles()
+{
+    m_rebuildPending = false;
+    if(!clCxxWorkspaceST::Get()->IsOpen()) { return; }
+
+    clFuzzyCatalogRequest* req = new clFuzzyCatalogRequest();
+    clCxxWorkspaceST::Get()->GetWorkspaceFiles(req->m_files);
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        req->m_buildId = ++m_workspaceFilesId;
+    }
+    m_thread->Add(req);
+}
@@ -0,0 +1,150 @@
+#ifndef CLFUZZYSEARCHSERVICE_H
+#define CLFUZZYSEARCHSERVICE_H
+
+#include "clFuzzyMatcher.h"
+#include "cl_command_event.h"
+#include "codelite_exports.h"
+#include "worker_thread.h"
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <wx/arrstr.h>
+#include <wx/event.h>
+#include <wx/sharedptr.h>
+#include <wx/thread.h>
+
+/**
+ * @class clFuzzySearchCatalog
+ * @brief an immutable list of items to search (e.g. the workspace files), kept in a single clFuzzyMatcher so the
+ * items are stored contiguously and can be scored from multiple threads.
+ * When the items are paths, each word of the filter is matched against the file name first, and against the full
+ * path if the name does not match. Items whose name matches all the words rank above the items that matched
+ * through their directories
+ */
+class WXDLLIMPEXP_SDK clFuzzySearchCatalog
+{
+public:
+    typedef wxSharedPtr<clFuzzySearchCatalog> Ptr_t;
+
+protected:
+    clFuzzyMatcher m_matcher;
+    std::vector<unsigned int> m_nameOffsets; // in bytes, where the file name starts in each path
+
+public:
+    /**
+     * @param items the items to search
+     * @param paths when true, the items are file paths
+     */
+    clFuzzySearchCatalog(const wxArrayString& items, bool paths);
+    virtual ~clFuzzySearchCatalog();
+
+    size_t GetCount() const { return m_matcher.GetCount(); }
+    wxString GetItem(size_t index) const { return m_matcher.GetItem(index); }
+
+    /**
+     * @brief score an item against every word of the filter (thread safe)
+     * @return the score of the item or wxNOT_FOUND if any of the words does not match
+     */
+    int Score(size_t index, const std::vector<clFuzzyMatcher::Pattern>& words) const;
+};
+
+/**
+ * @brief the results of a search. Results of the same query are sent as the search progresses, each time with the
+ * best matches found so far. The last results of a query are marked as complete
+ */
+struct WXDLLIMPEXP_SDK clFuzzySearchResults {
+    wxEvtHandler* m_owner;
+    size_t m_queryId;
+    clFuzzySearchCatalog::Ptr_t m_catalog; // the searched catalog
+    clFuzzyMatcher::Vec_t m_matches;       // indexes in m_catalog, best match first
+    bool m_complete;
+
+    clFuzzySearchResults()
+        : m_owner(NULL)
+        , m_queryId(0)
+        , m_complete(false)
+    {
+    }
+};
+
+typedef std::function<void(const clFuzzySearchResults&)> clFuzzySearchCallback_t;
+
+class clFuzzySearchThread;
+
+/**
+ * @class clFuzzySearchService
+ * @brief search catalogs in the background. The items are scored by a pool of threads and the best matches are
+ * delivered to the callback (on the main thread) while the search is still running.
+ * Every owner (e.g. a dialog) has a single current query: starting a new search cancels the previous one, and
+ * results of a cancelled query are never delivered.
+ * The service also keeps a catalog of the workspace files which is rebuilt in the background when the workspace
+ * changes
+ */
+class WXDLLIMPEXP_SDK clFuzzySearchService : public wxEvtHandler
+{
+    friend class clFuzzySearchThread;
+
+    static clFuzzySearchService* ms_instance;
+
+    clFuzzySearchThread* m_thread;
+    wxCriticalSection m_cs;
+    // protected by m_cs: the current query of each owner and the workspace files catalog
+    std::unordered_map<wxEvtHandler*, size_t> m_queries;
+    size_t m_lastQueryId;
+    clFuzzySearchCatalog::Ptr_t m_workspaceFiles;
+    size_t m_workspaceFilesId; // incremented for every rebuild, so outdated builds are dropped
+    // main thread only
+    std::unordered_map<wxEvtHandler*, clFuzzySearchCallback_t> m_callbacks;
+    bool m_rebuildPending;
+
+protected:
+    clFuzzySearchService();
+    virtual ~clFuzzySearchService();
+
+    void OnWorkspaceLoaded(wxCommandEvent& e);
+    void OnWorkspaceClosed(wxCommandEvent& e);
+    void OnProjectFilesChanged(clCommandEvent& e);
+    void DoScheduleRebuild();
+    void DoRebuildWorkspaceFiles();
+
+    // called from the worker thread
+    bool IsCurrent(wxEvtHandler* owner, size_t queryId);
+    void PostResults(const clFuzzySearchResults& results);
+    void SetWorkspaceFiles(clFuzzySearchCatalog::Ptr_t catalog, size_t buildId);
+
+    void OnResults(const clFuzzySearchResults& results);
+
+public:
+    static clFuzzySearchService& Get();
+    static void Release();
+
+    /**
+     * @brief search 'catalog' for the whitespace separated words of 'filter'. This cancels the current query of
+     * 'owner'
+     * @param maxResults the number of best matches to deliver
+     * @param callback called on the main thread with the results
+     * @return the query id
+     */
+    size_t Search(wxEvtHandler* owner, clFuzzySearchCatalog::Ptr_t catalog, const wxString& filter,
+                  size_t maxResults, const clFuzzySearchCallback_t& callback);
+
+    /**
+     * @brief search the workspace files. The catalog searched is the latest one when the search starts (the
+     * workspace files catalog is replaced whenever the workspace changes)
+     */
+    size_t SearchWorkspaceFiles(wxEvtHandler* owner, const wxString& filter, size_t maxResults,
+                                const clFuzzySearchCallback_t& callback);
+
+    /**
+     * @brief cancel the current query of 'owner'. This must be called before 'owner' is destroyed
+     */
+    void Cancel(wxEvtHandler* owner);
+
+    /**
+     * @brief return the workspace files catalog (thread safe). This may be NULL while it is built for the first
+     * time
+     */
+    clFuzzySearchCatalog::Ptr_t GetWorkspaceFiles();
+};
+
+#endif // CLFUZZYSEARCHSERVICE_H
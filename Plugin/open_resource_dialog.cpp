@@ -44,6 +44,8 @@
 #include <wx/wupdlock.h>
 #include <wx/xrc/xmlres.h>
 
+#define OPEN_RESOURCE_MAX_FILES 100
+
 BEGIN_EVENT_TABLE(OpenResourceDialog, OpenResourceDialogBase)
 EVT_TIMER(XRCID("OR_TIMER"), OpenResourceDialog::OnTimer)
 END_EVENT_TABLE()
@@ -95,24 +97,7 @@ OpenResourceDialog::OpenResourceDialog(wxWindow* parent, IManager* manager, cons
     SetName("OpenResourceDialog");
     WindowAttrManager::Load(this);
 
-    // load all files from the workspace
-    if(m_manager->IsWorkspaceOpen()) {
-        wxArrayString projects;
-        m_manager->GetWorkspace()->GetProjectList(projects);
-
-        for(size_t i = 0; i < projects.GetCount(); i++) {
-            ProjectPtr p = m_manager->GetWorkspace()->GetProject(projects.Item(i));
-            if(p) {
-                const Project::FilesMap_t& files = p->GetFiles();
-                // convert std::vector to wxArrayString
-                std::for_each(files.begin(), files.end(), [&](const Project::FilesMap_t::value_type& vt) {
-                    wxFileName fn(vt.second->GetFilename());
-                    m_files.insert(std::make_pair(fn.GetFullName(), fn.GetFullPath()));
-                });
-            }
-        }
-    }
-
+    // The workspace files are searched in the background by clFuzzySearchService, which keeps them indexed
     wxString lastStringTyped = clConfig::Get().Read("OpenResourceDialog/SearchString", wxString());
     // Set the initial selection
     // We use here 'SetValue' so an event will get fired and update the control
@@ -135,6 +120,7 @@ OpenResourceDialog::~OpenResourceDialog()
 {
     m_timer->Stop();
     wxDELETE(m_timer);
+    clFuzzySearchService::Get().Cancel(this);
 
     // Store current values
     clConfig::Get().Write("OpenResourceDialog/ShowFiles", m_checkBoxFiles->IsChecked());
@@ -147,10 +133,10 @@ void OpenResourceDialog::OnText(wxCommandEvent& event)
     event.Skip();
     m_timer->Stop();
     m_timer->Start(200, true);
-
-    wxString filter = m_textCtrlResourceName->GetValue();
-    filter.Trim().Trim(false);
     m_needRefresh = true;
+
+    // Searching the files does not block the UI, so there is no need to wait for the user to stop typing
+    if(DoParseFilter()) { DoSearchFiles(); }
 }
 
 void OpenResourceDialog::OnUsePartialMatching(wxCommandEvent& event)
@@ -170,37 +156,73 @@ void OpenResourceDialog::OnEntryActivated(wxDataViewEvent& event)
 
 void OpenResourceDialog::DoPopulateList()
 {
-    wxString name = m_textCtrlResourceName->GetValue();
-    name.Trim().Trim(false);
-    if(name.IsEmpty()) { return; }
+    if(!DoParseFilter()) { return; }
 
-    Clear();
+    DoSearchFiles();
+    DoPopulateTags();
+    DoRebuildList();
+}
 
-    wxWindowUpdateLocker locker(m_dataview);
+bool OpenResourceDialog::DoParseFilter()
+{
+    wxString name = m_textCtrlResourceName->GetValue();
+    name.Trim().Trim(false);
+    if(name.IsEmpty()) { return false; }
 
-    // First add the workspace files
     long nLineNumber;
     wxString modFilter;
     GetLineNumberFromFilter(name, modFilter, nLineNumber);
-    name.swap(modFilter);
+    m_filter.swap(modFilter);
+    m_filter.Trim().Trim(false);
 
     m_lineNumber = nLineNumber;
 
     // Prepare the user filter
     m_userFilters.Clear();
-    m_userFilters = ::wxStringTokenize(name, " \t", wxTOKEN_STRTOK);
+    m_userFilters = ::wxStringTokenize(m_filter, " \t", wxTOKEN_STRTOK);
     for(size_t i = 0; i < m_userFilters.GetCount(); ++i) {
         m_userFilters.Item(i).MakeLower();
     }
+    return true;
+}
+
+void OpenResourceDialog::DoSearchFiles()
+{
+    // do we need to include files?
+    bool showFiles =
+        m_checkBoxFiles->IsChecked() && (m_filters.IsEmpty() || m_filters.Index(KIND_FILE) != wxNOT_FOUND);
+    wxString query = showFiles ? m_filter : wxString();
+    if(query == m_filesQuery) { return; }
+    m_filesQuery = query;
+
+    if(query.IsEmpty()) {
+        clFuzzySearchService::Get().Cancel(this);
+        m_fileMatches.clear();
+        m_filesCatalog.reset(NULL);
+        DoFilterTags();
+        DoRebuildList();
+        return;
+    }
 
-    // Build the filter class
-    if(m_checkBoxFiles->IsChecked()) { DoPopulateWorkspaceFile(); }
-    if(m_checkBoxShowSymbols->IsChecked() && (nLineNumber == -1)) { DoPopulateTags(); }
+    // The previous matches are displayed until the first results of this query arrive
+    clFuzzySearchService::Get().SearchWorkspaceFiles(
+        this, query, OPEN_RESOURCE_MAX_FILES, [this](const clFuzzySearchResults& results) { OnFilesFound(results); });
+}
+
+void OpenResourceDialog::OnFilesFound(const clFuzzySearchResults& results)
+{
+    m_filesCatalog = results.m_catalog;
+    m_fileMatches = results.m_matches;
+    // The tags are fetched again only when the timer fires, until then show the ones that match the new filter
+    DoFilterTags();
+    DoRebuildList();
 }
 
 void OpenResourceDialog::DoPopulateTags()
 {
-    // Next, add the tags
+    m_tags.clear();
+    if(!m_checkBoxShowSymbols->IsChecked() || (m_lineNumber != wxNOT_FOUND)) return;
+
     TagEntryPtrVector_t tags;
     if(m_userFilters.IsEmpty()) return;
     m_manager->GetTagsManager()->GetTagsByPartialNames(m_userFilters, tags);
@@ -211,8 +233,41 @@ void OpenResourceDialog::DoPopulateTags()
         if(!m_filters.IsEmpty() && m_filters.Index(tag->GetKind()) == wxNOT_FOUND) continue;
 
         if(!MatchesFilter(tag->GetFullDisplayName())) { continue; }
+        m_tags.push_back(tag);
+    }
+}
 
-        wxString name(tag->GetName());
+void OpenResourceDialog::DoFilterTags()
+{
+    if(!m_checkBoxShowSymbols->IsChecked() || (m_lineNumber != wxNOT_FOUND) || m_userFilters.IsEmpty()) {
+        m_tags.clear();
+        return;
+    }
+
+    TagEntryPtrVector_t tags;
+    tags.reserve(m_tags.size());
+    for(size_t i = 0; i < m_tags.size(); i++) {
+        if(MatchesFilter(m_tags.at(i)->GetFullDisplayName())) { tags.push_back(m_tags.at(i)); }
+    }
+    m_tags.swap(tags);
+}
+
+void OpenResourceDialog::DoRebuildList()
+{
+    Clear();
+    wxWindowUpdateLocker locker(m_dataview);
+
+    // First add the workspace files
+    for(size_t i = 0; i < m_fileMatches.size(); ++i) {
+        wxFileName fn(m_filesCatalog->GetItem(m_fileMatches[i].m_index));
+        int imgId = clGetManager()->GetStdIcons()->GetMimeImageId(fn.GetFullName());
+        DoAppendLine(fn.GetFullName(), fn.GetFullPath(), false,
+                     new OpenResourceDialogItemData(fn.GetFullPath(), -1, wxT(""), fn.GetFullName(), wxT("")), imgId);
+    }
+
+    // Next, add the tags
+    for(size_t i = 0; i < m_tags.size(); i++) {
+        TagEntryPtr tag = m_tags.at(i);
 
         // keep the fullpath
         wxString fullname;
@@ -239,30 +294,10 @@ void OpenResourceDialog::DoPopulateTags()
                                  wxDV_SEARCH_ICASE | wxDV_SEARCH_METHOD_EXACT | wxDV_SEARCH_INCLUDE_CURRENT_ITEM);
         if(matchedItem.IsOk()) { DoSelectItem(matchedItem); }
     }
-}
 
-void OpenResourceDialog::DoPopulateWorkspaceFile()
-{
-    // do we need to include files?
-    if(!m_filters.IsEmpty() && m_filters.Index(KIND_FILE) == wxNOT_FOUND) return;
-
-    if(!m_userFilters.IsEmpty()) {
-
-        std::unordered_multimap<wxString, wxString>::iterator iter = m_files.begin();
-        const int maxFileSize = 100;
-        int counter = 0;
-        for(; (iter != m_files.end()) && (counter < maxFileSize); iter++) {
-            const wxString& fullpath = iter->second;
-            if(!MatchesFilter(fullpath)) continue;
-
-            wxFileName fn(iter->second);
-            int imgId = clGetManager()->GetStdIcons()->GetMimeImageId(fn.GetFullName());
-            DoAppendLine(fn.GetFullName(), fn.GetFullPath(), false,
-                         new OpenResourceDialogItemData(fn.GetFullPath(), -1, wxT(""), fn.GetFullName(), wxT("")),
-                         imgId);
-            ++counter;
-        }
-    }
+    // If there is only 1 item in the resource window then highlight it.
+    // This allows the user to hit ENTER immediately after to open the item, nice shortcut.
+    if(m_dataview->GetItemCount() == 1) { DoSelectItem(m_dataview->RowToItem(0)); }
 }
 
 void OpenResourceDialog::Clear()
@@ -273,7 +308,6 @@ void OpenResourceDialog::Clear()
         wxDELETE(cd);
     }
     m_dataview->DeleteAllItems();
-    m_userFilters.Clear();
 }
 
 void OpenResourceDialog::OpenSelection(const OpenResourceDialogItemData& selection, IManager* manager)
@@ -348,10 +382,6 @@ void OpenResourceDialog::OnTimer(wxTimerEvent& event)
     if(m_needRefresh) { DoPopulateList(); }
 
     m_needRefresh = false;
-
-    // If there is only 1 item in the resource window then highlight it.
-    // This allows the user to hit ENTER immediately after to open the item, nice shortcut.
-    if(m_dataview->GetItemCount() == 1) { DoSelectItem(m_dataview->RowToItem(0)); }
 }
 
 int OpenResourceDialog::DoGetTagImg(TagEntryPtr tag)
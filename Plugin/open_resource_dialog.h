@@ -27,6 +27,7 @@
 #define __open_resource_dialog__
 
 #include "clAnagram.h"
+#include "clFuzzySearchService.h"
 #include "codelite_exports.h"
 #include "entry.h"
 #include "fileextmanager.h"
@@ -79,13 +80,17 @@ public:
 class WXDLLIMPEXP_SDK OpenResourceDialog : public OpenResourceDialogBase
 {
     IManager* m_manager;
-    std::unordered_multimap<wxString, wxString> m_files;
     std::unordered_map<wxString, int> m_fileTypeHash;
     wxTimer* m_timer;
     bool m_needRefresh;
     wxArrayString m_filters;
+    wxString m_filter; // what the user typed, without the line number
     wxArrayString m_userFilters;
     long m_lineNumber;
+    wxString m_filesQuery; // the last filter the workspace files were searched for
+    clFuzzySearchCatalog::Ptr_t m_filesCatalog;
+    clFuzzyMatcher::Vec_t m_fileMatches;
+    TagEntryPtrVector_t m_tags;
 
 protected:
     virtual void OnEnter(wxCommandEvent& event);
@@ -94,9 +99,13 @@ protected:
     virtual void OnCheckboxfilesCheckboxClicked(wxCommandEvent& event);
     virtual void OnCheckboxshowsymbolsCheckboxClicked(wxCommandEvent& event);
     void DoPopulateList();
-    void DoPopulateWorkspaceFile();
+    bool DoParseFilter();
+    void DoSearchFiles();
+    void OnFilesFound(const clFuzzySearchResults& results);
     bool MatchesFilter(const wxString& name);
     void DoPopulateTags();
+    void DoFilterTags();
+    void DoRebuildList();
     void DoSelectItem(const wxDataViewItem& item);
     void Clear();
     void DoAppendLine(const wxString& name, const wxString& fullname, bool boldFont,
@@ -299,6 +299,16 @@ void wxCodeCompletionBox::ShowCompletionBox(wxStyledTextCtrl* ctrl, const wxCode
     // Filter all duplicate entries from the list (based on simple string match)
     RemoveDuplicateEntries();
 
+    // Prepare the filtering keys once for the whole list
+    std::vector<wxString> keys;
+    keys.reserve(m_allEntries.size());
+    for(size_t i = 0; i < m_allEntries.size(); ++i) {
+        wxString entryText = m_allEntries.at(i)->GetText().BeforeFirst('(');
+        entryText.Trim().Trim(false);
+        keys.push_back(entryText);
+    }
+    m_matcher.SetItems(keys);
+
     // Filter results based on user input
     FilterResults();
 
@@ -454,49 +464,18 @@ bool wxCodeCompletionBox::FilterResults()
         return false;
     }
 
-    m_entries.clear();
-    wxString lcFilter = word.Lower();
     // Smart sorting:
-    // We preare the list of matches in the following order:
-    // Exact matches
-    // Starts with
-    // Contains
-    wxCodeCompletionBoxEntry::Vec_t exactMatches, exactMatchesI, startsWith, startsWithI, contains, containsI;
-    for(size_t i = 0; i < m_allEntries.size(); ++i) {
-        wxString entryText = m_allEntries.at(i)->GetText().BeforeFirst('(');
-        entryText.Trim().Trim(false);
-        wxString lcEntryText = entryText.Lower();
-
-        // Exact match:
-        if(word == entryText) {
-            exactMatches.push_back(m_allEntries.at(i));
-
-        } else if(lcEntryText == lcFilter) {
-            exactMatchesI.push_back(m_allEntries.at(i));
-
-        } else if(entryText.StartsWith(word)) {
-            startsWith.push_back(m_allEntries.at(i));
-
-        } else if(lcEntryText.StartsWith(lcFilter)) {
-            startsWithI.push_back(m_allEntries.at(i));
-
-        } else if(entryText.Contains(word)) {
-            contains.push_back(m_allEntries.at(i));
-
-        } else if(lcEntryText.Contains(lcFilter)) {
-            containsI.push_back(m_allEntries.at(i));
-        }
+    // The matches are ordered by: exact match, starts with, contains (each case sensitive first) and finally the
+    // fuzzy matches (e.g. "gfn" for "GetFileName"). When the user extends the filter, only the previous matches
+    // are checked
+    m_matcher.Filter(word, m_matches);
+    m_entries.clear();
+    m_entries.reserve(m_matches.size());
+    for(size_t i = 0; i < m_matches.size(); ++i) {
+        m_entries.push_back(m_allEntries.at(m_matches[i].m_index));
     }
-
-    // Merge the results
-    m_entries.insert(m_entries.end(), exactMatches.begin(), exactMatches.end());
-    m_entries.insert(m_entries.end(), exactMatchesI.begin(), exactMatchesI.end());
-    m_entries.insert(m_entries.end(), startsWith.begin(), startsWith.end());
-    m_entries.insert(m_entries.end(), startsWithI.begin(), startsWithI.end());
-    m_entries.insert(m_entries.end(), contains.begin(), contains.end());
-    m_entries.insert(m_entries.end(), containsI.begin(), containsI.end());
     m_index = 0;
-    return exactMatches.empty() && exactMatchesI.empty() && startsWith.empty() && startsWithI.empty();
+    return m_matches.empty() || (clFuzzyMatcher::GetKind(m_matches[0].m_score) < clFuzzyMatcher::kStartsWithI);
 }
 
 void wxCodeCompletionBox::InsertSelection()
@@ -26,6 +26,7 @@
 #ifndef WXCODECOMPLETIONBOX_H
 #define WXCODECOMPLETIONBOX_H
 
+#include "clFuzzyMatcher.h"
 #include "wxCodeCompletionBoxBase.h"
 #include "wxCodeCompletionBoxEntry.h"
 #include <wx/arrstr.h>
@@ -60,6 +61,8 @@ public:
 protected:
     wxCodeCompletionBoxEntry::Vec_t m_allEntries;
     wxCodeCompletionBoxEntry::Vec_t m_entries;
+    clFuzzyMatcher m_matcher;        // filters m_allEntries
+    clFuzzyMatcher::Vec_t m_matches; // the last filter result
     wxCodeCompletionBox::BmpVec_t m_bitmaps;
     static wxCodeCompletionBox::BmpVec_t m_defaultBitmaps;
 
@@ -84,10 +84,12 @@ void SFTPWorkerThread::ProcessRequest(ThreadRequest* request)
                 // We don't really need this case. Just make the compiler silence
                 return;
             case eSFTPActions::kUpload: {
-                DoReportStatusBarMessage(wxString() << _("Uploading file: ") << req->GetRemoteFile());
+                m_transferMessage.Clear();
+                m_transferMessage << _("Uploading file: ") << req->GetRemoteFile();
+                DoReportStatusBarMessage(m_transferMessage);
                 SFTPAttribute::Ptr_t attr(new SFTPAttribute(NULL));
                 attr->SetPermissions(req->GetPermissions());
-                m_sftp->CreateRemoteFile(req->GetRemoteFile(), wxFileName(req->GetLocalFile()), attr);
+                m_sftp->CreateRemoteFile(req->GetRemoteFile(), wxFileName(req->GetLocalFile()), attr, this);
                 msg << "Successfully uploaded file: " << req->GetLocalFile() << " -> " << req->GetRemoteFile();
                 DoReportMessage(accountName, msg, SFTPThreadMessage::STATUS_OK);
                 DoReportStatusBarMessage("");
@@ -96,14 +98,11 @@ void SFTPWorkerThread::ProcessRequest(ThreadRequest* request)
             case eSFTPActions::kDownload:
             case eSFTPActions::kDownloadAndOpenContainingFolder:
             case eSFTPActions::kDownloadAndOpenWithDefaultApp: {
-                DoReportStatusBarMessage(wxString() << _("Downloading file: ") << req->GetRemoteFile());
-                wxMemoryBuffer buffer;
-                SFTPAttribute::Ptr_t fileAttr = m_sftp->Read(req->GetRemoteFile(), buffer);
-                wxFFile fp(req->GetLocalFile(), "w+b");
-                if(fp.IsOpened()) {
-                    fp.Write(buffer.GetData(), buffer.GetDataLen());
-                    fp.Close();
-                }
+                m_transferMessage.Clear();
+                m_transferMessage << _("Downloading file: ") << req->GetRemoteFile();
+                DoReportStatusBarMessage(m_transferMessage);
+                SFTPAttribute::Ptr_t fileAttr =
+                    m_sftp->Download(req->GetRemoteFile(), wxFileName(req->GetLocalFile()), this);
 
                 msg << "Successfully downloaded file: " << req->GetLocalFile() << " <- " << req->GetRemoteFile();
                 DoReportMessage(accountName, msg, SFTPThreadMessage::STATUS_OK);
@@ -157,7 +156,8 @@ void SFTPWorkerThread::ProcessRequest(ThreadRequest* request)
                 msg << "Retrying to upload file: " << req->GetRemoteFile();
                 DoReportMessage(req->GetAccount().GetAccountName(), msg, SFTPThreadMessage::STATUS_NONE);
 
-                // first time trying this request, requeue it
+                // first time trying this request, requeue it. An interrupted transfer continues from where
+                // it stopped
                 SFTPThreadRequet* retryReq = static_cast<SFTPThreadRequet*>(req->Clone());
                 retryReq->SetRetryCounter(1);
                 Add(retryReq);
@@ -213,6 +213,18 @@ void SFTPWorkerThread::DoReportStatusBarMessage(const wxString& message)
     GetNotifiedWindow()->CallAfter(&SFTPStatusPage::SetStatusBarMessage, message);
 }
 
+bool SFTPWorkerThread::OnTransferProgress(wxInt64 bytesDone, wxInt64 totalBytes, double bytesPerSecond)
+{
+    wxString message = m_transferMessage;
+    message << " " << wxFileName::GetHumanReadableSize(wxULongLong(bytesDone)) << " / "
+            << wxFileName::GetHumanReadableSize(wxULongLong(totalBytes)) << " ("
+            << wxFileName::GetHumanReadableSize(wxULongLong((wxULongLong_t)bytesPerSecond)) << "/s)";
+    DoReportStatusBarMessage(message);
+
+    // Abort the transfer when the thread is stopped
+    return !TestDestroy();
+}
+
 // -----------------------------------------
 // SFTPWriterThreadRequet
 // -----------------------------------------
@@ -110,11 +110,12 @@ public:
     int GetStatus() const { return m_status; }
 };
 
-class SFTPWorkerThread : public WorkerThread
+class SFTPWorkerThread : public WorkerThread, public clSFTPTransferCallback
 {
     static SFTPWorkerThread* ms_instance;
     clSFTP::Ptr_t m_sftp;
     SFTP* m_plugin;
+    wxString m_transferMessage; // the status bar message of the current transfer
 
 public:
     static SFTPWorkerThread* Instance();
@@ -129,6 +130,7 @@ private:
 
 public:
     virtual void ProcessRequest(ThreadRequest* request);
+    virtual bool OnTransferProgress(wxInt64 bytesDone, wxInt64 totalBytes, double bytesPerSecond);
     void SetSftpPlugin(SFTP* sftp);
 };
 
@@ -5,13 +5,20 @@
 #include "globals.h"
 #include "ieditor.h"
 #include "imanager.h"
+#include <wx/app.h>
 #include <wx/stc/stc.h>
 
+// When more lines than this were modified since the last completion (e.g. the file was reloaded),
+// parse the whole file in the background instead of parsing the modified lines in the main thread
+#define WORD_COMPLETION_MAX_DIRTY_LINES 500
+
 WordCompletionDictionary::WordCompletionDictionary()
+    : m_requestId(0)
 {
     EventNotifier::Get()->Bind(wxEVT_ACTIVE_EDITOR_CHANGED, &WordCompletionDictionary::OnEditorChanged, this);
+    EventNotifier::Get()->Bind(wxEVT_EDITOR_CLOSING, &WordCompletionDictionary::OnEditorClosing, this);
     EventNotifier::Get()->Bind(wxEVT_ALL_EDITORS_CLOSED, &WordCompletionDictionary::OnAllEditorsClosed, this);
-    EventNotifier::Get()->Bind(wxEVT_FILE_SAVED, &WordCompletionDictionary::OnFileSaved, this);
+    wxTheApp->Bind(wxEVT_STC_MODIFIED, &WordCompletionDictionary::OnStcModified, this);
 
     m_thread = new WordCompletionThread(this);
     m_thread->Start();
@@ -20,8 +27,9 @@ WordCompletionDictionary::WordCompletionDictionary()
 WordCompletionDictionary::~WordCompletionDictionary()
 {
     EventNotifier::Get()->Unbind(wxEVT_ACTIVE_EDITOR_CHANGED, &WordCompletionDictionary::OnEditorChanged, this);
+    EventNotifier::Get()->Unbind(wxEVT_EDITOR_CLOSING, &WordCompletionDictionary::OnEditorClosing, this);
     EventNotifier::Get()->Unbind(wxEVT_ALL_EDITORS_CLOSED, &WordCompletionDictionary::OnAllEditorsClosed, this);
-    EventNotifier::Get()->Unbind(wxEVT_FILE_SAVED, &WordCompletionDictionary::OnFileSaved, this);
+    wxTheApp->Unbind(wxEVT_STC_MODIFIED, &WordCompletionDictionary::OnStcModified, this);
 
     m_thread->Stop();   // Stop the thread
     wxDELETE(m_thread); // Delete it
@@ -31,93 +39,128 @@ void WordCompletionDictionary::OnEditorChanged(wxCommandEvent& event)
 {
     event.Skip();
 
-    // 1) Get a list of all open editors and set the compare it to the current cached files
-    //    and delete all "closed" editors
-    // 2) Request to cache the newly opened file's words
+    // 1) Get a list of all open editors and compare it to the indexed editors
+    //    and remove all "closed" editors
+    // 2) Request to index the newly opened file's words
     IEditor::List_t allEditors;
-    wxArrayString openEditors, cachedEditors, closedEditors;
     ::clGetManager()->GetAllEditors(allEditors);
 
+    std::unordered_map<wxStyledTextCtrl*, wxString> openEditors;
     std::for_each(allEditors.begin(), allEditors.end(), [&](IEditor* editor) {
-        openEditors.Add(editor->GetFileName().GetFullPath());
+        openEditors.insert(std::make_pair(editor->GetCtrl(), editor->GetFileName().GetFullPath()));
     });
 
-    std::for_each(m_files.begin(), m_files.end(), [&](const std::pair<wxString, wxStringSet_t>& p) {
-        cachedEditors.Add(p.first);
-    });
+    std::unordered_map<wxStyledTextCtrl*, wxString>::iterator iter = m_editors.begin();
+    while(iter != m_editors.end()) {
+        std::unordered_map<wxStyledTextCtrl*, wxString>::iterator openIter = openEditors.find(iter->first);
+        if(openIter == openEditors.end() || openIter->second != iter->second) {
+            // closed (or renamed)
+            m_index.RemoveFile(iter->second);
+            iter = m_editors.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
 
-    // std::set_difference requires that both arrays will be sorted
-    openEditors.Sort();
-    cachedEditors.Sort();
+    // 2: index the active editor
+    DoCacheActiveEditor();
+}
 
-    // Create a new array "closedEditors" which contains list of files that exists
-    // in the cachedEditors but not in openEditors list
-    std::set_difference(cachedEditors.begin(),
-                        cachedEditors.end(),
-                        openEditors.begin(),
-                        openEditors.end(),
-                        std::back_inserter(closedEditors));
+void WordCompletionDictionary::OnEditorClosing(wxCommandEvent& event)
+{
+    event.Skip();
+    IEditor* editor = reinterpret_cast<IEditor*>(event.GetClientData());
+    CHECK_PTR_RET(editor);
 
-    for(size_t i = 0; i < closedEditors.size(); ++i) {
-        m_files.erase(closedEditors.Item(i));
+    std::unordered_map<wxStyledTextCtrl*, wxString>::iterator iter = m_editors.find(editor->GetCtrl());
+    if(iter != m_editors.end()) {
+        m_index.RemoveFile(iter->second);
+        m_editors.erase(iter);
     }
-
-    // 2: cache the active editor
-    DoCacheActiveEditor(false);
 }
 
 void WordCompletionDictionary::OnSuggestThread(const WordCompletionThreadReply& reply)
 {
-    // Remove the current file's dictionary
-    std::map<wxString, wxStringSet_t>::iterator iter = m_files.find(reply.filename.GetFullPath());
-    if(iter != m_files.end()) m_files.erase(iter);
-
-    // Keep the words
-    m_files.insert(std::make_pair(reply.filename.GetFullPath(), reply.suggest));
+    // Keep the words (unless the file was closed or parsed again meanwhile)
+    m_index.SetFile(reply.filename.GetFullPath(), reply.requestId, reply.lines);
 }
 
 void WordCompletionDictionary::OnAllEditorsClosed(wxCommandEvent& event)
 {
     event.Skip();
-    m_files.clear();
+    m_index.Clear();
+    m_editors.clear();
+}
+
+void WordCompletionDictionary::OnStcModified(wxStyledTextEvent& event)
+{
+    event.Skip();
+    if(!(event.GetModificationType() & (wxSTC_MOD_INSERTTEXT | wxSTC_MOD_DELETETEXT))) { return; }
+
+    wxStyledTextCtrl* stc = dynamic_cast<wxStyledTextCtrl*>(event.GetEventObject());
+    std::unordered_map<wxStyledTextCtrl*, wxString>::iterator iter = m_editors.find(stc);
+    if(iter == m_editors.end()) { return; }
+
+    // Only the modified lines are parsed again, on the next completion
+    m_index.LinesChanged(iter->second, stc->LineFromPosition(event.GetPosition()), event.GetLinesAdded());
 }
 
-void WordCompletionDictionary::DoCacheActiveEditor(bool overwrite)
+void WordCompletionDictionary::DoCacheActiveEditor()
 {
-    // Step 2: cache the active editor (if not already cached)
+    // Step 2: index the active editor (if not already indexed)
     IEditor* activeEditor = ::clGetManager()->GetActiveEditor();
     CHECK_PTR_RET(activeEditor);
 
-    if(!overwrite && m_files.count(activeEditor->GetFileName().GetFullPath()))
-        return; // we already have this file in the cache
-        
-    m_files.erase(activeEditor->GetFileName().GetFullPath());
-    
-    // Insert a dummy entry, so we won't queue this file if not needed
-    m_files.insert(std::make_pair(activeEditor->GetFileName().GetFullPath(), wxStringSet_t()));
-    
-    // Queue this file
     wxStyledTextCtrl* stc = activeEditor->GetCtrl();
-    
-    // Invoke the thread to parse and suggets words for this file
+    if(m_editors.count(stc)) return; // we already have this file in the index
+
+    m_editors.insert(std::make_pair(stc, activeEditor->GetFileName().GetFullPath()));
+    DoParseFile(stc, activeEditor->GetFileName().GetFullPath());
+}
+
+void WordCompletionDictionary::DoParseFile(wxStyledTextCtrl* stc, const wxString& filename)
+{
+    // Invoke the thread to parse the whole file
     WordCompletionThreadRequest* req = new WordCompletionThreadRequest;
     req->buffer = stc->GetText();
-    req->filename = activeEditor->GetFileName();
+    req->filename = filename;
     req->filter = "filter";
+    req->requestId = ++m_requestId;
+    m_index.StartFullParse(filename, req->requestId);
     m_thread->Add(req);
 }
 
-void WordCompletionDictionary::OnFileSaved(clCommandEvent& event)
+void WordCompletionDictionary::DoUpdateDirtyLines()
 {
-    event.Skip();
-    DoCacheActiveEditor(true);
+    std::vector<int> dirtyLines;
+    std::for_each(m_editors.begin(), m_editors.end(), [&](const std::pair<wxStyledTextCtrl*, wxString>& p) {
+        if(m_index.IsFullParseInProgress(p.second)) { return; }
+
+        m_index.GetDirtyLines(p.second, dirtyLines);
+        if(dirtyLines.size() > WORD_COMPLETION_MAX_DIRTY_LINES) {
+            DoParseFile(p.first, p.second);
+            return;
+        }
+
+        for(size_t i = 0; i < dirtyLines.size(); ++i) {
+            WordCompletionIndex::Lines_t lines;
+            WordCompletionThread::ParseLines(p.first->GetLine(dirtyLines[i]), lines);
+
+            // GetLine() includes the line terminator
+            WordCompletionIndex::LineWords_t words;
+            std::for_each(lines.begin(), lines.end(), [&](const WordCompletionIndex::LineWords_t& lineWords) {
+                words.insert(words.end(), lineWords.begin(), lineWords.end());
+            });
+            m_index.SetLineWords(p.second, dirtyLines[i], words);
+        }
+    });
 }
 
-wxStringSet_t WordCompletionDictionary::GetWords() const
+wxStringSet_t WordCompletionDictionary::FindWords(const wxString& filter, bool prefix)
 {
+    DoUpdateDirtyLines();
+
     wxStringSet_t words;
-    std::for_each(m_files.begin(), m_files.end(), [&](const std::pair<wxString, wxStringSet_t>& p){
-        words.insert(p.second.begin(), p.second.end());
-    });
+    m_index.Find(filter, prefix, words);
     return words;
 }
@@ -32,19 +32,28 @@
 #include "WordCompletionThread.h"
 #include "WordCompletionRequestReply.h"
 #include "cl_command_event.h"
+#include "WordCompletionIndex.h"
+#include <unordered_map>
 
+class wxStyledTextCtrl;
+class wxStyledTextEvent;
 class WordCompletionDictionary : public wxEvtHandler
 {
-    std::map<wxString, wxStringSet_t> m_files;
+    WordCompletionIndex m_index;
+    std::unordered_map<wxStyledTextCtrl*, wxString> m_editors; // the open editors that are indexed
     WordCompletionThread* m_thread;
+    size_t m_requestId;
 
 protected:
     void OnEditorChanged(wxCommandEvent& event);
+    void OnEditorClosing(wxCommandEvent& event);
     void OnAllEditorsClosed(wxCommandEvent& event);
-    void OnFileSaved(clCommandEvent& event);
+    void OnStcModified(wxStyledTextEvent& event);
 
 private:
-    void DoCacheActiveEditor(bool overwrite);
+    void DoCacheActiveEditor();
+    void DoParseFile(wxStyledTextCtrl* stc, const wxString& filename);
+    void DoUpdateDirtyLines();
 
 public:
     WordCompletionDictionary();
@@ -57,9 +66,10 @@ public:
     void OnSuggestThread(const WordCompletionThreadReply& reply);
     
     /**
-     * @brief return a set of words from the current editors
+     * @brief return the words of the open editors that start with (or contain) 'filter'
+     * @param filter the word typed so far, in lower case
      */
-    wxStringSet_t GetWords() const;
+    wxStringSet_t FindWords(const wxString& filter, bool prefix);
 };
 
 #endif // WORDCOMPLETIONDICTIONARY_H
@@ -0,0 +1,192 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright            : (C) 2015 Eran Ifrah
+// File name            : WordCompletionIndex.cpp
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#include "WordCompletionIndex.h"
+#include <algorithm>
+
+WordCompletionIndex::WordCompletionIndex() {}
+
+WordCompletionIndex::~WordCompletionIndex() {}
+
+wxString WordCompletionIndex::MakeKey(const wxString& word)
+{
+    wxString key = word.Lower();
+    key << wxT('\1') << word;
+    return key;
+}
+
+void WordCompletionIndex::DoAddWords(const LineWords_t& words)
+{
+    for(size_t i = 0; i < words.size(); ++i) {
+        ++m_words[MakeKey(words[i])];
+    }
+}
+
+void WordCompletionIndex::DoRemoveWords(const LineWords_t& words)
+{
+    for(size_t i = 0; i < words.size(); ++i) {
+        std::map<wxString, size_t>::iterator iter = m_words.find(MakeKey(words[i]));
+        if(iter == m_words.end()) { continue; }
+        if(--iter->second == 0) { m_words.erase(iter); }
+    }
+}
+
+void WordCompletionIndex::DoLinesChanged(FileIndex& file, int line, int linesAdded)
+{
+    if(line < 0) { return; }
+    if((size_t)line >= file.m_lines.size()) { file.m_lines.resize(line + 1); }
+
+    std::set<int> dirtyLines;
+    if(linesAdded >= 0) {
+        // 'line' was modified and the new lines were added after it
+        std::for_each(file.m_dirtyLines.begin(), file.m_dirtyLines.end(),
+                      [&](int dirtyLine) { dirtyLines.insert(dirtyLine > line ? dirtyLine + linesAdded : dirtyLine); });
+        file.m_lines.insert(file.m_lines.begin() + line + 1, linesAdded, LineWords_t());
+        for(int i = line; i <= line + linesAdded; ++i) {
+            dirtyLines.insert(i);
+        }
+
+    } else {
+        // the lines after 'line' were joined into it
+        int deletedLines = -linesAdded;
+        int lastLine = std::min(line + deletedLines, (int)file.m_lines.size() - 1);
+        for(int i = line + 1; i <= lastLine; ++i) {
+            DoRemoveWords(file.m_lines[i]);
+        }
+        file.m_lines.erase(file.m_lines.begin() + line + 1, file.m_lines.begin() + lastLine + 1);
+
+        std::for_each(file.m_dirtyLines.begin(), file.m_dirtyLines.end(), [&](int dirtyLine) {
+            if(dirtyLine <= line) {
+                dirtyLines.insert(dirtyLine);
+            } else if(dirtyLine > line + deletedLines) {
+                dirtyLines.insert(dirtyLine - deletedLines);
+            }
+        });
+        dirtyLines.insert(line);
+    }
+    file.m_dirtyLines.swap(dirtyLines);
+}
+
+void WordCompletionIndex::RemoveFile(const wxString& filename)
+{
+    std::map<wxString, FileIndex>::iterator iter = m_files.find(filename);
+    if(iter == m_files.end()) { return; }
+
+    std::for_each(iter->second.m_lines.begin(), iter->second.m_lines.end(),
+                  [&](const LineWords_t& words) { DoRemoveWords(words); });
+    m_files.erase(iter);
+}
+
+void WordCompletionIndex::Clear()
+{
+    m_files.clear();
+    m_words.clear();
+}
+
+void WordCompletionIndex::StartFullParse(const wxString& filename, size_t requestId)
+{
+    FileIndex& file = m_files[filename];
+    file.m_requestId = requestId;
+    file.m_pendingChanges.clear();
+}
+
+bool WordCompletionIndex::IsFullParseInProgress(const wxString& filename) const
+{
+    std::map<wxString, FileIndex>::const_iterator iter = m_files.find(filename);
+    return iter != m_files.end() && iter->second.m_requestId != 0;
+}
+
+void WordCompletionIndex::SetFile(const wxString& filename, size_t requestId, const Lines_t& lines)
+{
+    std::map<wxString, FileIndex>::iterator iter = m_files.find(filename);
+    if(iter == m_files.end() || iter->second.m_requestId != requestId) {
+        // the file was closed, or parsed again since
+        return;
+    }
+
+    FileIndex& file = iter->second;
+    std::for_each(file.m_lines.begin(), file.m_lines.end(), [&](const LineWords_t& words) { DoRemoveWords(words); });
+    file.m_lines = lines;
+    std::for_each(file.m_lines.begin(), file.m_lines.end(), [&](const LineWords_t& words) { DoAddWords(words); });
+    file.m_dirtyLines.clear();
+    file.m_requestId = 0;
+
+    // Apply the changes that were made while the file was parsed
+    for(size_t i = 0; i < file.m_pendingChanges.size(); ++i) {
+        DoLinesChanged(file, file.m_pendingChanges[i].first, file.m_pendingChanges[i].second);
+    }
+    file.m_pendingChanges.clear();
+}
+
+void WordCompletionIndex::LinesChanged(const wxString& filename, int line, int linesAdded)
+{
+    std::map<wxString, FileIndex>::iterator iter = m_files.find(filename);
+    if(iter == m_files.end()) { return; }
+
+    FileIndex& file = iter->second;
+    if(file.m_requestId) { file.m_pendingChanges.push_back(std::make_pair(line, linesAdded)); }
+    DoLinesChanged(file, line, linesAdded);
+}
+
+void WordCompletionIndex::GetDirtyLines(const wxString& filename, std::vector<int>& lines) const
+{
+    lines.clear();
+    std::map<wxString, FileIndex>::const_iterator iter = m_files.find(filename);
+    if(iter == m_files.end()) { return; }
+    lines.insert(lines.end(), iter->second.m_dirtyLines.begin(), iter->second.m_dirtyLines.end());
+}
+
+void WordCompletionIndex::SetLineWords(const wxString& filename, int line, const LineWords_t& words)
+{
+    std::map<wxString, FileIndex>::iterator iter = m_files.find(filename);
+    if(iter == m_files.end()) { return; }
+
+    FileIndex& file = iter->second;
+    if(line < 0 || (size_t)line >= file.m_lines.size()) { return; }
+    DoRemoveWords(file.m_lines[line]);
+    file.m_lines[line] = words;
+    DoAddWords(words);
+    file.m_dirtyLines.erase(line);
+}
+
+void WordCompletionIndex::Find(const wxString& filter, bool prefix, wxStringSet_t& words) const
+{
+    if(prefix) {
+        // The keys that start with 'filter' are consecutive
+        std::map<wxString, size_t>::const_iterator iter = m_words.lower_bound(filter);
+        for(; iter != m_words.end() && iter->first.StartsWith(filter); ++iter) {
+            words.insert(iter->first.AfterFirst(wxT('\1')));
+        }
+
+    } else {
+        std::for_each(m_words.begin(), m_words.end(), [&](const std::pair<wxString, size_t>& p) {
+            // match only the lower case part of the key
+            size_t where = p.first.find(filter);
+            if(where != wxString::npos && (where + filter.length()) <= p.first.find(wxT('\1'))) {
+                words.insert(p.first.AfterFirst(wxT('\1')));
+            }
+        });
+    }
+}
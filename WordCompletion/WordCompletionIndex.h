@@ -0,0 +1,112 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright            : (C) 2015 Eran Ifrah
+// File name            : WordCompletionIndex.h
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef WORDCOMPLETIONINDEX_H
+#define WORDCOMPLETIONINDEX_H
+
+#include "macros.h"
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+#include <wx/string.h>
+
+/**
+ * @class WordCompletionIndex
+ * @brief the words of the open files, kept per line so a modification only re-parses the modified lines.
+ * The words of all the files are kept in a single sorted map (with a reference count), keyed by their lower
+ * case form, so the words that start with a given prefix are found without scanning all of them
+ */
+class WordCompletionIndex
+{
+public:
+    typedef std::vector<wxString> LineWords_t;
+    typedef std::vector<LineWords_t> Lines_t;
+
+protected:
+    struct FileIndex {
+        Lines_t m_lines;
+        std::set<int> m_dirtyLines; // lines that were modified since they were parsed
+        size_t m_requestId;         // the full parse in progress (0 if none)
+        std::vector<std::pair<int, int> > m_pendingChanges; // changes made during the full parse
+        FileIndex()
+            : m_requestId(0)
+        {
+        }
+    };
+
+    std::map<wxString, FileIndex> m_files;
+    std::map<wxString, size_t> m_words; // <lower case word>\1<word> -> number of occurrences
+
+protected:
+    static wxString MakeKey(const wxString& word);
+    void DoAddWords(const LineWords_t& words);
+    void DoRemoveWords(const LineWords_t& words);
+    void DoLinesChanged(FileIndex& file, int line, int linesAdded);
+
+public:
+    WordCompletionIndex();
+    virtual ~WordCompletionIndex();
+
+    bool HasFile(const wxString& filename) const { return m_files.count(filename); }
+    bool IsFullParseInProgress(const wxString& filename) const;
+    void RemoveFile(const wxString& filename);
+    void Clear();
+
+    /**
+     * @brief a full parse of 'filename' was requested. Until it completes, the file keeps its current words and
+     * the line changes are recorded, to be applied on top of the parse result
+     */
+    void StartFullParse(const wxString& filename, size_t requestId);
+
+    /**
+     * @brief set the words of 'filename' from a full parse. The result of an outdated request is ignored
+     */
+    void SetFile(const wxString& filename, size_t requestId, const Lines_t& lines);
+
+    /**
+     * @brief text was inserted or deleted in 'filename'
+     * @param line the line where the modification started
+     * @param linesAdded the number of lines added (negative when lines were deleted)
+     */
+    void LinesChanged(const wxString& filename, int line, int linesAdded);
+
+    /**
+     * @brief return the lines of 'filename' that need to be parsed again
+     */
+    void GetDirtyLines(const wxString& filename, std::vector<int>& lines) const;
+
+    /**
+     * @brief set the words of a single line
+     */
+    void SetLineWords(const wxString& filename, int line, const LineWords_t& words);
+
+    /**
+     * @brief find the words that start with (or contain) 'filter'. 'filter' must be in lower case
+     */
+    void Find(const wxString& filter, bool prefix, wxStringSet_t& words) const;
+};
+
+#endif // WORDCOMPLETIONINDEX_H
@@ -26,6 +26,7 @@
 #ifndef WordCompletionRequestReply_H__
 #define WordCompletionRequestReply_H__
 
+#include "WordCompletionIndex.h"
 #include "worker_thread.h"
 
 struct WordCompletionThreadRequest : public ThreadRequest {
@@ -33,10 +34,12 @@ struct WordCompletionThreadRequest : public ThreadRequest {
     wxString filter;
     wxFileName filename;
     bool insertSingleMatch;
+    size_t requestId;
 };
 
 struct WordCompletionThreadReply {
-    wxStringSet_t suggest;
+    WordCompletionIndex::Lines_t lines;
+    size_t requestId;
     wxFileName filename;
     wxString filter;
     bool insertSingleMatch;
@@ -16,15 +16,13 @@ void WordCompletionThread::ProcessRequest(ThreadRequest* request)
     WordCompletionThreadRequest* req = dynamic_cast<WordCompletionThreadRequest*>(request);
     CHECK_PTR_RET(req);
 
-    wxStringSet_t suggestsions;
-    ParseBuffer(req->buffer, suggestsions);
-
     // Parse and send back the reply
     WordCompletionThreadReply reply;
+    ParseLines(req->buffer, reply.lines);
+    reply.requestId = req->requestId;
     reply.filename = req->filename;
     reply.filter = req->filter;
     reply.insertSingleMatch = req->insertSingleMatch;
-    reply.suggest.swap(suggestsions);
     m_dict->CallAfter(&WordCompletionDictionary::OnSuggestThread, reply);
 }
 
@@ -67,3 +65,42 @@ void WordCompletionThread::ParseBuffer(const wxString& buffer, wxStringSet_t& su
     ::WordLexerDestroy(&scanner);
 #endif
 }
+
+void WordCompletionThread::ParseLines(const wxString& buffer, WordCompletionIndex::Lines_t& lines)
+{
+    lines.clear();
+    lines.push_back(WordCompletionIndex::LineWords_t());
+
+    WordScanner_t scanner = ::WordLexerNew(buffer);
+    if(!scanner) return;
+    WordLexerToken token;
+    std::string curword;
+    while(::WordLexerNext(scanner, token)) {
+        switch(token.type) {
+        case kWordDelim:
+            if(!curword.empty()) {
+                lines.back().push_back(wxString::FromUTF8(curword.c_str()));
+            }
+            curword.clear();
+            // A new line. Words never span lines, since '\n' is a delimiter
+            if(token.text[0] == '\n') {
+                lines.push_back(WordCompletionIndex::LineWords_t());
+            }
+            break;
+
+        case kWordNumber: {
+            if(!curword.empty()) {
+                curword += token.text;
+            }
+            break;
+        }
+        default:
+            curword += token.text;
+            break;
+        }
+    }
+    if(!curword.empty()) {
+        lines.back().push_back(wxString::FromUTF8(curword.c_str()));
+    }
+    ::WordLexerDestroy(&scanner);
+}
@@ -31,6 +31,7 @@
 #include <wx/filename.h>
 #include "macros.h"
 #include "WordCompletionRequestReply.h"
+#include "WordCompletionIndex.h"
 
 class WordCompletionDictionary;
 class WordCompletionThread : public WorkerThread
@@ -48,6 +49,11 @@ public:
      * @brief parse 'buffer' and return set of words to complete
      */
     static void ParseBuffer(const wxString& buffer, wxStringSet_t& suggest);
+
+    /**
+     * @brief parse 'buffer' and return the words of each of its lines
+     */
+    static void ParseLines(const wxString& buffer, WordCompletionIndex::Lines_t& lines);
 };
 
 #endif // WORDCOMPLETIONTHREAD_H
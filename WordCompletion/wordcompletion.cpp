@@ -87,22 +87,9 @@ void WordCompletionPlugin::OnWordComplete(clCodeCompletionEvent& event)
 
     wxString filter = event.GetWord().Lower(); // stc->GetTextRange(start, curPos);
 
-    wxStringSet_t words = m_dictionary->GetWords();
-    // Parse the current bufer (if modified), to include non saved words
-    if(activeEditor->IsModified()) {
-        // For performance (this parsing is done in the main thread)
-        // only parse the visible area of the document
-        wxStringSet_t unsavedBufferWords;
-        wxStyledTextCtrl* stc = activeEditor->GetCtrl();
-        int startPos = stc->PositionFromLine(stc->GetFirstVisibleLine());
-        int endPos = stc->GetCurrentPos();
-
-        wxString buffer = stc->GetTextRange(startPos, endPos);
-        WordCompletionThread::ParseBuffer(buffer, unsavedBufferWords);
-
-        // Merge the results
-        words.insert(unsavedBufferWords.begin(), unsavedBufferWords.end());
-    }
+    // The dictionary is kept up to date with the unsaved changes, and returns only the matching words
+    bool startsWith = (settings.GetComparisonMethod() == WordCompletionSettings::kComparisonStartsWith);
+    wxStringSet_t words = m_dictionary->FindWords(filter, startsWith);
 
     // Get the editor keywords and add them
     LexerConf::Ptr_t lexer = ColoursAndFontsManager::Get().GetLexerForFile(activeEditor->GetFileName().GetFullName());
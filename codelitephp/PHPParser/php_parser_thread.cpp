@@ -49,7 +49,6 @@ void PHPParserThread::ParseFiles(PHPParserThreadRequest* request)
 {
     wxFileName fnWorkspaceFile(request->workspaceFile);
     bool isFull = request->requestType == PHPParserThreadRequest::kParseWorkspaceFilesFull;
-    wxUnusedVar(isFull);
 
     wxStringSet_t uniqueFilesSet;
     uniqueFilesSet.insert(request->files.begin(), request->files.end());
@@ -76,13 +75,11 @@ void PHPParserThread::ParseFiles(PHPParserThreadRequest* request)
         allFiles.Add(*iter);
     }
 
-    // Get list of PHP files under
-    lookuptable.RecreateSymbolsDatabase(allFiles,
-                                        request->requestType == PHPParserThreadRequest::kParseWorkspaceFilesFull ?
-                                            PHPLookupTable::kUpdateMode_Full :
-                                            PHPLookupTable::kUpdateMode_Fast,
-                                        [&]() { return PHPParserThread::ms_goingDown; },
-                                        false);
+    // Parse the files using all the cores, this thread stores them into the database
+    PHPLookupTable::eUpdateMode updateMode =
+        isFull ? PHPLookupTable::kUpdateMode_Full : PHPLookupTable::kUpdateMode_Fast;
+    lookuptable.RecreateSymbolsDatabaseParallel(
+        allFiles, updateMode, [&]() { return PHPParserThread::ms_goingDown; }, false);
     // reset the shutdown flag
     ms_goingDown = false;
 }
@@ -0,0 +1,5 @@
+<?php
+
+class test_class_hierarchy_cache extends test_class_hierarchy_cache_base {
+    public function child_function() {}
+}
@@ -0,0 +1,5 @@
+<?php
+
+class test_class_hierarchy_cache_base {
+    public function base_function() {}
+}
@@ -856,6 +856,47 @@ TEST_FUNC(test_func_arg_in_lambda_in_assignment)
     return true;
 }
 
+// The members of a class and its parents are cached. Check that the cache follows the changes of the parent:
+// first it is missing, then it is parsed, then it gets a new member
+TEST_FUNC(test_class_hierarchy_cache)
+{
+    PHPSourceFile sourceFile(wxFileName("../Tests/test_class_hierarchy_cache.php"), &lookup);
+    sourceFile.SetParseFunctionBody(false);
+    sourceFile.Parse();
+    lookup.UpdateSourceFile(sourceFile);
+
+    PHPEntityBase::Ptr_t cls = lookup.FindClass("\\test_class_hierarchy_cache");
+    CHECK_BOOL(cls);
+    CHECK_SIZE(lookup.FindChildren(cls->GetDbId()).size(), 1);
+
+    wxFileName baseFile("../Tests/test_class_hierarchy_cache_base.php");
+    {
+        PHPSourceFile baseSource(baseFile, &lookup);
+        baseSource.SetParseFunctionBody(false);
+        baseSource.Parse();
+        lookup.UpdateSourceFile(baseSource);
+    }
+    CHECK_SIZE(lookup.FindChildren(cls->GetDbId()).size(), 2);
+    CHECK_BOOL(!lookup.FindMemberOf(cls->GetDbId(), "new_base_function"));
+
+    {
+        // Re-parse the parent with a new member
+        PHPSourceFile baseSource("<?php\n"
+                                 "class test_class_hierarchy_cache_base {\n"
+                                 "    public function base_function() {}\n"
+                                 "    public function new_base_function() {}\n"
+                                 "}\n",
+                                 &lookup);
+        baseSource.SetFilename(baseFile);
+        baseSource.SetParseFunctionBody(false);
+        baseSource.Parse();
+        lookup.UpdateSourceFile(baseSource);
+    }
+    CHECK_SIZE(lookup.FindChildren(cls->GetDbId()).size(), 3);
+    CHECK_BOOL(lookup.FindMemberOf(cls->GetDbId(), "new_base_function"));
+    return true;
+}
+
 
 //======================-------------------------------------------------
 // Main
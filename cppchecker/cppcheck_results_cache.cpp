@@ -0,0 +1,169 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2014 Eran Ifrah
+// file name            : cppcheck_results_cache.cpp
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#include "cppcheck_results_cache.h"
+#include "file_logger.h"
+#include "json_node.h"
+
+// Bump this when the format of the cache file or of the cached output changes
+#define CPPCHECK_CACHE_VERSION 1
+
+// 64 bit FNV-1a
+#define CPPCHECK_HASH_OFFSET 14695981039346656037ULL
+#define CPPCHECK_HASH_PRIME 1099511628211ULL
+
+static wxUint64 HashString(const wxString& str)
+{
+    const wxCharBuffer buffer = str.mb_str(wxConvUTF8);
+    const unsigned char* p = (const unsigned char*)buffer.data();
+    wxUint64 hash = CPPCHECK_HASH_OFFSET;
+    for(size_t i = 0; i < buffer.length(); ++i) {
+        hash ^= p[i];
+        hash *= CPPCHECK_HASH_PRIME;
+    }
+    return hash;
+}
+
+// 64 bit values are stored as hex strings, JSON numbers are doubles
+static wxString ToHex(wxUint64 value) { return wxString::Format("%" wxLongLongFmtSpec "x", value); }
+
+static wxUint64 FromHex(const wxString& str)
+{
+    wxULongLong_t value = 0;
+    if(!str.ToULongLong(&value, 16)) { return 0; }
+    return value;
+}
+
+CppCheckResultsCache::CppCheckResultsCache()
+    : m_modified(false)
+{
+}
+
+CppCheckResultsCache::~CppCheckResultsCache() {}
+
+void CppCheckResultsCache::Load(const wxFileName& filename)
+{
+    m_filename = filename;
+    m_entries.clear();
+    m_modified = false;
+    if(!m_filename.FileExists()) { return; }
+
+    JSONRoot root(m_filename);
+    JSONElement json = root.toElement();
+    if(json.namedObject("version").toInt() != CPPCHECK_CACHE_VERSION) {
+        CL_DEBUG("CppCheck: discarding results cache %s (unknown version)", m_filename.GetFullPath());
+        return;
+    }
+
+    JSONElement files = json.namedObject("files");
+    int count = files.arraySize();
+    for(int i = 0; i < count; ++i) {
+        JSONElement item = files.arrayItem(i);
+        Entry entry;
+        entry.m_fingerprint.m_size = (wxInt64)FromHex(item.namedObject("size").toString());
+        entry.m_fingerprint.m_mtime = (wxInt64)FromHex(item.namedObject("mtime").toString());
+        entry.m_fingerprint.m_hash = FromHex(item.namedObject("hash").toString());
+        entry.m_options = FromHex(item.namedObject("options").toString());
+        entry.m_output = item.namedObject("output").toString();
+        m_entries[item.namedObject("file").toString()] = entry;
+    }
+    CL_DEBUG("CppCheck: loaded %d cached results from %s", count, m_filename.GetFullPath());
+}
+
+void CppCheckResultsCache::Save()
+{
+    if(!m_modified || !m_filename.IsOk()) { return; }
+
+    JSONRoot root(cJSON_Object);
+    JSONElement json = root.toElement();
+    json.addProperty("version", CPPCHECK_CACHE_VERSION);
+    JSONElement files = JSONElement::createArray("files");
+    json.append(files);
+    for(Map_t::const_iterator iter = m_entries.begin(); iter != m_entries.end(); ++iter) {
+        const Entry& entry = iter->second;
+        JSONElement item = JSONElement::createObject();
+        item.addProperty("file", iter->first);
+        item.addProperty("size", ToHex((wxUint64)entry.m_fingerprint.m_size));
+        item.addProperty("mtime", ToHex((wxUint64)entry.m_fingerprint.m_mtime));
+        item.addProperty("hash", ToHex(entry.m_fingerprint.m_hash));
+        item.addProperty("options", ToHex(entry.m_options));
+        item.addProperty("output", entry.m_output);
+        files.arrayAppend(item);
+    }
+    root.save(m_filename);
+    m_modified = false;
+}
+
+void CppCheckResultsCache::Clear()
+{
+    m_filename.Clear();
+    m_entries.clear();
+    m_modified = false;
+}
+
+bool CppCheckResultsCache::GetKey(const wxString& filename, const wxString& options, Entry& key) const
+{
+    key.m_options = HashString(options);
+    if(!key.m_fingerprint.ReadAttributes(filename)) { return false; }
+
+    Map_t::const_iterator iter = m_entries.find(filename);
+    if(iter != m_entries.end()) {
+        const clFileFingerprint& cached = iter->second.m_fingerprint;
+        if(cached.m_size == key.m_fingerprint.m_size && cached.m_mtime == key.m_fingerprint.m_mtime) {
+            // Not modified since it was cached, no need to read it
+            key.m_fingerprint.m_hash = cached.m_hash;
+            return true;
+        }
+    }
+    return key.m_fingerprint.ReadHash(filename);
+}
+
+bool CppCheckResultsCache::Find(const wxString& filename, const Entry& key, wxString& output)
+{
+    Map_t::iterator iter = m_entries.find(filename);
+    if(iter == m_entries.end()) { return false; }
+
+    Entry& entry = iter->second;
+    if(entry.m_fingerprint.m_size != key.m_fingerprint.m_size ||
+       entry.m_fingerprint.m_hash != key.m_fingerprint.m_hash || entry.m_options != key.m_options) {
+        return false;
+    }
+    if(entry.m_fingerprint.m_mtime != key.m_fingerprint.m_mtime) {
+        // Same content (e.g. after a 'touch'), record the new time so the file is not hashed again
+        entry.m_fingerprint.m_mtime = key.m_fingerprint.m_mtime;
+        m_modified = true;
+    }
+    output = entry.m_output;
+    return true;
+}
+
+void CppCheckResultsCache::Add(const wxString& filename, const Entry& key, const wxString& output)
+{
+    Entry& entry = m_entries[filename];
+    entry.m_fingerprint = key.m_fingerprint;
+    entry.m_options = key.m_options;
+    entry.m_output = output;
+    m_modified = true;
+}
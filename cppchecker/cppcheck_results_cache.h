@@ -0,0 +1,99 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2014 Eran Ifrah
+// file name            : cppcheck_results_cache.h
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef CPPCHECK_RESULTS_CACHE_H
+#define CPPCHECK_RESULTS_CACHE_H
+
+#include "clFileFingerprint.h"
+#include "wxStringHash.h"
+#include <unordered_map>
+#include <wx/filename.h>
+#include <wx/string.h>
+
+/**
+ * @class CppCheckResultsCache
+ * @brief the cppcheck output of every checked file, keyed by the file content hash and by the options it was
+ * checked with. A file is checked again only if its content or the options changed.
+ * Note that the content of the headers included by a file is not part of its key
+ */
+class CppCheckResultsCache
+{
+public:
+    struct Entry {
+        clFileFingerprint m_fingerprint;
+        wxUint64 m_options; // the hash of the options the file was checked with
+        wxString m_output;
+
+        Entry()
+            : m_options(0)
+        {
+        }
+    };
+    typedef std::unordered_map<wxString, Entry> Map_t;
+
+protected:
+    wxFileName m_filename;
+    Map_t m_entries;
+    bool m_modified;
+
+public:
+    CppCheckResultsCache();
+    virtual ~CppCheckResultsCache();
+
+    /**
+     * @brief load the cache from 'filename'. The entries currently loaded are discarded
+     */
+    void Load(const wxFileName& filename);
+
+    /**
+     * @brief write the cache to the file it was loaded from, if it was modified
+     */
+    void Save();
+
+    /**
+     * @brief discard the loaded entries (the cache file is kept)
+     */
+    void Clear();
+
+    /**
+     * @brief compute the key of 'filename' checked with 'options'. The file content is hashed only if its size or
+     * modification time changed since it was cached
+     * @return false if the file can not be read
+     */
+    bool GetKey(const wxString& filename, const wxString& options, Entry& key) const;
+
+    /**
+     * @brief find the output of 'filename' for 'key'
+     * @return false if the file was not checked with this content and these options
+     */
+    bool Find(const wxString& filename, const Entry& key, wxString& output);
+
+    /**
+     * @brief record the output of 'filename' for 'key'
+     */
+    void Add(const wxString& filename, const Entry& key, const wxString& output);
+};
+
+#endif // CPPCHECK_RESULTS_CACHE_H
@@ -118,7 +118,11 @@ public:
     virtual void Serialize(Archive& arch);
     virtual void DeSerialize(Archive& arch);
 
-    wxString GetOptions() const;
+    /**
+     * @brief return the cppcheck command line options
+     * @param jobs include the number of jobs (-j) option
+     */
+    wxString GetOptions(bool jobs = true) const;
     void LoadProjectSpecificSettings(ProjectPtr proj);
 };
 
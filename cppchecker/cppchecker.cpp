@@ -53,6 +53,10 @@
 #include <wx/xml/xml.h>
 #include <wx/xrc/xmlres.h>
 
+// Printed by the shell once cppcheck exits successfully. The exit status of the processes is not reported, a
+// check that crashed or was killed is detected by the missing marker
+#define CPPCHECK_COMPLETED_MARKER "codelite-cppcheck-check-completed"
+
 static CppCheckPlugin* thePlugin = NULL;
 
 // Define the plugin entry point
@@ -85,6 +89,8 @@ CppCheckPlugin::CppCheckPlugin(IManager* manager)
     , m_analysisInProgress(false)
     , m_fileCount(0)
     , m_fileProcessed(1)
+    , m_nextFile(0)
+    , m_stopping(false)
 {
     FileExtManager::Init();
 
@@ -205,6 +211,10 @@ void CppCheckPlugin::UnPlug()
 
     // terminate the cppcheck daemon
     wxDELETE(m_cppcheckProcess);
+    for(CheckJobMap_t::iterator iter = m_runningChecks.begin(); iter != m_runningChecks.end(); ++iter) {
+        delete iter->first;
+    }
+    m_runningChecks.clear();
 }
 
 wxMenu* CppCheckPlugin::CreateFileExplorerPopMenu()
@@ -269,7 +279,7 @@ wxMenu* CppCheckPlugin::CreateWorkspacePopMenu()
 
 void CppCheckPlugin::OnCheckFileEditorItem(wxCommandEvent& e)
 {
-    if(m_cppcheckProcess) {
+    if(AnalysisInProgress()) {
         clLogMessage(_("CppCheckPlugin: CppCheck is currently busy please wait for it to complete the current check"));
         return;
     }
@@ -287,7 +297,7 @@ void CppCheckPlugin::OnCheckFileEditorItem(wxCommandEvent& e)
 
 void CppCheckPlugin::OnCheckFileExplorerItem(wxCommandEvent& e)
 {
-    if(m_cppcheckProcess) {
+    if(AnalysisInProgress()) {
         clLogMessage(_("CppCheckPlugin: CppCheck is currently busy please wait for it to complete the current check"));
         return;
     }
@@ -307,7 +317,7 @@ void CppCheckPlugin::OnCheckFileExplorerItem(wxCommandEvent& e)
 
 void CppCheckPlugin::OnCheckWorkspaceItem(wxCommandEvent& e)
 {
-    if(m_cppcheckProcess) {
+    if(AnalysisInProgress()) {
         clLogMessage(_("CppCheckPlugin: CppCheck is currently busy please wait for it to complete the current check"));
         return;
     }
@@ -357,7 +367,7 @@ ProjectPtr CppCheckPlugin::FindSelectedProject()
 
 void CppCheckPlugin::OnCheckProjectItem(wxCommandEvent& e)
 {
-    if(m_cppcheckProcess) {
+    if(AnalysisInProgress()) {
         clLogMessage(_("CppCheckPlugin: CppCheck is currently busy please wait for it to complete the current check"));
         return;
     }
@@ -382,8 +392,34 @@ void CppCheckPlugin::OnCheckProjectItem(wxCommandEvent& e)
 
 void CppCheckPlugin::OnCppCheckTerminated(clProcessEvent& e)
 {
-    m_filelist.Clear();
+    CheckJobMap_t::iterator iter = m_runningChecks.find(e.GetProcess());
+    if(iter != m_runningChecks.end()) {
+        CheckJob job = iter->second;
+        m_runningChecks.erase(iter);
+        delete e.GetProcess();
+
+        bool completed = job.m_output.Contains(CPPCHECK_COMPLETED_MARKER);
+        job.m_output.Replace(CPPCHECK_COMPLETED_MARKER, "");
+
+        // The output of a terminated check is incomplete
+        if(!m_stopping) {
+            // Only the output of a complete run is cached, a crashed check is run again next time
+            if(job.m_cacheable && completed) { m_resultsCache.Add(job.m_file, job.m_key, job.m_output); }
+            DoReportFileOutput(job.m_output);
+        }
+        DoCheckNextFiles();
+        return;
+    }
+
     wxDELETE(m_cppcheckProcess);
+    DoAnalysisDone();
+}
+
+void CppCheckPlugin::DoAnalysisDone()
+{
+    m_resultsCache.Save();
+    m_reportedLines.clear();
+    m_filelist.Clear();
 
     m_view->PrintStatusMessage();
     m_view->GotoFirstError();
@@ -448,27 +484,107 @@ void CppCheckPlugin::GetFileListFromDir(const wxString& root)
 
 void CppCheckPlugin::DoProcess(ProjectPtr proj)
 {
+    if(m_settings.GetJobs() > 1 && !m_settings.GetUnusedFunctions()) {
+        // The unused functions check needs to see all the files at once, so it is always done by a single process
+        DoStartParallelCheck(proj);
+        return;
+    }
+
     wxString command = DoGetCommand(proj);
     m_view->AppendLine(wxString::Format(_("Starting cppcheck: %s\n"), command.c_str()));
 
+    m_cppcheckProcess = DoCreateProcess(command);
+    if(!m_cppcheckProcess) {
+        wxMessageBox(_("Failed to launch codelite_cppcheck process!"), _("Warning"), wxOK | wxCENTER | wxICON_WARNING);
+        return;
+    }
+}
+
+IProcess* CppCheckPlugin::DoCreateProcess(const wxString& command)
+{
 #if defined(__WXMSW__)
     // Under Windows, we set the working directory to the binary folder
     // so the configurtion files can be found
     CL_DEBUG("CppCheck: Working directory: %s", clStandardPaths::Get().GetBinFolder());
     CL_DEBUG("CppCheck: Command: %s", command);
-    m_cppcheckProcess = CreateAsyncProcess(this, command, IProcessCreateDefault, clStandardPaths::Get().GetBinFolder());
+    return CreateAsyncProcess(this, command, IProcessCreateDefault, clStandardPaths::Get().GetBinFolder());
 #elif defined(__WXOSX__)
     CL_DEBUG("CppCheck: Working directory: %s", clStandardPaths::Get().GetDataDir());
     CL_DEBUG("CppCheck: Command: %s", command);
-    m_cppcheckProcess = CreateAsyncProcess(this, command, IProcessCreateDefault, clStandardPaths::Get().GetDataDir());
+    return CreateAsyncProcess(this, command, IProcessCreateDefault, clStandardPaths::Get().GetDataDir());
 
 #else
-    m_cppcheckProcess = CreateAsyncProcess(this, command);
+    return CreateAsyncProcess(this, command);
 #endif
-    if(!m_cppcheckProcess) {
-        wxMessageBox(_("Failed to launch codelite_cppcheck process!"), _("Warning"), wxOK | wxCENTER | wxICON_WARNING);
-        return;
+}
+
+void CppCheckPlugin::DoStartParallelCheck(ProjectPtr proj)
+{
+    wxString path = clStandardPaths::Get().GetBinaryFullPath("codelite_cppcheck");
+    ::WrapWithQuotes(path);
+
+    // Every process checks a single file, so the number of jobs is not passed to cppcheck
+    m_checkOptions = DoGetOptions(proj, false);
+    m_checkCommand.Clear();
+    m_checkCommand << path << " " << m_checkOptions;
+
+    m_nextFile = 0;
+    m_stopping = false;
+    m_reportedLines.clear();
+    if(clCxxWorkspaceST::Get()->IsOpen()) {
+        m_resultsCache.Load(wxFileName(clCxxWorkspaceST::Get()->GetPrivateFolder(), "cppcheck.cache"));
+    } else {
+        m_resultsCache.Clear();
+    }
+
+    m_view->AppendLine(wxString::Format(_("Starting cppcheck (%d jobs): %s\n"), m_settings.GetJobs(), m_checkCommand));
+    DoCheckNextFiles();
+}
+
+void CppCheckPlugin::DoCheckNextFiles()
+{
+    while(!m_stopping && (m_runningChecks.size() < (size_t)m_settings.GetJobs()) &&
+          (m_nextFile < m_filelist.GetCount())) {
+        CheckJob job;
+        job.m_file = m_filelist.Item(m_nextFile++);
+        job.m_cacheable = m_resultsCache.GetKey(job.m_file, m_checkOptions, job.m_key);
+
+        wxString output;
+        if(job.m_cacheable && m_resultsCache.Find(job.m_file, job.m_key, output)) {
+            // Not modified since it was last checked
+            DoReportFileOutput(output);
+            continue;
+        }
+
+        wxString file = job.m_file;
+        ::WrapWithQuotes(file);
+        wxString command = m_checkCommand;
+        command << " " << file << " && echo " << CPPCHECK_COMPLETED_MARKER;
+        ::WrapInShell(command);
+
+        IProcess* process = DoCreateProcess(command);
+        if(!process) {
+            m_view->AppendLine(wxString::Format(_("Failed to launch codelite_cppcheck process for %s\n"), job.m_file));
+            continue;
+        }
+        m_runningChecks.insert(std::make_pair(process, job));
     }
+
+    if(m_runningChecks.empty()) { DoAnalysisDone(); }
+}
+
+void CppCheckPlugin::DoReportFileOutput(const wxString& output)
+{
+    ++m_fileProcessed;
+
+    // A problem found in a header is reported by every file including it, report it once
+    wxString report;
+    wxArrayString lines = ::wxStringTokenize(output, "\r\n", wxTOKEN_STRTOK);
+    for(size_t i = 0; i < lines.GetCount(); ++i) {
+        const wxString& line = lines.Item(i);
+        if(line.StartsWith("Checking ") || m_reportedLines.insert(line).second) { report << line << "\n"; }
+    }
+    if(!report.IsEmpty()) { m_view->AppendLine(report); }
 }
 
 /**
@@ -512,6 +628,14 @@ void CppCheckPlugin::StopAnalysis()
         // terminate the m_cppcheckProcess
         m_cppcheckProcess->Terminate();
     }
+
+    if(!m_runningChecks.empty()) {
+        // Do not launch the next files, the analysis ends when the running processes are terminated
+        m_stopping = true;
+        for(CheckJobMap_t::iterator iter = m_runningChecks.begin(); iter != m_runningChecks.end(); ++iter) {
+            iter->first->Terminate();
+        }
+    }
 }
 
 size_t CppCheckPlugin::GetProgress()
@@ -540,6 +664,7 @@ void CppCheckPlugin::RemoveExcludedFiles()
 void CppCheckPlugin::OnWorkspaceClosed(wxCommandEvent& e)
 {
     m_view->Clear();
+    if(m_runningChecks.empty()) { m_resultsCache.Clear(); }
     e.Skip();
 }
 
@@ -574,7 +699,19 @@ wxString CppCheckPlugin::DoGetCommand(ProjectPtr proj)
 
     // build the command
     cmd << path << " ";
-    cmd << m_settings.GetOptions();
+    cmd << DoGetOptions(proj, true);
+
+    cmd << wxT(" --file-list=");
+    ::WrapWithQuotes(fileList);
+    cmd << fileList << " ";
+    CL_DEBUG("cppcheck command: %s", cmd);
+    ::WrapInShell(cmd);
+    return cmd;
+}
+
+wxString CppCheckPlugin::DoGetOptions(ProjectPtr proj, bool jobs)
+{
+    wxString cmd = m_settings.GetOptions(jobs);
 
     // Append here project specifc search paths
     if(proj) {
@@ -591,12 +728,6 @@ wxString CppCheckPlugin::DoGetCommand(ProjectPtr proj)
             cmd << " -D" << projMacros.Item(i);
         }
     }
-
-    cmd << wxT(" --file-list=");
-    ::WrapWithQuotes(fileList);
-    cmd << fileList << " ";
-    CL_DEBUG("cppcheck command: %s", cmd);
-    ::WrapInShell(cmd);
     return cmd;
 }
 
@@ -627,6 +758,12 @@ wxString CppCheckPlugin::DoGenerateFileList()
 void CppCheckPlugin::OnCppCheckReadData(clProcessEvent& e)
 {
     e.Skip();
+    CheckJobMap_t::iterator iter = m_runningChecks.find(e.GetProcess());
+    if(iter != m_runningChecks.end()) {
+        // Reported when the file check is done, so the output of the processes is not interleaved
+        iter->second.m_output << e.GetOutput();
+        return;
+    }
     m_view->AppendLine(e.GetOutput());
 }
 
@@ -28,14 +28,33 @@
 
 #include "plugin.h"
 #include "asyncprocess.h"
+#include "cppcheck_results_cache.h"
 #include "cppcheck_settings.h"
 #include "clTabTogglerHelper.h"
+#include <unordered_map>
+#include <unordered_set>
 
 class wxMenuItem;
 class CppCheckReportPage;
 
 class CppCheckPlugin : public IPlugin
 {
+    /**
+     * @brief a file being checked by its own process during a parallel analysis
+     */
+    struct CheckJob {
+        wxString m_file;
+        CppCheckResultsCache::Entry m_key;
+        bool m_cacheable; // false if the file could not be hashed
+        wxString m_output;
+
+        CheckJob()
+            : m_cacheable(false)
+        {
+        }
+    };
+    typedef std::unordered_map<IProcess*, CheckJob> CheckJobMap_t;
+
     wxString m_cppcheckPath;
     IProcess* m_cppcheckProcess;
     bool m_canRestart;
@@ -50,9 +69,35 @@ class CppCheckPlugin : public IPlugin
     size_t m_fileProcessed;
     clTabTogglerHelper::Ptr_t m_tabHelper;
 
+    // Parallel analysis
+    CheckJobMap_t m_runningChecks;
+    size_t m_nextFile;       // the index in m_filelist of the next file to check
+    wxString m_checkCommand; // the command, without the file to check
+    wxString m_checkOptions;
+    bool m_stopping;
+    CppCheckResultsCache m_resultsCache;
+    std::unordered_set<wxString> m_reportedLines;
+
 protected:
     wxString DoGetCommand(ProjectPtr proj);
+    wxString DoGetOptions(ProjectPtr proj, bool jobs);
     wxString DoGenerateFileList();
+    IProcess* DoCreateProcess(const wxString& command);
+
+    /**
+     * @brief check the files of m_filelist using a pool of cppcheck processes, one process per file.
+     * The files that were not modified since they were last checked with the same options are not checked again
+     */
+    void DoStartParallelCheck(ProjectPtr proj);
+    /**
+     * @brief launch processes for the next files of the list, up to the number of jobs
+     */
+    void DoCheckNextFiles();
+    /**
+     * @brief append the output of a single file check to the view
+     */
+    void DoReportFileOutput(const wxString& output);
+    void DoAnalysisDone();
 
 protected:
     wxMenu* CreateEditorPopMenu();
@@ -148,7 +193,7 @@ public:
     /**
      * @brief return true if analysis currently running
      */
-    bool AnalysisInProgress() const { return m_cppcheckProcess != NULL; }
+    bool AnalysisInProgress() const { return m_cppcheckProcess != NULL || !m_runningChecks.empty(); }
 
     /**
      * @brief return the progress
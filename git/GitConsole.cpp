@@ -304,58 +304,49 @@ void GitConsole::OnConfigurationChanged(wxCommandEvent& e)
     m_isVerbose = (data.GetFlags() & GitEntry::Git_Verbose_Log);
 }
 
-void GitConsole::UpdateTreeView(const wxString& output)
+void GitConsole::UpdateTreeView(const GitStatusMap_t& status)
 {
     Clear();
     wxVector<wxVariant> cols;
-    wxArrayString files = ::wxStringTokenize(output, "\n\r", wxTOKEN_STRTOK);
+    std::vector<std::pair<wxString, wxString> > files; // relative path, full path
+    files.reserve(status.size());
+    for(GitStatusMap_t::const_iterator iter = status.begin(); iter != status.end(); ++iter) {
+        files.push_back(std::make_pair(iter->second.m_path, iter->first));
+    }
     std::sort(files.begin(), files.end());
 
-    BitmapLoader* bitmaps = clGetManager()->GetStdIcons();
-    for(size_t i = 0; i < files.GetCount(); ++i) {
-        wxString filename = files.Item(i);
-        filename.Trim().Trim(false);
-        filename.Replace("\t", " ");
-        wxString prefix = filename.BeforeFirst(' ');
-        filename = filename.AfterFirst(' ');
-        wxString filenameFullpath = filename;
-
-        filename.Trim().Trim(false);
-
-        wxFileName fn(filename);
-        if(fn.IsRelative()) {
-            fn.MakeAbsolute(m_git->GetRepositoryDirectory());
-            if(fn.FileExists()) { filenameFullpath = fn.GetFullPath(); }
-        }
-
+    for(size_t i = 0; i < files.size(); ++i) {
+        const wxString& filename = files[i].first;
+        const wxString& filenameFullpath = files[i].second;
         if(filename.EndsWith("/")) { continue; }
-        wxChar chX = prefix[0];
-        wxChar chY = 0;
-        if(prefix.length() > 1) { chY = prefix[1]; }
+
+        const GitFileStatus& file = status.find(filenameFullpath)->second;
+        wxChar chX = (file.m_index != '.') ? file.m_index : file.m_worktree;
 
         wxBitmap statusBmp;
         eGitFile kind = eGitFile::kUntrackedFile;
-        switch(chX) {
-        case 'M':
-            statusBmp = m_modifiedBmp;
-            kind = eGitFile::kModifiedFile;
-            break;
-        case 'A':
-            statusBmp = m_newBmp;
-            kind = eGitFile::kNewFile;
-            break;
-        case 'D':
-            statusBmp = m_deleteBmp;
-            kind = eGitFile::kDeletedFile;
-            break;
-        case 'R':
-            statusBmp = m_modifiedBmp;
-            kind = eGitFile::kRenamedFile;
-            break;
-        default:
+        if(file.m_kind == GitFileStatus::kUntracked) {
             statusBmp = m_untrackedBmp;
             kind = eGitFile::kUntrackedFile;
-            break;
+        } else {
+            switch(chX) {
+            case 'A':
+                statusBmp = m_newBmp;
+                kind = eGitFile::kNewFile;
+                break;
+            case 'D':
+                statusBmp = m_deleteBmp;
+                kind = eGitFile::kDeletedFile;
+                break;
+            case 'R':
+                statusBmp = m_modifiedBmp;
+                kind = eGitFile::kRenamedFile;
+                break;
+            default:
+                statusBmp = m_modifiedBmp;
+                kind = eGitFile::kModifiedFile;
+                break;
+            }
         }
 
         if(kind != eGitFile::kUntrackedFile) {
@@ -364,6 +355,7 @@ void GitConsole::UpdateTreeView(const wxString& output)
             cols.push_back(MakeFileBitmapLabel(filename));
             m_dvListCtrl->AppendItem(cols, (wxUIntPtr) new GitClientData(filenameFullpath, kind));
         } else {
+            wxFileName fn(filenameFullpath);
             cols.clear();
             cols.push_back(MakeFileBitmapLabel(fn.GetFullName()));
             cols.push_back(fn.GetFullPath());
@@ -25,6 +25,7 @@
 
 #ifndef GITCONSOLE_H
 #define GITCONSOLE_H
+#include "GitStatusEngine.h"
 #include "bitmap_loader.h"
 #include "clGenericSTCStyler.h"
 #include "gitui.h"
@@ -50,7 +51,7 @@ public:
     void AddRawText(const wxString& text);
     void AddText(const wxString& text);
     bool IsVerbose() const;
-    void UpdateTreeView(const wxString& output);
+    void UpdateTreeView(const GitStatusMap_t& status);
 
     /**
      * @brief return true if there are any deleted/new/modified items
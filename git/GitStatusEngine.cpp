@@ -0,0 +1,392 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2014 Eran Ifrah
+// file name            : GitStatusEngine.cpp
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#include "GitStatusEngine.h"
+#include "asyncprocess.h"
+#include "file_logger.h"
+#include "worker_thread.h"
+#include <wx/filename.h>
+#include <wx/stopwatch.h>
+#include <wx/tokenzr.h>
+
+class GitStatusRequest : public ThreadRequest
+{
+public:
+    size_t m_requestId;
+    wxString m_git;
+    wxString m_repositoryDirectory;
+    bool m_useFsmonitor;
+    bool m_reset;
+
+    GitStatusRequest()
+        : m_requestId(0)
+        , m_useFsmonitor(false)
+        , m_reset(false)
+    {
+    }
+    virtual ~GitStatusRequest() {}
+};
+
+class GitStatusThread : public WorkerThread
+{
+    GitStatusEngine* m_engine;
+    // the status delivered last, the next status is compared to it
+    wxString m_repositoryDirectory;
+    GitStatusMap_t m_status;
+    bool m_reset; // the next status delivered is not compared to m_status
+    // 'git rev-parse --show-toplevel' of every repository folder
+    std::unordered_map<wxString, wxString> m_topLevelDirectories;
+
+protected:
+    bool DoExecute(const wxString& command, const wxString& workingDirectory, wxString& output);
+    bool DoGetTopLevelDirectory(GitStatusRequest* req, wxString& topLevelDirectory, wxString& error);
+    void DoStatus(GitStatusRequest* req);
+
+public:
+    GitStatusThread(GitStatusEngine* engine)
+        : m_engine(engine)
+        , m_reset(true)
+    {
+    }
+    virtual ~GitStatusThread() {}
+
+    virtual void ProcessRequest(ThreadRequest* request)
+    {
+        GitStatusRequest* req = dynamic_cast<GitStatusRequest*>(request);
+        if(req) { DoStatus(req); }
+    }
+};
+
+bool GitStatusThread::DoExecute(const wxString& command, const wxString& workingDirectory, wxString& output)
+{
+    // The process API reports neither the exit code nor stderr separately: stderr is part of 'output', which the
+    // callers validate
+    output.Clear();
+    IProcess::Ptr_t process(
+        ::CreateSyncProcess(command, IProcessCreateDefault | IProcessCreateWithHiddenConsole, workingDirectory));
+    if(!process) { return false; }
+    process->WaitForTerminate(output);
+    return true;
+}
+
+bool GitStatusThread::DoGetTopLevelDirectory(GitStatusRequest* req, wxString& topLevelDirectory, wxString& error)
+{
+    std::unordered_map<wxString, wxString>::const_iterator iter =
+        m_topLevelDirectories.find(req->m_repositoryDirectory);
+    if(iter != m_topLevelDirectories.end()) {
+        topLevelDirectory = iter->second;
+        return true;
+    }
+
+    wxString output;
+    if(!DoExecute(req->m_git + " --no-pager rev-parse --show-toplevel", req->m_repositoryDirectory, output)) {
+        error = output;
+        return false;
+    }
+    // A single line with an existing folder, anything else is an error message
+    topLevelDirectory = output.Trim().Trim(false);
+    if(topLevelDirectory.IsEmpty() || topLevelDirectory.find_first_of("\r\n") != wxString::npos ||
+       !wxFileName::DirExists(topLevelDirectory)) {
+        error = output;
+        return false;
+    }
+    m_topLevelDirectories.insert(std::make_pair(req->m_repositoryDirectory, topLevelDirectory));
+    return true;
+}
+
+void GitStatusThread::DoStatus(GitStatusRequest* req)
+{
+    // A newer request is already queued
+    if(!m_engine->IsCurrent(req->m_requestId)) { return; }
+
+    GitStatusResult result;
+    result.m_requestId = req->m_requestId;
+    result.m_repositoryDirectory = req->m_repositoryDirectory;
+
+    if(req->m_reset || (m_repositoryDirectory != req->m_repositoryDirectory)) {
+        m_repositoryDirectory = req->m_repositoryDirectory;
+        m_status.clear();
+        m_reset = true;
+    }
+
+    wxString topLevelDirectory;
+    if(!DoGetTopLevelDirectory(req, topLevelDirectory, result.m_error)) {
+        m_engine->PostResult(result);
+        return;
+    }
+
+    // --no-optional-locks: do not refresh the index, so 'status' does not compete for index.lock with the commands
+    // run by the user. The records are separated by new lines and not by NUL ('-z'): the process output is
+    // converted to a string as it is read, which does not keep the NUL characters on all the platforms
+    wxString command = req->m_git;
+    command << " --no-pager --no-optional-locks -c core.quotePath=false";
+    if(req->m_useFsmonitor) { command << " -c core.fsmonitor=true -c core.untrackedCache=true"; }
+    command << " status --porcelain=v2";
+
+    wxStopWatch sw;
+    wxString output;
+    if(!DoExecute(command, req->m_repositoryDirectory, output)) {
+        result.m_error = output;
+        m_engine->PostResult(result);
+        return;
+    }
+    if(!GitStatusEngine::ParseStatus(output, topLevelDirectory, result.m_status, result.m_error)) {
+        m_engine->PostResult(result);
+        return;
+    }
+    CL_DEBUG("Git: status of %s read in %ld ms (%d files)", req->m_repositoryDirectory, sw.Time(),
+             (int)result.m_status.size());
+
+    GitStatusMap_t::const_iterator iter = result.m_status.begin();
+    for(; iter != result.m_status.end(); ++iter) {
+        GitStatusMap_t::const_iterator prev = m_status.find(iter->first);
+        if((prev == m_status.end()) || (prev->second != iter->second)) { result.m_changed.insert(*iter); }
+    }
+    for(iter = m_status.begin(); iter != m_status.end(); ++iter) {
+        if(!result.m_status.count(iter->first)) { result.m_cleaned.Add(iter->first); }
+    }
+
+    result.m_ok = true;
+    result.m_reset = m_reset;
+    m_reset = false;
+    m_status = result.m_status;
+    if(result.m_reset || !result.m_changed.empty() || !result.m_cleaned.IsEmpty()) { m_engine->PostResult(result); }
+}
+
+GitStatusEngine::GitStatusEngine(const GitStatusCallback_t& callback)
+    : m_thread(NULL)
+    , m_callback(callback)
+    , m_lastRequestId(0)
+    , m_cancelledRequestId(0)
+    , m_resetPending(false)
+{
+    m_thread = new GitStatusThread(this);
+    m_thread->Start();
+}
+
+GitStatusEngine::~GitStatusEngine()
+{
+    Cancel();
+    m_thread->Stop();
+    wxDELETE(m_thread);
+}
+
+void GitStatusEngine::Request(const wxString& git, const wxString& repositoryDirectory, bool useFsmonitor)
+{
+    GitStatusRequest* req = new GitStatusRequest();
+    req->m_git = git;
+    req->m_repositoryDirectory = repositoryDirectory;
+    req->m_useFsmonitor = useFsmonitor;
+    req->m_reset = m_resetPending;
+    m_resetPending = false;
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        req->m_requestId = ++m_lastRequestId;
+    }
+    m_thread->Add(req);
+}
+
+void GitStatusEngine::Cancel()
+{
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        m_cancelledRequestId = m_lastRequestId;
+    }
+    // The thread compares the next status to one that may never be delivered
+    m_resetPending = true;
+}
+
+bool GitStatusEngine::IsCurrent(size_t requestId)
+{
+    wxCriticalSectionLocker locker(m_cs);
+    return (requestId == m_lastRequestId) && (requestId > m_cancelledRequestId);
+}
+
+void GitStatusEngine::PostResult(const GitStatusResult& result) { CallAfter(&GitStatusEngine::OnResult, result); }
+
+void GitStatusEngine::OnResult(const GitStatusResult& result)
+{
+    // Results are delivered even if a newer request was made since: the thread compares every status to the one
+    // before it, so skipping a result would lose its changes
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        if(result.m_requestId <= m_cancelledRequestId) { return; }
+    }
+    if(m_callback) { m_callback(result); }
+}
+
+/**
+ * @brief return the position in 'record' after 'count' space separated fields
+ */
+static size_t SkipFields(const wxString& record, size_t count)
+{
+    size_t pos = 0;
+    for(size_t i = 0; i < count; ++i) {
+        pos = record.find(' ', pos);
+        if(pos == wxString::npos) { return wxString::npos; }
+        ++pos;
+    }
+    return pos;
+}
+
+/**
+ * @brief remove the C style quoting git applies to the paths with special characters
+ */
+static wxString UnquotePath(const wxString& path)
+{
+    if(path.length() < 2 || !path.StartsWith("\"") || !path.EndsWith("\"")) { return path; }
+
+    const wxCharBuffer utf8 = path.Mid(1, path.length() - 2).mb_str(wxConvUTF8);
+    const char* p = utf8.data();
+    std::string unquoted;
+    while(*p) {
+        if(*p != '\\') {
+            unquoted += *p++;
+            continue;
+        }
+        ++p;
+        switch(*p) {
+        case 'a':
+            unquoted += '\a';
+            break;
+        case 'b':
+            unquoted += '\b';
+            break;
+        case 'f':
+            unquoted += '\f';
+            break;
+        case 'n':
+            unquoted += '\n';
+            break;
+        case 'r':
+            unquoted += '\r';
+            break;
+        case 't':
+            unquoted += '\t';
+            break;
+        case 'v':
+            unquoted += '\v';
+            break;
+        case '\0':
+            continue;
+        default:
+            if(*p >= '0' && *p <= '7') {
+                // octal byte (UTF-8 sequences are quoted byte by byte)
+                int value = 0;
+                for(int i = 0; i < 3 && *p >= '0' && *p <= '7'; ++i, ++p) {
+                    value = (value * 8) + (*p - '0');
+                }
+                unquoted += (char)value;
+                continue;
+            }
+            unquoted += *p; // '"' and '\\'
+            break;
+        }
+        ++p;
+    }
+    return wxString::FromUTF8(unquoted.c_str(), unquoted.length());
+}
+
+bool GitStatusEngine::ParseStatus(const wxString& output, const wxString& topLevelDirectory, GitStatusMap_t& status,
+                                  wxString& error)
+{
+    // The paths are relative to the top level folder, and quoted if they contain special characters:
+    // 1 XY sub mH mI mW hH hI path
+    // 2 XY sub mH mI mW hH hI Xscore path<TAB>origPath
+    // u XY sub m1 m2 m3 mW h1 h2 h3 path
+    // ? path
+    // ! path (only with --ignored)
+    // # header (only with --branch or --show-stash)
+    // The output of git on stderr is mixed with the records: warnings are skipped, any other line is an error
+    status.clear();
+    error.Clear();
+    wxArrayString records = ::wxStringTokenize(output, "\r\n", wxTOKEN_STRTOK);
+    for(size_t i = 0; i < records.GetCount(); ++i) {
+        const wxString& record = records.Item(i);
+        if(record.StartsWith("warning:") || record.StartsWith("hint:")) {
+            CL_WARNING("Git status: %s", record);
+            continue;
+        }
+
+        GitFileStatus file;
+        size_t fieldsCount = 0;
+        switch((record.length() > 2 && record[1] == ' ') ? (wxChar)record[0] : wxChar(0)) {
+        case '1':
+            file.m_kind = GitFileStatus::kChanged;
+            fieldsCount = 8;
+            break;
+        case '2':
+            file.m_kind = GitFileStatus::kRenamed;
+            fieldsCount = 9;
+            break;
+        case 'u':
+            file.m_kind = GitFileStatus::kConflict;
+            fieldsCount = 10;
+            break;
+        case '?':
+            file.m_kind = GitFileStatus::kUntracked;
+            file.m_index = '?';
+            file.m_worktree = '?';
+            fieldsCount = 1;
+            break;
+        case '!':
+        case '#':
+            continue;
+        default:
+            error = record;
+            status.clear();
+            return false;
+        }
+
+        // Every field before the path is present, and so is the path
+        size_t pathStart = SkipFields(record, fieldsCount);
+        bool valid = (pathStart != wxString::npos) && (pathStart < record.length());
+        if(valid && file.m_kind != GitFileStatus::kUntracked) {
+            // XY
+            valid = (record.length() > 4) && (record[4] == ' ');
+            if(valid) {
+                file.m_index = record[2];
+                file.m_worktree = record[3];
+            }
+        }
+        wxString path = valid ? record.Mid(pathStart) : wxString();
+        if(valid && file.m_kind == GitFileStatus::kRenamed) {
+            valid = path.Contains("\t");
+            file.m_origPath = UnquotePath(path.AfterFirst('\t'));
+            path = path.BeforeFirst('\t');
+        }
+        if(!valid || path.IsEmpty()) {
+            error = record;
+            status.clear();
+            return false;
+        }
+        file.m_path = UnquotePath(path);
+
+        wxFileName fn(file.m_path);
+        fn.MakeAbsolute(topLevelDirectory);
+        status[fn.GetFullPath()] = file;
+    }
+    return true;
+}
@@ -0,0 +1,157 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2014 Eran Ifrah
+// file name            : GitStatusEngine.h
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef GITSTATUSENGINE_H
+#define GITSTATUSENGINE_H
+
+#include "wxStringHash.h"
+#include <functional>
+#include <unordered_map>
+#include <wx/arrstr.h>
+#include <wx/event.h>
+#include <wx/string.h>
+#include <wx/thread.h>
+
+/**
+ * @brief the status of a file, as reported by 'git status --porcelain=v2'
+ */
+struct GitFileStatus {
+    enum eKind {
+        kChanged,   // ordinary changed entry
+        kRenamed,   // renamed or copied entry
+        kConflict,  // unmerged entry
+        kUntracked, // untracked file (or folder, in which case the path ends with '/')
+    };
+
+    eKind m_kind;
+    wxChar m_index;      // X: the status in the index, '.' if unchanged
+    wxChar m_worktree;   // Y: the status in the working tree, '.' if unchanged
+    wxString m_path;     // relative to the repository top level folder
+    wxString m_origPath; // renamed or copied entries: the path of the source
+
+    GitFileStatus()
+        : m_kind(kChanged)
+        , m_index('.')
+        , m_worktree('.')
+    {
+    }
+
+    /**
+     * @brief is the file modified in the working tree (what 'git ls-files -m' lists)
+     */
+    bool IsModifiedInWorktree() const { return m_kind != kUntracked && m_worktree != '.'; }
+
+    bool operator==(const GitFileStatus& other) const
+    {
+        return m_kind == other.m_kind && m_index == other.m_index && m_worktree == other.m_worktree &&
+               m_path == other.m_path && m_origPath == other.m_origPath;
+    }
+    bool operator!=(const GitFileStatus& other) const { return !(*this == other); }
+};
+
+// The files that have a status, keyed by their full path
+typedef std::unordered_map<wxString, GitFileStatus> GitStatusMap_t;
+
+/**
+ * @brief the status of a repository, and how it changed since the previous status of the same repository
+ */
+struct GitStatusResult {
+    size_t m_requestId;
+    bool m_ok;
+    wxString m_error;
+    wxString m_repositoryDirectory; // as requested
+    GitStatusMap_t m_status;        // the complete status
+    GitStatusMap_t m_changed;       // the files added to the status or whose status changed
+    wxArrayString m_cleaned;        // the files that are no longer in the status (e.g. committed or reverted)
+    bool m_reset;                   // there is no previous status, all the files changed
+
+    GitStatusResult()
+        : m_requestId(0)
+        , m_ok(false)
+        , m_reset(false)
+    {
+    }
+};
+
+typedef std::function<void(const GitStatusResult&)> GitStatusCallback_t;
+
+class GitStatusThread;
+
+/**
+ * @class GitStatusEngine
+ * @brief read the status of the repository in the background with 'git status --porcelain=v2' and compare it
+ * to the previous status, so the caller only updates the files whose status changed.
+ * Requests are coalesced: when several requests are queued (e.g. a file is saved while the status is being read)
+ * only the latest one is executed. A result is delivered to the callback (on the main thread) only if the status
+ * changed
+ */
+class GitStatusEngine : public wxEvtHandler
+{
+    friend class GitStatusThread;
+
+    GitStatusThread* m_thread;
+    GitStatusCallback_t m_callback;
+    wxCriticalSection m_cs;
+    // protected by m_cs
+    size_t m_lastRequestId;
+    size_t m_cancelledRequestId; // the results of this request and of the ones before it are dropped
+    // main thread only
+    bool m_resetPending;
+
+protected:
+    // called from the worker thread
+    bool IsCurrent(size_t requestId);
+    void PostResult(const GitStatusResult& result);
+
+    void OnResult(const GitStatusResult& result);
+
+public:
+    GitStatusEngine(const GitStatusCallback_t& callback);
+    virtual ~GitStatusEngine();
+
+    /**
+     * @brief read the status of 'repositoryDirectory'
+     * @param git the git executable (quoted if needed)
+     * @param useFsmonitor use git's file system monitor and untracked cache, which avoid scanning the whole
+     * working tree (requires git 2.36 or later)
+     */
+    void Request(const wxString& git, const wxString& repositoryDirectory, bool useFsmonitor);
+
+    /**
+     * @brief drop the queued and running requests, their results are not delivered. The next request is a reset
+     */
+    void Cancel();
+
+    /**
+     * @brief parse the output of 'git status --porcelain=v2'
+     * @param topLevelDirectory the repository top level folder, the paths are relative to it
+     * @param error set to the first line that is not a valid record nor a warning
+     * @return false if the output is not a valid status, 'status' is then empty
+     */
+    static bool ParseStatus(const wxString& output, const wxString& topLevelDirectory, GitStatusMap_t& status,
+                            wxString& error);
+};
+
+#endif // GITSTATUSENGINE_H
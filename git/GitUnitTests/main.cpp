@@ -0,0 +1,113 @@
+#include "GitStatusEngine.h"
+#include "tester.h"
+#include <stdio.h>
+#include <wx/filename.h>
+#include <wx/init.h>
+#include <wx/log.h>
+
+#define GIT_TOP_LEVEL_DIRECTORY "/tmp/repo"
+
+static const GitFileStatus* FindGitFileStatus(const GitStatusMap_t& status, const wxString& path)
+{
+    wxFileName fn(path);
+    fn.MakeAbsolute(GIT_TOP_LEVEL_DIRECTORY);
+    GitStatusMap_t::const_iterator iter = status.find(fn.GetFullPath());
+    return (iter == status.end()) ? NULL : &iter->second;
+}
+
+TEST_FUNC(testGitStatusPorcelainV2)
+{
+    wxString output;
+    output << "# branch.oid 1a2b3c4d\n"
+           << "# branch.head master\n"
+           << "1 .M N... 100644 100644 100644 3f2e1d0c 3f2e1d0c src/main.cpp\n"
+           << "1 A. N... 000000 100644 100644 00000000 4b825dc6 \"src/caf\\303\\251.cpp\"\n"
+           << "2 R. N... 100644 100644 100644 5e6f7a8b 5e6f7a8b R100 src/new name.cpp\tsrc/old name.cpp\n"
+           << "u UU N... 100644 100644 100644 100644 11111111 22222222 33333333 src/conflict.cpp\n"
+           << "warning: could not open directory 'private/': Permission denied\n"
+           << "? build/\n"
+           << "? notes.txt\n"
+           << "! main.o\n";
+
+    GitStatusMap_t status;
+    wxString error;
+    CHECK_CONDITION(GitStatusEngine::ParseStatus(output, GIT_TOP_LEVEL_DIRECTORY, status, error),
+                    "expected a valid status");
+    CHECK_CONDITION(error.IsEmpty(), "expected no error");
+    CHECK_SIZE(status.size(), 6);
+
+    const GitFileStatus* file = FindGitFileStatus(status, "src/main.cpp");
+    CHECK_CONDITION(file, "src/main.cpp: not found");
+    CHECK_CONDITION(file->m_kind == GitFileStatus::kChanged, "src/main.cpp: expected a changed file");
+    CHECK_CONDITION(file->m_index == '.' && file->m_worktree == 'M', "src/main.cpp: expected '.M'");
+    CHECK_CONDITION(file->IsModifiedInWorktree(), "src/main.cpp: expected a modified file");
+
+    file = FindGitFileStatus(status, wxString::FromUTF8("src/caf\xc3\xa9.cpp"));
+    CHECK_CONDITION(file, "quoted path: not found");
+    CHECK_CONDITION(file->m_index == 'A' && file->m_worktree == '.', "quoted path: expected 'A.'");
+    CHECK_CONDITION(!file->IsModifiedInWorktree(), "quoted path: expected a file modified only in the index");
+
+    file = FindGitFileStatus(status, "src/new name.cpp");
+    CHECK_CONDITION(file, "renamed file: not found");
+    CHECK_CONDITION(file->m_kind == GitFileStatus::kRenamed, "renamed file: expected a renamed file");
+    CHECK_CONDITION(file->m_index == 'R' && file->m_worktree == '.', "renamed file: expected 'R.'");
+    CHECK_STRING(file->m_path.mb_str(wxConvUTF8).data(), "src/new name.cpp");
+    CHECK_STRING(file->m_origPath.mb_str(wxConvUTF8).data(), "src/old name.cpp");
+    CHECK_CONDITION(!FindGitFileStatus(status, "src/old name.cpp"), "renamed file: the source is not in the status");
+
+    file = FindGitFileStatus(status, "src/conflict.cpp");
+    CHECK_CONDITION(file, "conflict: not found");
+    CHECK_CONDITION(file->m_kind == GitFileStatus::kConflict, "conflict: expected an unmerged file");
+    CHECK_CONDITION(file->m_index == 'U' && file->m_worktree == 'U', "conflict: expected 'UU'");
+
+    file = FindGitFileStatus(status, "build/");
+    CHECK_CONDITION(file, "untracked folder: not found");
+    CHECK_CONDITION(file->m_kind == GitFileStatus::kUntracked, "untracked folder: expected an untracked file");
+    CHECK_CONDITION(!file->IsModifiedInWorktree(), "untracked folder: expected a file that is not modified");
+
+    file = FindGitFileStatus(status, "notes.txt");
+    CHECK_CONDITION(file, "untracked file: not found");
+    CHECK_CONDITION(file->m_index == '?' && file->m_worktree == '?', "untracked file: expected '??'");
+
+    CHECK_CONDITION(!FindGitFileStatus(status, "main.o"), "ignored file: expected no status");
+
+    // A clean working tree
+    CHECK_CONDITION(GitStatusEngine::ParseStatus("# branch.head master\n", GIT_TOP_LEVEL_DIRECTORY, status, error),
+                    "clean working tree: expected a valid status");
+    CHECK_SIZE(status.size(), 0);
+    return true;
+}
+
+TEST_FUNC(testGitStatusPorcelainV2Errors)
+{
+    const char* outputs[] = {
+        "fatal: not a git repository (or any of the parent directories): .git\n",
+        "? notes.txt\nerror: unknown option `porcelain=v2'\n",
+        // a truncated record, an invalid XY, a rename without its source and an untracked record without path
+        "1 .M N... 100644 100644\n",
+        "1 .MX N... 100644 100644 100644 3f2e1d0c 3f2e1d0c src/main.cpp\n",
+        "2 R. N... 100644 100644 100644 5e6f7a8b 5e6f7a8b R100 src/new.cpp\n",
+        "?\n",
+    };
+
+    for(size_t i = 0; i < sizeof(outputs) / sizeof(outputs[0]); ++i) {
+        GitStatusMap_t status;
+        wxString error;
+        GitStatusEngine::ParseStatus("? notes.txt\n", GIT_TOP_LEVEL_DIRECTORY, status, error);
+        CHECK_SIZE(status.size(), 1);
+
+        CHECK_CONDITION(!GitStatusEngine::ParseStatus(outputs[i], GIT_TOP_LEVEL_DIRECTORY, status, error), outputs[i]);
+        CHECK_CONDITION(!error.IsEmpty(), "expected the invalid line");
+        CHECK_SIZE(status.size(), 0);
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    wxInitializer initializer(argc, argv);
+    wxLogNull NOLOG;
+    Tester::Instance()->RunTests();
+    Tester::Release();
+    return 0;
+}
@@ -132,6 +132,9 @@ GitPlugin::GitPlugin(IManager* manager)
     , m_commitListDlg(NULL)
     , m_commandProcessor(NULL)
     , m_gitBlameDlg(NULL)
+    , m_statusEngine(NULL)
+    , m_treeItemsValid(false)
+    , m_treeOverlaysPending(false)
 {
     m_longName = _("GIT plugin");
     m_shortName = wxT("Git");
@@ -139,6 +142,7 @@ GitPlugin::GitPlugin(IManager* manager)
 
     Bind(wxEVT_ASYNC_PROCESS_OUTPUT, &GitPlugin::OnProcessOutput, this);
     Bind(wxEVT_ASYNC_PROCESS_TERMINATED, &GitPlugin::OnProcessTerminated, this);
+    m_statusEngine = new GitStatusEngine([this](const GitStatusResult& result) { OnStatusResult(result); });
 
     EventNotifier::Get()->Connect(wxEVT_INIT_DONE, wxCommandEventHandler(GitPlugin::OnInitDone), NULL, this);
     EventNotifier::Get()->Connect(wxEVT_WORKSPACE_LOADED, wxCommandEventHandler(GitPlugin::OnWorkspaceLoaded), NULL,
@@ -157,6 +161,8 @@ GitPlugin::GitPlugin(IManager* manager)
     EventNotifier::Get()->Bind(wxEVT_CONTEXT_MENU_FOLDER, &GitPlugin::OnFolderMenu, this);
     EventNotifier::Get()->Bind(wxEVT_ACTIVE_PROJECT_CHANGED, &GitPlugin::OnActiveProjectChanged, this);
     EventNotifier::Get()->Bind(wxEVT_CODELITE_MAINFRAME_GOT_FOCUS, &GitPlugin::OnAppActivated, this);
+    EventNotifier::Get()->Bind(wxEVT_WORKSPACE_VIEW_BUILD_STARTING, &GitPlugin::OnWorkspaceViewBuildStarting, this);
+    EventNotifier::Get()->Bind(wxEVT_FILE_VIEW_REFRESHED, &GitPlugin::OnFileViewRefreshed, this);
 
     wxTheApp->Bind(wxEVT_MENU, &GitPlugin::OnFolderPullRebase, this, XRCID("git_pull_rebase_folder"));
     wxTheApp->Bind(wxEVT_MENU, &GitPlugin::OnFolderCommit, this, XRCID("git_commit_folder"));
@@ -425,6 +431,14 @@ void GitPlugin::UnPlug()
                                      wxCommandEventHandler(GitPlugin::OnWorkspaceConfigurationChanged), NULL, this);
     EventNotifier::Get()->Unbind(wxEVT_ACTIVE_PROJECT_CHANGED, &GitPlugin::OnActiveProjectChanged, this);
     EventNotifier::Get()->Unbind(wxEVT_CODELITE_MAINFRAME_GOT_FOCUS, &GitPlugin::OnAppActivated, this);
+    EventNotifier::Get()->Unbind(wxEVT_WORKSPACE_VIEW_BUILD_STARTING, &GitPlugin::OnWorkspaceViewBuildStarting, this);
+    EventNotifier::Get()->Unbind(wxEVT_FILE_VIEW_REFRESHED, &GitPlugin::OnFileViewRefreshed, this);
+
+    clTreeCtrl* tree = m_mgr->GetWorkspaceTree();
+    if(tree) {
+        tree->Unbind(wxEVT_TREE_ITEM_EXPANDED, &GitPlugin::OnWorkspaceTreeItemsChanged, this);
+        tree->Unbind(wxEVT_TREE_DELETE_ITEM, &GitPlugin::OnWorkspaceTreeItemsChanged, this);
+    }
 
     /*Context Menu*/
     m_eventHandler->Disconnect(XRCID("git_add_file"), wxEVT_COMMAND_MENU_SELECTED,
@@ -444,6 +458,7 @@ void GitPlugin::UnPlug()
     wxTheApp->Bind(wxEVT_MENU, &GitPlugin::OnFolderStashPop, this, XRCID("git_stash_pop_folder"));
     Unbind(wxEVT_ASYNC_PROCESS_OUTPUT, &GitPlugin::OnProcessOutput, this);
     Unbind(wxEVT_ASYNC_PROCESS_TERMINATED, &GitPlugin::OnProcessTerminated, this);
+    wxDELETE(m_statusEngine);
     m_tabToggler.reset(NULL);
 }
 
@@ -849,21 +864,19 @@ void GitPlugin::OnListModified(wxCommandEvent& e)
 {
     wxUnusedVar(e);
     wxArrayString choices;
-    std::map<wxString, wxTreeItemId>::const_iterator it;
+    wxStringSet_t::const_iterator it;
 
-    // First get a map of the filepaths/treeitemids of modified files
-    std::map<wxString, wxTreeItemId> modifiedIDs;
-    CreateFilesTreeIDsMap(modifiedIDs, true);
-
-    for(it = modifiedIDs.begin(); it != modifiedIDs.end(); ++it) {
-        if(it->second.IsOk()) choices.Add(it->first);
+    // Only the modified files that are in the workspace view
+    for(it = m_modifiedFiles.begin(); it != m_modifiedFiles.end(); ++it) {
+        if(DoFindTreeItem(*it).IsOk()) choices.Add(*it);
     }
 
     if(choices.GetCount() == 0) return;
+    choices.Sort();
 
     wxString choice = wxGetSingleChoice(_("Jump to modifed file"), _("Modifed files"), choices, m_topWindow);
     if(!choice.IsEmpty()) {
-        wxTreeItemId id = modifiedIDs[choice];
+        wxTreeItemId id = DoFindTreeItem(choice);
         if(id.IsOk()) {
             m_mgr->GetWorkspaceTree()->EnsureVisible(id);
             m_mgr->GetWorkspaceTree()->SelectItem(id);
@@ -963,27 +976,8 @@ void GitPlugin::OnBisectReset(wxCommandEvent& e)
 void GitPlugin::OnFileSaved(clCommandEvent& e)
 {
     e.Skip();
-    std::map<wxString, wxTreeItemId>::const_iterator it;
-
-    // First get an up to date map of the filepaths/treeitemids of modified files
-    // (Trying to cache these results in segfaults when the tree has been modified)
-    std::map<wxString, wxTreeItemId> modifiedIDs;
-    CreateFilesTreeIDsMap(modifiedIDs, true);
-
-    for(it = modifiedIDs.begin(); it != modifiedIDs.end(); ++it) {
-        if(!it->second.IsOk()) {
-            GIT_MESSAGE(wxT("Stored item not found in tree, rebuilding item IDs"));
-            gitAction ga(gitListAll, wxT(""));
-            m_gitActionQueue.push_back(ga);
-            break;
-        }
-        DoSetTreeItemImage(m_mgr->GetWorkspaceTree(), it->second, OverlayTool::Bmp_Modified);
-    }
-
-    gitAction ga(gitListModified, wxT(""));
-    m_gitActionQueue.push_back(ga);
-    ProcessGitActionQueue();
-    RefreshFileListView();
+    // The status is read in the background, only the files whose status changed are updated
+    DoRequestStatus();
 }
 
 /*******************************************************************************/
@@ -997,6 +991,7 @@ void GitPlugin::OnFilesAddedToProject(clCommandEvent& e)
         DoAddFiles(files);
         RefreshFileListView();
     }
+    DoInvalidateTreeItems();
 }
 
 /*******************************************************************************/
@@ -1004,6 +999,7 @@ void GitPlugin::OnFilesRemovedFromProject(clCommandEvent& e)
 {
     e.Skip();
     RefreshFileListView(); // in git world, deleting a file is enough
+    DoInvalidateTreeItems();
 }
 
 /*******************************************************************************/
@@ -1025,6 +1021,13 @@ void GitPlugin::OnInitDone(wxCommandEvent& e)
 {
     e.Skip();
     m_topWindow = m_mgr->GetTheApp()->GetTopWindow();
+
+    // The workspace view items are created when their parent is expanded and deleted when the view is rebuilt
+    clTreeCtrl* tree = m_mgr->GetWorkspaceTree();
+    if(tree) {
+        tree->Bind(wxEVT_TREE_ITEM_EXPANDED, &GitPlugin::OnWorkspaceTreeItemsChanged, this);
+        tree->Bind(wxEVT_TREE_DELETE_ITEM, &GitPlugin::OnWorkspaceTreeItemsChanged, this);
+    }
 }
 /*******************************************************************************/
 void GitPlugin::ProcessGitActionQueue()
@@ -1042,6 +1045,14 @@ void GitPlugin::ProcessGitActionQueue()
 
     if(m_process) { return; }
 
+    if(ga.action == gitStatus) {
+        // The status is read in the background, the queue does not wait for it
+        m_gitActionQueue.pop_front();
+        DoRequestStatus();
+        ProcessGitActionQueue();
+        return;
+    }
+
     wxString command = m_pathGITExecutable;
 
     // Wrap the executable with quotes if needed
@@ -1082,24 +1093,12 @@ void GitPlugin::ProcessGitActionQueue()
         GIT_MESSAGE(wxT("%s. Repo path: %s"), command.c_str(), m_repositoryDirectory.c_str());
         break;
 
-    case gitStatus:
-        command << " --no-pager status -s";
-        GIT_MESSAGE1("%s", command.c_str());
-        GIT_MESSAGE1(wxT("%s. Repo path: %s"), command.c_str(), m_repositoryDirectory.c_str());
-        break;
-
     case gitListAll:
         GIT_MESSAGE1(wxT("Listing files in git repository"));
         command << wxT(" --no-pager ls-files");
         GIT_MESSAGE1(wxT("%s. Repo path: %s"), command.c_str(), m_repositoryDirectory.c_str());
         break;
 
-    case gitListModified:
-        GIT_MESSAGE1(wxT("Listing modified files in git repository"));
-        command << wxT(" --no-pager ls-files -m");
-        GIT_MESSAGE1(wxT("%s. Repo path: %s"), command.c_str(), m_repositoryDirectory.c_str());
-        break;
-
     case gitUpdateRemotes:
         GIT_MESSAGE1(wxT("Updating remotes"));
         command << wxT(" --no-pager remote update");
@@ -1325,35 +1324,8 @@ void GitPlugin::FinishGitListAction(const gitAction& ga)
 
     if(ga.action == gitListAll) {
         m_mgr->SetStatusMessage(_("Colouring tracked git files..."), 0);
-        ColourFileTree(m_mgr->GetWorkspaceTree(), gitFileSet, OverlayTool::Bmp_OK);
         m_trackedFiles.swap(gitFileSet);
-
-    } else if(ga.action == gitListModified) {
-        m_mgr->SetStatusMessage(_("Colouring modifed git files..."), 0);
-        // Reset modified files
-        ColourFileTree(m_mgr->GetWorkspaceTree(), m_modifiedFiles, OverlayTool::Bmp_OK);
-        // First get an up to date map of the filepaths/treeitemids
-        // (Trying to cache these results in segfaults when the tree has been modified)
-        std::map<wxString, wxTreeItemId> IDs;
-        CreateFilesTreeIDsMap(IDs);
-
-        // Now filter using the list of modified files, gitFileList, to find which IDs to colour differently
-        wxStringSet_t toColour;
-        wxStringSet_t::const_iterator iter = gitFileSet.begin();
-        for(; iter != gitFileSet.end(); ++iter) {
-            wxTreeItemId id = IDs[(*iter)];
-            if(id.IsOk()) {
-                DoSetTreeItemImage(m_mgr->GetWorkspaceTree(), id, OverlayTool::Bmp_Modified);
-
-            } else {
-                toColour.insert(*iter);
-            }
-        }
-
-        if(!toColour.empty()) { ColourFileTree(m_mgr->GetWorkspaceTree(), toColour, OverlayTool::Bmp_Modified); }
-
-        // Finally, cache the modified-files list: it's used in other functions
-        m_modifiedFiles.swap(gitFileSet);
+        DoRefreshTreeOverlays();
     }
     m_mgr->SetStatusMessage("", 0);
 }
@@ -1527,17 +1499,13 @@ void GitPlugin::OnProcessTerminated(clProcessEvent& event)
         return;
     }
 
-    if(ga.action == gitListAll || ga.action == gitListModified || ga.action == gitResetRepo) {
+    if(ga.action == gitListAll || ga.action == gitResetRepo) {
         if(ga.action == gitListAll && m_bActionRequiresTreUpdate) {
             if(m_commandOutput.Lower().Contains(_("created"))) UpdateFileTree();
         }
         m_bActionRequiresTreUpdate = false;
         FinishGitListAction(ga);
 
-    } else if(ga.action == gitStatus) {
-        m_console->UpdateTreeView(m_commandOutput);
-        FinishGitListAction(ga);
-
     } else if(ga.action == gitListRemotes) {
         wxArrayString gitList = wxStringTokenize(m_commandOutput, wxT("\n"));
         m_remotes = gitList;
@@ -1575,7 +1543,7 @@ void GitPlugin::OnProcessTerminated(clProcessEvent& event)
         EventNotifier::Get()->PostReloadExternallyModifiedEvent(true);
 
         gitAction newAction;
-        newAction.action = gitListModified;
+        newAction.action = gitStatus;
         m_gitActionQueue.push_back(newAction);
 
     } else if(ga.action == gitBranchCurrent) {
@@ -1631,7 +1599,7 @@ void GitPlugin::OnProcessTerminated(clProcessEvent& event)
             // update the tree
             gitAction ga(gitListAll, wxT(""));
             m_gitActionQueue.push_back(ga);
-            ga.action = gitListModified;
+            ga.action = gitStatus;
             m_gitActionQueue.push_back(ga);
         }
 
@@ -1816,9 +1784,6 @@ void GitPlugin::AddDefaultActions()
     //    ga.action = gitListAll;
     //    m_gitActionQueue.push_back(ga);
 
-    ga.action = gitListModified;
-    m_gitActionQueue.push_back(ga);
-
     // ga.action = gitUpdateRemotes;
     // m_gitActionQueue.push_back(ga);
 
@@ -1836,45 +1801,90 @@ void GitPlugin::AddDefaultActions()
 }
 
 /*******************************************************************************/
-void GitPlugin::ColourFileTree(clTreeCtrl* tree, const wxStringSet_t& files, OverlayTool::BmpType bmpType) const
+void GitPlugin::DoRequestStatus()
 {
+    if(m_repositoryDirectory.IsEmpty() || !m_statusEngine) return;
+
     clConfig conf("git.conf");
     GitEntry data;
     conf.ReadItem(&data);
 
-    if(!(data.GetFlags() & GitEntry::Git_Colour_Tree_View)) return;
+    wxString git = m_pathGITExecutable;
+    git.Trim().Trim(false);
+    ::WrapWithQuotes(git);
+    GIT_MESSAGE1(wxT("%s status --porcelain=v2. Repo path: %s"), git, m_repositoryDirectory);
+    m_statusEngine->Request(git, m_repositoryDirectory, data.GetFlags() & GitEntry::Git_Use_Fsmonitor);
+}
 
-    std::stack<wxTreeItemId> items;
-    if(tree->GetRootItem().IsOk()) items.push(tree->GetRootItem());
+/*******************************************************************************/
+void GitPlugin::OnStatusResult(const GitStatusResult& result)
+{
+    // The repository changed since the status was requested
+    if(result.m_repositoryDirectory != m_repositoryDirectory) return;
 
-    while(!items.empty()) {
-        wxTreeItemId next = items.top();
-        items.pop();
+    if(!result.m_ok) {
+        GIT_MESSAGE1(wxT("Failed to read the repository status. %s"), result.m_error);
+        return;
+    }
 
-        if(next != tree->GetRootItem()) {
-            FilewViewTreeItemData* data = static_cast<FilewViewTreeItemData*>(tree->GetItemData(next));
-            const wxString& path = data->GetData().GetFile();
-            if(!path.IsEmpty() && files.count(path)) { DoSetTreeItemImage(tree, next, bmpType); }
-        }
+    m_gitStatus = result.m_status;
+    m_console->UpdateTreeView(m_gitStatus);
 
-        wxTreeItemIdValue cookie;
-        wxTreeItemId nextChild = tree->GetFirstChild(next, cookie);
-        while(nextChild.IsOk()) {
-            items.push(nextChild);
-            nextChild = tree->GetNextSibling(nextChild);
+    m_modifiedFiles.clear();
+    GitStatusMap_t::const_iterator iter = m_gitStatus.begin();
+    for(; iter != m_gitStatus.end(); ++iter) {
+        if(iter->second.IsModifiedInWorktree()) { m_modifiedFiles.insert(iter->first); }
+    }
+
+    // Keep the tracked files up to date until the next 'ls-files' (e.g. a new file was added or committed)
+    wxArrayString files;
+    for(iter = result.m_changed.begin(); iter != result.m_changed.end(); ++iter) {
+        files.Add(iter->first);
+        if(iter->second.m_kind != GitFileStatus::kUntracked) { m_trackedFiles.insert(iter->first); }
+    }
+    for(size_t i = 0; i < result.m_cleaned.GetCount(); ++i) {
+        const wxString& file = result.m_cleaned.Item(i);
+        files.Add(file);
+        if(wxFileName::FileExists(file)) {
+            m_trackedFiles.insert(file);
+        } else {
+            m_trackedFiles.erase(file);
         }
     }
+
+    if(result.m_reset) {
+        DoRefreshTreeOverlays();
+    } else {
+        DoUpdateTreeOverlays(files);
+    }
 }
 
 /*******************************************************************************/
+OverlayTool::BmpType GitPlugin::GetFileOverlay(const wxString& path) const
+{
+    GitStatusMap_t::const_iterator iter = m_gitStatus.find(path);
+    if(iter != m_gitStatus.end()) {
+        switch(iter->second.m_kind) {
+        case GitFileStatus::kConflict:
+            return OverlayTool::Bmp_Conflict;
+        case GitFileStatus::kUntracked:
+            return OverlayTool::Bmp_NoChange;
+        default:
+            return OverlayTool::Bmp_Modified;
+        }
+    }
+    return m_trackedFiles.count(path) ? OverlayTool::Bmp_OK : OverlayTool::Bmp_NoChange;
+}
 
-void GitPlugin::CreateFilesTreeIDsMap(std::map<wxString, wxTreeItemId>& IDs, bool ifmodified /*=false*/) const
+/*******************************************************************************/
+void GitPlugin::DoBuildTreeItemsIndex()
 {
+    m_treeItems.clear();
+    m_treeItemsValid = true;
+
     clTreeCtrl* tree = m_mgr->GetWorkspaceTree();
     if(!tree) { return; }
 
-    IDs.clear();
-
     std::stack<wxTreeItemId> items;
     if(tree->GetRootItem().IsOk()) items.push(tree->GetRootItem());
 
@@ -1884,11 +1894,7 @@ void GitPlugin::CreateFilesTreeIDsMap(std::map<wxString, wxTreeItemId>& IDs, boo
 
         if(next != tree->GetRootItem()) {
             FilewViewTreeItemData* data = static_cast<FilewViewTreeItemData*>(tree->GetItemData(next));
-            const wxString& path = data->GetData().GetFile();
-            if(!path.IsEmpty()) {
-                // If m_modifiedFiles has already been filled, only include files listed there
-                if(!ifmodified || m_modifiedFiles.count(path)) { IDs[path] = next; }
-            }
+            if(data && !data->GetData().GetFile().IsEmpty()) { m_treeItems[data->GetData().GetFile()] = next; }
         }
 
         wxTreeItemIdValue cookie;
@@ -1900,6 +1906,90 @@ void GitPlugin::CreateFilesTreeIDsMap(std::map<wxString, wxTreeItemId>& IDs, boo
     }
 }
 
+/*******************************************************************************/
+wxTreeItemId GitPlugin::DoFindTreeItem(const wxString& path)
+{
+    if(!m_treeItemsValid) { DoBuildTreeItemsIndex(); }
+    std::unordered_map<wxString, wxTreeItemId>::const_iterator iter = m_treeItems.find(path);
+    return (iter == m_treeItems.end()) ? wxTreeItemId() : iter->second;
+}
+
+/*******************************************************************************/
+void GitPlugin::DoInvalidateTreeItems()
+{
+    m_treeItems.clear();
+    m_treeItemsValid = false;
+
+    // Colour the new items once the tree is stable (e.g. all the children of the expanded item were added)
+    if(!m_treeOverlaysPending && !m_repositoryDirectory.IsEmpty()) {
+        m_treeOverlaysPending = true;
+        CallAfter(&GitPlugin::DoRefreshTreeOverlays);
+    }
+}
+
+/*******************************************************************************/
+void GitPlugin::DoRefreshTreeOverlays()
+{
+    m_treeOverlaysPending = false;
+
+    clConfig conf("git.conf");
+    GitEntry data;
+    conf.ReadItem(&data);
+    if(!(data.GetFlags() & GitEntry::Git_Colour_Tree_View)) return;
+
+    clTreeCtrl* tree = m_mgr->GetWorkspaceTree();
+    if(!tree) return;
+
+    if(!m_treeItemsValid) { DoBuildTreeItemsIndex(); }
+    std::unordered_map<wxString, wxTreeItemId>::const_iterator iter = m_treeItems.begin();
+    for(; iter != m_treeItems.end(); ++iter) {
+        OverlayTool::BmpType bmpType = GetFileOverlay(iter->first);
+        if(bmpType != OverlayTool::Bmp_NoChange) { DoSetTreeItemImage(tree, iter->second, bmpType); }
+    }
+}
+
+/*******************************************************************************/
+void GitPlugin::DoUpdateTreeOverlays(const wxArrayString& files)
+{
+    if(files.IsEmpty()) return;
+
+    clConfig conf("git.conf");
+    GitEntry data;
+    conf.ReadItem(&data);
+    if(!(data.GetFlags() & GitEntry::Git_Colour_Tree_View)) return;
+
+    clTreeCtrl* tree = m_mgr->GetWorkspaceTree();
+    if(!tree) return;
+
+    for(size_t i = 0; i < files.GetCount(); ++i) {
+        wxTreeItemId item = DoFindTreeItem(files.Item(i));
+        if(!item.IsOk()) continue;
+        OverlayTool::BmpType bmpType = GetFileOverlay(files.Item(i));
+        if(bmpType != OverlayTool::Bmp_NoChange) { DoSetTreeItemImage(tree, item, bmpType); }
+    }
+}
+
+/*******************************************************************************/
+void GitPlugin::OnWorkspaceTreeItemsChanged(wxTreeEvent& event)
+{
+    event.Skip();
+    DoInvalidateTreeItems();
+}
+
+/*******************************************************************************/
+void GitPlugin::OnWorkspaceViewBuildStarting(clCommandEvent& event)
+{
+    event.Skip();
+    DoInvalidateTreeItems();
+}
+
+/*******************************************************************************/
+void GitPlugin::OnFileViewRefreshed(wxCommandEvent& event)
+{
+    event.Skip();
+    DoInvalidateTreeItems();
+}
+
 /*******************************************************************************/
 void GitPlugin::OnProgressTimer(wxTimerEvent& Event)
 {
@@ -1944,6 +2034,10 @@ void GitPlugin::DoCleanup()
     m_remoteBranchList.Clear();
     m_trackedFiles.clear();
     m_modifiedFiles.clear();
+    m_gitStatus.clear();
+    if(m_statusEngine) { m_statusEngine->Cancel(); }
+    m_treeItems.clear();
+    m_treeItemsValid = false;
     m_addedFiles = false;
     m_progressMessage.Clear();
     m_commandOutput.Clear();
@@ -2549,7 +2643,7 @@ void GitPlugin::OnActiveProjectChanged(clProjectSettingsEvent& event)
     // Clear any stale repo data, otherwise it looks as if there's a valid git
     // repo when it actually belongs to a different project
     DoCleanup();
-    m_console->UpdateTreeView("");
+    m_console->UpdateTreeView(GitStatusMap_t());
 
     wxFileName projectFile(event.GetFileName());
     DoSetRepoPath(projectFile.GetPath(), false);
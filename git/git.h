@@ -49,6 +49,8 @@
 #include "cl_command_event.h"
 #include "gitui.h"
 #include <vector>
+#include <unordered_map>
+#include "GitStatusEngine.h"
 #include "clTabTogglerHelper.h"
 
 class clTreeCtrl;
@@ -107,7 +109,6 @@ class GitPlugin : public IPlugin
         gitNone = 0,
         gitUpdateRemotes,
         gitListAll,
-        gitListModified,
         gitListRemotes,
         gitAddFile,
         gitDeleteFile,
@@ -173,6 +174,12 @@ class GitPlugin : public IPlugin
     clCommandProcessor* m_commandProcessor;
     clTabTogglerHelper::Ptr_t m_tabToggler;
     GitBlameDlg* m_gitBlameDlg;
+    GitStatusEngine* m_statusEngine;
+    GitStatusMap_t m_gitStatus;
+    // The files of the workspace view, built when needed and invalidated whenever the tree items change
+    std::unordered_map<wxString, wxTreeItemId> m_treeItems;
+    bool m_treeItemsValid;
+    bool m_treeOverlaysPending;
 
 private:
     void DoCreateTreeImages();
@@ -185,8 +192,14 @@ private:
     void AddDefaultActions();
     void LoadDefaultGitCommands(GitEntry& data, bool overwrite = false);
     void ProcessGitActionQueue();
-    void ColourFileTree(clTreeCtrl* tree, const wxStringSet_t& files, OverlayTool::BmpType bmpType) const;
-    void CreateFilesTreeIDsMap(std::map<wxString, wxTreeItemId>& IDs, bool ifmodified = false) const;
+    void DoRequestStatus();
+    void OnStatusResult(const GitStatusResult& result);
+    OverlayTool::BmpType GetFileOverlay(const wxString& path) const;
+    void DoBuildTreeItemsIndex();
+    wxTreeItemId DoFindTreeItem(const wxString& path);
+    void DoInvalidateTreeItems();
+    void DoRefreshTreeOverlays();
+    void DoUpdateTreeOverlays(const wxArrayString& files);
     void DoShowCommitDialog(const wxString& diff, wxString& commitArgs);
     void DoRefreshView(bool ensureVisible);
     
@@ -254,6 +267,9 @@ private:
     void OnActiveProjectChanged(clProjectSettingsEvent& event);
     void OnFileGitBlame(wxCommandEvent& event);
     void OnAppActivated(wxCommandEvent& event);
+    void OnWorkspaceTreeItemsChanged(wxTreeEvent& event);
+    void OnWorkspaceViewBuildStarting(clCommandEvent& event);
+    void OnFileViewRefreshed(wxCommandEvent& event);
     
 #if 0
     void OnBisectStart(wxCommandEvent& e);
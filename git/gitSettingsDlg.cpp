@@ -43,6 +43,7 @@ GitSettingsDlg::GitSettingsDlg(wxWindow* parent, const wxString& localRepoPath)
     m_checkBoxLog->SetValue(data.GetFlags() & GitEntry::Git_Verbose_Log);
     m_checkBoxTerminal->SetValue(data.GetFlags() & GitEntry::Git_Show_Terminal);
     m_checkBoxTrackTree->SetValue(data.GetFlags() & GitEntry::Git_Colour_Tree_View);
+    m_checkBoxFsmonitor->SetValue(data.GetFlags() & GitEntry::Git_Use_Fsmonitor);
 
     GitEntry::GitProperties props = GitEntry::ReadGitProperties(m_localRepoPath);
 
@@ -73,6 +74,8 @@ void GitSettingsDlg::OnOK(wxCommandEvent& event)
 
     if(m_checkBoxTrackTree->IsChecked()) flags |= GitEntry::Git_Colour_Tree_View;
 
+    if(m_checkBoxFsmonitor->IsChecked()) flags |= GitEntry::Git_Use_Fsmonitor;
+
     data.SetFlags(flags);
     data.Save();
 
@@ -151,7 +151,12 @@ class GitEntry : public clConfigItem
     int m_gitBlameDlgVSashPos;
 
 public:
-    enum { Git_Verbose_Log = 0x00000001, Git_Show_Terminal = 0x00000002, Git_Colour_Tree_View = 0x00000004 };
+    enum {
+        Git_Verbose_Log = 0x00000001,
+        Git_Show_Terminal = 0x00000002,
+        Git_Colour_Tree_View = 0x00000004,
+        Git_Use_Fsmonitor = 0x00000008,
+    };
 
     struct GitProperties {
         wxString global_username;
@@ -180,6 +180,14 @@ GitSettingsDlgBase::GitSettingsDlgBase(wxWindow* parent, wxWindowID id, const wx
 
     boxSizer766->Add(m_checkBoxTrackTree, 0, wxALL, WXC_FROM_DIP(5));
 
+    m_checkBoxFsmonitor = new wxCheckBox(m_panel236, wxID_ANY, _("Use git's file system monitor"), wxDefaultPosition,
+                                         wxDLG_UNIT(m_panel236, wxSize(-1, -1)), 0);
+    m_checkBoxFsmonitor->SetValue(false);
+    m_checkBoxFsmonitor->SetToolTip(_("Let git use its file system monitor to find the modified files, instead of "
+                                      "scanning the whole working tree.\nThis requires git 2.36 or later"));
+
+    boxSizer766->Add(m_checkBoxFsmonitor, 0, wxALL, WXC_FROM_DIP(5));
+
     m_stdBtnSizer284 = new wxStdDialogButtonSizer();
 
     mainSizer->Add(m_stdBtnSizer284, 0, wxALL | wxALIGN_CENTER_HORIZONTAL, WXC_FROM_DIP(10));
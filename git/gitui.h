@@ -88,6 +88,7 @@ protected:
     wxCheckBox* m_checkBoxTerminal;
     wxCheckBox* m_checkBoxLog;
     wxCheckBox* m_checkBoxTrackTree;
+    wxCheckBox* m_checkBoxFsmonitor;
     wxStdDialogButtonSizer* m_stdBtnSizer284;
     wxButton* m_buttonOK;
     wxButton* m_buttonCancel;
@@ -116,6 +117,7 @@ public:
     wxCheckBox* GetCheckBoxTerminal() { return m_checkBoxTerminal; }
     wxCheckBox* GetCheckBoxLog() { return m_checkBoxLog; }
     wxCheckBox* GetCheckBoxTrackTree() { return m_checkBoxTrackTree; }
+    wxCheckBox* GetCheckBoxFsmonitor() { return m_checkBoxFsmonitor; }
     wxPanel* GetPanel236() { return m_panel236; }
     wxTreebook* GetTreebook230() { return m_treebook230; }
     GitSettingsDlgBase(wxWindow* parent, wxWindowID id = wxID_ANY, const wxString& title = _("Git settings..."),
@@ -6,6 +6,12 @@
 #include "network/named_pipe_client.h"
 #include "network/np_connections_server.h"
 #include "libctags/libctags.h"
+#include <string.h>
+#include <sstream>
+#include <vector>
+#ifndef __WXMSW__
+#include <signal.h>
+#endif
 
 #ifdef __WXMSW__
 #define PIPE_NAME "\\\\.\\pipe\\codelite_indexer_%s"
@@ -14,7 +20,7 @@ HINSTANCE gHandler = NULL;
 #define PIPE_NAME "/tmp/codelite_indexer.%s.sock"
 #endif
 
-static eQueue<clNamedPipe*> g_connectionQueue;
+static eQueue<IndexerJob*> g_connectionQueue;
 
 int main(int argc, char **argv)
 {
@@ -26,16 +32,19 @@ int main(int argc, char **argv)
 	gHandler = LoadLibrary("exchndl.dll");
 #endif
 
-	int  max_requests(5000);
+	int  max_parsed_files(5000);
 	int  requests(0);
 	long parent_pid (0);
+	int  workers(1);
 	if(argc < 2){
-		printf("Usage: %s <string> [--pid]\n",    argv[0]);
+		printf("Usage: %s <string> [--pid] [--parent <pid>] [--workers <count>]\n",    argv[0]);
 		printf("Usage: %s --batch <file_list> <output file>\n", argv[0]);
-		printf("   <string> - a unique string that identifies this indexer from other instances               \n");
-		printf("   --pid    - when set, <string> is handled as process number and the indexer will            \n");
-		printf("              check if this process alive. If it is down, the indexer will go down as well\n");
-		printf("   --batch  - when set, batch parsing is done using list of files set in file_list argument   \n");
+		printf("   <string>  - a unique string that identifies this indexer from other instances               \n");
+		printf("   --pid     - when set, <string> is handled as process number and the indexer will            \n");
+		printf("               check if this process alive. If it is down, the indexer will go down as well\n");
+		printf("   --parent  - same as --pid, but the process number is passed explicitly                    \n");
+		printf("   --workers - number of parsing worker processes (default: 1, parse in-process)            \n");
+		printf("   --batch   - when set, batch parsing is done using list of files set in file_list argument   \n");
 		return 1;
 	}
 
@@ -45,30 +54,70 @@ int main(int argc, char **argv)
 		return 0;
 	}
 
-	if ( argc == 3 && strcmp( argv[2], "--pid") == 0 ) {
-		parent_pid = atol( argv[1] );
-		printf("INFO: parent PID is set on %s\n", argv[1]);
+	for (int i=2; i<argc; i++) {
+		if ( strcmp( argv[i], "--pid") == 0 ) {
+			parent_pid = atol( argv[1] );
+
+		} else if ( strcmp( argv[i], "--parent") == 0 && (i + 1) < argc ) {
+			parent_pid = atol( argv[++i] );
+
+		} else if ( strcmp( argv[i], "--workers") == 0 && (i + 1) < argc ) {
+			workers = atoi( argv[++i] );
+			if ( workers < 1 ) {
+				workers = 1;
+			}
+		}
 	}
 
+	if ( parent_pid ) {
+		printf("INFO: parent PID is set on %ld\n", parent_pid);
+	}
+
+#ifndef __WXMSW__
+	// we are writing to sockets that might be closed by the other side (client or worker process)
+	signal(SIGPIPE, SIG_IGN);
+	// no need to wait for our worker processes
+	signal(SIGCHLD, SIG_IGN);
+#endif
+
 	// create the connection factory
 	char channel_name[1024];
 	sprintf(channel_name, PIPE_NAME, argv[1]);
 
 	clNamedPipeConnectionsServer server(channel_name);
 
-	// start the worker thread
-	WorkerThread  worker( &g_connectionQueue );
+	// start the worker threads. With a single worker, the parsing is done in this process
+	// otherwise, each worker forwards its requests to its own child indexer process
+	std::vector<WorkerThread*> pool;
+	std::vector<eQueue<IndexerJob*>*> queues;
+	if ( workers == 1 ) {
+		queues.push_back( &g_connectionQueue );
+		pool.push_back( new WorkerThread( &g_connectionQueue, max_parsed_files ) );
+
+	} else {
+		for (int i=0; i<workers; i++) {
+			std::stringstream childId;
+			childId << argv[1] << "_w" << i;
+
+			eQueue<IndexerJob*> *queue = new eQueue<IndexerJob*>();
+			queues.push_back( queue );
+			pool.push_back( new ProxyWorkerThread( queue, argv[0], childId.str() ) );
+		}
+	}
 
 	// start the 'is alive thread'
 	IsAliveThread isAliveThread( parent_pid, channel_name  );
-	worker.run();
+	for (size_t i=0; i<pool.size(); i++) {
+		pool.at(i)->run();
+	}
 	if ( parent_pid ) {
 		isAliveThread.run();
 	}
 
-	printf("INFO: codelite_indexer started\n");
+	printf("INFO: codelite_indexer started with %d worker(s)\n", workers);
 	printf("INFO: listening on %s\n", channel_name);
 
+	size_t next_worker(0);
 	while (true) {
 		clNamedPipe *conn = server.waitForNewConnection(-1);
 		if (!conn) {
@@ -78,26 +127,34 @@ int main(int argc, char **argv)
 			continue;
 		}
 
+		// dispatch the connection to the least busy worker (round robin between equally busy workers)
+		size_t selected = next_worker;
+		size_t min_depth = pool.at(selected)->getQueueDepth();
+		for (size_t i=1; i<pool.size() && min_depth > 0; i++) {
+			size_t index = (next_worker + i) % pool.size();
+			size_t depth = pool.at(index)->getQueueDepth();
+			if ( depth < min_depth ) {
+				selected = index;
+				min_depth = depth;
+			}
+		}
+		next_worker = (selected + 1) % pool.size();
+
 		// add the request to the queue
-		g_connectionQueue.put( conn );
+		queues.at(selected)->put( new IndexerJob(IndexerJob::NEW_CONNECTION, conn) );
 		requests ++;
 
-		if(requests == max_requests) {
-			// stop the worker thread and exit
-			printf("INFO: Max requests reached, going down\n");
-			worker.requestStop();
-			worker.wait(-1);
-
-			// stop the isAlive thread
-			if ( parent_pid ) {
-				isAliveThread.requestStop();
-				isAliveThread.wait(-1);
+		if ( pool.size() > 1 && (requests % 100) == 0 ) {
+			// report the load of the pool
+			std::stringstream ss;
+			for (size_t i=0; i<pool.size(); i++) {
+				ss << " worker" << i << "=" << pool.at(i)->getQueueDepth();
 			}
-			break;
+			printf("INFO: queue depth:%s\n", ss.str().c_str());
+			fflush(stdout);
 		}
 	}
 
-	// perform some cleanup
-	ctags_shutdown();
+	// The process goes down from the parsing thread, once it parsed max_parsed_files files
 	return 0;
 }
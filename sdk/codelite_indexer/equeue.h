@@ -19,6 +19,7 @@ public:
 
 	bool put(const T& item);
 	bool get(T& item, long timeout);
+	size_t size();
 };
 
 //----------------------------
@@ -48,4 +49,10 @@ bool eQueue<T>::put(const T& item)
 	return m_impl->put(item);
 }
 
+template<class T>
+size_t eQueue<T>::size()
+{
+	return m_impl->size();
+}
+
 #endif // __equeue__
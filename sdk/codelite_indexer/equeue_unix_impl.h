@@ -22,6 +22,7 @@ public:
 
 	bool put ( const T& item );
 	bool get ( T& item, long timeout );
+	size_t size();
 };
 
 //----------------------------
@@ -99,6 +100,15 @@ bool eQueueImpl<T>::put ( const T& item )
 	return true;
 }
 
+template<class T>
+size_t eQueueImpl<T>::size()
+{
+	pthread_mutex_lock ( &m_mutex );
+	size_t count = m_queue.size();
+	pthread_mutex_unlock ( &m_mutex );
+	return count;
+}
+
 #endif // __equeue_unix_impl_h__
 
 #endif // !defined(__WXMSW__)
@@ -20,6 +20,7 @@ public:
 
 	bool put(const T& item);
 	bool get(T& item, long timeout);
+	size_t size();
 };
 
 //----------------------------
@@ -94,6 +95,15 @@ bool eQueueImpl<T>::put(const T& item)
 	return true;
 }
 
+template<class T>
+size_t eQueueImpl<T>::size()
+{
+	EnterCriticalSection( &m_cs );
+	size_t count = m_queue.size();
+	LeaveCriticalSection( &m_cs );
+	return count;
+}
+
 #endif // __equeue_win_h__
 
 #endif
@@ -29,6 +29,7 @@
 
 clIndexerReply::clIndexerReply()
 : m_completionCode(0)
+, m_requestId(0)
 {
 }
 
@@ -40,12 +41,14 @@ void clIndexerReply::fromBinary(char* data)
 {
 	////////////////////////////////////////////////////////
 	// integer      | completion code
+	// integer      | request id
 	// integer      | file name len
 	// string       | file name string
 	// integer      | tags length
 	// string       | tags string
 	////////////////////////////////////////////////////////
 	UNPACK_INT(m_completionCode, data);
+	UNPACK_INT(m_requestId, data);
 	UNPACK_STD_STRING(m_fileName, data);
 	UNPACK_STD_STRING(m_tags, data);
 }
@@ -54,6 +57,7 @@ char* clIndexerReply::toBinary(size_t& buffer_size)
 {
 	buffer_size = 0;
 	buffer_size += sizeof(m_completionCode);
+	buffer_size += sizeof(m_requestId);
 	buffer_size += sizeof(size_t);          // length of the file name
 	buffer_size += m_fileName.length();
 	buffer_size += sizeof(size_t);
@@ -62,6 +66,7 @@ char* clIndexerReply::toBinary(size_t& buffer_size)
 	char *data = new char[buffer_size];
 	char *ptr = data;
 	PACK_INT(data, m_completionCode);
+	PACK_INT(data, m_requestId);
 	PACK_STD_STRING(data, m_fileName);
 	PACK_STD_STRING(data, m_tags);
 	return ptr;
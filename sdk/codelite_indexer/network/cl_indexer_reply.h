@@ -32,6 +32,18 @@ class clIndexerReply
 	size_t m_completionCode;
 	std::string m_fileName;
 	std::string m_tags;
+	size_t m_requestId;
+
+public:
+	// Completion codes
+	enum {
+		// The file was parsed, it has no tags
+		CLI_COMPLETION_NO_TAGS = 0,
+		CLI_COMPLETION_TAGS = 1,
+		// The file could not be parsed (e.g. a worker process of the pool failed), the client should not
+		// consider it as parsed
+		CLI_COMPLETION_ERROR = 2
+	};
 
 public:
 	clIndexerReply();
@@ -58,5 +70,17 @@ public:
 	const std::string& getTags() const {
 		return m_tags;
 	}
+	/**
+	 * @brief take the content of 'tags' without copying it
+	 */
+	void swapTags(std::string& tags) {
+		this->m_tags.swap(tags);
+	}
+	void setRequestId(const size_t& requestId) {
+		this->m_requestId = requestId;
+	}
+	const size_t& getRequestId() const {
+		return m_requestId;
+	}
 };
 #endif // __clindexerreply__
@@ -29,6 +29,8 @@
 
 clIndexerRequest::clIndexerRequest()
 : m_cmd(CLI_PARSE)
+, m_requestId(0)
+, m_flags(0)
 {
 }
 
@@ -39,6 +41,8 @@ clIndexerRequest::~clIndexerRequest()
 void clIndexerRequest::fromBinary(char* data)
 {
 	UNPACK_INT(m_cmd, data);
+	UNPACK_INT(m_requestId, data);
+	UNPACK_INT(m_flags, data);
 	UNPACK_STD_STRING(m_ctagOptions, data);
 	UNPACK_STD_STRING(m_databaseFileName, data);
 
@@ -59,6 +63,8 @@ char* clIndexerRequest::toBinary(size_t &buffer_size)
 {
 	buffer_size = 0;
 	buffer_size += sizeof(m_cmd);               // command type
+	buffer_size += sizeof(m_requestId);         // request id
+	buffer_size += sizeof(m_flags);             // flags
 	buffer_size += sizeof(size_t);              // length ctags options tring
 	buffer_size += m_ctagOptions.length();      // ctags options actual string
 	buffer_size += sizeof(size_t);              // length of the database file name
@@ -75,6 +81,8 @@ char* clIndexerRequest::toBinary(size_t &buffer_size)
 	char *ptr = data;
 
 	PACK_INT(data, m_cmd);
+	PACK_INT(data, m_requestId);
+	PACK_INT(data, m_flags);
 	PACK_STD_STRING(data, m_ctagOptions);
 	PACK_STD_STRING(data, m_databaseFileName);
 
@@ -35,10 +35,20 @@ class clIndexerRequest
 	std::string m_ctagOptions;
 	size_t m_cmd;
 	std::string m_databaseFileName;
+	size_t m_requestId;
+	size_t m_flags;
 public:
 	enum {
 		CLI_PARSE,
-		CLI_PARSE_AND_SAVE
+		CLI_PARSE_AND_SAVE,
+		// Parse the files and send back one reply per file. The connection
+		// is kept open so the client can send more requests on it
+		CLI_PARSE_STREAM
+	};
+
+	enum {
+		// Reply with the binary tags format (see cl_indexer_tags.h) instead of the ctags text output
+		CLI_REPLY_BINARY_TAGS = 0x00000001
 	};
 
 public:
@@ -72,5 +82,21 @@ public:
 	const std::string& getDatabaseFileName() const {
 		return m_databaseFileName;
 	}
+	/**
+	 * @brief the id of the first file in this request. In CLI_PARSE_STREAM mode, the reply
+	 * for getFiles().at(i) is tagged with getRequestId() + i
+	 */
+	void setRequestId(const size_t& requestId) {
+		this->m_requestId = requestId;
+	}
+	const size_t& getRequestId() const {
+		return m_requestId;
+	}
+	void setFlags(const size_t& flags) {
+		this->m_flags = flags;
+	}
+	const size_t& getFlags() const {
+		return m_flags;
+	}
 };
 #endif // __clindexercommand__
@@ -0,0 +1,116 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2014 Eran Ifrah
+// file name            : cl_indexer_session.cpp
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#include "cl_indexer_session.h"
+#include "clindexerprotocol.h"
+#include "named_pipe_client.h"
+
+clIndexerSession::clIndexerSession(const std::string& channel)
+    : m_channel(channel)
+    , m_client(NULL)
+    , m_nextRequestId(1)
+    , m_pendingReplies(0)
+    , m_lastActivity(0)
+{
+}
+
+clIndexerSession::~clIndexerSession() { disconnect(); }
+
+bool clIndexerSession::connect()
+{
+    if(isConnected()) { return true; }
+
+    m_client = new clNamedPipeClient(m_channel.c_str());
+    if(!m_client->connect()) {
+        disconnect();
+        return false;
+    }
+    m_lastActivity = time(NULL);
+    return true;
+}
+
+void clIndexerSession::disconnect()
+{
+    if(m_client) {
+        m_client->disconnect();
+        delete m_client;
+        m_client = NULL;
+    }
+    m_pendingReplies = 0;
+}
+
+bool clIndexerSession::isConnected() const { return m_client && m_client->isConnected(); }
+
+bool clIndexerSession::sendBatch(const std::vector<std::string>& files, const std::string& ctagsOptions,
+                                 size_t& firstRequestId, size_t flags)
+{
+    // The indexer closes idle sessions, don't wait for it to happen in the middle of our request
+    if(isConnected() && (m_pendingReplies == 0) &&
+       ((time(NULL) - m_lastActivity) >= (INDEXER_SESSION_IDLE_TIMEOUT - 1))) {
+        disconnect();
+    }
+    if(!connect()) { return false; }
+
+    clIndexerRequest req;
+    req.setCmd(clIndexerRequest::CLI_PARSE_STREAM);
+    req.setFiles(files);
+    req.setCtagOptions(ctagsOptions);
+    req.setRequestId(m_nextRequestId);
+    req.setFlags(flags);
+
+    if(!clIndexerProtocol::SendRequest(m_client, req)) {
+        // the connection is no longer usable
+        disconnect();
+        return false;
+    }
+
+    m_lastActivity = time(NULL);
+    firstRequestId = m_nextRequestId;
+    m_nextRequestId += files.size();
+    m_pendingReplies += files.size();
+    return true;
+}
+
+bool clIndexerSession::readReply(clIndexerReply& reply, std::string& errmsg)
+{
+    if(!isConnected()) {
+        errmsg = "ERROR: readReply: session is not connected";
+        return false;
+    }
+
+    if(m_pendingReplies == 0) {
+        errmsg = "ERROR: readReply: no pending replies";
+        return false;
+    }
+
+    if(!clIndexerProtocol::ReadReply(m_client, reply, errmsg)) {
+        // we lost sync with the indexer, drop the connection
+        disconnect();
+        return false;
+    }
+    --m_pendingReplies;
+    m_lastActivity = time(NULL);
+    return true;
+}
@@ -0,0 +1,84 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2014 Eran Ifrah
+// file name            : cl_indexer_session.h
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __clindexersession__
+#define __clindexersession__
+
+#include <string>
+#include <time.h>
+#include <vector>
+#include "cl_indexer_reply.h"
+#include "cl_indexer_request.h"
+
+class clNamedPipeClient;
+
+/**
+ * @class clIndexerSession
+ * @brief a long lived connection to the indexer. Files are sent in batches (CLI_PARSE_STREAM)
+ * and the indexer replies with one clIndexerReply per file. The replies may arrive in any order,
+ * each one is tagged with the request id of the file it belongs to
+ */
+class clIndexerSession
+{
+	std::string m_channel;
+	clNamedPipeClient *m_client;
+	size_t m_nextRequestId;
+	size_t m_pendingReplies;
+	time_t m_lastActivity;
+
+public:
+	clIndexerSession(const std::string &channel);
+	~clIndexerSession();
+
+	/**
+	 * @brief connect to the indexer. Does nothing if the session is already connected
+	 */
+	bool connect();
+	void disconnect();
+	bool isConnected() const;
+
+	/**
+	 * @brief send a batch of files to the indexer. files.at(i) is assigned the request id firstRequestId + i
+	 * Requests can be pipelined: it is allowed to send another batch before all the replies of the
+	 * previous batches were read. If the session was idle long enough for the indexer to close it,
+	 * a new connection is opened
+	 * @param flags request flags (e.g. clIndexerRequest::CLI_REPLY_BINARY_TAGS)
+	 */
+	bool sendBatch(const std::vector<std::string> &files, const std::string &ctagsOptions, size_t &firstRequestId,
+	               size_t flags = 0);
+
+	/**
+	 * @brief read the next reply from the indexer. On failure, the session is disconnected
+	 */
+	bool readReply(clIndexerReply &reply, std::string &errmsg);
+
+	/**
+	 * @brief return the number of replies that were not read yet
+	 */
+	size_t getPendingReplies() const {
+		return m_pendingReplies;
+	}
+};
+#endif // __clindexersession__
@@ -0,0 +1,349 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2014 Eran Ifrah
+// file name            : cl_indexer_tags.cpp
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#include <stdlib.h>
+#include <string.h>
+#include "cl_indexer_tags.h"
+
+static std::string trim(const std::string &s)
+{
+	static const char *whitespaces = " \t\r\n\v\f";
+	size_t start = s.find_first_not_of(whitespaces);
+	if (start == std::string::npos) {
+		return "";
+	}
+	size_t end = s.find_last_not_of(whitespaces);
+	return s.substr(start, end - start + 1);
+}
+
+// TagEntry::FromLine trims the name, the file, the kind and the pattern only from the right, do the same
+static std::string trim_right(const std::string &s)
+{
+	static const char *whitespaces = " \t\r\n\v\f";
+	size_t end = s.find_last_not_of(whitespaces);
+	if (end == std::string::npos) {
+		return "";
+	}
+	return s.substr(0, end + 1);
+}
+
+// split 's' at the first occurrence of 'ch'. If 'ch' is not found, 'after' is empty
+static void split_first(const std::string &s, char ch, std::string &before, std::string &after)
+{
+	size_t where = s.find(ch);
+	if (where == std::string::npos) {
+		before = s;
+		after.clear();
+	} else {
+		before = s.substr(0, where);
+		after = s.substr(where + 1);
+	}
+}
+
+//-----------------------------------------------------------------
+// clIndexerTagsWriter
+//-----------------------------------------------------------------
+
+clIndexerTagsWriter::clIndexerTagsWriter()
+: m_count(0)
+{
+}
+
+clIndexerTagsWriter::~clIndexerTagsWriter()
+{
+}
+
+void clIndexerTagsWriter::writeInt(std::string &buffer, unsigned int value)
+{
+	buffer.append((const char*)&value, sizeof(value));
+}
+
+void clIndexerTagsWriter::writeString(const std::string &str, bool intern)
+{
+	if (intern) {
+		std::map<std::string, unsigned int>::iterator iter = m_stringsIndex.find(str);
+		unsigned int index(0);
+		if (iter == m_stringsIndex.end()) {
+			index = m_strings.size();
+			m_strings.push_back(str);
+			m_stringsIndex.insert(std::make_pair(str, index));
+		} else {
+			index = iter->second;
+		}
+		writeInt(m_records, index | CLI_TAGS_INTERNED);
+
+	} else {
+		writeInt(m_records, str.length());
+		m_records.append(str);
+	}
+}
+
+void clIndexerTagsWriter::addLine(const std::string &line)
+{
+	// ctags line format:
+	// name<TAB>file<TAB>pattern or line number;"<TAB>kind<TAB>key:value<TAB>key:value...
+	std::string name, fileName, pattern, kind, rest;
+	split_first(line, '\t', name, rest);
+	split_first(std::string(rest), '\t', fileName, rest);
+
+	size_t end = rest.find(";\"");
+	if (end == std::string::npos) {
+		// invalid pattern
+		return;
+	}
+
+	int lineNumber(-1);
+	pattern = rest.substr(0, end);
+	rest = rest.substr(end + 2);
+	if (pattern.compare(0, 2, "/^") != 0) {
+		// line number pattern, this is usually the case with macros
+		// like wxString::ToLong(), the line number is set only when the whole pattern is a number
+		pattern = trim(pattern);
+		char *numberEnd(NULL);
+		long number = strtol(pattern.c_str(), &numberEnd, 10);
+		if (numberEnd != pattern.c_str() && *numberEnd == 0) {
+			lineNumber = (int)number;
+		}
+	} else {
+		pattern = trim_right(pattern);
+	}
+
+	if (!rest.empty() && rest.at(0) == '\t') {
+		rest.erase(0, 1);
+	}
+	split_first(std::string(rest), '\t', kind, rest);
+
+	std::vector<std::pair<std::string, std::string> > fields;
+	while (!rest.empty()) {
+		std::string token;
+		split_first(std::string(rest), '\t', token, rest);
+		if (token.empty()) {
+			continue;
+		}
+
+		std::string key, value;
+		split_first(token, ':', key, value);
+		key = trim(key);
+		value = trim(value);
+		if (key == "line" && !value.empty()) {
+			lineNumber = atoi(value.c_str());
+		} else {
+			fields.push_back(std::make_pair(key, value));
+		}
+	}
+
+	writeString(trim_right(name), false);
+	writeString(trim_right(fileName), true);
+	writeString(pattern, false);
+	writeInt(m_records, (unsigned int)lineNumber);
+	writeString(trim_right(kind), true);
+	writeInt(m_records, fields.size());
+	for (size_t i=0; i<fields.size(); i++) {
+		writeString(fields.at(i).first, true);
+		// signatures are rarely shared, all other values (access, scope, typeref...) are
+		writeString(fields.at(i).second, fields.at(i).first != "signature");
+	}
+	m_count++;
+}
+
+void clIndexerTagsWriter::addTags(const char *ctagsOutput)
+{
+	if (!ctagsOutput) {
+		return;
+	}
+
+	const char *start = ctagsOutput;
+	while (*start) {
+		const char *end = strchr(start, '\n');
+		std::string line = end ? std::string(start, end - start) : std::string(start);
+		line = trim(line);
+		if (!line.empty()) {
+			addLine(line);
+		}
+
+		if (!end) {
+			break;
+		}
+		start = end + 1;
+	}
+}
+
+void clIndexerTagsWriter::flush(std::string &output)
+{
+	if (m_count == 0) {
+		return;
+	}
+
+	writeInt(output, CLI_TAGS_MAGIC);
+	writeInt(output, m_strings.size());
+	for (size_t i=0; i<m_strings.size(); i++) {
+		writeInt(output, m_strings.at(i).length());
+		output.append(m_strings.at(i));
+	}
+	writeInt(output, m_count);
+	output.append(m_records);
+
+	m_strings.clear();
+	m_stringsIndex.clear();
+	m_records.clear();
+	m_count = 0;
+}
+
+//-----------------------------------------------------------------
+// clIndexerTagString
+//-----------------------------------------------------------------
+
+bool clIndexerTagString::equals(const char *s) const
+{
+	return strlen(s) == m_len && memcmp(s, m_data, m_len) == 0;
+}
+
+//-----------------------------------------------------------------
+// clIndexerTagsReader
+//-----------------------------------------------------------------
+
+clIndexerTagsReader::clIndexerTagsReader(const char *data, size_t len)
+: m_ptr(data)
+, m_end(data + len)
+, m_recordsLeft(0)
+, m_block(0)
+, m_error(false)
+{
+}
+
+clIndexerTagsReader::~clIndexerTagsReader()
+{
+}
+
+bool clIndexerTagsReader::readInt(unsigned int &value)
+{
+	if ((size_t)(m_end - m_ptr) < sizeof(value)) {
+		m_error = true;
+		return false;
+	}
+	memcpy(&value, m_ptr, sizeof(value));
+	m_ptr += sizeof(value);
+	return true;
+}
+
+bool clIndexerTagsReader::readBytes(clIndexerTagString &str, size_t len)
+{
+	if ((size_t)(m_end - m_ptr) < len) {
+		m_error = true;
+		return false;
+	}
+	str.m_data = m_ptr;
+	str.m_len = len;
+	str.m_interned = -1;
+	m_ptr += len;
+	return true;
+}
+
+bool clIndexerTagsReader::readString(clIndexerTagString &str)
+{
+	unsigned int ref(0);
+	if (!readInt(ref)) {
+		return false;
+	}
+
+	if (ref & CLI_TAGS_INTERNED) {
+		size_t index = ref & ~CLI_TAGS_INTERNED;
+		if (index >= m_strings.size()) {
+			m_error = true;
+			return false;
+		}
+		str = m_strings.at(index);
+		return true;
+	}
+	return readBytes(str, ref);
+}
+
+bool clIndexerTagsReader::readBlockHeader()
+{
+	unsigned int magic(0), count(0);
+	if (!readInt(magic)) {
+		return false;
+	}
+
+	if (magic != CLI_TAGS_MAGIC) {
+		m_error = true;
+		return false;
+	}
+
+	if (!readInt(count)) {
+		return false;
+	}
+
+	// each string takes at least its length
+	if (count > (m_end - m_ptr) / sizeof(unsigned int)) {
+		m_error = true;
+		return false;
+	}
+
+	m_strings.clear();
+	m_strings.reserve(count);
+	for (unsigned int i=0; i<count; i++) {
+		unsigned int len(0);
+		clIndexerTagString str;
+		if (!readInt(len) || !readBytes(str, len)) {
+			return false;
+		}
+		str.m_interned = i;
+		m_strings.push_back(str);
+	}
+	m_block++;
+	return readInt(m_recordsLeft);
+}
+
+bool clIndexerTagsReader::next(clIndexerTagRecord &record)
+{
+	while (m_recordsLeft == 0) {
+		if (m_error || m_ptr >= m_end || !readBlockHeader()) {
+			return false;
+		}
+	}
+
+	unsigned int line(0), numFields(0);
+	if (!readString(record.m_name) ||
+	    !readString(record.m_file) ||
+	    !readString(record.m_pattern) ||
+	    !readInt(line) ||
+	    !readString(record.m_kind) ||
+	    !readInt(numFields)) {
+		return false;
+	}
+
+	record.m_line = (int)line;
+	record.m_fields.clear();
+	for (unsigned int i=0; i<numFields; i++) {
+		std::pair<clIndexerTagString, clIndexerTagString> field;
+		if (!readString(field.first) || !readString(field.second)) {
+			return false;
+		}
+		record.m_fields.push_back(field);
+	}
+	m_recordsLeft--;
+	return true;
+}
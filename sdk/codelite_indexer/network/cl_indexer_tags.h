@@ -0,0 +1,175 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2014 Eran Ifrah
+// file name            : cl_indexer_tags.h
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __clindexertags__
+#define __clindexertags__
+
+#include <map>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+// Binary tags format, used by the indexer instead of the ctags text output
+// when the request has the CLI_REPLY_BINARY_TAGS flag set.
+//
+// A reply is a sequence of blocks (so the output of several files can simply
+// be concatenated). All integers are 32 bit, in the host byte order:
+//
+// integer      | magic (CLI_TAGS_MAGIC)
+// integer      | number of interned strings
+//   integer    |   string length
+//   bytes      |   string
+// integer      | number of records
+//   ref        |   name
+//   ref        |   file
+//   ref        |   pattern
+//   integer    |   line number (-1 if unknown)
+//   ref        |   kind
+//   integer    |   number of extension fields
+//     ref      |     key
+//     ref      |     value
+//
+// A 'ref' is an integer. When its high bit is set, the lower bits are an index
+// into the interned strings table of the block. Otherwise it is the length of
+// the string that follows it. File names, kinds, field keys and most of the
+// field values (access, scope, ...) repeat a lot and are interned
+////////////////////////////////////////////////////////////////////////////////
+
+#define CLI_TAGS_MAGIC 0x42544C43
+#define CLI_TAGS_INTERNED 0x80000000
+
+/**
+ * @class clIndexerTagsWriter
+ * @brief converts the ctags text output into the binary tags format
+ */
+class clIndexerTagsWriter
+{
+	std::vector<std::string> m_strings;
+	std::map<std::string, unsigned int> m_stringsIndex;
+	std::string m_records;
+	unsigned int m_count;
+
+protected:
+	void writeInt(std::string &buffer, unsigned int value);
+	void writeString(const std::string &str, bool intern);
+	void addLine(const std::string &line);
+
+public:
+	clIndexerTagsWriter();
+	~clIndexerTagsWriter();
+
+	/**
+	 * @brief add all the tags of a ctags output (one tag per line)
+	 */
+	void addTags(const char *ctagsOutput);
+
+	/**
+	 * @brief append the block to 'output' and clear the writer
+	 */
+	void flush(std::string &output);
+
+	size_t getCount() const {
+		return m_count;
+	}
+};
+
+/**
+ * @class clIndexerTagString
+ * @brief a string inside the receive buffer. The data is NOT null terminated
+ */
+struct clIndexerTagString {
+	const char *m_data;
+	size_t m_len;
+	// index of the string in the interned strings table, or -1
+	int m_interned;
+
+	clIndexerTagString() : m_data(NULL), m_len(0), m_interned(-1) {}
+	std::string str() const {
+		return std::string(m_data, m_len);
+	}
+	bool equals(const char *s) const;
+};
+
+struct clIndexerTagRecord {
+	clIndexerTagString m_name;
+	clIndexerTagString m_file;
+	clIndexerTagString m_pattern;
+	int m_line;
+	clIndexerTagString m_kind;
+	std::vector<std::pair<clIndexerTagString, clIndexerTagString> > m_fields;
+
+	clIndexerTagRecord() : m_line(-1) {}
+};
+
+/**
+ * @class clIndexerTagsReader
+ * @brief iterates over the records of a binary tags buffer without copying it. The buffer must
+ * outlive the reader and the records returned by it
+ */
+class clIndexerTagsReader
+{
+	const char *m_ptr;
+	const char *m_end;
+	unsigned int m_recordsLeft;
+	std::vector<clIndexerTagString> m_strings;
+	size_t m_block;
+	bool m_error;
+
+protected:
+	bool readInt(unsigned int &value);
+	bool readBytes(clIndexerTagString &str, size_t len);
+	bool readString(clIndexerTagString &str);
+	bool readBlockHeader();
+
+public:
+	clIndexerTagsReader(const char *data, size_t len);
+	~clIndexerTagsReader();
+
+	/**
+	 * @brief read the next record
+	 * @return false when there are no more records or when the buffer is malformed (see isOk())
+	 */
+	bool next(clIndexerTagRecord &record);
+
+	/**
+	 * @brief the interned strings of the current block. Interned strings are referenced from the
+	 * records by their index (clIndexerTagString::m_interned)
+	 */
+	const std::vector<clIndexerTagString>& getStrings() const {
+		return m_strings;
+	}
+
+	/**
+	 * @brief incremented every time a new block is started (i.e. every time getStrings() changes)
+	 */
+	size_t getBlock() const {
+		return m_block;
+	}
+
+	bool isOk() const {
+		return !m_error;
+	}
+};
+#endif // __clindexertags__
@@ -24,7 +24,10 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include "clindexerprotocol.h"
+#include "cl_indexer_macros.h"
+#include <algorithm>
 #include <memory>
+#include <string.h>
 #include <stdio.h>
 #include <sstream>
 
@@ -52,6 +55,72 @@ clIndexerProtocol::clIndexerProtocol() {}
 
 clIndexerProtocol::~clIndexerProtocol() {}
 
+// Replies are read in chunks, so a corrupted length does not make us allocate a huge buffer upfront
+#define READ_REPLY_CHUNK_SIZE (1024 * 1024)
+
+// Send buffers in chunks of this size
+#define WRITE_CHUNK_SIZE 3000
+
+static bool ReadBuffer(clNamedPipe* conn, char* data, size_t len, std::string& errmsg)
+{
+    size_t bytes_read(0);
+    while(bytes_read < len) {
+        size_t actual_read(0);
+        if(!conn->read(data + bytes_read, len - bytes_read, &actual_read, 10000)) {
+            std::stringstream ss;
+            ss << "ERROR: Protocol error: expected " << len << " bytes, got " << bytes_read
+               << " reason: " << conn->getLastError();
+            errmsg = ss.str();
+            return false;
+        }
+        bytes_read += actual_read;
+    }
+    return true;
+}
+
+static bool ReadSize(clNamedPipe* conn, size_t& value, size_t& bytes_left, std::string& errmsg)
+{
+    if(bytes_left < sizeof(value)) {
+        errmsg = "ERROR: ReadReply: Protocol error: truncated reply";
+        return false;
+    }
+    if(!ReadBuffer(conn, (char*)&value, sizeof(value), errmsg)) { return false; }
+    bytes_left -= sizeof(value);
+    return true;
+}
+
+static bool ReadString(clNamedPipe* conn, std::string& str, size_t& bytes_left, std::string& errmsg)
+{
+    size_t len(0);
+    if(!ReadSize(conn, len, bytes_left, errmsg)) { return false; }
+    if(len > bytes_left) {
+        errmsg = "ERROR: ReadReply: Protocol error: string length exceeds the reply size";
+        return false;
+    }
+
+    str.clear();
+    while(str.length() < len) {
+        size_t offset = str.length();
+        size_t chunk = std::min((size_t)READ_REPLY_CHUNK_SIZE, len - offset);
+        str.resize(offset + chunk);
+        if(!ReadBuffer(conn, &str[offset], chunk, errmsg)) { return false; }
+    }
+    bytes_left -= len;
+    return true;
+}
+
+static bool WriteBuffer(clNamedPipe* conn, const char* data, size_t len)
+{
+    size_t bytes_written(0);
+    while(bytes_written < len) {
+        size_t bytes_to_write = std::min((size_t)WRITE_CHUNK_SIZE, len - bytes_written);
+        size_t actual_written(0);
+        if(!conn->write(data + bytes_written, bytes_to_write, &actual_written, -1)) { return false; }
+        bytes_written += actual_written;
+    }
+    return true;
+}
+
 bool clIndexerProtocol::ReadReply(clNamedPipe* conn, clIndexerReply& reply, std::string& errmsg)
 {
     // first we read sizeof(size_t) to get the actual data size
@@ -73,46 +142,51 @@ bool clIndexerProtocol::ReadReply(clNamedPipe* conn, clIndexerReply& reply, std:
         return false;
     }
 
-    if((buff_len / (1024 * 1024)) > 15) {
-        // Dont read buffers larger than 15MB...
-        errmsg = "Buffer size is larger than 15MB";
+    // Read the reply fields directly from the pipe (see clIndexerReply::toBinary() for the layout)
+    // The tags are read straight into the reply, so large replies are never copied
+    size_t completionCode(0), requestId(0);
+    std::string fileName, tags;
+    if(!ReadSize(conn, completionCode, buff_len, errmsg) || !ReadSize(conn, requestId, buff_len, errmsg) ||
+       !ReadString(conn, fileName, buff_len, errmsg) || !ReadString(conn, tags, buff_len, errmsg)) {
         return false;
     }
 
-    char* data = new char[buff_len];
-    CharDeleter deleter(data);
-
-    int bytes_left(buff_len);
-    size_t bytes_read(0);
-    while(bytes_left > 0) {
-        if(!conn->read(data + bytes_read, bytes_left, &actual_read, 10000)) {
-            std::stringstream ss;
-            ss << "ERROR: Protocol error: expected " << buff_len << " bytes, got " << actual_read;
-            return false;
-        }
-        bytes_left -= actual_read;
-        bytes_read += actual_read;
+    if(buff_len != 0) {
+        errmsg = "ERROR: ReadReply: Protocol error: unexpected data at the end of the reply";
+        return false;
     }
 
-    reply.fromBinary(data);
+    reply.setCompletionCode(completionCode);
+    reply.setRequestId(requestId);
+    reply.setFileName(fileName);
+    reply.swapTags(tags);
     return true;
 }
 
-bool clIndexerProtocol::ReadRequest(clNamedPipe* conn, clIndexerRequest& req)
+bool clIndexerProtocol::ReadRequest(clNamedPipe* conn, clIndexerRequest& req, long timeout)
 {
     // first we read sizeof(size_t) to get the actual data size
     size_t buff_len(0);
     size_t actual_read(0);
 
-    if(!conn->read((void*)&buff_len, sizeof(buff_len), &actual_read, -1)) {
-        fprintf(stderr, "ERROR: Failed to read from the pipe, reason: %d\n", conn->getLastError());
+    if(!conn->read((void*)&buff_len, sizeof(buff_len), &actual_read, timeout)) {
+        if(conn->getLastError() != clNamedPipe::ZNP_TIMEOUT && conn->getLastError() != clNamedPipe::ZNP_CONN_CLOSED) {
+            fprintf(stderr, "ERROR: Failed to read from the pipe, reason: %d\n", conn->getLastError());
+        }
         return false;
     }
 
-    if(actual_read != sizeof(buff_len)) {
-        fprintf(stderr, "ERROR: Protocol error: expected %u bytes, got %u\n", (unsigned int)sizeof(buff_len),
-            (unsigned int)actual_read);
-        return false;
+    // The timeout only applies to the arrival of a request: once its first bytes arrived, the rest of the header
+    // is on its way. A header that can not be completed leaves the stream out of sync, it is never a timeout
+    size_t header_read(actual_read);
+    while(header_read < sizeof(buff_len)) {
+        if(!conn->read((char*)&buff_len + header_read, sizeof(buff_len) - header_read, &actual_read, -1)) {
+            fprintf(stderr, "ERROR: Protocol error: expected %u bytes, got %u\n", (unsigned int)sizeof(buff_len),
+                (unsigned int)header_read);
+            conn->setLastError(clNamedPipe::ZNP_READ_ERROR);
+            return false;
+        }
+        header_read += actual_read;
     }
 
     if(buff_len == 0) return false;
@@ -138,37 +212,29 @@ bool clIndexerProtocol::ReadRequest(clNamedPipe* conn, clIndexerRequest& req)
 
 bool clIndexerProtocol::SendReply(clNamedPipe* conn, clIndexerReply& reply)
 {
-    size_t buff_size(0);
-    char* data = reply.toBinary(buff_size);
-    CharDeleter deleter(data);
+    // Send the reply header followed by the tags. The tags are written directly from the reply
+    // (they can be large), the wire format is the same as clIndexerReply::toBinary()
+    size_t completionCode = reply.getCompletionCode();
+    size_t requestId = reply.getRequestId();
+    const std::string& fileName = reply.getFileName();
+    const std::string& tags = reply.getTags();
+
+    size_t header_size = sizeof(completionCode) + sizeof(requestId) + sizeof(size_t) + fileName.length() + sizeof(size_t);
+    size_t buff_size = header_size + tags.length();
+
+    char* header = new char[header_size];
+    CharDeleter deleter(header);
+    char* ptr = header;
+    PACK_INT(ptr, completionCode);
+    PACK_INT(ptr, requestId);
+    PACK_STD_STRING(ptr, fileName);
+    size_t tags_len = tags.length();
+    PACK_INT(ptr, tags_len);
 
     // send the reply size
     size_t written(0);
-    conn->write((void*)&buff_size, sizeof(buff_size), &written, -1);
-
-    int bytes_left(buff_size);
-    int bytes_to_write(0);
-    int bytes_written(0);
-
-    while(bytes_left > 0) {
-        // we write in chunks of 3000 bytes
-        if(bytes_left < 3000) {
-            bytes_to_write = bytes_left;
-        } else {
-            bytes_to_write = 3000;
-        }
-
-        size_t actual_written(0);
-        if(!conn->write(data + bytes_written, bytes_to_write, &actual_written, -1)) {
-            return false;
-        }
-
-        bytes_left -= actual_written;
-        bytes_written += actual_written;
-    }
-
-    // the above problem does not exist under Windows' NamedPipes
-    return true;
+    if(!conn->write((void*)&buff_size, sizeof(buff_size), &written, -1)) { return false; }
+    return WriteBuffer(conn, header, header_size) && WriteBuffer(conn, tags.data(), tags.length());
 }
 
 bool clIndexerProtocol::SendRequest(clNamedPipe* conn, clIndexerRequest& req)
@@ -184,26 +250,5 @@ bool clIndexerProtocol::SendRequest(clNamedPipe* conn, clIndexerRequest& req)
         printf("ERROR: [%s] protocol error: rc %d\n", __PRETTY_FUNCTION__, conn->getLastError());
         return false;
     }
-
-    int bytes_left(size);
-    int bytes_to_write(0);
-    int bytes_written(0);
-
-    while(bytes_left > 0) {
-        // we write in chunks of 3000 bytes
-        if(bytes_left < 3000) {
-            bytes_to_write = bytes_left;
-        } else {
-            bytes_to_write = 3000;
-        }
-
-        size_t actual_written(0);
-        if(!conn->write(data + bytes_written, bytes_to_write, &actual_written, -1)) {
-            return false;
-        }
-
-        bytes_left -= actual_written;
-        bytes_written += actual_written;
-    }
-    return true;
+    return WriteBuffer(conn, data, size);
 }
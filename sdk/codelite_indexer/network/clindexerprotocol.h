@@ -30,6 +30,9 @@
 #include "cl_indexer_reply.h"
 #include "cl_indexer_request.h"
 
+// Streaming sessions that did not send a request for this number of seconds are closed by the indexer
+#define INDEXER_SESSION_IDLE_TIMEOUT 5
+
 class clIndexerProtocol
 {
 
@@ -56,11 +59,14 @@ public:
      * @param conn [input] named pipe to use for reading the request
      * @param req [output] holds the received request. Should be used only if this function
      *        returns true
+     * @param timeout milliseconds to wait for the request to arrive (-1 means wait forever). When
+     *        no request arrived in time, this function returns false and conn->getLastError() is ZNP_TIMEOUT
      * @return true on success, false otherwise
      */
-    static bool ReadRequest(clNamedPipe* conn, clIndexerRequest& req);
+    static bool ReadRequest(clNamedPipe* conn, clIndexerRequest& req, long timeout = -1);
     /**
-     * @brief read reply from the server.
+     * @brief read reply from the server. The reply is read in chunks directly into 'reply',
+     * there is no limit on its size
      * @param conn connection to use
      * @param reply [output]
      * @return true on success, false otherwise
@@ -15,6 +15,7 @@
 #    include <Tlhelp32.h>
 #else
 #    include <signal.h>
+#    include <unistd.h>
 #endif
 
 #ifdef __FreeBSD__
@@ -117,6 +118,62 @@ bool is_process_alive(long pid)
 #endif
 }
 
+long get_current_pid()
+{
+#ifdef __WXMSW__
+	return (long)GetCurrentProcessId();
+#else
+	return (long)getpid();
+#endif
+}
+
+bool start_process(const std::vector<std::string> &args)
+{
+	if ( args.empty() ) {
+		return false;
+	}
+
+#ifdef __WXMSW__
+	std::string cmd;
+	for (size_t i=0; i<args.size(); i++) {
+		cmd += "\"" + args.at(i) + "\" ";
+	}
+
+	STARTUPINFOA si;
+	PROCESS_INFORMATION pi;
+	memset(&si, 0, sizeof(si));
+	memset(&pi, 0, sizeof(pi));
+	si.cb = sizeof(si);
+
+	std::vector<char> cmdline(cmd.begin(), cmd.end());
+	cmdline.push_back(0);
+	if ( !CreateProcessA(NULL, &cmdline[0], NULL, NULL, FALSE, CREATE_NO_WINDOW, NULL, NULL, &si, &pi) ) {
+		return false;
+	}
+	CloseHandle(pi.hThread);
+	CloseHandle(pi.hProcess);
+	return true;
+
+#else
+	std::vector<char*> argv;
+	for (size_t i=0; i<args.size(); i++) {
+		argv.push_back(const_cast<char*>(args.at(i).c_str()));
+	}
+	argv.push_back(NULL);
+
+	pid_t pid = fork();
+	if ( pid < 0 ) {
+		return false;
+
+	} else if ( pid == 0 ) {
+		// child process
+		execvp(argv[0], &argv[0]);
+		_exit(127);
+	}
+	return true;
+#endif
+}
+
 static char *load_file(const char *fileName) {
 	FILE *fp;
 	long len;
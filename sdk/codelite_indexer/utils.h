@@ -28,4 +28,16 @@ std::vector<std::string> string_tokenize(const std::string &str, const std::stri
  */
 bool is_process_alive(long pid);
 
+/**
+ * @brief return the process id of the calling process
+ */
+long get_current_pid();
+
+/**
+ * @brief start a new process without waiting for it to terminate
+ * @param args the executable followed by its arguments
+ * @return true if the process was started
+ */
+bool start_process(const std::vector<std::string> &args);
+
 #endif // __UTILS_H__
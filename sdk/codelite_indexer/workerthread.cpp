@@ -5,14 +5,25 @@
 #include "network/cl_indexer_request.h"
 #include "network/np_connections_server.h"
 #include "network/clindexerprotocol.h"
+#include "network/cl_indexer_session.h"
+#include "network/cl_indexer_tags.h"
 #include "libctags/libctags.h"
 #include "utils.h"
 #include <stdlib.h>
 #include <cstdio>
-#include <memory>
+#include <sstream>
+#include <vector>
 
-WorkerThread::WorkerThread(eQueue<clNamedPipe*> *queue)
+#ifdef __WXMSW__
+#define PIPE_NAME "\\\\.\\pipe\\codelite_indexer_%s"
+#else
+#define PIPE_NAME "/tmp/codelite_indexer.%s.sock"
+#endif
+
+WorkerThread::WorkerThread(eQueue<IndexerJob*> *queue, size_t maxParsedFiles)
 		: m_queue(queue)
+		, m_parsedFiles(0)
+		, m_maxParsedFiles(maxParsedFiles)
 {
 }
 
@@ -24,81 +35,347 @@ void WorkerThread::start()
 {
 	printf("INFO: WorkerThread: Started\n");
 	while ( !testDestroy() ) {
-		clNamedPipe *conn(NULL);
-		if (!m_queue->get(conn, 100)) {
+		IndexerJob *job(NULL);
+		if (!m_queue->get(job, 100)) {
 			continue;
 		}
 
-		if (conn) {
-			std::auto_ptr<clNamedPipe> p( conn );
-			// get request from the client
-			clIndexerRequest req;
-			if ( !clIndexerProtocol::ReadRequest(conn, req) ) {
-				continue;
-			}
+		if (job) {
+			processJob(job);
+			delete job;
+		}
+
+		// a streaming session parses any number of files, so the files are counted and not the connections
+		if ( m_maxParsedFiles && m_parsedFiles >= m_maxParsedFiles ) {
+			printf("INFO: Max parsed files reached, going down\n");
+			break;
+		}
+	}
+	printf("INFO: WorkerThread: Going down\n");
+	exit(-1);
+}
+
+void WorkerThread::processJob(IndexerJob *job)
+{
+	switch ( job->type ) {
+	case IndexerJob::NEW_CONNECTION:
+		processConnection(job->conn);
+		break;
 
-			char *tags(NULL);
-			// create fies for the requested files
-			for (size_t i=0; i<req.getFiles().size(); i++) {
+	case IndexerJob::SESSION_REQUEST:
+		// the jobs of a session are queued in the order its requests arrived. If a reply can not be sent the
+		// client is gone, and its session thread closes the session
+		if ( job->req.getCmd() == clIndexerRequest::CLI_PARSE_STREAM ) {
+			processStreamRequest(job->conn, job->req);
+		} else {
+			processRequest(job->conn, job->req);
+		}
+		break;
+
+	case IndexerJob::SESSION_CLOSED:
+		// this is the last job of the session
+		job->session->wait(-1);
+		delete job->session;
+		delete job->conn;
+		break;
+	}
+}
+
+void WorkerThread::processConnection(clNamedPipe *conn)
+{
+	// get request from the client
+	clIndexerRequest req;
+	if ( !clIndexerProtocol::ReadRequest(conn, req, -1) ) {
+		delete conn;
+		return;
+	}
+
+	if ( req.getCmd() == clIndexerRequest::CLI_PARSE_STREAM ) {
+		if ( !processStreamRequest(conn, req) ) {
+			delete conn;
+			return;
+		}
+
+		// the session thread owns the connection from now on
+		SessionThread *session = new SessionThread(this, conn);
+		session->run();
+		return;
+	}
+
+	processRequest(conn, req);
+	delete conn;
+}
+
+void WorkerThread::processRequest(clNamedPipe *conn, const clIndexerRequest &req)
+{
+	m_parsedFiles += req.getFiles().size();
+	std::string tags;
+	bool hasTags(false);
+	bool binary = (req.getFlags() & clIndexerRequest::CLI_REPLY_BINARY_TAGS);
+	clIndexerTagsWriter writer;
+	// create fies for the requested files
+	for (size_t i=0; i<req.getFiles().size(); i++) {
 
 #ifdef __DEBUG
-				printf("------------------------------------------------------------------\n");
-				printf("INFO: Source        : %s\n", req.getFiles().at(i).c_str());
-				printf("INFO: Command       : %d\n", req.getCmd());
-				printf("INFO: CTAGS options : %s\n", req.getCtagOptions().c_str());
-				printf("INFO: Database      : %s\n", req.getDatabaseFileName().c_str());
+		printf("------------------------------------------------------------------\n");
+		printf("INFO: Source        : %s\n", req.getFiles().at(i).c_str());
+		printf("INFO: Command       : %d\n", (int)req.getCmd());
+		printf("INFO: CTAGS options : %s\n", req.getCtagOptions().c_str());
+		printf("INFO: Database      : %s\n", req.getDatabaseFileName().c_str());
 #endif
 
-				char *new_tags = ctags_make_tags(req.getCtagOptions().c_str(), req.getFiles().at(i).c_str());
-				if (tags && new_tags) {
-					// re-allocate the buffer to containt the new tags + 2 chars: 1 for terminating null and one for the '\n'
-					// that will be appended
-					char *ptmp = (char*)malloc(strlen(tags) + strlen(new_tags) + 2);
-					memset(ptmp, 0, strlen(tags) + strlen(new_tags) + 2);
-					strcat(ptmp, tags);
-					strcat(ptmp, "\n");
-					strcat(ptmp, new_tags);
-
-					ctags_free(new_tags);
-					ctags_free(tags);
-
-					tags = ptmp;
-
-				} else if(new_tags) {
-					// first time
-					tags = new_tags;
-					new_tags = NULL;
+		char *new_tags = ctags_make_tags(req.getCtagOptions().c_str(), req.getFiles().at(i).c_str());
+		if (new_tags) {
+			if (binary) {
+				writer.addTags(new_tags);
+
+			} else {
+				if (hasTags) {
+					tags.append("\n");
 				}
+				tags.append(new_tags);
 			}
+			hasTags = true;
+			ctags_free(new_tags);
+		}
+	}
+
+	if (binary) {
+		writer.flush(tags);
+	}
 
-			// prepare the reply
+	// prepare the reply
 #ifdef __DEBUG
-			std::vector<std::string> lines = string_tokenize(tags, "\n");
-			for(size_t i=0; i<lines.size(); i++){
-				printf("%s\n", lines.at(i).c_str());
-			}
+	if (!binary) {
+		std::vector<std::string> lines = string_tokenize(tags, "\n");
+		for(size_t i=0; i<lines.size(); i++){
+			printf("%s\n", lines.at(i).c_str());
+		}
+	}
 #endif
 
-			clIndexerReply reply;
-			if (tags) {
-				// prepare reply
-				reply.setCompletionCode(1);
-				reply.setTags(tags);
+	clIndexerReply reply;
+	reply.setRequestId(req.getRequestId());
+	if (hasTags) {
+		// prepare reply
+		reply.setCompletionCode(clIndexerReply::CLI_COMPLETION_TAGS);
+		reply.setTags(tags);
+	} else {
+		reply.setCompletionCode(clIndexerReply::CLI_COMPLETION_NO_TAGS);
+	}
+
+	// send the reply
+	if ( !clIndexerProtocol::SendReply(conn, reply) ) {
+		fprintf(stderr, "ERROR: Protocol error: failed to send reply for file %s\n", reply.getFileName().c_str());
+	}
+}
+
+bool WorkerThread::processStreamRequest(clNamedPipe *conn, const clIndexerRequest &req)
+{
+	m_parsedFiles += req.getFiles().size();
+	for (size_t i=0; i<req.getFiles().size(); i++) {
+		const std::string &file = req.getFiles().at(i);
+
+		clIndexerReply reply;
+		reply.setRequestId(req.getRequestId() + i);
+		reply.setFileName(file);
+
+		char *tags = ctags_make_tags(req.getCtagOptions().c_str(), file.c_str());
+		if (tags) {
+			reply.setCompletionCode(clIndexerReply::CLI_COMPLETION_TAGS);
+			if (req.getFlags() & clIndexerRequest::CLI_REPLY_BINARY_TAGS) {
+				clIndexerTagsWriter writer;
+				writer.addTags(tags);
+
+				std::string binaryTags;
+				writer.flush(binaryTags);
+				reply.swapTags(binaryTags);
 			} else {
-				reply.setCompletionCode(0);
+				reply.setTags(tags);
 			}
-
 			ctags_free(tags);
+		} else {
+			reply.setCompletionCode(clIndexerReply::CLI_COMPLETION_NO_TAGS);
+		}
 
-			// send the reply
+		if ( !clIndexerProtocol::SendReply(conn, reply) ) {
+			fprintf(stderr, "ERROR: Protocol error: failed to send reply for file %s\n", file.c_str());
+			return false;
+		}
+	}
+	return true;
+}
+
+// ---------------------------------------------
+// pool worker thread
+// ---------------------------------------------
+
+ProxyWorkerThread::ProxyWorkerThread(eQueue<IndexerJob*> *queue, const std::string &exe, const std::string &childId)
+		: WorkerThread(queue)
+		, m_exe(exe)
+		, m_childId(childId)
+{
+	char channel_name[1024];
+	sprintf(channel_name, PIPE_NAME, m_childId.c_str());
+	m_session = new clIndexerSession(channel_name);
+}
+
+ProxyWorkerThread::~ProxyWorkerThread()
+{
+	delete m_session;
+}
+
+bool ProxyWorkerThread::ensureChild()
+{
+	if ( m_session->isConnected() || m_session->connect() ) {
+		return true;
+	}
+
+	// (re)start the child process. It goes down when this process terminates
+	std::stringstream pid;
+	pid << get_current_pid();
+
+	std::vector<std::string> args;
+	args.push_back(m_exe);
+	args.push_back(m_childId);
+	args.push_back("--parent");
+	args.push_back(pid.str());
+	if ( !start_process(args) ) {
+		fprintf(stderr, "ERROR: failed to start indexer worker process %s\n", m_childId.c_str());
+		return false;
+	}
+
+	// give the child some time to open its channel
+	for (int i=0; i<50; i++) {
+		eThreadSleep(100);
+		if ( m_session->connect() ) {
+			printf("INFO: indexer worker process %s is ready\n", m_childId.c_str());
+			return true;
+		}
+	}
+	fprintf(stderr, "ERROR: failed to connect to indexer worker process %s\n", m_childId.c_str());
+	return false;
+}
+
+bool ProxyWorkerThread::forwardRequest(clNamedPipe *conn, const clIndexerRequest &req, bool stream)
+{
+	const std::vector<std::string> &files = req.getFiles();
+	std::vector<std::string> tags(files.size());
+	std::vector<bool> answered(files.size(), false);
+	bool failed(false);
+
+	size_t firstRequestId(0);
+	bool ok = ensureChild() && m_session->sendBatch(files, req.getCtagOptions(), firstRequestId, req.getFlags());
+	for (size_t i=0; ok && i<files.size(); i++) {
+		clIndexerReply reply;
+		std::string errmsg;
+		if ( !m_session->readReply(reply, errmsg) ) {
+			fprintf(stderr, "ERROR: indexer worker process %s: %s\n", m_childId.c_str(), errmsg.c_str());
+			ok = false;
+			break;
+		}
+
+		size_t index = reply.getRequestId() - firstRequestId;
+		if ( index >= files.size() ) {
+			continue;
+		}
+
+		answered[index] = true;
+		if ( stream ) {
+			// translate the id back into the client ids
+			reply.setRequestId(req.getRequestId() + index);
 			if ( !clIndexerProtocol::SendReply(conn, reply) ) {
-				fprintf(stderr, "ERROR: Protocol error: failed to send reply for file %s\n", reply.getFileName().c_str());
-				break;
+				return false;
 			}
+
+		} else if ( reply.getCompletionCode() == clIndexerReply::CLI_COMPLETION_TAGS ) {
+			tags[index] = reply.getTags();
+
+		} else if ( reply.getCompletionCode() == clIndexerReply::CLI_COMPLETION_ERROR ) {
+			failed = true;
 		}
 	}
-	printf("INFO: WorkerThread: Going down\n");
-	exit(-1);
+
+	if ( stream ) {
+		// the client expects a reply per file, the files that the child did not parse are reported as failed so
+		// the client parses them again later
+		for (size_t i=0; i<files.size(); i++) {
+			if ( answered[i] ) {
+				continue;
+			}
+			clIndexerReply reply;
+			reply.setRequestId(req.getRequestId() + i);
+			reply.setFileName(files.at(i));
+			reply.setCompletionCode(clIndexerReply::CLI_COMPLETION_ERROR);
+			if ( !clIndexerProtocol::SendReply(conn, reply) ) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// binary tags blocks can be concatenated as-is, ctags text lines need a separator
+	bool binary = (req.getFlags() & clIndexerRequest::CLI_REPLY_BINARY_TAGS);
+	std::string allTags;
+	bool hasTags(false);
+	for (size_t i=0; i<tags.size(); i++) {
+		if ( tags.at(i).empty() ) {
+			continue;
+		}
+		if ( hasTags && !binary ) {
+			allTags.append("\n");
+		}
+		allTags.append(tags.at(i));
+		hasTags = true;
+	}
+
+	for (size_t i=0; i<files.size(); i++) {
+		failed = failed || !answered[i];
+	}
+
+	clIndexerReply reply;
+	reply.setRequestId(req.getRequestId());
+	if ( failed ) {
+		// partial tags would replace all the tags of the files
+		reply.setCompletionCode(clIndexerReply::CLI_COMPLETION_ERROR);
+	} else {
+		reply.setCompletionCode(hasTags ? clIndexerReply::CLI_COMPLETION_TAGS : clIndexerReply::CLI_COMPLETION_NO_TAGS);
+		reply.setTags(allTags);
+	}
+	return clIndexerProtocol::SendReply(conn, reply);
+}
+
+void ProxyWorkerThread::processRequest(clNamedPipe *conn, const clIndexerRequest &req)
+{
+	if ( !forwardRequest(conn, req, false) ) {
+		fprintf(stderr, "ERROR: Protocol error: failed to send reply\n");
+	}
+}
+
+bool ProxyWorkerThread::processStreamRequest(clNamedPipe *conn, const clIndexerRequest &req)
+{
+	return forwardRequest(conn, req, true);
+}
+
+// ---------------------------------------------
+// session reader thread
+// ---------------------------------------------
+
+void SessionThread::start()
+{
+	while ( !testDestroy() ) {
+		// a timeout means that the session is idle, the client opens a new one when it needs it again. Any
+		// other failure (including a request that was not read completely) leaves the stream out of sync
+		IndexerJob *job = new IndexerJob(IndexerJob::SESSION_REQUEST, m_conn, this);
+		if ( !clIndexerProtocol::ReadRequest(m_conn, job->req, INDEXER_SESSION_IDLE_TIMEOUT * 1000) ) {
+			delete job;
+			break;
+		}
+		m_worker->putJob(job);
+	}
+
+	// the worker deletes this thread and the connection once the requests before this one were served
+	m_worker->putJob(new IndexerJob(IndexerJob::SESSION_CLOSED, m_conn, this));
 }
 
 // ---------------------------------------------
@@ -2,19 +2,138 @@
 #define __workerthread__
 
 #include "network/named_pipe.h"
+#include "network/cl_indexer_request.h"
 #include "ethread.h"
 #include "equeue.h"
+#include <string>
+
+class clIndexerSession;
+class SessionThread;
+
+/**
+ * @brief a unit of work of a WorkerThread
+ */
+struct IndexerJob {
+	enum Type {
+		// a new connection, its request was not read yet
+		NEW_CONNECTION,
+		// a request that was read from an open streaming session
+		SESSION_REQUEST,
+		// the streaming session was closed, its thread and its connection can be deleted
+		SESSION_CLOSED
+	};
+
+	Type type;
+	clNamedPipe *conn;
+	SessionThread *session;
+	clIndexerRequest req;
+
+	IndexerJob(Type t, clNamedPipe *c, SessionThread *s = NULL) : type(t), conn(c), session(s) {}
+};
 
 // ---------------------------------------------
 // parsing thread
 // ---------------------------------------------
 
 class WorkerThread : public eThread {
-	eQueue<clNamedPipe*> *m_queue;
+protected:
+	eQueue<IndexerJob*> *m_queue;
+	size_t m_parsedFiles;
+	size_t m_maxParsedFiles;
+
+protected:
+	/**
+	 * @brief serve the first request of a new connection. A streaming session is then read by its own
+	 * SessionThread, which queues its requests back to this worker
+	 */
+	void processConnection(clNamedPipe *conn);
+	void processJob(IndexerJob *job);
+	/**
+	 * @brief parse all the files and send back a single reply with all the tags
+	 */
+	virtual void processRequest(clNamedPipe *conn, const clIndexerRequest &req);
+	/**
+	 * @brief parse the files and send back one reply per file
+	 */
+	virtual bool processStreamRequest(clNamedPipe *conn, const clIndexerRequest &req);
+
+public:
+	/**
+	 * @param maxParsedFiles the process goes down once this thread parsed that many files, so the memory leaked
+	 * by libctags is reclaimed (the client restarts the indexer). 0 means no limit
+	 */
+	WorkerThread(eQueue<IndexerJob*> *queue, size_t maxParsedFiles = 0);
+	virtual ~WorkerThread();
+
+	/**
+	 * @brief return the number of jobs waiting for this worker
+	 */
+	size_t getQueueDepth() {
+		return m_queue->size();
+	}
+
+	void putJob(IndexerJob *job) {
+		m_queue->put(job);
+	}
+
+public:
+	virtual void start();
+};
+
+// ---------------------------------------------
+// pool worker thread
+// ---------------------------------------------
+
+/**
+ * @class ProxyWorkerThread
+ * @brief a worker of the indexer pool. libctags is not thread safe, so instead of parsing in-process
+ * each pool worker owns a child indexer process and forwards the files to it over a streaming session
+ */
+class ProxyWorkerThread : public WorkerThread {
+	std::string m_exe;
+	std::string m_childId;
+	clIndexerSession *m_session;
+
+protected:
+	/**
+	 * @brief make sure that the child process is running and that we are connected to it
+	 */
+	bool ensureChild();
+	/**
+	 * @brief forward the files of 'req' to the child process. When 'stream' is true, each reply is sent
+	 * back to the client as soon as it arrives, otherwise a single reply is sent with all the tags
+	 */
+	bool forwardRequest(clNamedPipe *conn, const clIndexerRequest &req, bool stream);
+
+	virtual void processRequest(clNamedPipe *conn, const clIndexerRequest &req);
+	virtual bool processStreamRequest(clNamedPipe *conn, const clIndexerRequest &req);
+
+public:
+	/**
+	 * @param exe the indexer executable
+	 * @param childId the unique string of the child process channel
+	 */
+	ProxyWorkerThread(eQueue<IndexerJob*> *queue, const std::string &exe, const std::string &childId);
+	virtual ~ProxyWorkerThread();
+};
+
+// ---------------------------------------------
+// session reader thread
+// ---------------------------------------------
+
+/**
+ * @class SessionThread
+ * @brief reads the requests of a streaming session as they arrive and queues them to the worker that serves
+ * the session, so a worker never waits on a session that has nothing to send. The session is closed when the
+ * client disconnects, on a protocol error or when no request arrived for INDEXER_SESSION_IDLE_TIMEOUT seconds
+ */
+class SessionThread : public eThread {
+	WorkerThread *m_worker;
+	clNamedPipe  *m_conn;
 
 public:
-	WorkerThread(eQueue<clNamedPipe*> *queue);
-	~WorkerThread();
+	SessionThread(WorkerThread *worker, clNamedPipe *conn) : m_worker(worker), m_conn(conn) {}
+	virtual ~SessionThread() {}
 
 public:
 	virtual void start();